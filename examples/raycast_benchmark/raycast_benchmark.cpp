@@ -0,0 +1,117 @@
+#include <edyn/edyn.hpp>
+#include <edyn/time/time.hpp>
+#include <entt/entt.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+// Measures the time per ray of single raycasts and of batches of raycasts in
+// a scene with a grid of static bodies of different shape types.
+
+constexpr int grid_size = 20;
+constexpr size_t num_rays = 20000;
+constexpr int num_runs = 5;
+
+void make_bodies(entt::registry &registry, std::mt19937 &rng) {
+    std::uniform_real_distribution<edyn::scalar> angle_dist(0, edyn::pi2);
+
+    auto def = edyn::rigidbody_def();
+    def.kind = edyn::rigidbody_kind::rb_static;
+    auto count = 0;
+
+    for (int x = 0; x < grid_size; ++x) {
+        for (int y = 0; y < grid_size; ++y) {
+            for (int z = 0; z < grid_size; ++z) {
+                switch (count++ % 4) {
+                case 0:
+                    def.shape = edyn::box_shape{0.4, 0.3, 0.5};
+                    break;
+                case 1:
+                    def.shape = edyn::sphere_shape{0.4};
+                    break;
+                case 2:
+                    def.shape = edyn::cylinder_shape{0.3, 0.4};
+                    break;
+                case 3:
+                    def.shape = edyn::capsule_shape{0.2, 0.4};
+                    break;
+                }
+
+                def.position = {edyn::scalar(x * 2), edyn::scalar(y * 2), edyn::scalar(z * 2)};
+                def.orientation = edyn::quaternion_axis_angle(edyn::vector3_y, angle_dist(rng));
+                edyn::make_rigidbody(registry, def);
+            }
+        }
+    }
+}
+
+std::vector<edyn::raycast_query> make_rays(std::mt19937 &rng) {
+    // Short rays with nearby origins, as in a batch of visibility checks
+    // from a crowd of agents.
+    std::uniform_real_distribution<edyn::scalar> pos_dist(-2, grid_size * 2);
+    std::uniform_real_distribution<edyn::scalar> dir_dist(-8, 8);
+    std::vector<edyn::raycast_query> queries;
+
+    for (size_t i = 0; i < num_rays; ++i) {
+        auto query = edyn::raycast_query{};
+        query.p0 = {pos_dist(rng), pos_dist(rng), pos_dist(rng)};
+        query.p1 = query.p0 + edyn::vector3{dir_dist(rng), dir_dist(rng), dir_dist(rng)};
+        queries.push_back(query);
+    }
+
+    return queries;
+}
+
+template<typename Func>
+double best_time_per_ray(Func func) {
+    auto best = std::numeric_limits<double>::max();
+
+    for (int i = 0; i < num_runs; ++i) {
+        auto start = edyn::performance_time();
+        func();
+        best = std::min(best, edyn::performance_time() - start);
+    }
+
+    return best / num_rays * 1e9;
+}
+
+size_t count_hits(const std::vector<edyn::raycast_result> &results) {
+    return std::count_if(results.begin(), results.end(), [] (auto &res) {
+        return res.entity != entt::null;
+    });
+}
+
+int main(int argc, char** argv) {
+    entt::registry registry;
+    edyn::init();
+    edyn::attach(registry);
+
+    std::mt19937 rng(1337);
+    make_bodies(registry, rng);
+    auto queries = make_rays(rng);
+    auto results = std::vector<edyn::raycast_result>(queries.size());
+
+    auto single_time = best_time_per_ray([&] {
+        for (size_t i = 0; i < queries.size(); ++i) {
+            results[i] = edyn::raycast(registry, queries[i].p0, queries[i].p1);
+        }
+    });
+    printf("single raycast:       %8.1f ns/ray, %zu hits\n", single_time, count_hits(results));
+
+    auto closest_time = best_time_per_ray([&] {
+        edyn::raycast_batch(registry, queries, results, edyn::raycast_mode::closest_hit);
+    });
+    printf("batch, closest hit:   %8.1f ns/ray, %zu hits\n", closest_time, count_hits(results));
+
+    auto any_time = best_time_per_ray([&] {
+        edyn::raycast_batch(registry, queries, results, edyn::raycast_mode::any_hit);
+    });
+    printf("batch, any hit:       %8.1f ns/ray, %zu hits\n", any_time, count_hits(results));
+
+    edyn::detach(registry);
+    edyn::deinit();
+
+    return 0;
+}
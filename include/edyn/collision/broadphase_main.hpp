@@ -1,10 +1,10 @@
 #ifndef EDYN_COLLISION_BROADPHASE_MAIN_HPP
 #define EDYN_COLLISION_BROADPHASE_MAIN_HPP
 
-#include <map>
 #include <vector>
 #include <entt/entity/fwd.hpp>
 #include <entt/entity/utility.hpp>
+#include "edyn/comp/tag.hpp"
 #include "edyn/comp/island.hpp"
 #include "edyn/math/constants.hpp"
 #include "edyn/collision/dynamic_tree.hpp"
@@ -12,15 +12,22 @@
 
 namespace edyn {
 
-class tree_view;
-struct collision_filter;
-struct multi_island_resident;
-
+/**
+ * @brief Broad-phase collision detection between entities residing in
+ * different islands.
+ *
+ * A single world tree containing the AABBs of all procedural entities is kept
+ * in the coordinator and updated with the AABBs received from the island
+ * workers. Pairs of procedural entities residing in different islands are
+ * found by querying this tree once for each awake procedural entity, which
+ * avoids having to walk the trees of every pair of overlapping islands.
+ */
 class broadphase_main {
 
     using aabb_view_t = entt::basic_view<entt::entity, entt::exclude_t<>, AABB>;
+    using island_resident_view_t = entt::basic_view<entt::entity, entt::exclude_t<>, island_resident>;
     using multi_resident_view_t = entt::basic_view<entt::entity, entt::exclude_t<>, multi_island_resident>;
-    using tree_view_view_t = entt::basic_view<entt::entity, entt::exclude_t<>, tree_view>;
+    using sleeping_view_t = entt::basic_view<entt::entity, entt::exclude_t<>, sleeping_tag>;
 
     // A higher threshold is used in the main broadphase to create contact
     // manifolds between different islands a little earlier and decrease the
@@ -30,45 +37,57 @@ class broadphase_main {
     constexpr static auto m_aabb_offset = vector3_one * -m_threshold;
     constexpr static auto m_separation_threshold = m_threshold * scalar(1.3);
 
-    entity_pair_vector intersect_islands(const tree_view &tree_viewA, const tree_view &tree_viewB,
-                                         const aabb_view_t &aabb_view) const;
-    entity_pair_vector intersect_islands_a(const tree_view &tree_viewA, const tree_view &tree_viewB,
-                                           const aabb_view_t &aabb_view) const;
-    entity_pair_vector intersect_island_np(const tree_view &island_tree, entt::entity np_entity,
-                                           const aabb_view_t &aabb_view) const;
-    entity_pair_vector find_intersecting_islands(entt::entity island_entityA,
-                                                 const aabb_view_t &aabb_view,
-                                                 const multi_resident_view_t &resident_view,
-                                                 const tree_view_view_t &tree_view_view) const;
+    void init_new_aabb_entities();
+    void update_filter(dynamic_tree &tree, tree_node_id_t id, entt::entity entity);
+
+    entity_pair_vector find_intersecting_pairs(tree_node_id_t id,
+                                               const aabb_view_t &aabb_view,
+                                               const island_resident_view_t &resident_view,
+                                               const multi_resident_view_t &multi_resident_view,
+                                               const sleeping_view_t &sleeping_view) const;
 
 public:
     broadphase_main(entt::registry &);
     void update();
 
     template<typename Func>
-    void raycast_islands(vector3 p0, vector3 p1, Func func);
+    void raycast_procedural(vector3 p0, vector3 p1, Func func);
 
     template<typename Func>
     void raycast_non_procedural(vector3 p0, vector3 p1, Func func);
 
-    void on_construct_tree_view(entt::registry &, entt::entity);
-    void on_construct_static_tag(entt::registry &, entt::entity);
+    /**
+     * @brief Calls `func` for the procedural and the non-procedural AABB
+     * trees. Signature `void(const dynamic_tree &)`.
+     */
+    template<typename Func>
+    void each_tree(Func func) const;
+
+    /**
+     * @brief Moves the node of a static entity in the non-procedural tree
+     * after its AABB is modified, e.g. when its shape is edited.
+     */
+    void update_static_aabb(entt::entity);
+
+    void on_construct_aabb(entt::registry &, entt::entity);
     void on_construct_static_kinematic_tag(entt::registry &, entt::entity);
     void on_destroy_tree_resident(entt::registry &, entt::entity);
+    void on_update_collision_filter(entt::registry &, entt::entity);
+    void on_destroy_collision_filter(entt::registry &, entt::entity);
 
 private:
     entt::registry *m_registry;
-    dynamic_tree m_island_tree; // Tree for island AABBs.
+    dynamic_tree m_tree; // Procedural dynamic tree, i.e. the world tree.
     dynamic_tree m_np_tree; // Tree for non-procedural entities.
+    std::vector<entt::entity> m_new_aabb_entities;
+    std::vector<tree_node_id_t> m_awake_nodes;
     std::vector<entity_pair_vector> m_pair_results;
-
-    bool should_collide(entt::entity, entt::entity) const;
 };
 
 template<typename Func>
-void broadphase_main::raycast_islands(vector3 p0, vector3 p1, Func func) {
-    m_island_tree.raycast(p0, p1, [&] (tree_node_id_t id) {
-        func(m_island_tree.get_node(id).entity);
+void broadphase_main::raycast_procedural(vector3 p0, vector3 p1, Func func) {
+    m_tree.raycast(p0, p1, [&] (tree_node_id_t id) {
+        func(m_tree.get_node(id).entity);
     });
 }
 
@@ -79,6 +98,12 @@ void broadphase_main::raycast_non_procedural(vector3 p0, vector3 p1, Func func)
     });
 }
 
+template<typename Func>
+void broadphase_main::each_tree(Func func) const {
+    func(m_tree);
+    func(m_np_tree);
+}
+
 }
 
 #endif // EDYN_COLLISION_BROADPHASE_MAIN_HPP
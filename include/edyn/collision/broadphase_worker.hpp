@@ -1,11 +1,15 @@
 #ifndef EDYN_COLLISION_BROADPHASE_WORKER_HPP
 #define EDYN_COLLISION_BROADPHASE_WORKER_HPP
 
+#include <mutex>
+#include <atomic>
+#include <utility>
 #include <vector>
 #include <entt/entity/fwd.hpp>
 #include "edyn/comp/aabb.hpp"
 #include "edyn/util/entity_pair.hpp"
 #include "edyn/collision/dynamic_tree.hpp"
+#include "edyn/collision/hash_grid.hpp"
 #include "edyn/collision/contact_manifold_map.hpp"
 
 namespace edyn {
@@ -20,11 +24,15 @@ class broadphase_worker {
     constexpr static auto m_separation_threshold = contact_breaking_threshold * scalar(4 * 1.3);
 
     void init_new_aabb_entities();
+    void update_filter(dynamic_tree &tree, tree_node_id_t id, entt::entity entity);
 
-    void collide_tree(const dynamic_tree &tree, entt::entity entity, const AABB &offset_aabb);
-    void collide_tree_async(const dynamic_tree &tree, entt::entity entity, const AABB &offset_aabb, size_t result_index);
+    void collide_tree(const dynamic_tree &tree, tree_node_id_t id, const AABB &offset_aabb);
+    void collide_tree_async(const dynamic_tree &tree, tree_node_id_t id, const AABB &offset_aabb, size_t result_index);
 
     void common_update();
+    void update_procedural_tree() const;
+    void build_hash_grid();
+    void collide_grid_element(size_t index);
 
 public:
 
@@ -35,28 +43,47 @@ public:
     void finish_async_update();
 
     /**
-     * @brief Returns a view of the procedural dynamic tree.
-     * @return Tree view of the procedural dynamic tree.
+     * @brief Calls `func` with the entity of each node in the procedural and
+     * non-procedural AABB trees whose AABB intersects the segment.
      */
-    tree_view view() const;
-
     template<typename Func>
     void raycast(vector3 p0, vector3 p1, Func func);
 
+    /**
+     * @brief Calls `func` for the procedural and the non-procedural AABB
+     * trees. Signature `void(const dynamic_tree &)`.
+     */
+    template<typename Func>
+    void each_tree(Func func) const;
+
     void on_construct_aabb(entt::registry &, entt::entity);
+    void on_update_aabb(entt::registry &, entt::entity);
     void on_destroy_tree_resident(entt::registry &, entt::entity);
+    void on_update_collision_filter(entt::registry &, entt::entity);
+    void on_destroy_collision_filter(entt::registry &, entt::entity);
 
 private:
     entt::registry *m_registry;
-    dynamic_tree m_tree; // Procedural dynamic tree.
+
+    // Procedural dynamic tree. When the hashed grid is used for pair finding,
+    // the AABBs of the procedural nodes are only updated in the tree before
+    // it is queried, since moving all nodes in every step is wasteful.
+    mutable dynamic_tree m_tree;
+    mutable std::atomic<bool> m_tree_outdated {false};
+    mutable std::mutex m_tree_mutex;
+
     dynamic_tree m_np_tree; // Non-procedural dynamic tree.
     contact_manifold_map m_manifold_map;
     std::vector<entt::entity> m_new_aabb_entities;
     std::vector<entity_pair_vector> m_pair_results;
+    hash_grid m_grid; // Used instead of the procedural tree for pair finding if enabled in settings.
+    std::vector<tree_node_id_t> m_grid_nodes;
+    std::vector<AABB> m_grid_aabbs;
 };
 
 template<typename Func>
 void broadphase_worker::raycast(vector3 p0, vector3 p1, Func func) {
+    update_procedural_tree();
     m_tree.raycast(p0, p1, [&] (tree_node_id_t id) {
         func(m_tree.get_node(id).entity);
     });
@@ -65,6 +92,13 @@ void broadphase_worker::raycast(vector3 p0, vector3 p1, Func func) {
     });
 }
 
+template<typename Func>
+void broadphase_worker::each_tree(Func func) const {
+    update_procedural_tree();
+    func(std::as_const(m_tree));
+    func(m_np_tree);
+}
+
 }
 
 #endif // EDYN_COLLISION_BROADPHASE_WORKER_HPP
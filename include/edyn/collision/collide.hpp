@@ -3,6 +3,7 @@
 
 #include "edyn/shapes/shapes.hpp"
 #include "edyn/collision/collision_result.hpp"
+#include "edyn/collision/collision_cache.hpp"
 #include "edyn/util/aabb_util.hpp"
 #include "edyn/util/tuple_util.hpp"
 
@@ -19,10 +20,18 @@ struct collision_context {
 
     scalar threshold;
 
+    // Persistent state of the pair of shapes being tested. Only set for the
+    // top-level shapes of a contact manifold thus it must be reset when
+    // creating a context for child shapes.
+    collision_cache *cache {nullptr};
+
+    // The cache is kept in the swapped context. A pair of shape types is
+    // always swapped the same way, thus the state stored by the swapped
+    // `collide` is consistently in the object space of its own shape A.
     collision_context swapped() const {
         return {posB, ornB, aabbB,
                 posA, ornA, aabbA,
-                threshold};
+                threshold, cache};
     }
 };
 
@@ -222,6 +231,55 @@ void collide(const paged_mesh_shape &shA, const mesh_shape &shB,
     swap_collide(shA, shB, ctx, result);
 }
 
+// Heightfield-Heightfield
+inline
+void collide(const heightfield_shape &shA, const heightfield_shape &shB,
+             const collision_context &ctx, collision_result &result) {
+    // collision between heightfields is undefined.
+}
+
+// Plane-Heightfield
+inline
+void collide(const plane_shape &shA, const heightfield_shape &shB,
+             const collision_context &ctx, collision_result &result) {
+    // collision between heightfields and planes is undefined.
+}
+
+// Heightfield-Plane
+inline
+void collide(const heightfield_shape &shA, const plane_shape &shB,
+             const collision_context &ctx, collision_result &result) {
+    swap_collide(shA, shB, ctx, result);
+}
+
+// Mesh-Heightfield
+inline
+void collide(const mesh_shape &shA, const heightfield_shape &shB,
+             const collision_context &ctx, collision_result &result) {
+    // collision between triangle meshes and heightfields is undefined.
+}
+
+// Heightfield-Mesh
+inline
+void collide(const heightfield_shape &shA, const mesh_shape &shB,
+             const collision_context &ctx, collision_result &result) {
+    swap_collide(shA, shB, ctx, result);
+}
+
+// Paged Mesh-Heightfield
+inline
+void collide(const paged_mesh_shape &shA, const heightfield_shape &shB,
+             const collision_context &ctx, collision_result &result) {
+    // collision between paged triangle meshes and heightfields is undefined.
+}
+
+// Heightfield-Paged Mesh
+inline
+void collide(const heightfield_shape &shA, const paged_mesh_shape &shB,
+             const collision_context &ctx, collision_result &result) {
+    swap_collide(shA, shB, ctx, result);
+}
+
 // Polyhedron-Polyhedron
 void collide(const polyhedron_shape &shA, const polyhedron_shape &shB,
              const collision_context &ctx, collision_result &result);
@@ -293,6 +351,7 @@ void collide(const compound_shape &shA, const T &shB,
         auto child_ctx = ctx;
         child_ctx.posA = to_world_space(nodeA.position, ctx.posA, ctx.ornA);
         child_ctx.ornA = ctx.ornA * nodeA.orientation;
+        child_ctx.cache = nullptr;
 
         collision_result child_result;
         collide(sh, shB, child_ctx, child_result);
@@ -340,8 +399,7 @@ void collide(const T &shA, const paged_mesh_shape &shB,
     };
     auto inset_aabb = ctx.aabbA.inset(inset);
 
-    shB.trimesh->visit_submeshes(inset_aabb, [&] (size_t mesh_idx) {
-        auto trimesh = shB.trimesh->get_submesh(mesh_idx);
+    shB.trimesh->visit_submeshes(inset_aabb, [&] (size_t, auto &trimesh) {
         collide(shA, *trimesh, ctx, result);
     });
 }
@@ -353,6 +411,33 @@ void collide(const paged_mesh_shape &shA, const T &shB,
     swap_collide(shA, shB, ctx, result);
 }
 
+// Box/Sphere/Cylinder/Capsule/Polyhedron/Compound-Heightfield
+template<typename T>
+void collide(const T &shA, const heightfield_shape &shB,
+             const collision_context &ctx, collision_result &result) {
+    constexpr auto inset = vector3 {
+        -contact_breaking_threshold,
+        -contact_breaking_threshold,
+        -contact_breaking_threshold
+    };
+    auto inset_aabb = ctx.aabbA.inset(inset);
+
+    // Collide with the triangles of each tile under the shape as a regular
+    // triangle mesh. Patches are only generated when the shape moves over a
+    // tile whose patch is not cached.
+    shB.field->visit_tiles(inset_aabb, [&] (size_t tile_idx) {
+        auto patch = get_heightfield_patch(shB.field, tile_idx);
+        collide(shA, *patch, ctx, result);
+    });
+}
+
+// Heightfield-Box/Sphere/Cylinder/Capsule/Polyhedron/Compound
+template<typename T>
+void collide(const heightfield_shape &shA, const T &shB,
+             const collision_context &ctx, collision_result &result) {
+    swap_collide(shA, shB, ctx, result);
+}
+
 template<typename ShapeAType, typename ShapeBType>
 void swap_collide(const ShapeAType &shA, const ShapeBType &shB,
                   const collision_context &ctx, collision_result &result) {
@@ -0,0 +1,143 @@
+#ifndef EDYN_COLLISION_COLLIDE_GJK_HPP
+#define EDYN_COLLISION_COLLIDE_GJK_HPP
+
+#include <type_traits>
+#include "edyn/shapes/sphere_shape.hpp"
+#include "edyn/shapes/box_shape.hpp"
+#include "edyn/shapes/cylinder_shape.hpp"
+#include "edyn/shapes/capsule_shape.hpp"
+#include "edyn/shapes/polyhedron_shape.hpp"
+#include "edyn/collision/gjk_epa.hpp"
+#include "edyn/collision/collide.hpp"
+#include "edyn/util/shape_util.hpp"
+
+namespace edyn {
+
+/**
+ * @brief Whether a shape is convex and has a support function which allows it
+ * to be collided using GJK/EPA.
+ */
+template<typename T>
+struct has_support_function : std::false_type {};
+
+template<> struct has_support_function<sphere_shape> : std::true_type {};
+template<> struct has_support_function<box_shape> : std::true_type {};
+template<> struct has_support_function<cylinder_shape> : std::true_type {};
+template<> struct has_support_function<capsule_shape> : std::true_type {};
+template<> struct has_support_function<polyhedron_shape> : std::true_type {};
+
+template<typename T>
+inline constexpr bool has_support_function_v = has_support_function<T>::value;
+
+// World space support points of convex shapes.
+inline vector3 shape_support_point(const sphere_shape &sh, const vector3 &pos,
+                                   const quaternion &, const vector3 &dir) {
+    auto len_sqr = length_sqr(dir);
+
+    if (len_sqr > EDYN_EPSILON) {
+        return pos + dir * (sh.radius / std::sqrt(len_sqr));
+    }
+
+    return pos + vector3_x * sh.radius;
+}
+
+inline vector3 shape_support_point(const box_shape &sh, const vector3 &pos,
+                                   const quaternion &orn, const vector3 &dir) {
+    return sh.support_point(pos, orn, dir);
+}
+
+inline vector3 shape_support_point(const cylinder_shape &sh, const vector3 &pos,
+                                   const quaternion &orn, const vector3 &dir) {
+    return cylinder_support_point(sh.radius, sh.half_length, pos, orn, dir);
+}
+
+inline vector3 shape_support_point(const capsule_shape &sh, const vector3 &pos,
+                                   const quaternion &orn, const vector3 &dir) {
+    auto vertices = sh.get_vertices(pos, orn);
+    auto &vertex = dot(vertices[0], dir) > dot(vertices[1], dir) ? vertices[0] : vertices[1];
+    return shape_support_point(sphere_shape{sh.radius}, vertex, orn, dir);
+}
+
+// The vertices of the rotated mesh are already in world space orientation.
+inline vector3 shape_support_point(const polyhedron_shape &sh, const vector3 &pos,
+                                   const quaternion &, const vector3 &dir) {
+    auto &vertices = sh.rotated->vertices;
+    return pos + vertices[sh.mesh->support_vertex_index(vertices, dir)];
+}
+
+/**
+ * @brief Generic collision detection between two convex shapes using GJK to
+ * find the closest points and EPA to find the penetration if they intersect.
+ * It generates one contact point per call, which are accumulated over time in
+ * the contact manifold. The last normal is stored in the collision cache and
+ * is used as the initial search direction in the next call.
+ */
+template<typename ShapeAType, typename ShapeBType>
+void collide_gjk(const ShapeAType &shA, const ShapeBType &shB,
+                 const collision_context &ctx, collision_result &result) {
+    static_assert(has_support_function_v<ShapeAType> && has_support_function_v<ShapeBType>);
+
+    // Calculate collision with shape A in the origin for better floating point
+    // precision. Position of shape B is modified accordingly.
+    const auto posA = vector3_zero;
+    const auto &ornA = ctx.ornA;
+    const auto posB = ctx.posB - ctx.posA;
+    const auto &ornB = ctx.ornB;
+    const auto threshold = ctx.threshold;
+
+    auto support = [&] (const vector3 &dir) {
+        auto pointA = shape_support_point(shA, posA, ornA, dir);
+        auto pointB = shape_support_point(shB, posB, ornB, -dir);
+        return support_vertex{pointA - pointB, pointA, pointB};
+    };
+
+    auto dir = posA - posB;
+
+    if (ctx.cache && ctx.cache->has_gjk_direction) {
+        dir = rotate(ornA, ctx.cache->gjk_direction);
+    }
+
+    auto gjk_res = gjk(support, dir, threshold);
+
+    if (gjk_res.beyond_max_distance) {
+        return;
+    }
+
+    vector3 pointA, pointB, normal;
+    scalar distance;
+
+    if (gjk_res.intersecting) {
+        auto epa_res = epa_result{};
+
+        if (!epa(support, gjk_res.simplex, epa_res)) {
+            return;
+        }
+
+        pointA = epa_res.pointA;
+        pointB = epa_res.pointB;
+        normal = epa_res.normal;
+        distance = -epa_res.depth;
+    } else {
+        pointA = gjk_res.pointA;
+        pointB = gjk_res.pointB;
+        normal = gjk_res.normal;
+        distance = gjk_res.distance;
+    }
+
+    if (ctx.cache) {
+        ctx.cache->gjk_direction = rotate(conjugate(ornA), normal);
+        ctx.cache->has_gjk_direction = true;
+    }
+
+    if (distance > threshold) {
+        return;
+    }
+
+    auto pivotA = to_object_space(pointA, posA, ornA);
+    auto pivotB = to_object_space(pointB, posB, ornB);
+    result.maybe_add_point({pivotA, pivotB, normal, distance, contact_normal_attachment::none});
+}
+
+}
+
+#endif // EDYN_COLLISION_COLLIDE_GJK_HPP
@@ -0,0 +1,65 @@
+#ifndef EDYN_COLLISION_COLLISION_CACHE_HPP
+#define EDYN_COLLISION_COLLISION_CACHE_HPP
+
+#include <array>
+#include "edyn/math/vector3.hpp"
+#include "edyn/math/quaternion.hpp"
+#include "edyn/comp/aabb.hpp"
+#include "edyn/collision/collision_result.hpp"
+
+namespace edyn {
+
+/**
+ * @brief Collision detection state of a contact manifold which is kept
+ * between steps to speed up collision detection of the same pair of shapes
+ * in the next step. It is local to the island worker where the manifold
+ * resides and is never shared.
+ */
+struct collision_cache {
+    // Position and orientation of B in the object space of A at the time
+    // `result` was calculated.
+    vector3 rel_position;
+    quaternion rel_orientation;
+
+    // Last collision result. Pivots are in object space and normals are in
+    // the object space of A, thus it remains valid as long as the relative
+    // transform does not change.
+    collision_result result;
+    bool has_result {false};
+
+    // Direction in the object space of A along which the shapes were found
+    // to be separated by more than the contact breaking threshold. If it still
+    // separates the shapes, the full separating axis test can be skipped.
+    vector3 separating_axis;
+    bool has_separating_axis {false};
+
+    // Last contact normal found by GJK/EPA in the object space of A, which is
+    // used as the initial search direction in the next step.
+    vector3 gjk_direction;
+    bool has_gjk_direction {false};
+
+    // Pivots on A of the points selected in the last contact reduction,
+    // which are preferred in the next reduction.
+    std::array<vector3, max_contacts> reduced_pivots;
+    size_t num_reduced_pivots {0};
+
+    // If one of the bodies is a paged triangle mesh, the region around the
+    // other body whose submeshes were last loaded synchronously and the
+    // number of evictions of the mesh before then. While the other body stays
+    // inside this region and nothing was evicted, they're still loaded.
+    AABB paged_mesh_resident_aabb;
+    size_t paged_mesh_num_evictions;
+    bool has_paged_mesh_resident_aabb {false};
+
+    void clear() {
+        has_result = false;
+        has_separating_axis = false;
+        has_gjk_direction = false;
+        num_reduced_pivots = 0;
+        has_paged_mesh_resident_aabb = false;
+    }
+};
+
+}
+
+#endif // EDYN_COLLISION_COLLISION_CACHE_HPP
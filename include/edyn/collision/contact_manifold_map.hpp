@@ -1,7 +1,9 @@
 #ifndef EDYN_COLLISION_CONTACT_MANIFOLD_MAP
 #define EDYN_COLLISION_CONTACT_MANIFOLD_MAP
 
-#include <map>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
 #include <utility>
 #include <entt/entity/fwd.hpp>
 #include "edyn/util/entity_pair.hpp"
@@ -10,6 +12,14 @@ namespace edyn {
 
 /**
  * @brief Maps a pair of entities to their contact manifold.
+ *
+ * Pairs are stored in a flat open-addressing hash table keyed on the 64-bit
+ * value formed by packing both entities in ascending order, thus the order of
+ * the entities in a pair does not matter. Collisions are resolved by linear
+ * probing and removals shift the following entries back, so that no
+ * tombstones are ever left behind. Lookups do not modify the table and can
+ * be performed concurrently as long as no manifold is created or destroyed
+ * at the same time.
  */
 class contact_manifold_map {
 public:
@@ -39,7 +49,21 @@ public:
     void on_destroy_contact_manifold(entt::registry &, entt::entity);
 
 private:
-    std::map<entity_pair, entt::entity> m_pair_map;
+    using key_type = uint64_t;
+    static constexpr key_type empty_key = ~key_type{0};
+    static constexpr size_t npos = SIZE_MAX;
+
+    static key_type make_key(entt::entity, entt::entity);
+    size_t home_slot(key_type) const;
+    size_t find(key_type) const;
+    void insert(key_type, entt::entity);
+    void erase(key_type);
+    void rehash(size_t capacity);
+
+    std::vector<key_type> m_keys;
+    std::vector<entt::entity> m_values;
+    size_t m_size {0};
+    unsigned m_shift {64};
 };
 
 }
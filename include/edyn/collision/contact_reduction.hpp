@@ -0,0 +1,39 @@
+#ifndef EDYN_COLLISION_CONTACT_REDUCTION_HPP
+#define EDYN_COLLISION_CONTACT_REDUCTION_HPP
+
+#include <vector>
+#include "edyn/collision/collision_result.hpp"
+
+namespace edyn {
+
+struct collision_cache;
+
+/**
+ * @brief Appends all points of a collision result to a list of candidates.
+ */
+inline void append_contact_points(const collision_result &result,
+                                  std::vector<collision_result::collision_point> &candidates) {
+    candidates.insert(candidates.end(), result.point.begin(),
+                      result.point.begin() + result.num_points);
+}
+
+/**
+ * @brief Selects the best set of contact points among many candidates, which
+ * are usually collected from the collisions of a shape against several
+ * triangles of a mesh. Unlike inserting points into a `collision_result` one
+ * at a time, the selection does not depend on the order of the candidates.
+ * The deepest point is selected first, followed by the point furthest from it
+ * and then the points which maximize the contact area.
+ * @param candidates Candidate points. The points already in `result` are
+ * appended to it, thus it's modified.
+ * @param result Collision result where the selected points are stored.
+ * @param cache Optional collision cache. The pivots of the points selected in
+ * the previous call are preferred to keep the manifold stable over time. The
+ * pivots of the new selection are stored in it.
+ */
+void reduce_contact_points(std::vector<collision_result::collision_point> &candidates,
+                           collision_result &result, collision_cache *cache);
+
+}
+
+#endif // EDYN_COLLISION_CONTACT_REDUCTION_HPP
@@ -61,6 +61,15 @@ public:
      */
     bool move(tree_node_id_t, const AABB &);
 
+    /**
+     * @brief Assigns the collision filter of the entity in a leaf node.
+     *
+     * @param id The node id.
+     * @param filter The entity's collision filter.
+     * @param has_exclusion Whether the entity has a collision exclusion list.
+     */
+    void set_filter(tree_node_id_t, const collision_filter &, bool has_exclusion);
+
     /**
      * @brief Destroys a node with the given id.
      *
@@ -89,6 +98,19 @@ public:
     template<typename Func>
     void raycast(vector3 p0, vector3 p1, Func func) const;
 
+    /**
+     * @brief Traverses the tree with a packet of queries at once.
+     * @param num_queries Number of queries in the packet, at most
+     * `max_tree_packet_size`.
+     * @param test_func Function with signature
+     * `bool(const tree_node &, size_t)` which checks whether a query with the
+     * given index in the packet intersects a node.
+     * @param visit_func Function to be called for each leaf node that passes
+     * the test for a query, with signature `void(tree_node_id_t, size_t)`.
+     */
+    template<typename TestFunc, typename VisitFunc>
+    void traverse_packet(size_t num_queries, TestFunc test_func, VisitFunc visit_func) const;
+
     /**
      * @brief Gets a tree node.
      *
@@ -97,12 +119,23 @@ public:
      */
     const tree_node & get_node(tree_node_id_t) const;
 
+    /**
+     * @brief Gets the collision filter of the entity in a leaf node.
+     *
+     * @param id The leaf node id.
+     * @return A reference to the leaf filter.
+     */
+    const tree_leaf_filter & get_filter(tree_node_id_t) const;
+
     tree_view view() const;
 
 private:
     tree_node_id_t m_root;
 
     std::vector<tree_node> m_nodes;
+    // Leaf filters indexed by node id, parallel to `m_nodes`. Only meaningful
+    // for leaf nodes.
+    std::vector<tree_leaf_filter> m_filters;
     tree_node_id_t m_free_list;
 };
 
@@ -116,6 +149,11 @@ void dynamic_tree::raycast(vector3 p0, vector3 p1, Func func) const {
     raycast_tree(*this, m_root, null_tree_node_id, p0, p1, func);
 }
 
+template<typename TestFunc, typename VisitFunc>
+void dynamic_tree::traverse_packet(size_t num_queries, TestFunc test_func, VisitFunc visit_func) const {
+    traverse_tree_packet(*this, m_root, null_tree_node_id, num_queries, test_func, visit_func);
+}
+
 }
 
 #endif // EDYN_COLLISION_DYNAMIC_TREE_HPP
@@ -0,0 +1,356 @@
+#ifndef EDYN_COLLISION_GJK_EPA_HPP
+#define EDYN_COLLISION_GJK_EPA_HPP
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <initializer_list>
+#include "edyn/math/vector3.hpp"
+#include "edyn/math/constants.hpp"
+
+namespace edyn {
+
+/**
+ * @brief A vertex of the Minkowski difference `A - B` along with the support
+ * points on A and B that generated it.
+ */
+struct support_vertex {
+    vector3 point;
+    vector3 pointA;
+    vector3 pointB;
+};
+
+/**
+ * @brief Simplex used by GJK. The weights are the barycentric coordinates of
+ * the point in the simplex that's closest to the origin.
+ */
+struct gjk_simplex {
+    std::array<support_vertex, 4> vertices;
+    std::array<scalar, 4> weights;
+    size_t size {0};
+
+    void add(const support_vertex &vertex) {
+        vertices[size++] = vertex;
+    }
+};
+
+/**
+ * @brief Finds the point in the simplex that's closest to the origin and
+ * reduces the simplex to the smallest subset of vertices which contains it.
+ * The weights of the remaining vertices are updated.
+ * @param simplex A simplex with 1 to 4 vertices.
+ * @return Closest point to the origin. It is zero if the origin is contained
+ * in the simplex, in which case no vertices are removed.
+ */
+vector3 gjk_solve_simplex(gjk_simplex &simplex);
+
+struct gjk_result {
+    // Whether the shapes are intersecting, in which case the other values are
+    // not meaningful and EPA must be used to find the penetration.
+    bool intersecting {false};
+    // Whether the shapes are known to be separated by more than the maximum
+    // distance, in which case the other values are not meaningful.
+    bool beyond_max_distance {false};
+    // Closest points on A and B.
+    vector3 pointA;
+    vector3 pointB;
+    // Direction from B to A.
+    vector3 normal;
+    scalar distance;
+    gjk_simplex simplex;
+};
+
+inline constexpr size_t gjk_max_iterations = 64;
+inline constexpr auto gjk_relative_tolerance = scalar(1e-5);
+inline constexpr auto gjk_intersection_tolerance = scalar(1e-10);
+inline constexpr auto gjk_degenerate_tolerance = scalar(1e-4);
+
+/**
+ * @brief Finds the closest points between two convex shapes using the
+ * Gilbert-Johnson-Keerthi algorithm.
+ * @param support Support function of the Minkowski difference `A - B` with
+ * signature `support_vertex(const vector3 &dir)`.
+ * @param dir Initial search direction. Ideally, it points from B to A. The
+ * last normal is a good choice when collision is performed between the same
+ * shapes repeatedly.
+ * @param max_distance Stops early if the shapes are found to be separated by
+ * more than this amount.
+ * @return GJK result.
+ */
+template<typename SupportFunc>
+gjk_result gjk(SupportFunc support, vector3 dir, scalar max_distance) {
+    auto result = gjk_result{};
+    auto &simplex = result.simplex;
+
+    if (length_sqr(dir) < EDYN_EPSILON) {
+        dir = vector3_x;
+    }
+
+    simplex.add(support(-dir));
+    simplex.weights[0] = 1;
+    auto v = simplex.vertices[0].point;
+
+    for (size_t i = 0; i < gjk_max_iterations; ++i) {
+        auto v_len_sqr = length_sqr(v);
+
+        if (v_len_sqr < gjk_intersection_tolerance) {
+            result.intersecting = true;
+            return result;
+        }
+
+        auto w = support(-v);
+        auto proj = dot(v, w.point);
+
+        // The support plane separates the shapes by more than the max
+        // distance, thus their closest points are even further apart.
+        if (proj > 0 && proj * proj > max_distance * max_distance * v_len_sqr) {
+            result.beyond_max_distance = true;
+            return result;
+        }
+
+        // No significant progress can be made, thus `v` is the closest point.
+        if (v_len_sqr - proj <= gjk_relative_tolerance * v_len_sqr) {
+            break;
+        }
+
+        // A vertex that's already in the simplex also indicates that no
+        // progress can be made, which happens due to rounding errors.
+        auto duplicate = false;
+
+        for (size_t j = 0; j < simplex.size; ++j) {
+            if (distance_sqr(simplex.vertices[j].point, w.point) < gjk_intersection_tolerance) {
+                duplicate = true;
+                break;
+            }
+        }
+
+        if (duplicate) {
+            break;
+        }
+
+        simplex.add(w);
+        v = gjk_solve_simplex(simplex);
+
+        if (simplex.size == 4) {
+            result.intersecting = true;
+            return result;
+        }
+    }
+
+    result.pointA = result.pointB = vector3_zero;
+
+    for (size_t i = 0; i < simplex.size; ++i) {
+        result.pointA += simplex.vertices[i].pointA * simplex.weights[i];
+        result.pointB += simplex.vertices[i].pointB * simplex.weights[i];
+    }
+
+    result.distance = length(v);
+
+    if (result.distance > EDYN_EPSILON) {
+        result.normal = v / result.distance;
+    } else {
+        result.intersecting = true;
+    }
+
+    return result;
+}
+
+inline constexpr size_t epa_max_iterations = 64;
+inline constexpr auto epa_tolerance = scalar(1e-4);
+
+// One vertex is added to the initial tetrahedron per iteration. A closed
+// triangulated polytope with `V` vertices has `2V - 4` faces and `3V - 6`
+// edges, which bounds the number of horizon edges.
+inline constexpr size_t epa_max_vertices = epa_max_iterations + 4;
+inline constexpr size_t epa_max_faces = epa_max_vertices * 2 - 4;
+inline constexpr size_t epa_max_horizon_edges = epa_max_vertices * 3 - 6;
+
+/**
+ * @brief Convex polytope which is expanded towards the boundary of the
+ * Minkowski difference during EPA. Storage has a fixed capacity which is
+ * enough for `epa_max_iterations` expansions, thus no memory is allocated.
+ */
+struct epa_polytope {
+    struct face {
+        std::array<uint16_t, 3> vertices;
+        vector3 normal;
+        scalar distance;
+    };
+
+    std::array<support_vertex, epa_max_vertices> vertices;
+    std::array<face, epa_max_faces> faces;
+    size_t num_vertices {0};
+    size_t num_faces {0};
+
+    /**
+     * @brief Initializes the polytope with a tetrahedron containing the origin.
+     * @return False if the tetrahedron is degenerate.
+     */
+    bool init(const std::array<support_vertex, 4> &tetrahedron);
+
+    /**
+     * @brief Returns the index of the face that's closest to the origin.
+     */
+    size_t closest_face() const;
+
+    /**
+     * @brief Adds a new vertex, removing all faces that can be seen from it
+     * and connecting it to the resulting horizon.
+     * @return False if the expansion failed due to numerical issues or if the
+     * capacity of the polytope was reached.
+     */
+    bool expand(const support_vertex &vertex);
+};
+
+struct epa_result {
+    // Closest points on the boundary of A and B.
+    vector3 pointA;
+    vector3 pointB;
+    // Direction along which A must move to resolve the penetration.
+    vector3 normal;
+    // Penetration depth.
+    scalar depth;
+};
+
+/**
+ * @brief Tries to turn the simplex into a tetrahedron containing the origin
+ * by adding support vertices along directions which are not spanned by it.
+ * @return False if the Minkowski difference is degenerate.
+ */
+template<typename SupportFunc>
+bool epa_complete_simplex(SupportFunc support, gjk_simplex &simplex) {
+    constexpr auto tolerance = scalar(1e-6);
+    const std::array<vector3, 6> axes {
+        vector3_x, -vector3_x, vector3_y, -vector3_y, vector3_z, -vector3_z
+    };
+
+    if (simplex.size == 1) {
+        for (auto &axis : axes) {
+            auto w = support(axis);
+
+            if (distance_sqr(w.point, simplex.vertices[0].point) > tolerance) {
+                simplex.add(w);
+                break;
+            }
+        }
+
+        if (simplex.size < 2) {
+            return false;
+        }
+    }
+
+    if (simplex.size == 2) {
+        auto d = simplex.vertices[1].point - simplex.vertices[0].point;
+
+        for (auto &axis : axes) {
+            auto dir = cross(d, axis);
+
+            if (length_sqr(dir) < tolerance) {
+                continue;
+            }
+
+            auto w = support(dir);
+            auto ratio = length_sqr(cross(w.point - simplex.vertices[0].point, d));
+
+            if (ratio > tolerance * length_sqr(d)) {
+                simplex.add(w);
+                break;
+            }
+        }
+
+        if (simplex.size < 3) {
+            return false;
+        }
+    }
+
+    if (simplex.size == 3) {
+        auto &v0 = simplex.vertices[0].point;
+        auto normal = cross(simplex.vertices[1].point - v0, simplex.vertices[2].point - v0);
+
+        for (auto dir : {normal, -normal}) {
+            auto w = support(dir);
+
+            if (std::abs(dot(w.point - v0, normal)) > tolerance * length(normal)) {
+                simplex.add(w);
+                break;
+            }
+        }
+    }
+
+    return simplex.size == 4;
+}
+
+/**
+ * @brief Finds the penetration between two intersecting convex shapes using
+ * the Expanding Polytope Algorithm.
+ * @param support Support function of the Minkowski difference `A - B`.
+ * @param simplex Simplex containing the origin, as returned by `gjk`.
+ * @param result Penetration information.
+ * @return False if the penetration could not be determined.
+ */
+template<typename SupportFunc>
+bool epa(SupportFunc support, gjk_simplex simplex, epa_result &result) {
+    if (!epa_complete_simplex(support, simplex)) {
+        return false;
+    }
+
+    // Default initialized to avoid zeroing the storage.
+    epa_polytope polytope;
+
+    if (!polytope.init(simplex.vertices)) {
+        return false;
+    }
+
+    // The closest face is copied since a failed expansion might have already
+    // removed it from the polytope, in which case it remains the result.
+    auto face = polytope.faces[polytope.closest_face()];
+
+    for (size_t i = 0; i < epa_max_iterations; ++i) {
+        auto w = support(face.normal);
+
+        if (dot(w.point, face.normal) - face.distance < epa_tolerance) {
+            break;
+        }
+
+        if (!polytope.expand(w)) {
+            break;
+        }
+
+        face = polytope.faces[polytope.closest_face()];
+    }
+
+    auto &v0 = polytope.vertices[face.vertices[0]];
+    auto &v1 = polytope.vertices[face.vertices[1]];
+    auto &v2 = polytope.vertices[face.vertices[2]];
+
+    // Barycentric coordinates of the projection of the origin on the face.
+    auto p = face.normal * face.distance;
+    auto e0 = v1.point - v0.point;
+    auto e1 = v2.point - v0.point;
+    auto e2 = p - v0.point;
+    auto d00 = dot(e0, e0);
+    auto d01 = dot(e0, e1);
+    auto d11 = dot(e1, e1);
+    auto d20 = dot(e2, e0);
+    auto d21 = dot(e2, e1);
+    auto denom = d00 * d11 - d01 * d01;
+    scalar b0 = 1, b1 = 0, b2 = 0;
+
+    // Use the first vertex if the face is too thin.
+    if (std::abs(denom) > EDYN_EPSILON * d00 * d11) {
+        b1 = (d11 * d20 - d01 * d21) / denom;
+        b2 = (d00 * d21 - d01 * d20) / denom;
+        b0 = scalar(1) - b1 - b2;
+    }
+
+    result.pointA = v0.pointA * b0 + v1.pointA * b1 + v2.pointA * b2;
+    result.pointB = v0.pointB * b0 + v1.pointB * b1 + v2.pointB * b2;
+    result.normal = -face.normal;
+    result.depth = face.distance;
+
+    return true;
+}
+
+}
+
+#endif // EDYN_COLLISION_GJK_EPA_HPP
@@ -0,0 +1,182 @@
+#ifndef EDYN_COLLISION_HASH_GRID_HPP
+#define EDYN_COLLISION_HASH_GRID_HPP
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "edyn/comp/aabb.hpp"
+
+namespace edyn {
+
+/**
+ * @brief Uniform hashed grid for broad-phase collision detection among
+ * elements of similar size.
+ *
+ * The grid is rebuilt from scratch on every call to `build`. The cell size is
+ * the median of the largest dimension of all AABBs. Each element is inserted
+ * in all cells it overlaps, which are identified by a 64-bit key formed by
+ * packing the integer cell coordinates. The entries are then sorted by key
+ * and candidate pairs are generated among elements sharing the same cell.
+ * Elements which would span too many cells are not inserted in the grid.
+ * Instead, they're listed as _large elements_ and must be handled separately.
+ */
+class hash_grid {
+public:
+    using index_type = uint32_t;
+    using key_type = uint64_t;
+
+    // Maximum number of cells an element can overlap before it's considered
+    // large. Elements up to twice the cell size fit in 3x3x3 cells.
+    static constexpr size_t max_cells_per_element = 27;
+
+    /**
+     * @brief Rebuilds the grid with the given AABBs. Elements are identified
+     * by their index in the array.
+     * @param aabbs AABBs of all elements.
+     */
+    void build(const std::vector<AABB> &aabbs);
+
+    /**
+     * @brief Calls `func` once for each pair of elements inserted in the grid
+     * whose AABBs intersect.
+     * @tparam Func Inferred function parameter type.
+     * @param aabbs The same AABBs used in the last call to `build`.
+     * @param func Function with signature `void(index_type, index_type)`.
+     */
+    template<typename Func>
+    void each_pair(const std::vector<AABB> &aabbs, Func func) const;
+
+    /**
+     * @brief Calls `func` for each element inserted in the grid whose AABB
+     * intersects that of the element at `index` and which has a greater
+     * index. Calling it for all elements reports the same pairs as
+     * `each_pair`. Can be called concurrently for different elements.
+     * @tparam Func Inferred function parameter type.
+     * @param index Index of an element which is not large.
+     * @param aabbs The same AABBs used in the last call to `build`.
+     * @param func Function with signature `void(index_type, index_type)`.
+     */
+    template<typename Func>
+    void each_pair_of(index_type index, const std::vector<AABB> &aabbs, Func func) const;
+
+    /**
+     * @brief Whether the element at `index` was not inserted in the grid in
+     * the last call to `build` because it spans too many cells.
+     * @param index Element index.
+     * @return Whether the element is large.
+     */
+    bool is_large(index_type index) const {
+        return m_offsets[index] == m_offsets[index + 1];
+    }
+
+    /**
+     * @brief Indices of elements that span too many cells and were not
+     * inserted in the grid.
+     * @return Array of element indices.
+     */
+    const std::vector<index_type> & large_elements() const {
+        return m_large_elements;
+    }
+
+    /**
+     * @brief Cell size used in the last call to `build`.
+     * @return Cell size.
+     */
+    scalar cell_size() const {
+        return m_cell_size;
+    }
+
+private:
+    struct entry {
+        key_type key;
+        index_type index;
+    };
+
+    static bool entry_less(const entry &lhs, const entry &rhs) {
+        return lhs.key < rhs.key || (lhs.key == rhs.key && lhs.index < rhs.index);
+    }
+
+    key_type cell_key(const vector3 &point) const;
+
+    // Assigns the keys of all cells overlapped by the AABB of an element which
+    // is not large and returns the number of cells.
+    size_t cell_keys(const AABB &aabb, std::array<key_type, max_cells_per_element> &keys) const;
+
+    scalar m_cell_size {1};
+    scalar m_cell_size_inv {1};
+    std::vector<entry> m_entries;
+    std::vector<size_t> m_offsets;
+    std::vector<scalar> m_sizes;
+    std::vector<index_type> m_large_elements;
+};
+
+template<typename Func>
+void hash_grid::each_pair(const std::vector<AABB> &aabbs, Func func) const {
+    auto num_entries = m_entries.size();
+    size_t begin = 0;
+
+    while (begin < num_entries) {
+        auto key = m_entries[begin].key;
+        auto end = begin + 1;
+
+        while (end < num_entries && m_entries[end].key == key) {
+            ++end;
+        }
+
+        for (auto i = begin; i < end; ++i) {
+            auto idxA = m_entries[i].index;
+            auto &aabbA = aabbs[idxA];
+
+            for (auto j = i + 1; j < end; ++j) {
+                auto idxB = m_entries[j].index;
+                auto &aabbB = aabbs[idxB];
+
+                if (!intersect(aabbA, aabbB)) {
+                    continue;
+                }
+
+                // Elements can share more than one cell. Only report the pair
+                // in the cell that contains the minimum of the intersection,
+                // which is unique.
+                if (cell_key(max(aabbA.min, aabbB.min)) == key) {
+                    func(idxA, idxB);
+                }
+            }
+        }
+
+        begin = end;
+    }
+}
+
+template<typename Func>
+void hash_grid::each_pair_of(index_type index, const std::vector<AABB> &aabbs, Func func) const {
+    if (is_large(index)) {
+        return;
+    }
+
+    auto &aabbA = aabbs[index];
+    auto keys = std::array<key_type, max_cells_per_element>{};
+    auto num_keys = cell_keys(aabbA, keys);
+
+    for (size_t k = 0; k < num_keys; ++k) {
+        auto key = keys[k];
+
+        // Entries in a cell are sorted by index, thus start right after the
+        // entry of this element.
+        auto it = std::upper_bound(m_entries.begin(), m_entries.end(), entry{key, index}, entry_less);
+
+        for (; it != m_entries.end() && it->key == key; ++it) {
+            auto &aabbB = aabbs[it->index];
+
+            // Same rule as in `each_pair` to report the pair only once.
+            if (intersect(aabbA, aabbB) && cell_key(max(aabbA.min, aabbB.min)) == key) {
+                func(index, it->index);
+            }
+        }
+    }
+}
+
+}
+
+#endif // EDYN_COLLISION_HASH_GRID_HPP
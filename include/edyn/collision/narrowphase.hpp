@@ -2,6 +2,8 @@
 #define EDYN_COLLISION_NARROWPHASE_HPP
 
 #include <array>
+#include <atomic>
+#include <memory>
 #include <entt/entity/fwd.hpp>
 #include "edyn/comp/aabb.hpp"
 #include "edyn/comp/center_of_mass.hpp"
@@ -11,8 +13,10 @@
 #include "edyn/collision/contact_manifold.hpp"
 #include "edyn/collision/contact_point.hpp"
 #include "edyn/collision/collision_result.hpp"
+#include "edyn/collision/collision_cache.hpp"
 #include "edyn/constraints/constraint_impulse.hpp"
 #include "edyn/util/collision_util.hpp"
+#include "edyn/context/settings.hpp"
 
 namespace edyn {
 
@@ -31,6 +35,8 @@ class narrowphase {
 
     void add_new_contact_point(entt::entity contact_entity,
                                std::array<entt::entity, 2> body);
+    void assign_collision_caches();
+    void prefetch_paged_meshes();
 
 public:
     narrowphase(entt::registry &);
@@ -64,6 +70,9 @@ private:
     std::vector<contact_point_construction_info> m_cp_construction_infos;
     std::vector<contact_point_destruction_info> m_cp_destruction_infos;
     std::vector<entt::entity> m_new_contact_points;
+    // Whether the last job which prefetches paged mesh submeshes is still
+    // running. Shared with the job since it might outlive this object.
+    std::shared_ptr<std::atomic<bool>> m_prefetch_pending;
 };
 
 template<typename Iterator>
@@ -81,12 +90,14 @@ void narrowphase::update_contact_manifolds(Iterator begin, Iterator end,
     auto cp_view = m_registry->view<contact_point>();
     auto imp_view = m_registry->view<constraint_impulse>();
     auto views_tuple = get_tuple_of_shape_views(*m_registry);
+    auto &gjk_shape_pairs = m_registry->ctx<const settings>().gjk_shape_pairs;
 
     for (auto it = begin; it != end; ++it) {
         entt::entity manifold_entity = *it;
         auto &manifold = std::get<0>(manifold_view.get(manifold_entity));
+        auto &cache = m_registry->get_or_emplace<collision_cache>(manifold_entity);
         collision_result result;
-        detect_collision(manifold.body, result, body_view, com_view, views_tuple);
+        detect_collision(manifold.body, result, body_view, com_view, views_tuple, cache, gjk_shape_pairs);
 
         process_collision(manifold_entity, manifold, result, cp_view, imp_view, tr_view, com_view,
                           [&] (const collision_result::collision_point &rp) {
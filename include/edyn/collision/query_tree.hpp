@@ -1,11 +1,61 @@
 #ifndef EDYN_COLLISION_QUERY_TREE_HPP
 #define EDYN_COLLISION_QUERY_TREE_HPP
 
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include "edyn/config/config.h"
 #include "edyn/comp/aabb.hpp"
 #include "edyn/math/geom.hpp"
 
 namespace edyn {
 
+namespace detail {
+
+/**
+ * @brief Stack of nodes pending a visit in a tree traversal. The first `N`
+ * entries are stored inline, which is enough for the depth of a balanced
+ * tree, thus it only allocates for degenerate trees.
+ */
+template<typename T, size_t N = 64>
+class traversal_stack {
+public:
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    void push(const T &value) {
+        if (m_size < N) {
+            m_inline[m_size] = value;
+        } else {
+            m_overflow.push_back(value);
+        }
+
+        ++m_size;
+    }
+
+    T pop() {
+        EDYN_ASSERT(m_size > 0);
+        --m_size;
+
+        if (m_size < N) {
+            return m_inline[m_size];
+        }
+
+        auto value = m_overflow.back();
+        m_overflow.pop_back();
+        return value;
+    }
+
+private:
+    std::array<T, N> m_inline;
+    std::vector<T> m_overflow;
+    size_t m_size {0};
+};
+
+}
+
 template<typename Tree, typename NodeIdType, typename TestFunc, typename VisitFunc>
 void traverse_tree(const Tree &tree, NodeIdType root_id, NodeIdType null_node_id,
                    TestFunc test_func, VisitFunc visit_func) {
@@ -20,7 +70,7 @@ void traverse_tree(const Tree &tree, NodeIdType root_id, NodeIdType null_node_id
             continue;
         }
 
-        auto &node = tree.get_node(id);
+        const auto &node = tree.get_node(id);
 
         if (test_func(node)) {
             if (node.leaf()) {
@@ -33,6 +83,109 @@ void traverse_tree(const Tree &tree, NodeIdType root_id, NodeIdType null_node_id
     }
 }
 
+/**
+ * @brief Traverses two trees simultaneously and visits all pairs of leaves
+ * for which the test passes. The larger node of each pair is descended first,
+ * thus subtrees that do not overlap are skipped as early as possible.
+ * @param test_func Function with signature `bool(const nodeA &, const nodeB &)`.
+ * @param visit_func Function with signature `void(NodeIdType, NodeIdType)`.
+ */
+template<typename TreeA, typename TreeB, typename NodeIdType, typename TestFunc, typename VisitFunc>
+void traverse_tree_pair(const TreeA &treeA, NodeIdType rootA_id,
+                        const TreeB &treeB, NodeIdType rootB_id,
+                        NodeIdType null_node_id,
+                        TestFunc test_func, VisitFunc visit_func) {
+    // Each step replaces a pair by two pairs one level deeper in one of the
+    // trees, thus the stack grows with the sum of the depths of the trees.
+    auto stack = detail::traversal_stack<std::pair<NodeIdType, NodeIdType>>{};
+    stack.push({rootA_id, rootB_id});
+
+    while (!stack.empty()) {
+        auto [idA, idB] = stack.pop();
+
+        if (idA == null_node_id || idB == null_node_id) {
+            continue;
+        }
+
+        const auto &nodeA = treeA.get_node(idA);
+        const auto &nodeB = treeB.get_node(idB);
+
+        if (!test_func(nodeA, nodeB)) {
+            continue;
+        }
+
+        if (nodeA.leaf() && nodeB.leaf()) {
+            visit_func(idA, idB);
+        } else if (nodeB.leaf() || (!nodeA.leaf() && nodeA.aabb.area() > nodeB.aabb.area())) {
+            stack.push({nodeA.child1, idB});
+            stack.push({nodeA.child2, idB});
+        } else {
+            stack.push({idA, nodeB.child1});
+            stack.push({idA, nodeB.child2});
+        }
+    }
+}
+
+// Maximum number of queries in a packet, which are tracked as bits in a mask.
+inline constexpr size_t max_tree_packet_size = 64;
+
+/**
+ * @brief Traverses a tree with a packet of queries at once and visits the
+ * leaves which pass the test for each query. Every node is fetched once for
+ * all queries that reach it rather than once per query, which pays off when
+ * the queries are spatially coherent.
+ * @param num_queries Number of queries in the packet, which must not exceed
+ * `max_tree_packet_size`.
+ * @param test_func Function with signature `bool(const node &, size_t)`, where
+ * the second argument is the index of the query in the packet.
+ * @param visit_func Function with signature `void(NodeIdType, size_t)`.
+ */
+template<typename Tree, typename NodeIdType, typename TestFunc, typename VisitFunc>
+void traverse_tree_packet(const Tree &tree, NodeIdType root_id, NodeIdType null_node_id,
+                          size_t num_queries, TestFunc test_func, VisitFunc visit_func) {
+    EDYN_ASSERT(num_queries <= max_tree_packet_size);
+
+    if (num_queries == 0) {
+        return;
+    }
+
+    // Each stack entry holds a node and a mask with the bits of the queries
+    // that reached it set.
+    struct entry {
+        NodeIdType id;
+        uint64_t mask;
+    };
+
+    auto stack = detail::traversal_stack<entry>{};
+    stack.push({root_id, ~uint64_t{0} >> (max_tree_packet_size - num_queries)});
+
+    while (!stack.empty()) {
+        auto [id, mask] = stack.pop();
+
+        if (id == null_node_id) {
+            continue;
+        }
+
+        const auto &node = tree.get_node(id);
+        auto passed = uint64_t{0};
+
+        for (size_t i = 0; i < num_queries; ++i) {
+            if ((mask >> i & 1) && test_func(node, i)) {
+                if (node.leaf()) {
+                    visit_func(id, i);
+                } else {
+                    passed |= uint64_t{1} << i;
+                }
+            }
+        }
+
+        if (passed != 0) {
+            stack.push({node.child1, passed});
+            stack.push({node.child2, passed});
+        }
+    }
+}
+
 template<typename Tree, typename NodeIdType, typename Func>
 void query_tree(const Tree &tree, NodeIdType root_id, NodeIdType null_node_id,
                 const AABB &aabb, Func func) {
@@ -0,0 +1,182 @@
+#ifndef EDYN_COLLISION_QUERY_WORLD_HPP
+#define EDYN_COLLISION_QUERY_WORLD_HPP
+
+#include <array>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <entt/entity/fwd.hpp>
+#include "edyn/shapes/shapes.hpp"
+#include "edyn/collision/raycast.hpp"
+#include "edyn/collision/tree_view.hpp"
+#include "edyn/collision/shape_query.hpp"
+#include "edyn/util/raycast_util.hpp"
+
+namespace edyn {
+
+/**
+ * @brief An immutable copy of the data needed to run queries against the main
+ * registry, i.e. the broad-phase trees and the shape and transform of each
+ * entity in them. It does not reference the registry thus any number of
+ * threads can run queries on it simultaneously, while `edyn::update` runs.
+ * @remark Shapes are immutable and shared among worlds, thus a shape is only
+ * copied once after it is created or modified in the registry. Paged meshes
+ * are queried using the submeshes which are loaded at the time of the query.
+ */
+class query_world {
+public:
+    // Copy of the shape of each entity, shared among worlds.
+    using shape_cache_t = std::unordered_map<entt::entity, std::shared_ptr<const shapes_variant_t>>;
+
+    /**
+     * @brief Performs a raycast query.
+     * @param p0 First point in the ray.
+     * @param p1 Second point in the ray.
+     * @param filter Only entities whose collision filter collides with this
+     * filter can be hit.
+     * @return Raycast result.
+     */
+    raycast_result raycast(vector3 p0, vector3 p1, const collision_filter &filter = {}) const;
+
+    /*! @copydoc edyn::raycast_batch */
+    void raycast_batch(const std::vector<raycast_query> &queries,
+                       std::vector<raycast_result> &results,
+                       raycast_mode mode = raycast_mode::closest_hit) const;
+
+    /*! @copydoc edyn::overlap */
+    void overlap(const overlap_query &query, std::vector<entt::entity> &entities) const;
+
+    /*! @copydoc edyn::shape_cast */
+    shape_cast_result shape_cast(const shape_cast_query &query) const;
+
+    /**
+     * @brief Copies the current state of the main registry. Memory allocated
+     * in a previous update is reused.
+     * @param registry The main registry.
+     * @param shapes Shapes shared among worlds. Missing shapes are copied
+     * from the registry and inserted.
+     */
+    void update(entt::registry &registry, shape_cache_t &shapes);
+
+private:
+    struct body {
+        entt::entity entity;
+        std::shared_ptr<const shapes_variant_t> shape;
+        // Origin of shape, which differs from the position if the entity
+        // has a center of mass offset.
+        vector3 pos;
+        quaternion orn;
+    };
+
+    static constexpr auto null_body_index = UINT32_MAX;
+
+    template<typename Func>
+    void visit_candidates(const AABB &aabb, const collision_filter &filter, Func func) const;
+
+    void cast_packet(raycast_packet &packet, std::vector<raycast_candidate> &candidates,
+                     raycast_mode mode) const;
+
+    // Trees for procedural and non-procedural entities.
+    std::array<tree_view, 2> m_trees;
+    // Index of the body of each node in the trees.
+    std::array<std::vector<uint32_t>, 2> m_node_body;
+    std::vector<body> m_bodies;
+};
+
+/**
+ * @brief Holds the last published `query_world`. Readers in other threads
+ * keep a `std::shared_ptr` to it and acquire the current world whenever they
+ * need one, without ever accessing the registry. It remains valid after the
+ * query world is disabled, holding on to the last world that was published.
+ */
+class query_world_source {
+public:
+    /**
+     * @brief Returns the world that was last published. Safe to call from any
+     * thread.
+     * @return The last published world, or null if nothing was published yet.
+     */
+    std::shared_ptr<const query_world> acquire() const;
+
+private:
+    friend class query_world_buffer;
+
+    // Only accessed with the atomic operations for `std::shared_ptr`.
+    std::shared_ptr<const query_world> m_world;
+};
+
+/**
+ * @brief Holds two `query_world`s, one which is published and another which is
+ * updated with the state of the main registry after each `edyn::update` and
+ * then published in place of the former. A published world is never modified.
+ * A world that is still held by a reader is not reused; a new one is allocated
+ * in its place. Shapes are shared among worlds and copied again only when
+ * they're constructed, replaced or destroyed in the registry.
+ */
+class query_world_buffer {
+public:
+    query_world_buffer(entt::registry &);
+    ~query_world_buffer();
+    query_world_buffer(query_world_buffer &&) = default;
+
+    /**
+     * @brief Updates the back world and publishes it.
+     */
+    void publish();
+
+    /**
+     * @brief Returns the world that was last published.
+     * @return The last published world, or null if nothing was published yet.
+     */
+    std::shared_ptr<const query_world> acquire() const;
+
+    /**
+     * @brief Returns the source where worlds are published, which can be
+     * handed to other threads.
+     * @return The source of published worlds.
+     */
+    std::shared_ptr<const query_world_source> source() const {
+        return m_source;
+    }
+
+private:
+    void on_change_shape(entt::registry &, entt::entity);
+
+    entt::registry *m_registry;
+    std::shared_ptr<query_world_source> m_source;
+    std::shared_ptr<query_world> m_back;
+    query_world::shape_cache_t m_shapes;
+};
+
+/**
+ * @brief Enables publishing a `query_world` after each call to `edyn::update`.
+ * @param registry The main registry.
+ * @return The source where worlds are published. It can be handed to other
+ * threads, which can then acquire the latest world at any time.
+ */
+std::shared_ptr<const query_world_source> enable_query_world(entt::registry &registry);
+
+/**
+ * @brief Stops publishing a `query_world`. Worlds and sources still held by
+ * readers remain valid.
+ * @param registry The main registry.
+ */
+void disable_query_world(entt::registry &registry);
+
+/**
+ * @brief Returns the last published `query_world`. It accesses the registry
+ * thus it must be called in the thread which owns it. The returned world can
+ * be handed to other threads. Readers should hold on to a world only for the
+ * duration of a batch of queries, so its memory can be reused. Threads that
+ * need the latest world repeatedly should keep the `query_world_source`
+ * returned by `edyn::enable_query_world` instead.
+ * @param registry The main registry.
+ * @return The query world, or null if nothing was published yet or the query
+ * world is not enabled.
+ */
+std::shared_ptr<const query_world> get_query_world(const entt::registry &registry);
+
+}
+
+#endif // EDYN_COLLISION_QUERY_WORLD_HPP
@@ -1,10 +1,12 @@
 #ifndef EDYN_COLLISION_RAYCAST_HPP
 #define EDYN_COLLISION_RAYCAST_HPP
 
+#include <vector>
 #include <variant>
 #include <entt/entity/fwd.hpp>
 #include <entt/entity/entity.hpp>
 #include "edyn/math/vector3.hpp"
+#include "edyn/comp/collision_filter.hpp"
 #include "edyn/shapes/cylinder_shape.hpp"
 #include "edyn/shapes/capsule_shape.hpp"
 
@@ -17,6 +19,7 @@ struct compound_shape;
 struct plane_shape;
 struct mesh_shape;
 struct paged_mesh_shape;
+struct heightfield_shape;
 
 /**
  * @brief Info provided when raycasting a box.
@@ -72,6 +75,14 @@ struct paged_mesh_raycast_info {
     size_t triangle_index;
 };
 
+/**
+ * @brief Info provided when raycasting a heightfield.
+ */
+struct heightfield_raycast_info {
+    // Index of triangle the ray intersects.
+    size_t triangle_index;
+};
+
 /**
  * @brief Info provided when raycasting a compound.
  */
@@ -106,7 +117,8 @@ struct shape_raycast_result {
         polyhedron_raycast_info,
         compound_raycast_info,
         mesh_raycast_info,
-        paged_mesh_raycast_info
+        paged_mesh_raycast_info,
+        heightfield_raycast_info
     > info_var;
 };
 
@@ -143,6 +155,44 @@ struct raycast_context {
  */
 raycast_result raycast(entt::registry &registry, vector3 p0, vector3 p1);
 
+/**
+ * @brief A ray in a batch of raycast queries.
+ */
+struct raycast_query {
+    // First point in the ray.
+    vector3 p0;
+    // Second point in the ray.
+    vector3 p1;
+    // Only entities whose collision filter collides with this filter can be
+    // hit, according to `filters_collide`.
+    collision_filter filter;
+};
+
+/**
+ * @brief Determines which intersection is reported for each ray in a batch.
+ */
+enum class raycast_mode {
+    // The intersection closest to the first point of the ray.
+    closest_hit,
+    // Any intersection, which is not necessarily the closest. Faster, since
+    // the ray stops at the first hit. Useful for visibility checks.
+    any_hit
+};
+
+/**
+ * @brief Performs many raycast queries on a registry at once. The rays are
+ * sorted so that nearby rays with similar directions are processed together
+ * in packets, which traverse the broad-phase trees at once. The packets are
+ * processed in parallel in the global `edyn::job_dispatcher`.
+ * @param registry Data source.
+ * @param queries The rays.
+ * @param results The result of each query, in the same order as `queries`.
+ * @param mode Which intersection to report.
+ */
+void raycast_batch(entt::registry &registry, const std::vector<raycast_query> &queries,
+                   std::vector<raycast_result> &results,
+                   raycast_mode mode = raycast_mode::closest_hit);
+
 // Raycast functions for each shape.
 
 shape_raycast_result raycast(const box_shape &, const raycast_context &);
@@ -154,6 +204,7 @@ shape_raycast_result raycast(const compound_shape &, const raycast_context &);
 shape_raycast_result raycast(const plane_shape &, const raycast_context &);
 shape_raycast_result raycast(const mesh_shape &, const raycast_context &);
 shape_raycast_result raycast(const paged_mesh_shape &, const raycast_context &);
+shape_raycast_result raycast(const heightfield_shape &, const raycast_context &);
 
 }
 
@@ -0,0 +1,125 @@
+#ifndef EDYN_COLLISION_SHAPE_QUERY_HPP
+#define EDYN_COLLISION_SHAPE_QUERY_HPP
+
+#include <vector>
+#include <variant>
+#include <entt/entity/fwd.hpp>
+#include <entt/entity/entity.hpp>
+#include "edyn/math/vector3.hpp"
+#include "edyn/math/quaternion.hpp"
+#include "edyn/comp/collision_filter.hpp"
+#include "edyn/shapes/sphere_shape.hpp"
+#include "edyn/shapes/cylinder_shape.hpp"
+#include "edyn/shapes/capsule_shape.hpp"
+#include "edyn/shapes/box_shape.hpp"
+#include "edyn/shapes/polyhedron_shape.hpp"
+
+namespace edyn {
+
+/**
+ * @brief Convex shapes which can be used in shape queries. Polyhedrons only
+ * need a valid `mesh`, since the rotated mesh is not used.
+ */
+using query_shape_variant_t = std::variant<
+    sphere_shape,
+    cylinder_shape,
+    capsule_shape,
+    box_shape,
+    polyhedron_shape
+>;
+
+/**
+ * @brief Input for a query which finds all entities whose shapes intersect
+ * a shape placed at the given transform.
+ */
+struct overlap_query {
+    query_shape_variant_t shape;
+    vector3 pos;
+    quaternion orn;
+    // Only entities whose collision filter collides with this filter are
+    // tested, according to `filters_collide`.
+    collision_filter filter;
+};
+
+/**
+ * @brief Input for a query which sweeps a shape along a segment without
+ * rotating it and finds the first entity it hits.
+ */
+struct shape_cast_query {
+    query_shape_variant_t shape;
+    // Position of shape at the start of the sweep.
+    vector3 p0;
+    // Position of shape at the end of the sweep.
+    vector3 p1;
+    // Orientation of shape during the sweep.
+    quaternion orn;
+    // Only entities whose collision filter collides with this filter can be
+    // hit, according to `filters_collide`.
+    collision_filter filter;
+};
+
+/**
+ * @brief Information returned from a shape cast query.
+ */
+struct shape_cast_result {
+    // Fraction of the sweep where the shapes first touch. The shape is at
+    // `lerp(p0, p1, fraction)` at the time of impact. It is zero if the shape
+    // is initially intersecting the entity that was hit.
+    scalar fraction { EDYN_SCALAR_MAX };
+    // Normal at the point of impact, pointing towards the cast shape. In case
+    // of initial intersection, it is the direction in which the cast shape
+    // must move to resolve the penetration.
+    vector3 normal;
+    // Point of impact in world space, on the surface of the entity that was hit.
+    vector3 point;
+    // The entity that was hit. It's set to `entt::null` if no entity is hit.
+    entt::entity entity { entt::null };
+};
+
+/**
+ * @brief Finds all entities whose shapes intersect the query shape. Shapes
+ * are tested against the convex pieces of each candidate entity using GJK,
+ * i.e. the children of compounds and the triangles of meshes and
+ * heightfields.
+ * @param registry Data source.
+ * @param query The query shape and its transform.
+ * @param entities The entities intersecting the query shape are appended to
+ * this vector.
+ */
+void overlap(entt::registry &registry, const overlap_query &query,
+             std::vector<entt::entity> &entities);
+
+/**
+ * @brief Sweeps the query shape and finds the first entity it hits, using
+ * conservative advancement on the distance calculated by GJK.
+ * @param registry Data source.
+ * @param query The query shape and its sweep.
+ * @return Shape cast result.
+ */
+shape_cast_result shape_cast(entt::registry &registry, const shape_cast_query &query);
+
+/**
+ * @brief Performs many overlap queries at once, in parallel in the global
+ * `edyn::job_dispatcher`. Like the other queries, it only reads from the
+ * registry and can be called from multiple threads simultaneously.
+ * @param registry Data source.
+ * @param queries The query shapes.
+ * @param results The entities intersecting each query shape, in the same
+ * order as `queries`. The inner vectors are reused.
+ */
+void overlap_batch(entt::registry &registry, const std::vector<overlap_query> &queries,
+                   std::vector<std::vector<entt::entity>> &results);
+
+/**
+ * @brief Performs many shape cast queries at once, in parallel in the global
+ * `edyn::job_dispatcher`.
+ * @param registry Data source.
+ * @param queries The query shapes and their sweeps.
+ * @param results The result of each query, in the same order as `queries`.
+ */
+void shape_cast_batch(entt::registry &registry, const std::vector<shape_cast_query> &queries,
+                      std::vector<shape_cast_result> &results);
+
+}
+
+#endif // EDYN_COLLISION_SHAPE_QUERY_HPP
@@ -2,11 +2,46 @@
 #define EDYN_COLLIDE_SHOULD_COLLIDE_HPP
 
 #include <entt/entity/fwd.hpp>
+#include "edyn/collision/tree_node.hpp"
 
 namespace edyn {
 
 bool should_collide_default(const entt::registry &, entt::entity, entt::entity);
 
+using should_collide_func_t = decltype(&should_collide_default);
+
+/**
+ * @brief Checks whether the entities in two broad-phase tree leaves should
+ * collide. When the default filtering function is in use, the collision
+ * filters stored alongside the leaves are tested first and the registry is
+ * only accessed if one of the entities has a collision exclusion list. A
+ * custom filtering function is always invoked.
+ * @param registry Data source.
+ * @param func The collision filtering function set in the settings.
+ * @param entity0 Entity in one leaf.
+ * @param filter0 Leaf filter of `entity0`.
+ * @param entity1 Entity in another leaf.
+ * @param filter1 Leaf filter of `entity1`.
+ * @return Whether the entities should collide.
+ */
+inline bool should_collide(const entt::registry &registry, should_collide_func_t func,
+                           entt::entity entity0, const tree_leaf_filter &filter0,
+                           entt::entity entity1, const tree_leaf_filter &filter1) {
+    if (func != &should_collide_default) {
+        return (*func)(registry, entity0, entity1);
+    }
+
+    if (entity0 == entity1 || !filters_collide(filter0.filter, filter1.filter)) {
+        return false;
+    }
+
+    if (filter0.has_exclusion || filter1.has_exclusion) {
+        return (*func)(registry, entity0, entity1);
+    }
+
+    return true;
+}
+
 }
 
 #endif // EDYN_COLLIDE_SHOULD_COLLIDE_HPP
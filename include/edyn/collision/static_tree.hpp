@@ -6,44 +6,122 @@
 #include <iterator>
 #include <numeric>
 #include <algorithm>
+#include <array>
+#include <unordered_map>
 #include "edyn/collision/query_tree.hpp"
+#include "edyn/util/mappable_vector.hpp"
+#include "edyn/parallel/parallel_for.hpp"
 
 namespace edyn {
 
 constexpr uint32_t EDYN_NULL_NODE = UINT32_MAX;
 
 namespace detail {
+    /**
+     * @brief Splits a set of AABBs in two using the surface area heuristic.
+     * The centroids are binned along the axis where they're most spread out
+     * and the split between bins with the lowest estimated cost is chosen.
+     * This avoids sorting the set at every level of the tree.
+     * @return Iterator to the first id in the second subset.
+     */
     template<typename Iterator_AABB, typename Iterator_ids>
     Iterator_ids aabb_set_partition(Iterator_AABB aabb_begin, Iterator_AABB aabb_end,
                                     Iterator_ids ids_begin, Iterator_ids ids_end,
                                     const AABB &set_aabb) {
-        auto aabb_size = set_aabb.max - set_aabb.min;
-        auto split_axis_idx = max_index(aabb_size);
-        auto split_pos = set_aabb.center()[split_axis_idx];
-
-        std::sort(ids_begin, ids_end, [&] (auto a, auto b) {
-            auto &b0 = *(aabb_begin + a);
-            auto &b1 = *(aabb_begin + b);
-            auto ca = b0.center();
-            auto cb = b1.center();
-            return ca[split_axis_idx] < cb[split_axis_idx];
-        });
+        constexpr size_t num_bins = 16;
+
+        auto centroid_aabb = AABB{set_aabb.max, set_aabb.min};
 
         for (auto it = ids_begin; it != ids_end; ++it) {
+            auto center = (aabb_begin + *it)->center();
+            centroid_aabb.min = min(centroid_aabb.min, center);
+            centroid_aabb.max = max(centroid_aabb.max, center);
+        }
+
+        auto centroid_extent = centroid_aabb.max - centroid_aabb.min;
+        auto split_axis_idx = max_index(centroid_extent);
+        auto axis_extent = centroid_extent[split_axis_idx];
+
+        // All centroids are at the same location. Split in half.
+        if (!(axis_extent > EDYN_EPSILON)) {
+            return ids_begin + std::distance(ids_begin, ids_end) / 2;
+        }
+
+        auto bin_scale = scalar(num_bins) / axis_extent;
+        auto get_bin = [&] (uint32_t id) {
+            auto center = (aabb_begin + id)->center();
+            auto pos = (center[split_axis_idx] - centroid_aabb.min[split_axis_idx]) * bin_scale;
+            return std::min(static_cast<size_t>(pos), num_bins - 1);
+        };
+
+        struct bin {
+            AABB aabb;
+            size_t count {0};
+        };
+
+        std::array<bin, num_bins> bins;
+
+        for (auto it = ids_begin; it != ids_end; ++it) {
+            auto &b = bins[get_bin(*it)];
             auto &aabb = *(aabb_begin + *it);
-            auto center = aabb.center();
+            b.aabb = b.count == 0 ? aabb : enclosing_aabb(b.aabb, aabb);
+            ++b.count;
+        }
+
+        // Sweep from the right to accumulate the cost of the second subset
+        // for each split, i.e. the split after bin `i` in `right_cost[i]`.
+        std::array<scalar, num_bins - 1> right_cost;
+        auto right_aabb = AABB{};
+        auto right_count = size_t(0);
+
+        for (auto i = num_bins - 1; i > 0; --i) {
+            if (bins[i].count > 0) {
+                right_aabb = right_count > 0 ? enclosing_aabb(right_aabb, bins[i].aabb) : bins[i].aabb;
+                right_count += bins[i].count;
+            }
 
-            if (center[split_axis_idx] > split_pos) {
-                return it;
+            right_cost[i - 1] = right_count > 0 ? right_aabb.area() * scalar(right_count) : EDYN_SCALAR_MAX;
+        }
+
+        // Sweep from the left and pick the cheapest split.
+        auto best_cost = EDYN_SCALAR_MAX;
+        auto best_split = size_t(0);
+        auto left_aabb = AABB{};
+        auto left_count = size_t(0);
+
+        for (size_t i = 0; i < num_bins - 1; ++i) {
+            if (bins[i].count > 0) {
+                left_aabb = left_count > 0 ? enclosing_aabb(left_aabb, bins[i].aabb) : bins[i].aabb;
+                left_count += bins[i].count;
+            }
+
+            if (left_count == 0 || right_cost[i] == EDYN_SCALAR_MAX) {
+                continue;
+            }
+
+            auto cost = left_aabb.area() * scalar(left_count) + right_cost[i];
+
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_split = i;
             }
         }
 
-        return ids_begin + std::distance(ids_begin, ids_end) / 2;
+        return std::partition(ids_begin, ids_end, [&] (auto id) {
+            return get_bin(id) <= best_split;
+        });
     }
 }
 
+/**
+ * @brief An AABB tree which is built once and can be modified in batches by
+ * inserting and removing leaves and refitting. The bounds of the nodes are
+ * quantized to 16 bits relative to the root AABB and rounded outwards, thus
+ * they're slightly larger than the exact bounds.
+ */
 class static_tree {
 public:
+    // Decoded node.
     struct tree_node {
         AABB aabb;
         uint32_t child1;
@@ -57,17 +135,41 @@ public:
         }
     };
 
+    // Node as stored in memory.
+    struct packed_node {
+        std::array<uint16_t, 3> min;
+        std::array<uint16_t, 3> max;
+        uint32_t child1;
+        union {
+            uint32_t child2;
+            uint32_t id;
+        };
+    };
+
     AABB root_aabb() const {
         EDYN_ASSERT(!m_nodes.empty());
-        return m_nodes.front().aabb;
+        return m_aabb;
     }
 
     bool empty() const {
         return m_nodes.empty();
     }
 
-    const tree_node & get_node(uint32_t id) const {
-        return m_nodes[id];
+    /**
+     * @brief Number of bytes used by the nodes of this tree.
+     */
+    size_t memory_size() const {
+        return m_nodes.size() * sizeof(packed_node);
+    }
+
+    tree_node get_node(uint32_t id) const {
+        auto &packed = m_nodes[id];
+        auto node = tree_node{};
+        node.aabb.min = m_aabb.min + vector3{scalar(packed.min[0]), scalar(packed.min[1]), scalar(packed.min[2])} * m_quantization_scale;
+        node.aabb.max = m_aabb.min + vector3{scalar(packed.max[0]), scalar(packed.max[1]), scalar(packed.max[2])} * m_quantization_scale;
+        node.child1 = packed.child1;
+        node.child2 = packed.child2;
+        return node;
     }
 
     template<typename Func>
@@ -76,23 +178,47 @@ public:
     template<typename Func>
     void raycast(vector3 p0, vector3 p1, Func func) const;
 
+    /**
+     * @brief Builds the tree top-down, splitting the sets of AABBs using the
+     * surface area heuristic.
+     * @param aabb_begin Begin iterator for the AABBs of the objects.
+     * @param aabb_end End iterator for the AABBs of the objects.
+     * @param report_leaf Called for each leaf with the node and the range of
+     * object ids it contains, i.e. `void(tree_node &, It ids_begin, It ids_end)`.
+     * @param max_obj_per_leaf Maximum number of objects per leaf.
+     * @param parallel Whether to build the subtrees below the top levels in
+     * parallel using `parallel_for`. If true, `report_leaf` must be thread-safe
+     * and the calling thread must not be a worker (see `can_parallel_for`).
+     */
     template<typename Iterator, typename Func>
-    void build(Iterator aabb_begin, Iterator aabb_end, Func &report_leaf, uint32_t max_obj_per_leaf = 1) {
+    void build(Iterator aabb_begin, Iterator aabb_end, Func &report_leaf,
+               uint32_t max_obj_per_leaf = 1, bool parallel = false) {
         EDYN_ASSERT(aabb_begin != aabb_end);
 
         auto count = std::distance(aabb_begin, aabb_end);
         std::vector<uint32_t> ids(count);
         std::iota(ids.begin(), ids.end(), 0);
 
+        // Build with full precision and quantize once the root AABB is known.
+        std::vector<tree_node> nodes;
+
         // Insert root node.
-        m_nodes.emplace_back();
+        nodes.emplace_back();
+
+        if (parallel) {
+            parallel_build(nodes, aabb_begin, aabb_end, ids.begin(), ids.end(),
+                           report_leaf, max_obj_per_leaf);
+        } else {
+            recurse_build(nodes, aabb_begin, aabb_end, ids.begin(), ids.end(),
+                          0, report_leaf, max_obj_per_leaf);
+        }
 
-        recurse_build(aabb_begin, aabb_end, ids.begin(), ids.end(),
-                      0, report_leaf, max_obj_per_leaf);
+        pack(nodes);
     }
 
     template<typename Iterator_AABB, typename Iterator_ids, typename Func>
-    void recurse_build(Iterator_AABB aabb_begin, Iterator_AABB aabb_end,
+    void recurse_build(std::vector<tree_node> &nodes,
+                       Iterator_AABB aabb_begin, Iterator_AABB aabb_end,
                        Iterator_ids ids_begin, Iterator_ids ids_end,
                        size_t node_idx, Func &report_leaf,
                        uint32_t max_obj_per_leaf) {
@@ -104,7 +230,7 @@ public:
             set_aabb = enclosing_aabb(set_aabb, *(aabb_begin + *it));
         }
 
-        auto &node = m_nodes[node_idx];
+        auto &node = nodes[node_idx];
         node.aabb = set_aabb;
 
         auto count = std::distance(ids_begin, ids_end);
@@ -115,28 +241,406 @@ public:
         } else {
             auto ids_middle = detail::aabb_set_partition(aabb_begin, aabb_end, ids_begin, ids_end, set_aabb);
 
-            auto child1 = m_nodes.size();
-            auto child2 = m_nodes.size() + 1;
+            auto child1 = nodes.size();
+            auto child2 = nodes.size() + 1;
 
             node.child1 = child1;
             node.child2 = child2;
 
-            m_nodes.emplace_back();
-            m_nodes.emplace_back();
+            nodes.emplace_back();
+            nodes.emplace_back();
 
-            recurse_build(aabb_begin, aabb_end, ids_begin, ids_middle,
+            recurse_build(nodes, aabb_begin, aabb_end, ids_begin, ids_middle,
                           child1, report_leaf, max_obj_per_leaf);
-            recurse_build(aabb_begin, aabb_end, ids_middle, ids_end,
+            recurse_build(nodes, aabb_begin, aabb_end, ids_middle, ids_end,
                           child2, report_leaf, max_obj_per_leaf);
         }
     }
 
+    /**
+     * @brief Splits the top levels of the tree in the calling thread until
+     * there are enough subtrees to keep all workers busy, then builds each
+     * subtree into a separate array in parallel and appends them to `nodes`.
+     * The split of each node is the same as in `recurse_build`, thus the
+     * resulting tree has the same structure, with nodes in a different order.
+     */
+    template<typename Iterator_AABB, typename Iterator_ids, typename Func>
+    void parallel_build(std::vector<tree_node> &nodes,
+                        Iterator_AABB aabb_begin, Iterator_AABB aabb_end,
+                        Iterator_ids ids_begin, Iterator_ids ids_end,
+                        Func &report_leaf, uint32_t max_obj_per_leaf) {
+        // Subtrees smaller than this are not worth a job of their own.
+        constexpr size_t min_subtree_count = 1024;
+
+        struct subtree {
+            size_t node_idx;
+            Iterator_ids ids_begin;
+            Iterator_ids ids_end;
+            std::vector<tree_node> nodes;
+        };
+
+        auto &dispatcher = job_dispatcher::global();
+        auto count = static_cast<size_t>(std::distance(ids_begin, ids_end));
+        auto num_subtrees = (dispatcher.num_workers() + 1) * 4;
+        auto max_subtree_count = std::max(count / num_subtrees, min_subtree_count);
+        auto subtrees = std::vector<subtree>{};
+
+        auto split = [&] (auto &self, size_t node_idx, Iterator_ids begin, Iterator_ids end) -> void {
+            if (static_cast<size_t>(std::distance(begin, end)) <= max_subtree_count) {
+                subtrees.push_back({node_idx, begin, end, {}});
+                return;
+            }
+
+            AABB set_aabb = *(aabb_begin + *begin);
+
+            for (auto it = begin + 1; it != end; ++it) {
+                set_aabb = enclosing_aabb(set_aabb, *(aabb_begin + *it));
+            }
+
+            auto middle = detail::aabb_set_partition(aabb_begin, aabb_end, begin, end, set_aabb);
+            auto child1 = nodes.size();
+            auto child2 = nodes.size() + 1;
+
+            auto &node = nodes[node_idx];
+            node.aabb = set_aabb;
+            node.child1 = child1;
+            node.child2 = child2;
+
+            nodes.emplace_back();
+            nodes.emplace_back();
+
+            self(self, child1, begin, middle);
+            self(self, child2, middle, end);
+        };
+
+        split(split, 0, ids_begin, ids_end);
+
+        auto build_subtree = [&] (size_t index) {
+            auto &sub = subtrees[index];
+            sub.nodes.emplace_back();
+            recurse_build(sub.nodes, aabb_begin, aabb_end, sub.ids_begin, sub.ids_end,
+                          0, report_leaf, max_obj_per_leaf);
+        };
+
+        if (subtrees.size() > 1 && can_parallel_for(dispatcher)) {
+            parallel_for(size_t{0}, subtrees.size(), build_subtree);
+        } else {
+            for (size_t index = 0; index < subtrees.size(); ++index) {
+                build_subtree(index);
+            }
+        }
+
+        // The root of each subtree replaces its placeholder node and the rest
+        // of the nodes are appended, thus the node at index `k > 0` in the
+        // array of the subtree is moved to `offset + k`.
+        for (auto &sub : subtrees) {
+            auto offset = static_cast<uint32_t>(nodes.size() - 1);
+            auto relocate = [offset] (tree_node node) {
+                if (!node.leaf()) {
+                    node.child1 += offset;
+                    node.child2 += offset;
+                }
+                return node;
+            };
+
+            nodes[sub.node_idx] = relocate(sub.nodes.front());
+
+            for (size_t k = 1; k < sub.nodes.size(); ++k) {
+                nodes.push_back(relocate(sub.nodes[k]));
+            }
+        }
+    }
+
+    /**
+     * @brief Removes the leaves with the given ids by replacing their parents
+     * with their siblings. The nodes which are left unreachable are discarded
+     * and the bounds of the ancestors are updated in the next `refit`. The
+     * tree must keep at least one leaf.
+     * @param ids Ids of the leaves to be removed.
+     */
+    void remove_leaves(const std::vector<uint32_t> &ids) {
+        if (ids.empty()) {
+            return;
+        }
+
+        // Find the parent of every reachable node and the nodes of the leaves
+        // to be removed.
+        const auto &nodes = m_nodes;
+        auto parents = std::vector<uint32_t>(nodes.size(), EDYN_NULL_NODE);
+        auto leaf_nodes = std::unordered_map<uint32_t, uint32_t>{};
+
+        for (auto id : ids) {
+            leaf_nodes.emplace(id, EDYN_NULL_NODE);
+        }
+
+        auto stack = std::vector<uint32_t>{0};
+
+        while (!stack.empty()) {
+            auto node_idx = stack.back();
+            stack.pop_back();
+            auto &node = nodes[node_idx];
+
+            if (node.child1 == EDYN_NULL_NODE) {
+                if (auto it = leaf_nodes.find(node.id); it != leaf_nodes.end()) {
+                    it->second = node_idx;
+                }
+            } else {
+                parents[node.child1] = parents[node.child2] = node_idx;
+                stack.push_back(node.child1);
+                stack.push_back(node.child2);
+            }
+        }
+
+        for (auto id : ids) {
+            auto node_idx = leaf_nodes.at(id);
+            EDYN_ASSERT(node_idx != EDYN_NULL_NODE);
+            auto parent_idx = parents[node_idx];
+            EDYN_ASSERT(parent_idx != EDYN_NULL_NODE);
+            auto &parent = nodes[parent_idx];
+            auto sibling_idx = parent.child1 == node_idx ? parent.child2 : parent.child1;
+
+            // Children keep their position in the array thus their parent
+            // must be updated. A moved leaf might be removed later.
+            m_nodes[parent_idx] = nodes[sibling_idx];
+            auto &moved = nodes[parent_idx];
+
+            if (moved.child1 == EDYN_NULL_NODE) {
+                if (auto it = leaf_nodes.find(moved.id); it != leaf_nodes.end()) {
+                    it->second = parent_idx;
+                }
+            } else {
+                parents[moved.child1] = parents[moved.child2] = parent_idx;
+            }
+        }
+    }
+
+    /**
+     * @brief Inserts a leaf next to the leaf whose bounds grow the least in
+     * area when enclosing the new leaf. The bounds of the ancestors are
+     * updated in the next `refit`.
+     * @param id Id of the new leaf.
+     * @param aabb Bounds of the new leaf.
+     */
+    void insert_leaf(uint32_t id, const AABB &aabb) {
+        EDYN_ASSERT(!m_nodes.empty());
+        auto node_idx = uint32_t{0};
+
+        while (m_nodes[node_idx].child1 != EDYN_NULL_NODE) {
+            auto child1 = m_nodes[node_idx].child1;
+            auto child2 = m_nodes[node_idx].child2;
+            auto aabb1 = get_node(child1).aabb;
+            auto aabb2 = get_node(child2).aabb;
+            auto cost1 = enclosing_aabb(aabb1, aabb).area() - aabb1.area();
+            auto cost2 = enclosing_aabb(aabb2, aabb).area() - aabb2.area();
+            node_idx = cost1 <= cost2 ? child1 : child2;
+        }
+
+        auto leaf = packed_node{};
+        leaf.min = quantize(aabb.min, false);
+        leaf.max = quantize(aabb.max, true);
+        leaf.child1 = EDYN_NULL_NODE;
+        leaf.id = id;
+
+        // The existing leaf is moved down and its node becomes the parent of
+        // both leaves. Its quantized bounds are enlarged so that subsequent
+        // insertions can take the new leaf into account.
+        auto child1 = static_cast<uint32_t>(m_nodes.size());
+        auto existing = m_nodes[node_idx];
+        m_nodes.push_back(existing);
+        m_nodes.push_back(leaf);
+
+        auto &parent = m_nodes[node_idx];
+        parent.child1 = child1;
+        parent.child2 = child1 + 1;
+
+        for (size_t i = 0; i < 3; ++i) {
+            parent.min[i] = std::min(parent.min[i], leaf.min[i]);
+            parent.max[i] = std::max(parent.max[i], leaf.max[i]);
+        }
+    }
+
+    /**
+     * @brief Recalculates the bounds of all nodes bottom-up, after the
+     * objects referenced by the leaves have changed, and discards nodes which
+     * are unreachable. The structure of the tree is not changed, thus its
+     * quality might degrade if the objects move too much.
+     * @param update_leaf Called for each leaf with a reference to its id, which
+     * can be reassigned. It must return the bounds of the leaf, i.e.
+     * `AABB(uint32_t &)`.
+     */
+    template<typename Func>
+    void refit(Func update_leaf) {
+        EDYN_ASSERT(!m_nodes.empty());
+        const auto &packed_nodes = m_nodes;
+        std::vector<tree_node> nodes;
+        nodes.reserve(packed_nodes.size());
+        nodes.emplace_back();
+
+        // Pairs of node indices in the current and the new array. Children are
+        // always placed after their parent in the new array.
+        auto stack = std::vector<std::pair<uint32_t, uint32_t>>{};
+        stack.emplace_back(0, 0);
+
+        while (!stack.empty()) {
+            auto [packed_idx, node_idx] = stack.back();
+            stack.pop_back();
+            auto &packed = packed_nodes[packed_idx];
+
+            if (packed.child1 == EDYN_NULL_NODE) {
+                auto id = packed.id;
+                auto aabb = update_leaf(id);
+                auto &node = nodes[node_idx];
+                node.aabb = aabb;
+                node.child1 = EDYN_NULL_NODE;
+                node.id = id;
+            } else {
+                auto child1 = static_cast<uint32_t>(nodes.size());
+                nodes.emplace_back();
+                nodes.emplace_back();
+                nodes[node_idx].child1 = child1;
+                nodes[node_idx].child2 = child1 + 1;
+                stack.emplace_back(packed.child1, child1);
+                stack.emplace_back(packed.child2, child1 + 1);
+            }
+        }
+
+        for (auto i = nodes.size(); i-- > 0;) {
+            auto &node = nodes[i];
+
+            if (!node.leaf()) {
+                node.aabb = enclosing_aabb(nodes[node.child1].aabb, nodes[node.child2].aabb);
+            }
+        }
+
+        pack(nodes);
+    }
+
+    /**
+     * @brief Recalculates the bounds of the leaves which intersect `aabb`
+     * and have changed, and of their ancestors, in quantized space. Much
+     * cheaper than `refit` when few leaves change, but it can only be used if
+     * no leaves were inserted or removed. Nothing is modified if the new
+     * bounds of a leaf are outside of the root AABB.
+     * @param aabb Region containing the previous bounds of all changed leaves.
+     * @param update_leaf Called for each leaf in the region, i.e.
+     * `bool(uint32_t id, AABB &aabb)`. It must assign the new bounds of the
+     * leaf and return true if it has changed, or return false otherwise.
+     * @return Whether the tree was updated. If false, `refit` must be used.
+     */
+    template<typename Func>
+    bool refit_region(const AABB &aabb, Func update_leaf) {
+        EDYN_ASSERT(!m_nodes.empty());
+
+        // Changed leaves paired with their new bounds, and their ancestors,
+        // which are visited in post-order thus children come first.
+        auto leaves = std::vector<std::pair<uint32_t, AABB>>{};
+        auto ancestors = std::vector<uint32_t>{};
+
+        auto visit = [&] (auto &self, uint32_t node_idx) -> bool {
+            auto node = get_node(node_idx);
+
+            if (!intersect(node.aabb, aabb)) {
+                return false;
+            }
+
+            if (node.leaf()) {
+                auto leaf_aabb = AABB{};
+
+                if (update_leaf(node.id, leaf_aabb)) {
+                    leaves.emplace_back(node_idx, leaf_aabb);
+                    return true;
+                }
+
+                return false;
+            }
+
+            auto changed1 = self(self, node.child1);
+            auto changed2 = self(self, node.child2);
+
+            if (changed1 || changed2) {
+                ancestors.push_back(node_idx);
+                return true;
+            }
+
+            return false;
+        };
+
+        visit(visit, 0);
+
+        for (auto &[node_idx, leaf_aabb] : leaves) {
+            if (!m_aabb.contains(leaf_aabb)) {
+                return false;
+            }
+        }
+
+        for (auto &[node_idx, leaf_aabb] : leaves) {
+            auto &packed = m_nodes[node_idx];
+            packed.min = quantize(leaf_aabb.min, false);
+            packed.max = quantize(leaf_aabb.max, true);
+        }
+
+        for (auto node_idx : ancestors) {
+            auto packed = m_nodes[node_idx];
+            auto &child1 = m_nodes[packed.child1];
+            auto &child2 = m_nodes[packed.child2];
+
+            for (size_t i = 0; i < 3; ++i) {
+                packed.min[i] = std::min(child1.min[i], child2.min[i]);
+                packed.max[i] = std::max(child1.max[i], child2.max[i]);
+            }
+
+            m_nodes[node_idx] = packed;
+        }
+
+        return true;
+    }
+
     template<typename Archive>
     friend void serialize(Archive &archive, static_tree &tree);
     friend size_t serialization_sizeof(const static_tree &tree);
 
 private:
-    std::vector<tree_node> m_nodes;
+    // Round outwards by one extra step to account for the rounding error in
+    // `get_node`.
+    std::array<uint16_t, 3> quantize(const vector3 &v, bool round_up) const {
+        constexpr auto max_quantized = scalar(UINT16_MAX);
+        auto q = std::array<uint16_t, 3>{};
+
+        for (size_t i = 0; i < 3; ++i) {
+            if (m_quantization_scale[i] > 0) {
+                auto f = (v[i] - m_aabb.min[i]) / m_quantization_scale[i];
+                f = round_up ? std::ceil(f) + 1 : std::floor(f) - 1;
+                q[i] = static_cast<uint16_t>(std::clamp(f, scalar(0), max_quantized));
+            }
+        }
+
+        return q;
+    }
+
+    void pack(const std::vector<tree_node> &nodes) {
+        constexpr auto max_quantized = scalar(UINT16_MAX);
+        m_aabb = nodes.front().aabb;
+        // Leave room for the extra step at the top of the range. Otherwise,
+        // the bounds at the maximum of the root AABB would be clamped and
+        // `get_node` could decode them slightly below the exact value.
+        m_quantization_scale = (m_aabb.max - m_aabb.min) / (max_quantized - 2);
+
+        m_nodes.clear();
+        m_nodes.reserve(nodes.size());
+
+        for (auto &node : nodes) {
+            auto &packed = m_nodes.emplace_back();
+            packed.min = quantize(node.aabb.min, false);
+            packed.max = quantize(node.aabb.max, true);
+            packed.child1 = node.child1;
+            packed.child2 = node.child2;
+        }
+    }
+
+private:
+    mappable_vector<packed_node> m_nodes;
+    AABB m_aabb;
+    vector3 m_quantization_scale;
 };
 
 template<typename Func>
@@ -5,6 +5,7 @@
 #include <limits>
 #include <entt/entity/fwd.hpp>
 #include "edyn/comp/aabb.hpp"
+#include "edyn/comp/collision_filter.hpp"
 
 namespace edyn {
 
@@ -31,6 +32,18 @@ struct tree_node {
     }
 };
 
+/**
+ * @brief Collision filter of the entity in a leaf node. Stored in an array
+ * parallel to the nodes so that most pairs can be rejected without accessing
+ * the registry while internal nodes stay small.
+ */
+struct tree_leaf_filter {
+    collision_filter filter;
+
+    // Whether the entity has a `collision_exclusion`.
+    bool has_exclusion {false};
+};
+
 }
 
 #endif // EDYN_COLLISION_TREE_NODE_HPP
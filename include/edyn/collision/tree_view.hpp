@@ -40,10 +40,14 @@ public:
     /**
      * @brief Initializes a `tree_view` with the given nodes.
      * @param nodes All tree nodes.
+     * @param filters Collision filter of the entity in each leaf node, indexed
+     * by node id.
      * @param root_id The id of the root node in the vector of nodes.
      */
-    tree_view(const std::vector<tree_node> &nodes, tree_node_id_t root_id)
+    tree_view(const std::vector<tree_node> &nodes,
+              const std::vector<collision_filter> &filters, tree_node_id_t root_id)
         : m_nodes(nodes)
+        , m_filters(filters)
         , m_root(root_id)
     {}
 
@@ -60,6 +64,10 @@ public:
     template<typename Func>
     void raycast(vector3 p0, vector3 p1, Func func) const;
 
+    /*! @copydoc dynamic_tree::traverse_packet */
+    template<typename TestFunc, typename VisitFunc>
+    void traverse_packet(size_t num_queries, TestFunc test_func, VisitFunc visit_func) const;
+
     /**
      * @brief Calls the given function for each leaf node.
      * @tparam Func Type of the function object to invoke.
@@ -80,6 +88,14 @@ public:
         return m_nodes[id];
     }
 
+    /**
+     * @brief Returns the collision filter of the entity in a leaf node.
+     * @return Reference to the filter for the requested leaf node id.
+     */
+    const collision_filter & get_filter(tree_node_id_t id) const {
+        return m_filters[id];
+    }
+
     /**
      * @brief Returns the node if of the root node.
      * @return Node id of the root.
@@ -128,6 +144,7 @@ public:
 
 private:
     std::vector<tree_node> m_nodes;
+    std::vector<collision_filter> m_filters;
     tree_node_id_t m_root;
 };
 
@@ -136,6 +153,11 @@ void tree_view::query(const AABB &aabb, Func func) const {
     query_tree(*this, m_root, null_tree_node_id, aabb, func);
 }
 
+template<typename TestFunc, typename VisitFunc>
+void tree_view::traverse_packet(size_t num_queries, TestFunc test_func, VisitFunc visit_func) const {
+    traverse_tree_packet(*this, m_root, null_tree_node_id, num_queries, test_func, visit_func);
+}
+
 template<typename Func>
 void tree_view::each(Func func) const {
     for (const auto &node : m_nodes) {
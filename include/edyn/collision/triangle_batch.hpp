@@ -0,0 +1,89 @@
+#ifndef EDYN_COLLISION_TRIANGLE_BATCH_HPP
+#define EDYN_COLLISION_TRIANGLE_BATCH_HPP
+
+#include <vector>
+#include <cstdint>
+#include "edyn/math/vector3.hpp"
+#include "edyn/comp/aabb.hpp"
+
+namespace edyn {
+
+class triangle_mesh;
+
+/**
+ * @brief Candidate triangles of a mesh for narrow-phase collision detection
+ * against a convex shape. The triangles are gathered first and culled in
+ * bulk before the expensive per-triangle separating axis tests. The
+ * coordinates are stored as a structure of arrays so the culling loops can
+ * be vectorized by the compiler.
+ */
+struct triangle_batch {
+    std::vector<uint32_t> indices;
+    // First vertex of each triangle.
+    std::vector<scalar> vx, vy, vz;
+    // Face normal of each triangle.
+    std::vector<scalar> nx, ny, nz;
+    // Scratch buffer with the distance of the shape to the triangle planes.
+    std::vector<scalar> distances;
+
+    size_t size() const {
+        return indices.size();
+    }
+
+    void clear();
+
+    /**
+     * @brief Replaces the contents of this batch with all triangles in the
+     * mesh whose AABB intersects the given AABB.
+     * @param mesh The triangle mesh.
+     * @param aabb Query AABB.
+     */
+    void gather(const triangle_mesh &mesh, const AABB &aabb);
+
+    /**
+     * @brief Removes all triangles whose plane separates them from a convex
+     * shape by more than `threshold`, i.e. the triangles which the separating
+     * axis test would reject using the face normal.
+     * @param support_projection Function with signature
+     * `scalar(const vector3 &dir)` which returns the greatest projection of
+     * the convex shape along the given direction.
+     * @param threshold Contact breaking threshold.
+     */
+    template<typename SupportFunc>
+    void cull(SupportFunc support_projection, scalar threshold) {
+        const auto count = size();
+        distances.resize(count);
+
+        // Plane distances. The support function is inlined in this loop,
+        // which doesn't branch for most shapes.
+        for (size_t i = 0; i < count; ++i) {
+            auto normal = vector3{nx[i], ny[i], nz[i]};
+            auto proj_shape = -support_projection(-normal);
+            auto proj_tri = vx[i] * nx[i] + vy[i] * ny[i] + vz[i] * nz[i];
+            distances[i] = proj_shape - proj_tri;
+        }
+
+        // Compact survivors in place.
+        size_t num_kept = 0;
+
+        for (size_t i = 0; i < count; ++i) {
+            if (distances[i] > threshold) {
+                continue;
+            }
+
+            indices[num_kept] = indices[i];
+            vx[num_kept] = vx[i]; vy[num_kept] = vy[i]; vz[num_kept] = vz[i];
+            nx[num_kept] = nx[i]; ny[num_kept] = ny[i]; nz[num_kept] = nz[i];
+            ++num_kept;
+        }
+
+        resize(num_kept);
+    }
+
+private:
+    void resize(size_t);
+};
+
+}
+
+#endif // EDYN_COLLISION_TRIANGLE_BATCH_HPP
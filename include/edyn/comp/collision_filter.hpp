@@ -10,6 +10,14 @@ struct collision_filter {
     uint64_t mask {~0ULL};
 };
 
+/**
+ * @brief Checks whether the group of each filter is accepted by the mask of
+ * the other.
+ */
+inline bool filters_collide(const collision_filter &filter0, const collision_filter &filter1) {
+    return (filter0.group & filter1.mask) != 0 && (filter1.group & filter0.mask) != 0;
+}
+
 }
 
 #endif // EDYN_COMP_COLLISION_FILTER_HPP
@@ -0,0 +1,21 @@
+#ifndef EDYN_COMP_ROTATED_MESH_HANDLE_HPP
+#define EDYN_COMP_ROTATED_MESH_HANDLE_HPP
+
+#include "edyn/shapes/rotated_mesh_pool.hpp"
+
+namespace edyn {
+
+/**
+ * @brief Refers to the rotated meshes of an entity holding a `polyhedron_shape`
+ * or a `compound_shape` which contains polyhedrons. The rotated meshes reside
+ * in the `rotated_mesh_pool` of the island worker and `index` is the first of
+ * the chain of rotated meshes of this entity, which has a single element in
+ * the case of a `polyhedron_shape`.
+ */
+struct rotated_mesh_handle {
+    rotated_mesh_pool::index_type index {rotated_mesh_pool::null_index};
+};
+
+}
+
+#endif // EDYN_COMP_ROTATED_MESH_HANDLE_HPP
@@ -20,7 +20,6 @@
 #include "edyn/comp/collision_exclusion.hpp"
 #include "edyn/comp/continuous.hpp"
 #include "edyn/shapes/shapes.hpp"
-#include "edyn/collision/tree_view.hpp"
 #include "edyn/collision/contact_manifold.hpp"
 #include "edyn/collision/contact_point.hpp"
 
@@ -61,8 +60,7 @@ static const auto shared_components = std::tuple_cat(std::tuple<
     continuous_contacts_tag,
     external_tag,
     shape_index,
-    rigidbody_tag,
-    tree_view
+    rigidbody_tag
 >{}, constraints_tuple, shapes_tuple); // Concatenate with all shapes and constraints at the end.
 
 using shared_components_t = std::decay_t<decltype(shared_components)>;
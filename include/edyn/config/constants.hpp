@@ -29,6 +29,38 @@ inline constexpr auto contact_merging_threshold = scalar(0.01);
  */
 inline constexpr auto contact_caching_threshold = scalar(0.04);
 
+/**
+ * If the position and orientation of a body relative to another change less
+ * than these amounts since the last time collision detection was performed
+ * between them, the previous collision result is reused.
+ */
+inline constexpr auto collision_cache_linear_tolerance = scalar(0.0005);
+inline constexpr auto collision_cache_angular_tolerance = scalar(0.002);
+
+/**
+ * When reducing many candidate contact points to a manifold, candidates
+ * located near the points selected in the previous step are preferred: their
+ * penetration is considered deeper by `contact_reduction_depth_hysteresis` and
+ * the area they span is scaled up by `1 + contact_reduction_area_hysteresis`.
+ * This prevents the manifold from switching between similar points every step.
+ */
+inline constexpr auto contact_reduction_depth_hysteresis = scalar(0.002);
+inline constexpr auto contact_reduction_area_hysteresis = scalar(0.1);
+
+/**
+ * Rotated meshes are only recalculated if any component of the orientation
+ * of their rigid body changed more than this amount since the last update.
+ */
+inline constexpr auto rotated_mesh_orientation_tolerance = scalar(1e-6);
+
+/**
+ * Vertex positions of triangle meshes are quantized to 16 bits relative to the
+ * bounds of the mesh if the resulting rounding error is below this value, i.e.
+ * if the mesh is smaller than about 65 units along every axis, which is
+ * usually the case for the submeshes of a paged triangle mesh.
+ */
+inline constexpr auto triangle_mesh_max_quantization_error = scalar(0.0005);
+
 /**
  * The magnitude of the linear and angular velocity of all rigid bodies in an
  * island must stay under these thresholds for the island to eventually fall
@@ -2,6 +2,8 @@
 #define EDYN_CONTEXT_SETTINGS_HPP
 
 #include <memory>
+#include <vector>
+#include <utility>
 #include "edyn/math/scalar.hpp"
 #include "edyn/math/constants.hpp"
 #include "edyn/context/external_system.hpp"
@@ -12,7 +14,16 @@ namespace edyn {
 
 std::unique_ptr<island_delta_builder> make_island_delta_builder_default();
 
-using should_collide_func_t = decltype(&should_collide_default);
+/**
+ * @brief Algorithm used to find intersecting pairs of procedural entities
+ * within an island.
+ */
+enum class broadphase_type {
+    // Dynamic AABB tree. Suits most scenes.
+    dynamic_tree,
+    // Uniform hashed grid. Suits large numbers of bodies of similar size.
+    hash_grid
+};
 
 struct settings {
     scalar fixed_dt {scalar(1.0 / 60)};
@@ -25,6 +36,18 @@ struct settings {
     external_system_func_t external_system_pre_step {nullptr};
     external_system_func_t external_system_post_step {nullptr};
     should_collide_func_t should_collide_func {&should_collide_default};
+    broadphase_type broadphase {broadphase_type::dynamic_tree};
+    // Pairs of shape indices, as given by `get_shape_index`, whose collisions
+    // are detected using the generic GJK/EPA algorithm instead of the
+    // dedicated collision function. Only applies to convex shapes.
+    std::vector<std::pair<size_t, size_t>> gjk_shape_pairs;
+    // Submeshes of paged triangle meshes are prefetched along the path a body
+    // is expected to travel during this amount of time at its current velocity.
+    scalar paged_mesh_look_ahead_time {scalar(0.5)};
+    // Whether to load submeshes of paged triangle meshes synchronously if a
+    // body touches one that is not in the cache yet. It stalls the simulation
+    // while the submesh is loaded but prevents bodies from falling through.
+    bool paged_mesh_blocking_load {true};
 };
 
 }
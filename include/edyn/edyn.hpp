@@ -36,6 +36,8 @@
 #include "collision/contact_manifold_map.hpp"
 #include "context/settings.hpp"
 #include "collision/raycast.hpp"
+#include "collision/shape_query.hpp"
+#include "collision/query_world.hpp"
 #include <entt/entity/registry.hpp>
 
 namespace edyn {
@@ -190,6 +192,54 @@ void tag_external_entity(entt::registry &registry, entt::entity entity, bool pro
  */
 void set_should_collide(entt::registry &registry, should_collide_func_t func);
 
+/**
+ * @brief Get the broad-phase algorithm used in island workers.
+ * @param registry Data source.
+ * @return Broad-phase type.
+ */
+broadphase_type get_broadphase_type(const entt::registry &registry);
+
+/**
+ * @brief Changes the broad-phase algorithm used in island workers. The hashed
+ * grid is usually faster in scenes with many bodies of similar size, such as
+ * particles and debris.
+ * @param registry Data source.
+ * @param type The broad-phase type.
+ */
+void set_broadphase_type(entt::registry &registry, broadphase_type type);
+
+/**
+ * @brief Configures how submeshes of paged triangle meshes are loaded ahead
+ * of time as bodies move towards them.
+ * @param registry Data source.
+ * @param look_ahead_time Submeshes along the path a body will travel during
+ *      this amount of time at its current velocity are prefetched.
+ * @param blocking_load Whether to stall the simulation to load a submesh
+ *      which is touched by a body before it was prefetched.
+ */
+void set_paged_mesh_prefetch(entt::registry &registry, scalar look_ahead_time,
+                             bool blocking_load = true);
+
+/**
+ * @brief Enables or disables the generic GJK/EPA collision detection algorithm
+ * for a pair of convex shapes, replacing the dedicated collision function for
+ * that pair. It is useful for polyhedrons with many faces. The children of
+ * compound shapes always use the dedicated collision functions.
+ * @param registry Data source.
+ * @param shape_indexA Index of the first shape type, as per `get_shape_index`.
+ * @param shape_indexB Index of the second shape type, as per `get_shape_index`.
+ * @param enabled Whether to use GJK/EPA for this pair.
+ */
+void set_gjk_collision(entt::registry &registry, size_t shape_indexA,
+                       size_t shape_indexB, bool enabled = true);
+
+/*! @copydoc set_gjk_collision */
+template<typename ShapeAType, typename ShapeBType>
+void set_gjk_collision(entt::registry &registry, bool enabled = true) {
+    set_gjk_collision(registry, get_shape_index<ShapeAType>(),
+                      get_shape_index<ShapeBType>(), enabled);
+}
+
 /**
  * @brief Propagates changes to a component to the island worker where the
  * entity currently resides.
@@ -0,0 +1,63 @@
+#ifndef EDYN_MATH_OCTAHEDRAL_HPP
+#define EDYN_MATH_OCTAHEDRAL_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include "edyn/math/vector3.hpp"
+
+namespace edyn {
+
+/**
+ * @brief Encodes a unit vector into 32 bits using the octahedral mapping.
+ * The vector is projected onto the octahedron `|x| + |y| + |z| = 1`, whose
+ * lower half is folded over the upper half, and the resulting x and y
+ * coordinates are stored as two 16-bit signed normalized integers. The
+ * angular error is below 1e-4 radians and axis-aligned vectors
+ * are represented exactly.
+ * @param v Unit vector.
+ * @return Encoded vector.
+ */
+inline uint32_t octahedral_encode(const vector3 &v) {
+    auto l1 = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+    auto u = v.x / l1;
+    auto w = v.y / l1;
+
+    if (v.z < 0) {
+        auto fu = (scalar(1) - std::abs(w)) * (u < 0 ? scalar(-1) : scalar(1));
+        auto fw = (scalar(1) - std::abs(u)) * (w < 0 ? scalar(-1) : scalar(1));
+        u = fu;
+        w = fw;
+    }
+
+    auto to_snorm = [] (scalar s) {
+        auto i = static_cast<int16_t>(std::round(std::clamp(s, scalar(-1), scalar(1)) * scalar(32767)));
+        return static_cast<uint32_t>(static_cast<uint16_t>(i));
+    };
+
+    return to_snorm(u) | (to_snorm(w) << 16);
+}
+
+/**
+ * @brief Decodes a unit vector encoded with `octahedral_encode`.
+ * @param e Encoded vector.
+ * @return Unit vector.
+ */
+inline vector3 octahedral_decode(uint32_t e) {
+    auto u = static_cast<int16_t>(e & 0xffff) / scalar(32767);
+    auto w = static_cast<int16_t>(e >> 16) / scalar(32767);
+    auto z = scalar(1) - std::abs(u) - std::abs(w);
+
+    if (z < 0) {
+        auto fu = (scalar(1) - std::abs(w)) * (u < 0 ? scalar(-1) : scalar(1));
+        auto fw = (scalar(1) - std::abs(u)) * (w < 0 ? scalar(-1) : scalar(1));
+        u = fu;
+        w = fw;
+    }
+
+    return normalize(vector3{u, w, z});
+}
+
+}
+
+#endif // EDYN_MATH_OCTAHEDRAL_HPP
@@ -23,6 +23,11 @@ class island_delta;
  */
 class island_coordinator final {
 
+    /**
+     * Inserts new nodes and edges into islands. Connected components which do
+     * not touch an existing island are placed into a new island, which starts
+     * asleep if all of its procedural nodes have a `sleeping_tag`.
+     */
     void init_new_nodes_and_edges();
     void init_new_non_procedural_node(entt::entity);
     entt::entity create_island(double timestamp, bool sleeping,
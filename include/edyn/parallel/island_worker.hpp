@@ -85,7 +85,8 @@ public:
     void on_destroy_graph_edge(entt::registry &, entt::entity);
     void on_construct_polyhedron_shape(entt::registry &, entt::entity);
     void on_construct_compound_shape(entt::registry &, entt::entity);
-    void on_destroy_rotated_mesh_list(entt::registry &, entt::entity);
+    void on_destroy_rotated_mesh_handle(entt::registry &, entt::entity);
+    void on_update_mesh_shape(entt::registry &, entt::entity);
 
     void on_set_paused(const msg::set_paused &msg);
     void on_step_simulation(const msg::step_simulation &msg);
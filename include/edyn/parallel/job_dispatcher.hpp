@@ -79,6 +79,11 @@ public:
      */
     size_t num_workers() const;
 
+    /**
+     * Whether the current thread is one of the background workers.
+     */
+    bool is_worker_thread() const;
+
 private:
     std::vector<std::unique_ptr<std::thread>> m_threads;
     std::map<std::thread::id, std::unique_ptr<worker>> m_workers;
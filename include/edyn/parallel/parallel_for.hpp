@@ -100,6 +100,18 @@ void parallel_for_job_func(job::data_type &data) {
 
 } // namespace detail
 
+/**
+ * @brief Whether `parallel_for` can be called from the current thread. The
+ * dispatcher must have workers and the current thread must not be one of them,
+ * since `parallel_for` blocks until all jobs are done. A worker doing so from
+ * within a job, e.g. when a mesh is created in an island worker, can stall or
+ * deadlock the pool while waiting on jobs queued behind other blocked jobs.
+ * @param dispatcher The `edyn::job_dispatcher` where the parallel jobs would be run.
+ */
+inline bool can_parallel_for(const job_dispatcher &dispatcher = job_dispatcher::global()) {
+    return dispatcher.num_workers() > 0 && !dispatcher.is_worker_thread();
+}
+
 /**
  * @brief Dynamically splits the range `[first, last)` and calls `func` in parallel
  * once for each element starting at `first` and incrementing by `step` until `last`.
@@ -0,0 +1,186 @@
+#ifndef EDYN_SERIALIZATION_BUFFERED_FILE_ARCHIVE_HPP
+#define EDYN_SERIALIZATION_BUFFERED_FILE_ARCHIVE_HPP
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "edyn/config/config.h"
+#include "edyn/util/tuple_util.hpp"
+#include "edyn/serialization/s11n_util.hpp"
+
+namespace edyn {
+
+/**
+ * Default size of the buffer of buffered file archives, in bytes.
+ */
+inline constexpr size_t file_archive_buffer_size = size_t{1} << 16;
+
+/**
+ * @brief Writes to a file in the same format as a `file_output_archive`, but
+ * accumulates small writes in a buffer which is written to the file in
+ * large blocks, avoiding the overhead of a stream call per value. Blocks
+ * larger than the buffer are written directly.
+ */
+class buffered_file_output_archive {
+public:
+    using is_input = std::false_type;
+    using is_output = std::true_type;
+
+    buffered_file_output_archive(const std::string &path,
+                                 size_t buffer_size = file_archive_buffer_size)
+        : m_file(path, std::ios::binary | std::ios::out)
+        , m_buffer(buffer_size)
+    {
+        EDYN_ASSERT(m_file.good());
+    }
+
+    ~buffered_file_output_archive() {
+        close();
+    }
+
+    buffered_file_output_archive(const buffered_file_output_archive &) = delete;
+    buffered_file_output_archive & operator=(const buffered_file_output_archive &) = delete;
+
+    template<typename T>
+    void operator()(T& t) {
+        if constexpr(has_type<T, archive_fundamental_types>::value) {
+            raw_bytes(&t, sizeof t);
+        } else {
+            serialize(*this, t);
+        }
+    }
+
+    template<typename... Ts>
+    void operator()(Ts&... t) {
+        (operator()(t), ...);
+    }
+
+    void raw_bytes(const void *data, size_t size) {
+        if (m_size + size > m_buffer.size()) {
+            flush();
+
+            if (size >= m_buffer.size()) {
+                m_file.write(reinterpret_cast<const char *>(data), size);
+                return;
+            }
+        }
+
+        std::memcpy(m_buffer.data() + m_size, data, size);
+        m_size += size;
+    }
+
+    /**
+     * @brief Writes the contents of the buffer to the file.
+     */
+    void flush() {
+        if (m_size > 0) {
+            m_file.write(reinterpret_cast<const char *>(m_buffer.data()), m_size);
+            m_size = 0;
+        }
+    }
+
+    void close() {
+        if (m_file.is_open()) {
+            flush();
+            m_file.close();
+        }
+    }
+
+private:
+    std::ofstream m_file;
+    std::vector<uint8_t> m_buffer;
+    size_t m_size {0};
+};
+
+/**
+ * @brief Reads a file written by a `file_output_archive` or a
+ * `buffered_file_output_archive`, filling a buffer with large blocks of the
+ * file at a time. Blocks larger than the buffer are read directly.
+ */
+class buffered_file_input_archive {
+public:
+    using is_input = std::true_type;
+    using is_output = std::false_type;
+
+    buffered_file_input_archive(const std::string &path,
+                                size_t buffer_size = file_archive_buffer_size)
+        : m_file(path, std::ios::binary | std::ios::in)
+        , m_buffer(buffer_size)
+    {}
+
+    buffered_file_input_archive(const buffered_file_input_archive &) = delete;
+    buffered_file_input_archive & operator=(const buffered_file_input_archive &) = delete;
+
+    bool is_file_open() const {
+        return m_file.is_open();
+    }
+
+    /**
+     * @brief Whether a read went past the end of the file.
+     */
+    bool is_file_at_end() const {
+        return m_at_end;
+    }
+
+    void close() {
+        m_file.close();
+    }
+
+    template<typename T>
+    void operator()(T& t) {
+        if constexpr(has_type<T, archive_fundamental_types>::value) {
+            raw_bytes(&t, sizeof t);
+        } else {
+            serialize(*this, t);
+        }
+    }
+
+    template<typename... Ts>
+    void operator()(Ts&... t) {
+        (operator()(t), ...);
+    }
+
+    void raw_bytes(void *data, size_t size) {
+        auto *dest = reinterpret_cast<uint8_t *>(data);
+        auto available = m_end - m_position;
+
+        if (size > available) {
+            // Consume what is left in the buffer and refill it.
+            std::memcpy(dest, m_buffer.data() + m_position, available);
+            dest += available;
+            size -= available;
+            m_position = m_end = 0;
+
+            if (size >= m_buffer.size()) {
+                m_file.read(reinterpret_cast<char *>(dest), size);
+                m_at_end |= static_cast<size_t>(m_file.gcount()) < size;
+                return;
+            }
+
+            m_file.read(reinterpret_cast<char *>(m_buffer.data()), m_buffer.size());
+            m_end = static_cast<size_t>(m_file.gcount());
+
+            if (size > m_end) {
+                m_at_end = true;
+                size = m_end;
+            }
+        }
+
+        std::memcpy(dest, m_buffer.data() + m_position, size);
+        m_position += size;
+    }
+
+private:
+    std::ifstream m_file;
+    std::vector<uint8_t> m_buffer;
+    size_t m_position {0};
+    size_t m_end {0};
+    bool m_at_end {false};
+};
+
+}
+
+#endif // EDYN_SERIALIZATION_BUFFERED_FILE_ARCHIVE_HPP
@@ -0,0 +1,37 @@
+#ifndef EDYN_SERIALIZATION_CONVEX_MESH_S11N_HPP
+#define EDYN_SERIALIZATION_CONVEX_MESH_S11N_HPP
+
+#include "edyn/shapes/convex_mesh.hpp"
+#include "edyn/serialization/std_s11n.hpp"
+#include "edyn/serialization/math_s11n.hpp"
+
+namespace edyn {
+
+template<typename Archive>
+void serialize(Archive &archive, convex_mesh &mesh) {
+    archive(mesh.vertices);
+    archive(mesh.indices);
+    archive(mesh.edges);
+    archive(mesh.edge_faces);
+    archive(mesh.faces);
+    archive(mesh.normals);
+    archive(mesh.adjacency_offsets);
+    archive(mesh.adjacency);
+}
+
+inline
+size_t serialization_sizeof(const convex_mesh &mesh) {
+    return
+        serialization_sizeof(mesh.vertices) +
+        serialization_sizeof(mesh.indices) +
+        serialization_sizeof(mesh.edges) +
+        serialization_sizeof(mesh.edge_faces) +
+        serialization_sizeof(mesh.faces) +
+        serialization_sizeof(mesh.normals) +
+        serialization_sizeof(mesh.adjacency_offsets) +
+        serialization_sizeof(mesh.adjacency);
+}
+
+}
+
+#endif // EDYN_SERIALIZATION_CONVEX_MESH_S11N_HPP
@@ -60,6 +60,11 @@ public:
         return m_file.tellg();
     }
 
+    void raw_bytes(void *data, size_t size) {
+        EDYN_ASSERT(m_file.is_open() && !m_file.eof());
+        m_file.read(reinterpret_cast<char *>(data), size);
+    }
+
 protected:
     template<typename T>
     void read_bytes(T &t) {
@@ -95,6 +100,10 @@ public:
         (operator()(t), ...);
     }
 
+    void raw_bytes(const void *data, size_t size) {
+        m_file.write(reinterpret_cast<const char *>(data), size);
+    }
+
     void close() {
         m_file.close();
     }
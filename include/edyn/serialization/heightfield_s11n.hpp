@@ -0,0 +1,44 @@
+#ifndef EDYN_SERIALIZATION_HEIGHTFIELD_S11N_HPP
+#define EDYN_SERIALIZATION_HEIGHTFIELD_S11N_HPP
+
+#include "edyn/shapes/heightfield.hpp"
+#include "edyn/serialization/std_s11n.hpp"
+#include "edyn/serialization/math_s11n.hpp"
+#include "edyn/serialization/comp/material_s11n.hpp"
+
+namespace edyn {
+
+template<typename Archive>
+void serialize(Archive &archive, heightfield &field) {
+    archive(field.m_num_rows);
+    archive(field.m_num_columns);
+    archive(field.m_cell_size);
+    archive(field.m_origin);
+    archive(field.m_min_height);
+    archive(field.m_height_scale);
+    archive(field.m_heights);
+    archive(field.m_materials);
+    archive(field.m_material_table);
+    archive(field.m_aabb.min);
+    archive(field.m_aabb.max);
+}
+
+inline
+size_t serialization_sizeof(const heightfield &field) {
+    return
+        sizeof(field.m_num_rows) +
+        sizeof(field.m_num_columns) +
+        sizeof(field.m_cell_size) +
+        sizeof(field.m_origin) +
+        sizeof(field.m_min_height) +
+        sizeof(field.m_height_scale) +
+        serialization_sizeof(field.m_heights) +
+        serialization_sizeof(field.m_materials) +
+        serialization_sizeof(field.m_material_table) +
+        sizeof(field.m_aabb.min) +
+        sizeof(field.m_aabb.max);
+}
+
+}
+
+#endif // EDYN_SERIALIZATION_HEIGHTFIELD_S11N_HPP
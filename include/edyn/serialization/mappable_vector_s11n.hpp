@@ -0,0 +1,32 @@
+#ifndef EDYN_SERIALIZATION_MAPPABLE_VECTOR_S11N_HPP
+#define EDYN_SERIALIZATION_MAPPABLE_VECTOR_S11N_HPP
+
+#include "edyn/util/mappable_vector.hpp"
+#include "edyn/serialization/s11n_util.hpp"
+
+namespace edyn {
+
+// Same format as `std::vector`.
+template<typename Archive, typename T>
+void serialize(Archive &archive, mappable_vector<T> &vector) {
+    auto size = vector.size();
+    archive(size);
+
+    if constexpr(Archive::is_output::value) {
+        // Use const access to avoid copying mapped elements.
+        const auto &const_vector = vector;
+        serialize_array(archive, const_cast<T *>(const_vector.data()), size);
+    } else {
+        vector.resize(size);
+        serialize_array(archive, vector.data(), size);
+    }
+}
+
+template<typename T>
+size_t serialization_sizeof(const mappable_vector<T> &vector) {
+    return sizeof(size_t) + vector.size() * sizeof(T);
+}
+
+}
+
+#endif // EDYN_SERIALIZATION_MAPPABLE_VECTOR_S11N_HPP
@@ -0,0 +1,171 @@
+#ifndef EDYN_SERIALIZATION_MAPPED_ARCHIVE_HPP
+#define EDYN_SERIALIZATION_MAPPED_ARCHIVE_HPP
+
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "edyn/config/config.h"
+#include "edyn/util/tuple_util.hpp"
+#include "edyn/util/mappable_vector.hpp"
+#include "edyn/serialization/s11n_util.hpp"
+
+namespace edyn {
+
+/**
+ * Alignment of the elements of a `mappable_vector` in a mapped archive.
+ */
+inline constexpr size_t mapped_archive_alignment = 16;
+
+/**
+ * @brief Writes to a file in a layout which can be memory-mapped and read
+ * back with a `mapped_input_archive` without copying the contents of a
+ * `mappable_vector`. Their elements are written as raw bytes aligned to
+ * `mapped_archive_alignment` relative to the beginning of the file, thus
+ * the file can only be read on platforms with the same data layout.
+ */
+class mapped_output_archive {
+public:
+    using is_input = std::false_type;
+    using is_output = std::true_type;
+
+    mapped_output_archive(const std::string &path)
+        : m_file(path, std::ios::binary | std::ios::out)
+    {
+        EDYN_ASSERT(m_file.good());
+    }
+
+    template<typename T>
+    void operator()(T& t) {
+        if constexpr(has_type<T, archive_fundamental_types>::value) {
+            write_bytes(&t, sizeof t);
+        } else if constexpr(is_mappable_vector_v<T>) {
+            // Use const access to avoid copying mapped elements.
+            const auto &vector = t;
+            auto size = vector.size();
+            write_bytes(&size, sizeof size);
+            align();
+            write_bytes(vector.data(), size * sizeof(typename T::value_type));
+        } else {
+            serialize(*this, t);
+        }
+    }
+
+    template<typename... Ts>
+    void operator()(Ts&... t) {
+        (operator()(t), ...);
+    }
+
+    /**
+     * @brief Pads the file with zeros up to the next multiple of
+     * `mapped_archive_alignment`.
+     */
+    void align() {
+        constexpr char zeros[mapped_archive_alignment] = {};
+        auto remainder = m_position % mapped_archive_alignment;
+
+        if (remainder != 0) {
+            write_bytes(zeros, mapped_archive_alignment - remainder);
+        }
+    }
+
+    size_t tell_position() const {
+        return m_position;
+    }
+
+    void raw_bytes(const void *data, size_t size) {
+        write_bytes(data, size);
+    }
+
+    void seek_position(size_t pos) {
+        m_file.seekp(pos);
+        m_position = pos;
+    }
+
+    void close() {
+        m_file.close();
+    }
+
+private:
+    void write_bytes(const void *data, size_t size) {
+        m_file.write(reinterpret_cast<const char *>(data), size);
+        m_position += size;
+    }
+
+    std::ofstream m_file;
+    size_t m_position {0};
+};
+
+/**
+ * @brief Reads data written by a `mapped_output_archive` from memory,
+ * usually a `mapped_file`. The `mappable_vector`s reference the buffer
+ * directly, which must outlive them. The buffer must start at a position of
+ * the file which is a multiple of `mapped_archive_alignment`.
+ */
+class mapped_input_archive {
+public:
+    using data_type = uint8_t;
+    using buffer_type = const data_type*;
+    using is_input = std::true_type;
+    using is_output = std::false_type;
+
+    mapped_input_archive(buffer_type buffer, size_t size)
+        : m_buffer(buffer)
+        , m_size(size)
+        , m_position(0)
+    {}
+
+    template<typename T>
+    void operator()(T& t) {
+        if constexpr(has_type<T, archive_fundamental_types>::value) {
+            read_bytes(&t, sizeof t);
+        } else if constexpr(is_mappable_vector_v<T>) {
+            using value_type = typename T::value_type;
+            size_t size;
+            read_bytes(&size, sizeof size);
+            align();
+            EDYN_ASSERT(m_position + size * sizeof(value_type) <= m_size);
+            t.map(reinterpret_cast<const value_type *>(m_buffer + m_position), size);
+            m_position += size * sizeof(value_type);
+        } else {
+            serialize(*this, t);
+        }
+    }
+
+    template<typename... Ts>
+    void operator()(Ts&... t) {
+        (operator()(t), ...);
+    }
+
+    void align() {
+        auto remainder = m_position % mapped_archive_alignment;
+
+        if (remainder != 0) {
+            m_position += mapped_archive_alignment - remainder;
+        }
+    }
+
+    size_t tell_position() const {
+        return m_position;
+    }
+
+    void raw_bytes(void *data, size_t size) {
+        read_bytes(data, size);
+    }
+
+private:
+    void read_bytes(void *data, size_t size) {
+        EDYN_ASSERT(m_position + size <= m_size);
+        std::memcpy(data, m_buffer + m_position, size);
+        m_position += size;
+    }
+
+    buffer_type m_buffer;
+    const size_t m_size;
+    size_t m_position;
+};
+
+}
+
+#endif // EDYN_SERIALIZATION_MAPPED_ARCHIVE_HPP
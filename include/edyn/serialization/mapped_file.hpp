@@ -0,0 +1,58 @@
+#ifndef EDYN_SERIALIZATION_MAPPED_FILE_HPP
+#define EDYN_SERIALIZATION_MAPPED_FILE_HPP
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace edyn {
+
+/**
+ * @brief A read-only memory mapping of an entire file. Pages are loaded by
+ * the operating system as they're accessed and can be evicted from memory at
+ * any time, since they're backed by the file.
+ */
+class mapped_file {
+public:
+    mapped_file() = default;
+
+    mapped_file(const std::string &path) {
+        open(path);
+    }
+
+    ~mapped_file() {
+        close();
+    }
+
+    mapped_file(const mapped_file &) = delete;
+    mapped_file & operator=(const mapped_file &) = delete;
+
+    /**
+     * @brief Maps a file into memory, closing the current mapping if any.
+     * @param path Path of the file.
+     * @return Whether the file was mapped successfully.
+     */
+    bool open(const std::string &path);
+
+    void close();
+
+    bool is_open() const {
+        return m_data != nullptr;
+    }
+
+    const uint8_t * data() const {
+        return m_data;
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+private:
+    const uint8_t *m_data {nullptr};
+    size_t m_size {0};
+};
+
+}
+
+#endif // EDYN_SERIALIZATION_MAPPED_FILE_HPP
@@ -23,6 +23,15 @@ void serialize(Archive &archive, matrix3x3 &m) {
     archive(m.row);
 }
 
+template<>
+struct is_raw_serializable<vector3> : std::bool_constant<sizeof(vector3) == 3 * sizeof(scalar)> {};
+
+template<>
+struct is_raw_serializable<quaternion> : std::bool_constant<sizeof(quaternion) == 4 * sizeof(scalar)> {};
+
+template<>
+struct is_raw_serializable<matrix3x3> : std::bool_constant<sizeof(matrix3x3) == 9 * sizeof(scalar)> {};
+
 }
 
 #endif // EDYN_SERIALIZATION_MATH_S11N_HPP
\ No newline at end of file
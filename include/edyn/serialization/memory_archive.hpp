@@ -2,6 +2,7 @@
 #define EDYN_SERIALIZATION_MEMORY_ARCHIVE_HPP
 
 #include <cstdint>
+#include <cstring>
 #include <type_traits>
 #include <vector>
 #include <array>
@@ -39,6 +40,12 @@ public:
         (operator()(t), ...);
     }
 
+    void raw_bytes(void *data, size_t size) {
+        EDYN_ASSERT(m_position + size <= m_size);
+        std::memcpy(data, m_buffer + m_position, size);
+        m_position += size;
+    }
+
 protected:
     template<typename T>
     void read_bytes(T &t) {
@@ -79,6 +86,12 @@ public:
         (operator()(t), ...);
     }
 
+    void raw_bytes(const void *data, size_t size) {
+        auto idx = m_buffer->size();
+        m_buffer->resize(idx + size);
+        std::memcpy(m_buffer->data() + idx, data, size);
+    }
+
 protected:
     template<typename T>
     void write_bytes(T &t) { 
@@ -118,6 +131,12 @@ public:
         (operator()(t), ...);
     }
 
+    void raw_bytes(const void *data, size_t size) {
+        EDYN_ASSERT(m_position + size <= m_size);
+        std::memcpy(m_buffer + m_position, data, size);
+        m_position += size;
+    }
+
 protected:
     template<typename T>
     void write_bytes(T &t) { 
@@ -13,6 +13,9 @@ namespace edyn {
 
 class paged_triangle_mesh_file_output_archive;
 class paged_triangle_mesh_file_input_archive;
+class paged_triangle_mesh_mapped_loader;
+class mapped_output_archive;
+class mapped_file;
 class load_mesh_job;
 class finish_load_mesh_job;
 
@@ -22,6 +25,17 @@ void serialize(paged_triangle_mesh_file_output_archive &archive,
 void serialize(paged_triangle_mesh_file_input_archive &archive,
                paged_triangle_mesh &paged_tri_mesh);
 
+/**
+ * Writes a `paged_triangle_mesh` in a layout which can be memory-mapped and
+ * loaded using a `paged_triangle_mesh_mapped_loader`. All submeshes must be
+ * in the cache, which is the case right after `create_paged_triangle_mesh`.
+ */
+void serialize(mapped_output_archive &archive,
+               paged_triangle_mesh &paged_tri_mesh);
+
+void serialize(paged_triangle_mesh_mapped_loader &loader,
+               paged_triangle_mesh &paged_tri_mesh);
+
 /**
  * A `paged_triangle_mesh` can have each of its submeshes serialized into separate
  * files or have everything inside a single file.
@@ -116,6 +130,8 @@ public:
 
     void load(size_t index) override;
 
+    void load_blocking(size_t index) override;
+
     virtual entt::sink<loaded_mesh_func_t> on_load_sink() override {
         return entt::sink {m_loaded_signal};
     }
@@ -126,6 +142,10 @@ public:
     friend void finish_load_mesh_job_func(job::data_type &);
 
 private:
+    // Reads a submesh using its own file handle, which allows multiple
+    // submeshes to be loaded concurrently.
+    std::shared_ptr<triangle_mesh> read_submesh(size_t index) const;
+
     std::string m_path;
     size_t m_base_offset;
     std::vector<size_t> m_offsets;
@@ -133,6 +153,41 @@ private:
     entt::sigh<loaded_mesh_func_t> m_loaded_signal;
 };
 
+/**
+ * Page loader for a `paged_triangle_mesh` written with a
+ * `mapped_output_archive`. The file is memory-mapped and the arrays of a
+ * loaded submesh reference the mapped pages directly, thus loading a submesh
+ * involves no parsing or copying and is done synchronously. Unloading a
+ * submesh drops the view and the operating system manages which pages stay
+ * in memory.
+ */
+class paged_triangle_mesh_mapped_loader: public triangle_mesh_page_loader_base {
+public:
+    paged_triangle_mesh_mapped_loader(const std::string &path);
+
+    /**
+     * @brief Whether the file was mapped and its layout is compatible with
+     * this build.
+     */
+    bool is_open() const;
+
+    void load(size_t index) override;
+
+    virtual entt::sink<loaded_mesh_func_t> on_load_sink() override {
+        return entt::sink {m_loaded_signal};
+    }
+
+    friend void serialize(paged_triangle_mesh_mapped_loader &loader,
+                          paged_triangle_mesh &paged_tri_mesh);
+
+private:
+    // Shared with the loaded submeshes, which keep the mapping alive.
+    std::shared_ptr<mapped_file> m_file;
+    bool m_compatible {false};
+    std::vector<size_t> m_offsets;
+    entt::sigh<loaded_mesh_func_t> m_loaded_signal;
+};
+
 /**
  * Job used to load submeshes in the background.
  */
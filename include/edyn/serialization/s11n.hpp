@@ -7,5 +7,11 @@
 #include "edyn/serialization/triangle_mesh_s11n.hpp"
 #include "edyn/serialization/paged_triangle_mesh_s11n.hpp"
 #include "edyn/serialization/entt_s11n.hpp"
+#include "edyn/serialization/convex_mesh_s11n.hpp"
+#include "edyn/serialization/heightfield_s11n.hpp"
 #include "edyn/serialization/file_archive.hpp"
-#include "edyn/serialization/memory_archive.hpp"
\ No newline at end of file
+#include "edyn/serialization/buffered_file_archive.hpp"
+#include "edyn/serialization/memory_archive.hpp"
+#include "edyn/serialization/mapped_archive.hpp"
+#include "edyn/serialization/mapped_file.hpp"
+#include "edyn/serialization/snapshot.hpp"
\ No newline at end of file
@@ -2,6 +2,11 @@
 #define EDYN_SERIALIZATION_S11N_UTIL_HPP
 
 #include <tuple>
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+#include <array>
+#include "edyn/util/tuple_util.hpp"
 
 namespace edyn {
 
@@ -24,6 +29,75 @@ using archive_fundamental_types = std::tuple<
 template<typename Archive, typename T>
 void serialize(Archive &, T &);
 
+/**
+ * @brief Checks whether an archive is able to transfer a contiguous block of
+ * bytes in a single call, via a member function `raw_bytes(void *, size_t)`.
+ */
+template<typename Archive, typename = void>
+struct has_raw_bytes : std::false_type {};
+
+template<typename Archive>
+struct has_raw_bytes<Archive, std::void_t<decltype(
+    std::declval<Archive &>().raw_bytes(std::declval<void *>(), std::declval<size_t>()))>>
+    : std::true_type {};
+
+/**
+ * @brief Whether the serialized form of `T` is identical to its memory
+ * representation, which allows contiguous arrays of it to be transferred as
+ * a single block of bytes without changing the format. Specialize it for
+ * types whose `serialize` function writes all members in declaration order
+ * and which have no padding.
+ */
+template<typename T>
+struct is_raw_serializable : has_type<T, archive_fundamental_types> {};
+
+template<typename T, size_t N>
+struct is_raw_serializable<std::array<T, N>> : is_raw_serializable<T> {};
+
+template<typename T>
+inline constexpr bool is_raw_serializable_v = is_raw_serializable<T>::value;
+
+/**
+ * @brief Serializes an array of trivially copyable objects as raw bytes. The
+ * result is only valid on platforms with the same data layout.
+ * @param archive Input or output archive.
+ * @param data Pointer to the first element.
+ * @param count Number of elements.
+ */
+template<typename Archive, typename T>
+void serialize_raw(Archive &archive, T *data, size_t count) {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    if constexpr(has_raw_bytes<Archive>::value) {
+        archive.raw_bytes(data, count * sizeof(T));
+    } else {
+        auto *bytes = reinterpret_cast<unsigned char *>(data);
+
+        for (size_t i = 0; i < count * sizeof(T); ++i) {
+            archive(bytes[i]);
+        }
+    }
+}
+
+/**
+ * @brief Serializes a contiguous array element by element, or as a single
+ * block of bytes if the elements are raw serializable and the archive
+ * supports it. Both produce the same result.
+ * @param archive Input or output archive.
+ * @param data Pointer to the first element.
+ * @param count Number of elements.
+ */
+template<typename Archive, typename T>
+void serialize_array(Archive &archive, T *data, size_t count) {
+    if constexpr(is_raw_serializable_v<T> && has_raw_bytes<Archive>::value) {
+        archive.raw_bytes(data, count * sizeof(T));
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            archive(data[i]);
+        }
+    }
+}
+
 }
 
-#endif // EDYN_SERIALIZATION_S11N_UTIL_HPP
\ No newline at end of file
+#endif // EDYN_SERIALIZATION_S11N_UTIL_HPP
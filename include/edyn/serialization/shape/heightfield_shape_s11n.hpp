@@ -0,0 +1,26 @@
+#ifndef EDYN_SERIALIZATION_SHAPE_HEIGHTFIELD_SHAPE_S11N_HPP
+#define EDYN_SERIALIZATION_SHAPE_HEIGHTFIELD_SHAPE_S11N_HPP
+
+#include <cstdint>
+#include "edyn/shapes/heightfield_shape.hpp"
+
+namespace edyn {
+
+template<typename Archive>
+void serialize(Archive &archive, heightfield_shape &s) {
+    if constexpr(Archive::is_output::value) {
+        auto *field_ptr = new std::shared_ptr(s.field);
+        auto intptr = reinterpret_cast<intptr_t>(field_ptr);
+        archive(intptr);
+    } else {
+        intptr_t intptr;
+        archive(intptr);
+        auto *field_ptr = reinterpret_cast<std::shared_ptr<heightfield> *>(intptr);
+        s.field = *field_ptr;
+        delete field_ptr;
+    }
+}
+
+}
+
+#endif // EDYN_SERIALIZATION_SHAPE_HEIGHTFIELD_SHAPE_S11N_HPP
@@ -4,4 +4,5 @@
 #include "edyn/serialization/shape/capsule_shape_s11n.hpp"
 #include "edyn/serialization/shape/sphere_shape_s11n.hpp"
 #include "edyn/serialization/shape/mesh_shape_s11n.hpp"
-#include "edyn/serialization/shape/paged_mesh_shape_s11n.hpp"
\ No newline at end of file
+#include "edyn/serialization/shape/paged_mesh_shape_s11n.hpp"
+#include "edyn/serialization/shape/heightfield_shape_s11n.hpp"
\ No newline at end of file
@@ -0,0 +1,528 @@
+#ifndef EDYN_SERIALIZATION_SNAPSHOT_HPP
+#define EDYN_SERIALIZATION_SNAPSHOT_HPP
+
+#include <tuple>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <variant>
+#include <utility>
+#include <type_traits>
+#include <unordered_map>
+#include <entt/entity/registry.hpp>
+#include "edyn/config/config.h"
+#include "edyn/comp/shared_comp.hpp"
+#include "edyn/comp/graph_node.hpp"
+#include "edyn/comp/graph_edge.hpp"
+#include "edyn/comp/present_position.hpp"
+#include "edyn/comp/present_orientation.hpp"
+#include "edyn/parallel/entity_graph.hpp"
+#include "edyn/parallel/merge/merge_component.hpp"
+#include "edyn/parallel/merge/merge_contact_point.hpp"
+#include "edyn/parallel/merge/merge_contact_manifold.hpp"
+#include "edyn/parallel/merge/merge_constraint.hpp"
+#include "edyn/parallel/merge/merge_collision_exclusion.hpp"
+#include "edyn/serialization/s11n_util.hpp"
+#include "edyn/serialization/math_s11n.hpp"
+#include "edyn/serialization/convex_mesh_s11n.hpp"
+#include "edyn/serialization/triangle_mesh_s11n.hpp"
+#include "edyn/serialization/heightfield_s11n.hpp"
+#include "edyn/serialization/static_tree_s11n.hpp"
+#include "edyn/util/entity_map.hpp"
+#include "edyn/util/tuple_util.hpp"
+
+namespace edyn {
+
+class paged_triangle_mesh;
+
+/**
+ * Tuple of components stored in a snapshot. Components are assigned in this
+ * order when a snapshot is loaded, thus `AABB`, `collision_filter` and
+ * `collision_exclusion` come before `static_tag` and `kinematic_tag`, which
+ * insert the entity into the broad-phase tree when constructed.
+ */
+static const auto snapshot_components = std::tuple_cat(std::tuple<
+    AABB,
+    collision_filter,
+    collision_exclusion,
+    constraint_impulse,
+    inertia,
+    inertia_inv,
+    inertia_world_inv,
+    gravity,
+    angvel,
+    linvel,
+    mass,
+    mass_inv,
+    material,
+    position,
+    orientation,
+    present_position,
+    present_orientation,
+    center_of_mass,
+    contact_manifold,
+    contact_point,
+    continuous,
+    shape_index,
+    dynamic_tag,
+    kinematic_tag,
+    static_tag,
+    procedural_tag,
+    sleeping_tag,
+    sleeping_disabled_tag,
+    disabled_tag,
+    continuous_contacts_tag,
+    external_tag,
+    rigidbody_tag
+>{}, constraints_tuple, shapes_tuple);
+
+namespace detail {
+
+struct snapshot_header {
+    static constexpr uint32_t magic_value = 0x53534445; // "EDSS"
+    static constexpr uint32_t current_version = 1;
+
+    uint32_t magic {magic_value};
+    uint32_t version {current_version};
+    uint32_t scalar_size {sizeof(scalar)};
+    uint32_t entity_size {sizeof(entt::entity)};
+    uint32_t num_component_types {std::tuple_size_v<std::decay_t<decltype(snapshot_components)>>};
+
+    bool operator==(const snapshot_header &other) const {
+        return magic == other.magic &&
+               version == other.version &&
+               scalar_size == other.scalar_size &&
+               entity_size == other.entity_size &&
+               num_component_types == other.num_component_types;
+    }
+};
+
+template<typename Archive>
+void serialize(Archive &archive, snapshot_header &header) {
+    archive(header.magic);
+    archive(header.version);
+    archive(header.scalar_size);
+    archive(header.entity_size);
+    archive(header.num_component_types);
+}
+
+/**
+ * Shape data which can be shared among many entities. Each object is stored
+ * only once in a table and shapes refer to it by its index in the table.
+ */
+struct snapshot_shared_data {
+    static constexpr uint32_t null_index = UINT32_MAX;
+
+    std::vector<std::shared_ptr<convex_mesh>> convex_meshes;
+    std::vector<std::shared_ptr<triangle_mesh>> triangle_meshes;
+    std::vector<std::shared_ptr<heightfield>> heightfields;
+    std::vector<std::shared_ptr<paged_triangle_mesh>> paged_triangle_meshes;
+
+    // Index of each object in its table. Only used while saving.
+    std::unordered_map<const void *, uint32_t> indices;
+
+    template<typename T>
+    void insert(std::vector<std::shared_ptr<T>> &table, const std::shared_ptr<T> &object) {
+        if (object && indices.count(object.get()) == 0) {
+            indices[object.get()] = static_cast<uint32_t>(table.size());
+            table.push_back(object);
+        }
+    }
+
+    void insert_shapes(const compound_shape &compound) {
+        for (auto &node : compound.nodes) {
+            if (auto *polyhedron = std::get_if<polyhedron_shape>(&node.shape_var)) {
+                insert(convex_meshes, polyhedron->mesh);
+            }
+        }
+    }
+};
+
+/**
+ * Translates the component type ids in a `continuous` into indices in the
+ * `shared_components` tuple and back, since the ids are only valid in the
+ * current process. Types which are not in `shared_components` are dropped.
+ */
+void continuous_to_snapshot(continuous &);
+void continuous_from_snapshot(continuous &);
+
+template<typename Component>
+void component_to_snapshot(Component &comp) {
+    if constexpr(std::is_same_v<Component, continuous>) {
+        continuous_to_snapshot(comp);
+    }
+}
+
+template<typename Component>
+void component_from_snapshot(Component &comp) {
+    if constexpr(std::is_same_v<Component, continuous>) {
+        continuous_from_snapshot(comp);
+    }
+}
+
+/**
+ * Entities stored in a snapshot: rigid bodies and other graph nodes,
+ * constraints, contact manifolds and contact points.
+ */
+inline bool is_snapshot_entity(const entt::registry &registry, entt::entity entity) {
+    return registry.any_of<graph_node, graph_edge, contact_point>(entity);
+}
+
+template<typename Archive, typename T>
+void serialize_shared_ref(Archive &archive, std::shared_ptr<T> &object,
+                          const std::vector<std::shared_ptr<T>> &table,
+                          const snapshot_shared_data &shared) {
+    auto index = snapshot_shared_data::null_index;
+
+    if constexpr(Archive::is_output::value) {
+        if (object) {
+            auto it = shared.indices.find(object.get());
+            // Paged triangle meshes must be provided by the caller.
+            EDYN_ASSERT(it != shared.indices.end());
+            index = it != shared.indices.end() ? it->second : index;
+        }
+    }
+
+    archive(index);
+
+    if constexpr(Archive::is_input::value) {
+        object = index < table.size() ? table[index] : nullptr;
+    }
+}
+
+template<typename Archive, typename Shape>
+void serialize_snapshot_shape(Archive &archive, Shape &shape, snapshot_shared_data &shared);
+
+template<typename Archive, typename... Ts, size_t... Indices>
+void serialize_snapshot_shape_variant(Archive &archive, std::variant<Ts...> &var,
+                                      snapshot_shared_data &shared,
+                                      std::index_sequence<Indices...>) {
+    auto index = var.index();
+    archive(index);
+
+    if constexpr(Archive::is_input::value) {
+        ((index == Indices ? (void)var.template emplace<Indices>() : (void)0), ...);
+    }
+
+    std::visit([&] (auto &&alternative) {
+        serialize_snapshot_shape(archive, alternative, shared);
+    }, var);
+}
+
+template<typename Archive, typename... Ts>
+void serialize_snapshot_shape_variant(Archive &archive, std::variant<Ts...> &var,
+                                      snapshot_shared_data &shared) {
+    serialize_snapshot_shape_variant(archive, var, shared, std::index_sequence_for<Ts...>{});
+}
+
+template<typename Archive, typename Shape>
+void serialize_snapshot_shape(Archive &archive, Shape &shape, snapshot_shared_data &shared) {
+    if constexpr(std::is_same_v<Shape, polyhedron_shape>) {
+        serialize_shared_ref(archive, shape.mesh, shared.convex_meshes, shared);
+
+        if constexpr(Archive::is_input::value) {
+            // Assigned by the island worker.
+            shape.rotated = nullptr;
+        }
+    } else if constexpr(std::is_same_v<Shape, compound_shape>) {
+        auto size = shape.nodes.size();
+        archive(size);
+        shape.nodes.resize(size);
+
+        for (auto &node : shape.nodes) {
+            serialize_snapshot_shape_variant(archive, node.shape_var, shared);
+            archive(node.position);
+            archive(node.orientation);
+            archive(node.aabb.min);
+            archive(node.aabb.max);
+        }
+
+        archive(shape.tree);
+    } else if constexpr(std::is_same_v<Shape, mesh_shape>) {
+        serialize_shared_ref(archive, shape.trimesh, shared.triangle_meshes, shared);
+    } else if constexpr(std::is_same_v<Shape, paged_mesh_shape>) {
+        serialize_shared_ref(archive, shape.trimesh, shared.paged_triangle_meshes, shared);
+    } else if constexpr(std::is_same_v<Shape, heightfield_shape>) {
+        serialize_shared_ref(archive, shape.field, shared.heightfields, shared);
+    } else {
+        serialize_raw(archive, &shape, 1);
+    }
+}
+
+template<typename Archive, typename T>
+void serialize_shared_table(Archive &archive, std::vector<std::shared_ptr<T>> &table) {
+    auto size = table.size();
+    archive(size);
+    table.resize(size);
+
+    for (auto &object : table) {
+        if constexpr(Archive::is_input::value) {
+            object = std::make_shared<T>();
+        }
+
+        archive(*object);
+    }
+}
+
+template<typename Archive, typename Component>
+void save_snapshot_components(Archive &archive, entt::registry &registry,
+                              snapshot_shared_data &shared) {
+    auto entities = std::vector<entt::entity>{};
+
+    for (auto entity : registry.view<Component>()) {
+        if (is_snapshot_entity(registry, entity)) {
+            entities.push_back(entity);
+        }
+    }
+
+    auto count = entities.size();
+    archive(count);
+    serialize_raw(archive, entities.data(), count);
+
+    if constexpr(std::is_empty_v<Component>) {
+        return;
+    } else if constexpr(std::is_trivially_copyable_v<Component>) {
+        // Copy into a contiguous array to write all components at once.
+        auto components = std::vector<Component>{};
+        components.reserve(count);
+
+        for (auto entity : entities) {
+            auto &comp = components.emplace_back(registry.get<Component>(entity));
+            component_to_snapshot(comp);
+        }
+
+        serialize_raw(archive, components.data(), count);
+    } else {
+        for (auto entity : entities) {
+            serialize_snapshot_shape(archive, registry.get<Component>(entity), shared);
+        }
+    }
+}
+
+template<typename Archive, typename Component>
+void load_snapshot_components(Archive &archive, entt::registry &registry,
+                              const entity_map &map, snapshot_shared_data &shared) {
+    size_t count;
+    archive(count);
+    auto entities = std::vector<entt::entity>(count);
+    serialize_raw(archive, entities.data(), count);
+
+    if constexpr(std::is_empty_v<Component>) {
+        for (auto entity : entities) {
+            registry.emplace<Component>(map.remloc(entity));
+        }
+    } else if constexpr(std::is_trivially_copyable_v<Component>) {
+        auto components = std::vector<Component>(count);
+        serialize_raw(archive, components.data(), count);
+        auto ctx = merge_context{&registry, &map};
+
+        for (size_t i = 0; i < count; ++i) {
+            auto &comp = components[i];
+            component_from_snapshot(comp);
+            // Replace the saved entities referenced by the component.
+            merge(static_cast<const Component *>(nullptr), comp, ctx);
+            registry.emplace<Component>(map.remloc(entities[i]), comp);
+        }
+    } else {
+        for (auto entity : entities) {
+            auto comp = Component{};
+            serialize_snapshot_shape(archive, comp, shared);
+            registry.emplace<Component>(map.remloc(entity), std::move(comp));
+        }
+    }
+}
+
+/**
+ * Inserts nodes and edges into the entity graph. The two node entities of
+ * each edge are stored in sequence in `edge_node_entities`.
+ */
+void load_snapshot_graph(entt::registry &registry,
+                         const std::vector<entt::entity> &node_entities,
+                         const std::vector<entt::entity> &edge_entities,
+                         const std::vector<entt::entity> &edge_node_entities);
+
+}
+
+/**
+ * @brief Writes the state of all rigid bodies, constraints and contacts in a
+ * registry into an archive. The snapshot can be loaded into a registry with
+ * `load_snapshot` to resume the simulation exactly where it was saved, with
+ * warm-started contacts and the same islands asleep.
+ * @remark Components are written as raw memory thus a snapshot can only be
+ * loaded on platforms with the same data layout, which is verified upon
+ * loading. Shared shape data such as convex and triangle meshes is stored
+ * once, regardless of how many shapes reference it. Paged triangle meshes
+ * are not stored since they are backed by their own files. Instead, they're
+ * stored as an index into `paged_meshes`, and the same meshes must be
+ * provided to `load_snapshot` in the same order.
+ * @param registry Data source.
+ * @param archive Output archive.
+ * @param paged_meshes All paged triangle meshes referenced by shapes in the
+ * registry.
+ */
+template<typename Archive>
+void save_snapshot(entt::registry &registry, Archive &archive,
+                   const std::vector<std::shared_ptr<paged_triangle_mesh>> &paged_meshes = {}) {
+    auto header = detail::snapshot_header{};
+    archive(header);
+
+    auto entities = std::vector<entt::entity>{};
+
+    for (auto entity : registry.view<graph_node>()) {
+        entities.push_back(entity);
+    }
+
+    for (auto entity : registry.view<graph_edge>()) {
+        entities.push_back(entity);
+    }
+
+    for (auto entity : registry.view<contact_point>()) {
+        entities.push_back(entity);
+    }
+
+    auto num_entities = entities.size();
+    archive(num_entities);
+    serialize_raw(archive, entities.data(), num_entities);
+
+    // Collect shared shape data.
+    auto shared = detail::snapshot_shared_data{};
+
+    for (auto &mesh : paged_meshes) {
+        shared.insert(shared.paged_triangle_meshes, mesh);
+    }
+
+    for (auto entity : registry.view<polyhedron_shape>()) {
+        shared.insert(shared.convex_meshes, registry.get<polyhedron_shape>(entity).mesh);
+    }
+
+    for (auto entity : registry.view<compound_shape>()) {
+        shared.insert_shapes(registry.get<compound_shape>(entity));
+    }
+
+    for (auto entity : registry.view<mesh_shape>()) {
+        shared.insert(shared.triangle_meshes, registry.get<mesh_shape>(entity).trimesh);
+    }
+
+    for (auto entity : registry.view<heightfield_shape>()) {
+        shared.insert(shared.heightfields, registry.get<heightfield_shape>(entity).field);
+    }
+
+    detail::serialize_shared_table(archive, shared.convex_meshes);
+    detail::serialize_shared_table(archive, shared.triangle_meshes);
+    detail::serialize_shared_table(archive, shared.heightfields);
+
+    auto num_paged_meshes = shared.paged_triangle_meshes.size();
+    archive(num_paged_meshes);
+
+    std::apply([&] (auto ... c) {
+        (detail::save_snapshot_components<Archive, decltype(c)>(archive, registry, shared), ...);
+    }, snapshot_components);
+
+    // Write the graph topology.
+    auto &graph = registry.ctx<entity_graph>();
+    auto node_entities = std::vector<entt::entity>{};
+    auto edge_entities = std::vector<entt::entity>{};
+    auto edge_node_entities = std::vector<entt::entity>{};
+
+    for (auto entity : registry.view<graph_node>()) {
+        node_entities.push_back(entity);
+    }
+
+    auto edge_view = registry.view<graph_edge>();
+
+    for (auto entity : edge_view) {
+        auto &edge = std::get<0>(edge_view.get(entity));
+        auto nodes = graph.edge_node_entities(edge.edge_index);
+        edge_entities.push_back(entity);
+        edge_node_entities.push_back(nodes.first);
+        edge_node_entities.push_back(nodes.second);
+    }
+
+    auto num_nodes = node_entities.size();
+    archive(num_nodes);
+    serialize_raw(archive, node_entities.data(), num_nodes);
+
+    auto num_edges = edge_entities.size();
+    archive(num_edges);
+    serialize_raw(archive, edge_entities.data(), num_edges);
+    serialize_raw(archive, edge_node_entities.data(), num_edges * 2);
+}
+
+/**
+ * @brief Creates the entities stored in a snapshot written by `save_snapshot`
+ * in a registry where Edyn is attached. The entities are inserted alongside
+ * any existing entities, with new identifiers. Islands are created in the
+ * next update.
+ * @param registry Destination registry.
+ * @param archive Input archive.
+ * @param paged_meshes The same paged triangle meshes given to `save_snapshot`
+ * in the same order.
+ * @return Whether the snapshot is valid and compatible with this build, and
+ * all paged triangle meshes were provided. Nothing is loaded otherwise.
+ */
+template<typename Archive>
+bool load_snapshot(entt::registry &registry, Archive &archive,
+                   const std::vector<std::shared_ptr<paged_triangle_mesh>> &paged_meshes = {}) {
+    auto header = detail::snapshot_header{};
+    auto expected_header = header;
+    archive(header);
+
+    if (!(header == expected_header)) {
+        return false;
+    }
+
+    size_t num_entities;
+    archive(num_entities);
+    auto entities = std::vector<entt::entity>(num_entities);
+    serialize_raw(archive, entities.data(), num_entities);
+
+    auto shared = detail::snapshot_shared_data{};
+    detail::serialize_shared_table(archive, shared.convex_meshes);
+    detail::serialize_shared_table(archive, shared.triangle_meshes);
+    detail::serialize_shared_table(archive, shared.heightfields);
+
+    size_t num_paged_meshes;
+    archive(num_paged_meshes);
+
+    if (paged_meshes.size() < num_paged_meshes) {
+        return false;
+    }
+
+    shared.paged_triangle_meshes = paged_meshes;
+
+    auto map = entity_map{};
+
+    for (auto entity : entities) {
+        map.insert(entity, registry.create());
+    }
+
+    std::apply([&] (auto ... c) {
+        (detail::load_snapshot_components<Archive, decltype(c)>(archive, registry, map, shared), ...);
+    }, snapshot_components);
+
+    size_t num_nodes;
+    archive(num_nodes);
+    auto node_entities = std::vector<entt::entity>(num_nodes);
+    serialize_raw(archive, node_entities.data(), num_nodes);
+
+    size_t num_edges;
+    archive(num_edges);
+    auto edge_entities = std::vector<entt::entity>(num_edges);
+    auto edge_node_entities = std::vector<entt::entity>(num_edges * 2);
+    serialize_raw(archive, edge_entities.data(), num_edges);
+    serialize_raw(archive, edge_node_entities.data(), num_edges * 2);
+
+    for (auto *entities : {&node_entities, &edge_entities, &edge_node_entities}) {
+        for (auto &entity : *entities) {
+            entity = map.remloc(entity);
+        }
+    }
+
+    detail::load_snapshot_graph(registry, node_entities, edge_entities, edge_node_entities);
+
+    return true;
+}
+
+}
+
+#endif // EDYN_SERIALIZATION_SNAPSHOT_HPP
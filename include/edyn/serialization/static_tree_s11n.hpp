@@ -2,36 +2,50 @@
 #define EDYN_SERIALIZATION_STATIC_TREE_S11N_HPP
 
 #include "edyn/collision/static_tree.hpp"
+#include "edyn/serialization/std_s11n.hpp"
+#include "edyn/serialization/mappable_vector_s11n.hpp"
 
 namespace edyn {
 
 template<typename Archive>
-void serialize(Archive &archive, static_tree::tree_node &node) {
-    archive(node.aabb.min);
-    archive(node.aabb.max);
+void serialize(Archive &archive, static_tree::packed_node &node) {
+    archive(node.min);
+    archive(node.max);
     archive(node.child1);
     archive(node.child2);
 }
 
+template<>
+struct is_raw_serializable<static_tree::packed_node>
+    : std::bool_constant<sizeof(static_tree::packed_node) ==
+                         2 * sizeof(std::array<uint16_t, 3>) + 2 * sizeof(uint32_t)> {};
+
 template<typename Archive>
 void serialize(Archive &archive, static_tree &tree) {
     archive(tree.m_nodes);
+    archive(tree.m_aabb.min);
+    archive(tree.m_aabb.max);
+    archive(tree.m_quantization_scale);
 }
 
 inline
-size_t serialization_sizeof(const static_tree::tree_node &node) {
+size_t serialization_sizeof(const static_tree::packed_node &node) {
     return 
-        sizeof(node.aabb.min) +
-        sizeof(node.aabb.max) +
+        sizeof(node.min) +
+        sizeof(node.max) +
         sizeof(node.child1) +
         sizeof(node.child2);
 }
 
 inline
 size_t serialization_sizeof(const static_tree &tree) {
-    return serialization_sizeof(tree.m_nodes);
+    return
+        serialization_sizeof(tree.m_nodes) +
+        sizeof(tree.m_aabb.min) +
+        sizeof(tree.m_aabb.max) +
+        sizeof(tree.m_quantization_scale);
 }
 
 }
 
-#endif // EDYN_SERIALIZATION_STATIC_TREE_S11N_HPP
\ No newline at end of file
+#endif // EDYN_SERIALIZATION_STATIC_TREE_S11N_HPP
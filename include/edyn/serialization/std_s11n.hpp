@@ -10,6 +10,7 @@
 #include <type_traits>
 #include <entt/core/ident.hpp>
 #include "edyn/util/tuple_util.hpp"
+#include "edyn/serialization/s11n_util.hpp"
 
 namespace edyn {
 
@@ -29,10 +30,7 @@ void serialize(Archive &archive, std::vector<T> &vector) {
     auto size = vector.size();
     archive(size);
     vector.resize(size);
-
-    for (size_t i = 0; i < size; ++i) {
-        archive(vector[i]);
-    }
+    serialize_array(archive, vector.data(), size);
 }
 
 template<typename Archive>
@@ -83,9 +81,7 @@ size_t serialization_sizeof(const std::vector<bool> &vec) {
 
 template<typename Archive, typename T, size_t N>
 void serialize(Archive &archive, std::array<T, N> &arr) {
-    for (size_t i = 0; i < arr.size(); ++i) {
-        archive(arr[i]);
-    }
+    serialize_array(archive, arr.data(), N);
 }
 
 namespace internal {
@@ -3,6 +3,8 @@
 
 #include "edyn/shapes/triangle_mesh.hpp"
 #include "edyn/serialization/std_s11n.hpp"
+#include "edyn/serialization/math_s11n.hpp"
+#include "edyn/serialization/mappable_vector_s11n.hpp"
 #include "edyn/serialization/static_tree_s11n.hpp"
 
 namespace edyn {
@@ -13,6 +15,10 @@ void serialize(Archive &archive, commutative_pair<T> &pair) {
     archive(pair.second);
 }
 
+template<typename T>
+struct is_raw_serializable<commutative_pair<T>>
+    : std::bool_constant<is_raw_serializable_v<T> && sizeof(commutative_pair<T>) == 2 * sizeof(T)> {};
+
 template<typename T>
 constexpr size_t serialization_sizeof(const commutative_pair<T> &pair) {
     return 2 * sizeof(T);
@@ -32,11 +38,14 @@ size_t serialization_sizeof(const flat_nested_array<T> &array) {
 template<typename Archive>
 void serialize(Archive &archive, triangle_mesh &tri_mesh) {
     archive(tri_mesh.m_vertices);
+    archive(tri_mesh.m_quantized_vertices);
+    archive(tri_mesh.m_quantization_origin);
+    archive(tri_mesh.m_quantization_scale);
     archive(tri_mesh.m_indices);
     archive(tri_mesh.m_normals);
+    archive(tri_mesh.m_external_adjacent_keys);
+    archive(tri_mesh.m_external_adjacent_normals);
     archive(tri_mesh.m_edge_vertex_indices);
-    archive(tri_mesh.m_vertex_edge_indices);
-    archive(tri_mesh.m_adjacent_normals);
     archive(tri_mesh.m_face_edge_indices);
     archive(tri_mesh.m_edge_face_indices);
     archive(tri_mesh.m_is_boundary_edge);
@@ -48,11 +57,14 @@ inline
 size_t serialization_sizeof(const triangle_mesh &tri_mesh) {
     return
         serialization_sizeof(tri_mesh.m_vertices) +
+        serialization_sizeof(tri_mesh.m_quantized_vertices) +
+        sizeof(tri_mesh.m_quantization_origin) +
+        sizeof(tri_mesh.m_quantization_scale) +
         serialization_sizeof(tri_mesh.m_indices) +
         serialization_sizeof(tri_mesh.m_normals) +
+        serialization_sizeof(tri_mesh.m_external_adjacent_keys) +
+        serialization_sizeof(tri_mesh.m_external_adjacent_normals) +
         serialization_sizeof(tri_mesh.m_edge_vertex_indices) +
-        serialization_sizeof(tri_mesh.m_vertex_edge_indices) +
-        serialization_sizeof(tri_mesh.m_adjacent_normals) +
         serialization_sizeof(tri_mesh.m_face_edge_indices) +
         serialization_sizeof(tri_mesh.m_edge_face_indices) +
         serialization_sizeof(tri_mesh.m_is_boundary_edge) +
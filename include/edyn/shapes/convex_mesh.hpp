@@ -26,6 +26,11 @@ struct convex_mesh {
     // vertices of an edge in the `vertices` array.
     std::vector<uint16_t> edges;
 
+    // Each subsequent pair of integers represents the indices of the two
+    // faces that share an edge, in the same order as `edges`. The arc between
+    // their normals is the edge's image on the Gauss map.
+    std::vector<uint16_t> edge_faces;
+
     // Each subsequent pair of integers represents the index of the first
     // vertex of a face in the `indices` array and the number of vertices
     // in the face.
@@ -34,6 +39,12 @@ struct convex_mesh {
     // Face normals.
     std::vector<vector3> normals;
 
+    // Vertex adjacency in compressed form. The indices of the vertices which
+    // share an edge with vertex `i` are stored in `adjacency` in the range
+    // `[adjacency_offsets[i], adjacency_offsets[i + 1])`.
+    std::vector<uint32_t> adjacency_offsets;
+    std::vector<uint16_t> adjacency;
+
     /**
      * @brief Initializes calculated properties. Call this after vertices,
      * indices and faces are assigned.
@@ -101,9 +112,51 @@ struct convex_mesh {
      */
     std::array<vector3, 2> get_rotated_edge(const rotated_mesh &, size_t idx) const;
 
+    /**
+     * @brief Returns the indices of the two faces that share an edge.
+     * @param idx Edge index.
+     * @return Face indices, where the second is equal to the first if the
+     * edge belongs to a single face, which happens in open meshes.
+     */
+    std::array<uint16_t, 2> get_edge_faces(size_t idx) const {
+        EDYN_ASSERT(idx * 2 + 1 < edge_faces.size());
+        return {edge_faces[idx * 2], edge_faces[idx * 2 + 1]};
+    }
+
+    /**
+     * @brief Finds the index of the vertex that's furthest along the given
+     * direction by hill-climbing over the vertex adjacency, which visits only
+     * a small fraction of the vertices of large meshes.
+     * @param points Vertex positions, either `vertices` or the vertices of a
+     * rotated mesh associated with this mesh.
+     * @param dir A direction vector (non-zero).
+     * @param start Vertex where the search begins. The result of a previous
+     * query along a similar direction is a good starting point.
+     * @return Index of support vertex.
+     */
+    uint16_t support_vertex_index(const std::vector<vector3> &points,
+                                  const vector3 &dir, uint16_t start = 0) const;
+
+    /**
+     * @brief Calculates the maximum projection of the vertices along the
+     * given direction using `support_vertex_index`.
+     * @param points Vertex positions, either `vertices` or the vertices of a
+     * rotated mesh associated with this mesh.
+     * @param dir A direction vector (non-zero).
+     * @param hint Vertex where the search begins. It's updated with the index
+     * of the support vertex so it can be passed on to the next query.
+     * @return The maximal projection.
+     */
+    scalar support_projection(const std::vector<vector3> &points,
+                              const vector3 &dir, uint16_t &hint) const {
+        hint = support_vertex_index(points, dir, hint);
+        return dot(points[hint], dir);
+    }
+
     void shift_to_centroid();
     void calculate_normals();
     void calculate_edges();
+    void calculate_adjacency();
 
 #ifdef EDYN_DEBUG
     void validate() const;
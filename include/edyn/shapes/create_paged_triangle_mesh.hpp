@@ -41,7 +41,7 @@ struct submesh_builder {
         paged_tri_mesh.m_cache.resize(infos.size());
 
         // Create submeshes using the triangle indices stored in the `build_info`s.
-        parallel_for(size_t{0}, infos.size(), [&] (size_t idx) {
+        auto build_submesh = [&] (size_t idx) {
             auto &info = infos[idx];
 
             // Transform triangle indices into vertex indices.
@@ -75,7 +75,6 @@ struct submesh_builder {
 
             submesh->m_indices.resize(local_num_triangles);
             submesh->m_normals.resize(local_num_triangles);
-            submesh->m_adjacent_normals.resize(local_num_triangles);
 
             // Obtain local indices from global indices and add to triangle mesh.
             for (size_t tri_idx = 0; tri_idx < local_num_triangles; ++tri_idx) {
@@ -89,8 +88,6 @@ struct submesh_builder {
                     EDYN_ASSERT(it != local_indices.end());
                     auto local_vertex_idx = std::distance(local_indices.begin(), it);
                     submesh->m_indices[tri_idx][i] = local_vertex_idx;
-                    // Assign adjacent normals as well.
-                    submesh->m_adjacent_normals[tri_idx][i] = global_tri_mesh.m_adjacent_normals[global_tri_idx][i];
                 }
 
                 // Assign normals as well.
@@ -100,65 +97,49 @@ struct submesh_builder {
             // `initialize()` should not be called on the submesh. Initialize
             // submesh selectively, copying already calculated data from the
             // full triangle mesh, which includes adjacency information related
-            // to the neighboring submeshes.
+            // to the neighboring submeshes. Vertices are quantized relative to
+            // the bounds of the submesh.
+            submesh->quantize_vertices();
             submesh->init_edge_indices();
             submesh->build_triangle_tree();
 
             auto local_num_edges = submesh->m_edge_vertex_indices.size();
             submesh->m_is_convex_edge.resize(local_num_edges);
 
-            // Assign edge normals.
-            for (size_t edge_idx = 0; edge_idx < local_num_edges; ++edge_idx) {
-                // Find corresponding global edge index.
-                // Get indices of vertices of this edge in the submesh.
-                auto local_vertex_index0 = submesh->m_edge_vertex_indices[edge_idx].first;
-                auto local_vertex_index1 = submesh->m_edge_vertex_indices[edge_idx].second;
-                // Also get vertex indices in the global mesh.
-                auto global_vertex_index0 = local_indices[local_vertex_index0];
-                auto global_vertex_index1 = local_indices[local_vertex_index1];
-                // Get list of global edge indices which share the first vertex
-                // and find the edge that contains both global vertices.
-                auto global_edge_indices = global_tri_mesh.m_vertex_edge_indices[global_vertex_index0];
-
-            #if EDYN_DEBUG && !EDYN_DISABLE_ASSERT
-                auto edge_was_found = false;
-            #endif
-
-                for (size_t i = 0; i < global_edge_indices.size(); ++i) {
-                    auto global_edge_idx = global_edge_indices[i];
-                    auto global_edge_vertex_indices = global_tri_mesh.m_edge_vertex_indices[global_edge_idx];
-
-                    // If one of the vertices is the second one then this must be it.
-                    if (global_edge_vertex_indices[0] != global_vertex_index1 &&
-                        global_edge_vertex_indices[1] != global_vertex_index1) {
-                        continue;
-                    }
-
-                    // Ensure the first vertex index matches expectation.
-                    EDYN_ASSERT(global_edge_vertex_indices[0] == global_vertex_index0 ||
-                                global_edge_vertex_indices[1] == global_vertex_index0);
-
-                    auto is_convex = global_tri_mesh.m_is_convex_edge[global_edge_idx];
-                    submesh->m_is_convex_edge[edge_idx] = is_convex;
+            // Assign edge convexity and the normals of the faces which are on
+            // the other side of the boundary of the submesh. The i-th edge of
+            // a face connects the same vertices in both meshes.
+            for (size_t tri_idx = 0; tri_idx < local_num_triangles; ++tri_idx) {
+                auto global_tri_idx = info.ids[tri_idx];
 
-                #if EDYN_DEBUG && !EDYN_DISABLE_ASSERT
-                    edge_was_found = true;
-                #endif
+                for (size_t i = 0; i < 3; ++i) {
+                    auto edge_idx = submesh->m_face_edge_indices[tri_idx][i];
+                    auto global_edge_idx = global_tri_mesh.m_face_edge_indices[global_tri_idx][i];
+                    submesh->m_is_convex_edge[edge_idx] = global_tri_mesh.m_is_convex_edge[global_edge_idx];
 
-                    break;
+                    if (submesh->m_is_boundary_edge[edge_idx] && !global_tri_mesh.m_is_boundary_edge[global_edge_idx]) {
+                        auto adjacent_normal = global_tri_mesh.get_adjacent_face_normal(global_tri_idx, i);
+                        submesh->set_external_adjacent_normal(tri_idx, i, adjacent_normal);
+                    }
                 }
-
-            #if EDYN_DEBUG && !EDYN_DISABLE_ASSERT
-                EDYN_ASSERT(edge_was_found);
-            #endif
             }
 
             // Create node.
             auto &paged_node = paged_tri_mesh.m_cache[idx];
-            paged_node.num_vertices = submesh->m_vertices.size();
+            paged_node.num_vertices = submesh->num_vertices();
             paged_node.num_indices = submesh->m_indices.size();
             paged_node.trimesh = std::move(submesh);
-        });
+        };
+
+        // Submeshes are built in the calling thread if it is a worker, e.g.
+        // when the mesh is created in a job, since `parallel_for` blocks.
+        if (infos.size() > 1 && can_parallel_for()) {
+            parallel_for(size_t{0}, infos.size(), build_submesh);
+        } else {
+            for (size_t idx = 0; idx < infos.size(); ++idx) {
+                build_submesh(idx);
+            }
+        }
     }
 };
 } // namespace detail
@@ -181,7 +162,7 @@ void create_paged_triangle_mesh(
         size_t max_tri_per_submesh) {
 
     // Only allowed to create a mesh if this instance is empty.
-    EDYN_ASSERT(paged_tri_mesh.m_tree.empty() && paged_tri_mesh.m_cache.empty());
+    EDYN_ASSERT(paged_tri_mesh.m_tree->empty() && paged_tri_mesh.m_cache.empty());
 
     auto num_indices = static_cast<size_t>(std::distance(index_begin, index_end));
     auto num_triangles = num_indices / 3;
@@ -196,26 +177,31 @@ void create_paged_triangle_mesh(
     // Calculate AABB of each triangle.
     std::vector<AABB> aabbs(num_triangles);
 
-    parallel_for(size_t{0}, num_triangles, [&] (size_t i) {
+    auto calculate_aabb = [&] (size_t i) {
         auto verts = triangle_vertices{
             *(vertex_begin + *(index_begin + (i * 3 + 0))),
             *(vertex_begin + *(index_begin + (i * 3 + 1))),
             *(vertex_begin + *(index_begin + (i * 3 + 2)))
         };
         aabbs[i] = get_triangle_aabb(verts);
-    });
+    };
+
+    if (num_triangles > 1 && can_parallel_for()) {
+        parallel_for(size_t{0}, num_triangles, calculate_aabb);
+    } else {
+        for (size_t i = 0; i < num_triangles; ++i) {
+            calculate_aabb(i);
+        }
+    }
 
     // Build tree and submeshes.
     auto builder = detail::submesh_builder{};
-    paged_tri_mesh.m_tree.build(aabbs.begin(), aabbs.end(), builder, max_tri_per_submesh);
+    auto tree = std::make_shared<static_tree>();
+    tree->build(aabbs.begin(), aabbs.end(), builder, max_tri_per_submesh);
+    paged_tri_mesh.m_tree = tree;
     builder.build(paged_tri_mesh, global_tri_mesh, vertex_begin, vertex_end, index_begin, index_end);
 
-    // Resize LRU queue to have the number of leaves.
-    paged_tri_mesh.m_lru_indices.resize(paged_tri_mesh.m_cache.size());
-    std::iota(paged_tri_mesh.m_lru_indices.begin(),
-              paged_tri_mesh.m_lru_indices.end(), 0);
-
-    paged_tri_mesh.m_is_loading_submesh = std::make_unique<std::atomic<bool>[]>(paged_tri_mesh.m_cache.size());
+    paged_tri_mesh.init_cache_state();
 }
 
 }
@@ -0,0 +1,404 @@
+#ifndef EDYN_SHAPES_HEIGHTFIELD_HPP
+#define EDYN_SHAPES_HEIGHTFIELD_HPP
+
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "edyn/math/vector3.hpp"
+#include "edyn/comp/aabb.hpp"
+#include "edyn/comp/material.hpp"
+#include "edyn/util/triangle_util.hpp"
+
+namespace edyn {
+
+class triangle_mesh;
+
+/**
+ * @brief A regular grid of heights in the xz plane. Only the quantized
+ * heights and optional per-cell materials are stored. Triangles are
+ * generated on demand: each cell is split into two triangles along the
+ * diagonal going from its first to its last vertex.
+ *
+ * Vertices are laid out in row-major order. Columns advance along the x axis
+ * and rows along the z axis. The vertex at row `r` and column `c` is located
+ * at `origin + vector3{c * cell_size, height(r, c), r * cell_size}`.
+ */
+class heightfield {
+public:
+    using height_type = uint16_t;
+    using material_type = uint8_t;
+
+    heightfield() = default;
+
+    /**
+     * @brief Creates a heightfield from a list of heights.
+     * @param num_rows Number of vertices along the z axis. Must be at least 2.
+     * @param num_columns Number of vertices along the x axis. Must be at least 2.
+     * @param cell_size Distance between neighboring vertices.
+     * @param heights Height of each vertex in row-major order. The values are
+     * quantized to 16 bits between the minimum and maximum height.
+     * @param origin Position of the first vertex, ignoring its height.
+     */
+    heightfield(size_t num_rows, size_t num_columns, scalar cell_size,
+                const std::vector<scalar> &heights,
+                const vector3 &origin = vector3_zero);
+
+    /**
+     * @brief Assigns a material to each cell. Contacts with a cell use its
+     * material instead of the `material` of the rigid body.
+     * @param indices One index into `materials` per cell in row-major order,
+     * i.e. `(num_rows - 1) * (num_columns - 1)` values.
+     * @param materials The materials referred to by the indices.
+     */
+    void set_materials(const std::vector<material_type> &indices,
+                       const std::vector<material> &materials);
+
+    size_t num_rows() const {
+        return m_num_rows;
+    }
+
+    size_t num_columns() const {
+        return m_num_columns;
+    }
+
+    size_t num_triangles() const {
+        return (m_num_rows - 1) * (m_num_columns - 1) * 2;
+    }
+
+    AABB get_aabb() const {
+        return m_aabb;
+    }
+
+    scalar get_height(size_t row, size_t column) const {
+        EDYN_ASSERT(row < m_num_rows && column < m_num_columns);
+        return m_min_height + m_height_scale * m_heights[row * m_num_columns + column];
+    }
+
+    vector3 get_vertex_position(size_t row, size_t column) const {
+        return m_origin + vector3{column * m_cell_size, get_height(row, column), row * m_cell_size};
+    }
+
+    triangle_vertices get_triangle_vertices(size_t tri_idx) const;
+
+    vector3 get_triangle_normal(size_t tri_idx) const;
+
+    /**
+     * @brief Material index of a triangle. Zero if no materials were assigned.
+     */
+    material_type get_triangle_material(size_t tri_idx) const {
+        EDYN_ASSERT(tri_idx < num_triangles());
+        return m_materials.empty() ? material_type{0} : m_materials[tri_idx / 2];
+    }
+
+    /**
+     * @brief Material of the cell under a point, ignoring its height.
+     * @param point A point in the plane of the grid.
+     * @return The material or null if no materials were assigned.
+     */
+    const material * get_material(const vector3 &point) const;
+
+    /**
+     * @brief Visits all triangles whose AABB intersects the given AABB.
+     * @param aabb Query AABB.
+     * @param func Function with signature `void(size_t tri_idx)`.
+     */
+    template<typename Func>
+    void visit_triangles(const AABB &aabb, Func func) const;
+
+    /**
+     * @brief Visits the triangles of the cells crossed by a line segment
+     * using a 2D digital differential analyzer. Cells are visited in order
+     * from `p0` to `p1` and cells which the segment passes above or below
+     * are skipped.
+     * @param p0 First point of the segment.
+     * @param p1 Second point of the segment.
+     * @param func Function with signature `bool(size_t tri_idx)`, which is
+     * called for both triangles of a cell. The traversal stops after the
+     * current cell if it returns true, which should happen when the segment
+     * intersects the triangle, since no other cell can be closer.
+     */
+    template<typename Func>
+    void raycast(const vector3 &p0, const vector3 &p1, Func func) const;
+
+    // Number of cells along each side of a tile. Patches are generated per
+    // tile, which keeps them small enough to be built serially.
+    static constexpr size_t tile_size = 16;
+
+    size_t num_tile_rows() const {
+        return (m_num_rows - 2) / tile_size + 1;
+    }
+
+    size_t num_tile_columns() const {
+        return (m_num_columns - 2) / tile_size + 1;
+    }
+
+    size_t num_tiles() const {
+        return num_tile_rows() * num_tile_columns();
+    }
+
+    /**
+     * @brief Visits the tiles containing cells which are near the given AABB.
+     * Tiles whose cells are all above or below the AABB are skipped.
+     * @param aabb Query AABB.
+     * @param func Function with signature `void(size_t tile_idx)`.
+     */
+    template<typename Func>
+    void visit_tiles(const AABB &aabb, Func func) const;
+
+    /**
+     * @brief Generates a triangle mesh containing the triangles of a tile.
+     * The patch of a tile is always the same, thus the indices of its
+     * triangles and edges remain valid if it is generated again. Edges shared
+     * with cells of neighboring tiles are boundary edges of the patch which
+     * take their adjacent normal and convexity from those cells.
+     * @param tile_idx Index of the tile, in row-major order.
+     * @param mesh An empty triangle mesh where the patch will be generated.
+     */
+    void build_tile_patch(size_t tile_idx, triangle_mesh &mesh) const;
+
+    /**
+     * @brief Index of the triangle of the heightfield which corresponds to a
+     * triangle in the patch of a tile.
+     * @param tile_idx Index of the tile.
+     * @param patch_tri_idx Index of the triangle in the patch.
+     * @return Triangle index.
+     */
+    size_t get_tile_triangle_index(size_t tile_idx, size_t patch_tri_idx) const;
+
+    template<typename Archive>
+    friend void serialize(Archive &, heightfield &);
+    friend size_t serialization_sizeof(const heightfield &);
+
+private:
+    // Calculates the inclusive range of cells which overlap the given AABB
+    // in the xz plane. Returns false if there's no overlap.
+    bool get_cell_range(const AABB &aabb, size_t &row_begin, size_t &column_begin,
+                        size_t &row_end, size_t &column_end) const;
+
+    // Whether the AABB is not above or below all cells in the range.
+    bool intersects_cells(const AABB &aabb, size_t row_begin, size_t column_begin,
+                          size_t row_end, size_t column_end) const;
+
+    // Generates the triangles in the inclusive range of cells.
+    void build_patch(size_t row_begin, size_t column_begin,
+                     size_t row_end, size_t column_end, triangle_mesh &mesh) const;
+
+    // Inclusive range of cells of a tile.
+    void get_tile_cell_range(size_t tile_idx, size_t &row_begin, size_t &column_begin,
+                             size_t &row_end, size_t &column_end) const;
+
+    // Index of the triangle on the other side of an edge of a triangle, or
+    // `SIZE_MAX` if the edge is on the border of the grid. Edge `i` connects
+    // the i-th and (i+1)-th vertices of a triangle.
+    size_t get_adjacent_triangle_index(size_t tri_idx, size_t edge_idx) const;
+
+    // Minimum and maximum height of the four vertices of a cell.
+    void get_cell_height_range(size_t row, size_t column, scalar &min_height, scalar &max_height) const;
+
+    // Row, column and diagonal side of a triangle.
+    void get_triangle_cell(size_t tri_idx, size_t &row, size_t &column, size_t &side) const {
+        EDYN_ASSERT(tri_idx < num_triangles());
+        auto cell_idx = tri_idx / 2;
+        row = cell_idx / (m_num_columns - 1);
+        column = cell_idx % (m_num_columns - 1);
+        side = tri_idx % 2;
+    }
+
+    size_t get_cell_triangle_index(size_t row, size_t column) const {
+        return (row * (m_num_columns - 1) + column) * 2;
+    }
+
+private:
+    uint32_t m_num_rows {0};
+    uint32_t m_num_columns {0};
+    scalar m_cell_size {1};
+    vector3 m_origin {vector3_zero};
+
+    // Heights are stored as `m_min_height + m_height_scale * quantized_height`.
+    scalar m_min_height {0};
+    scalar m_height_scale {1};
+    std::vector<height_type> m_heights;
+
+    // Optional material index of each cell into the material table.
+    std::vector<material_type> m_materials;
+    std::vector<material> m_material_table;
+
+    AABB m_aabb;
+};
+
+/**
+ * @brief Returns the patch of a tile, like `heightfield::build_tile_patch`.
+ * Patches are cached in the calling thread, so they are reused while a body
+ * remains over the same tiles, as is usually the case in consecutive steps.
+ * The heightfield must not be modified afterwards.
+ * @param field The heightfield.
+ * @param tile_idx Index of the tile.
+ * @return The patch.
+ */
+std::shared_ptr<const triangle_mesh> get_heightfield_patch(const std::shared_ptr<heightfield> &field,
+                                                           size_t tile_idx);
+
+template<typename Func>
+void heightfield::visit_tiles(const AABB &aabb, Func func) const {
+    size_t row_begin, column_begin, row_end, column_end;
+
+    if (!get_cell_range(aabb, row_begin, column_begin, row_end, column_end)) {
+        return;
+    }
+
+    for (auto tile_row = row_begin / tile_size; tile_row <= row_end / tile_size; ++tile_row) {
+        for (auto tile_column = column_begin / tile_size; tile_column <= column_end / tile_size; ++tile_column) {
+            // Cells of the tile in range.
+            auto tile_row_begin = std::max(row_begin, tile_row * tile_size);
+            auto tile_column_begin = std::max(column_begin, tile_column * tile_size);
+            auto tile_row_end = std::min(row_end, tile_row * tile_size + tile_size - 1);
+            auto tile_column_end = std::min(column_end, tile_column * tile_size + tile_size - 1);
+
+            if (intersects_cells(aabb, tile_row_begin, tile_column_begin, tile_row_end, tile_column_end)) {
+                func(tile_row * num_tile_columns() + tile_column);
+            }
+        }
+    }
+}
+
+template<typename Func>
+void heightfield::visit_triangles(const AABB &aabb, Func func) const {
+    size_t row_begin, column_begin, row_end, column_end;
+
+    if (!get_cell_range(aabb, row_begin, column_begin, row_end, column_end)) {
+        return;
+    }
+
+    for (auto row = row_begin; row <= row_end; ++row) {
+        for (auto column = column_begin; column <= column_end; ++column) {
+            scalar min_height, max_height;
+            get_cell_height_range(row, column, min_height, max_height);
+
+            if (aabb.max.y < min_height || aabb.min.y > max_height) {
+                continue;
+            }
+
+            auto tri_idx = get_cell_triangle_index(row, column);
+
+            for (auto i = tri_idx; i < tri_idx + 2; ++i) {
+                auto tri_aabb = get_triangle_aabb(get_triangle_vertices(i));
+
+                if (intersect(aabb, tri_aabb)) {
+                    func(i);
+                }
+            }
+        }
+    }
+}
+
+template<typename Func>
+void heightfield::raycast(const vector3 &p0, const vector3 &p1, Func func) const {
+    // Work in grid space, where cells have unit size. The parameter `t`
+    // remains the fraction along the segment.
+    auto inv_cell_size = scalar(1) / m_cell_size;
+    auto x0 = (p0.x - m_origin.x) * inv_cell_size;
+    auto z0 = (p0.z - m_origin.z) * inv_cell_size;
+    auto dx = (p1.x - p0.x) * inv_cell_size;
+    auto dz = (p1.z - p0.z) * inv_cell_size;
+    auto num_cells_x = scalar(m_num_columns - 1);
+    auto num_cells_z = scalar(m_num_rows - 1);
+
+    // Clip segment against the bounds of the grid.
+    auto t_min = scalar(0), t_max = scalar(1);
+
+    auto clip = [&] (scalar start, scalar delta, scalar size) {
+        if (std::abs(delta) < EDYN_EPSILON) {
+            return start >= 0 && start <= size;
+        }
+
+        auto t0 = -start / delta;
+        auto t1 = (size - start) / delta;
+
+        if (t0 > t1) {
+            std::swap(t0, t1);
+        }
+
+        t_min = std::max(t_min, t0);
+        t_max = std::min(t_max, t1);
+        return t_min <= t_max;
+    };
+
+    if (!clip(x0, dx, num_cells_x) || !clip(z0, dz, num_cells_z)) {
+        return;
+    }
+
+    auto column = static_cast<size_t>(std::clamp(std::floor(x0 + dx * t_min), scalar(0), num_cells_x - 1));
+    auto row = static_cast<size_t>(std::clamp(std::floor(z0 + dz * t_min), scalar(0), num_cells_z - 1));
+
+    // Fraction where the segment crosses the next cell boundary along each
+    // axis and the increment in fraction to cross a whole cell.
+    auto t_next_x = EDYN_SCALAR_MAX, t_delta_x = EDYN_SCALAR_MAX;
+    auto t_next_z = EDYN_SCALAR_MAX, t_delta_z = EDYN_SCALAR_MAX;
+
+    if (dx > EDYN_EPSILON) {
+        t_next_x = (scalar(column + 1) - x0) / dx;
+        t_delta_x = scalar(1) / dx;
+    } else if (dx < -EDYN_EPSILON) {
+        t_next_x = (scalar(column) - x0) / dx;
+        t_delta_x = scalar(-1) / dx;
+    }
+
+    if (dz > EDYN_EPSILON) {
+        t_next_z = (scalar(row + 1) - z0) / dz;
+        t_delta_z = scalar(1) / dz;
+    } else if (dz < -EDYN_EPSILON) {
+        t_next_z = (scalar(row) - z0) / dz;
+        t_delta_z = scalar(-1) / dz;
+    }
+
+    auto dy = p1.y - p0.y;
+    auto t_enter = t_min;
+
+    while (true) {
+        auto t_exit = std::min(std::min(t_next_x, t_next_z), t_max);
+
+        // Skip cell if the segment is entirely above or below it.
+        auto y_enter = p0.y + dy * t_enter;
+        auto y_exit = p0.y + dy * t_exit;
+        scalar min_height, max_height;
+        get_cell_height_range(row, column, min_height, max_height);
+
+        if (std::max(y_enter, y_exit) >= min_height && std::min(y_enter, y_exit) <= max_height) {
+            auto tri_idx = get_cell_triangle_index(row, column);
+            auto hit0 = func(tri_idx);
+            auto hit1 = func(tri_idx + 1);
+
+            if (hit0 || hit1) {
+                return;
+            }
+        }
+
+        if (t_exit >= t_max) {
+            break;
+        }
+
+        if (t_next_x < t_next_z) {
+            if (dx > 0) {
+                if (++column >= m_num_columns - 1) break;
+            } else {
+                if (column-- == 0) break;
+            }
+            t_next_x += t_delta_x;
+        } else {
+            if (dz > 0) {
+                if (++row >= m_num_rows - 1) break;
+            } else {
+                if (row-- == 0) break;
+            }
+            t_next_z += t_delta_z;
+        }
+
+        t_enter = t_exit;
+    }
+}
+
+}
+
+#endif // EDYN_SHAPES_HEIGHTFIELD_HPP
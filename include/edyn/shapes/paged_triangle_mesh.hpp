@@ -13,6 +13,8 @@ namespace edyn {
 
 class paged_triangle_mesh_file_input_archive;
 class paged_triangle_mesh_file_output_archive;
+class paged_triangle_mesh_mapped_loader;
+class mapped_output_archive;
 class finish_load_mesh_job;
 
 // Forward declaration of `detail::submesh_builder` needed by `friend`
@@ -31,6 +33,19 @@ public:
         size_t num_indices;
         // Triangle mesh pointer. Will be nullptr if mesh is not loaded.
         std::shared_ptr<triangle_mesh> trimesh;
+        // Edited submeshes differ from the source thus they're never unloaded,
+        // except by `clear_cache`, which reverts them.
+        bool is_edited {false};
+    };
+
+    /**
+     * @brief Region a body is expected to sweep in the near future.
+     */
+    struct prefetch_region {
+        // Current AABB of the body.
+        AABB aabb;
+        // Displacement of the body over the look-ahead time.
+        vector3 displacement;
     };
 
     paged_triangle_mesh(std::shared_ptr<triangle_mesh_page_loader_base> loader);
@@ -41,16 +56,20 @@ public:
      * with a similar AABB should hit those submeshes.
      * @tparam Func Type of the function object to invoke.
      * @param aabb Query AABB.
-     * @param func Will be called with submesh index.
+     * @param func Will be called with the submesh index and the submesh, with
+     * signature `void(size_t mesh_idx, const std::shared_ptr<triangle_mesh> &)`.
+     * The submesh is kept alive during the call even if it is unloaded
+     * concurrently.
      */
     template<typename Func>
     void visit_submeshes(const AABB &aabb, Func func) {
-        m_tree.query(aabb, [&] (auto tree_node_idx) {
-            auto mesh_idx = m_tree.get_node(tree_node_idx).id;
+        auto tree = get_tree();
+        tree->query(aabb, [&] (auto tree_node_idx) {
+            auto mesh_idx = tree->get_node(tree_node_idx).id;
             load_node_if_needed(mesh_idx);
 
-            if (m_cache[mesh_idx].trimesh) {
-                func(mesh_idx);
+            if (auto trimesh = get_submesh(mesh_idx)) {
+                func(mesh_idx, trimesh);
                 mark_recent_visit(mesh_idx);
             }
         });
@@ -64,7 +83,7 @@ public:
     template<typename Func>
     void visit_all_cached_edges(Func func) const {
         for (size_t mesh_idx = 0; mesh_idx < m_cache.size(); ++mesh_idx) {
-            auto trimesh = m_cache[mesh_idx].trimesh;
+            auto trimesh = get_submesh(mesh_idx);
 
             if (trimesh) {
                 for (size_t edge_idx = 0; edge_idx < trimesh->num_edges(); ++edge_idx) {
@@ -79,21 +98,23 @@ public:
      * @param aabb The AABB to visit.
      * @param func An element into which the `operator()` will be called.
      *      The expected signature is:
-     *      `void(uint32_t mesh_idx, uint32_t tri_idx)`
+     *      `void(uint32_t mesh_idx, uint32_t tri_idx, const std::shared_ptr<triangle_mesh> &trimesh)`
      *      Where:
      *      - `mesh_idx` is the index of the submesh.
      *      - `tri_idx` is the triangle index within the submesh.
+     *      - `trimesh` is the submesh, which is kept alive during the call.
      */
     template<typename Func>
     void visit_triangles(const AABB &aabb, Func func) {
-        m_tree.query(aabb, [&] (auto tree_node_idx) {
-            auto mesh_idx = m_tree.get_node(tree_node_idx).id;
+        auto tree = get_tree();
+        tree->query(aabb, [&] (auto tree_node_idx) {
+            auto mesh_idx = tree->get_node(tree_node_idx).id;
             load_node_if_needed(mesh_idx);
-            auto trimesh = m_cache[mesh_idx].trimesh;
+            auto trimesh = get_submesh(mesh_idx);
 
             if (trimesh) {
-                trimesh->visit_triangles(aabb, [=] (uint32_t tri_idx) {
-                    func(mesh_idx, tri_idx);
+                trimesh->visit_triangles(aabb, [&] (uint32_t tri_idx) {
+                    func(mesh_idx, tri_idx, trimesh);
                 });
                 mark_recent_visit(mesh_idx);
             }
@@ -107,19 +128,20 @@ public:
      * @param aabb The AABB to visit.
      * @param func An element into which the `operator()` will be called.
      *      The expected signature is:
-     *      `void(uint32_t mesh_idx, uint32_t tri_idx)`
+     *      `void(uint32_t mesh_idx, uint32_t tri_idx, const std::shared_ptr<triangle_mesh> &trimesh)`
      *      Where:
      *      - `mesh_idx` is the index of the submesh.
      *      - `tri_idx` is the triangle index within the submesh.
+     *      - `trimesh` is the submesh, which is kept alive during the call.
      */
     template<typename Func>
     void visit_cached_triangles(const AABB &aabb, Func func) const {
         for (size_t mesh_idx = 0; mesh_idx < m_cache.size(); ++mesh_idx) {
-            auto trimesh = m_cache[mesh_idx].trimesh;
+            auto trimesh = get_submesh(mesh_idx);
 
             if (trimesh) {
-                trimesh->visit_triangles(aabb, [=] (uint32_t tri_idx) {
-                    func(mesh_idx, tri_idx);
+                trimesh->visit_triangles(aabb, [&] (uint32_t tri_idx) {
+                    func(mesh_idx, tri_idx, trimesh);
                 });
             }
         }
@@ -129,19 +151,20 @@ public:
      * @brief Visits all triangles of all cached nodes.
      * @param func An element into which the `operator()` will be called.
      *      The expected signature is:
-     *      `void(uint32_t mesh_idx, uint32_t tri_idx)`
+     *      `void(uint32_t mesh_idx, uint32_t tri_idx, const std::shared_ptr<triangle_mesh> &trimesh)`
      *      Where:
      *      - `mesh_idx` is the index of the submesh.
      *      - `tri_idx` is the triangle index within the submesh.
+     *      - `trimesh` is the submesh, which is kept alive during the call.
      */
     template<typename Func>
     void visit_all_cached_triangles(Func func) const {
         for (size_t mesh_idx = 0; mesh_idx < m_cache.size(); ++mesh_idx) {
-            auto trimesh = m_cache[mesh_idx].trimesh;
+            auto trimesh = get_submesh(mesh_idx);
 
             if (trimesh) {
                 for (size_t tri_idx = 0; tri_idx < trimesh->num_triangles(); ++tri_idx) {
-                    func(mesh_idx, tri_idx);
+                    func(mesh_idx, tri_idx, trimesh);
                 }
             }
         }
@@ -154,18 +177,20 @@ public:
      * @tparam Func Type of the function object to invoke.
      * @param p0 First point in the ray.
      * @param p1 Second point in the ray.
-     * @param func Will be called with the submesh index and triangle index.
+     * @param func Will be called with the submesh index, triangle index and
+     * the submesh, which is kept alive during the call.
      */
     template<typename Func>
     void raycast(const vector3 &p0, const vector3 &p1, Func func) {
-        m_tree.raycast(p0, p1, [&] (auto tree_node_idx) {
-            auto mesh_idx = m_tree.get_node(tree_node_idx).id;
+        auto tree = get_tree();
+        tree->raycast(p0, p1, [&] (auto tree_node_idx) {
+            auto mesh_idx = tree->get_node(tree_node_idx).id;
             load_node_if_needed(mesh_idx);
-            auto trimesh = m_cache[mesh_idx].trimesh;
+            auto trimesh = get_submesh(mesh_idx);
 
             if (trimesh) {
-                trimesh->raycast(p0, p1, [=] (uint32_t tri_idx) {
-                    func(mesh_idx, tri_idx);
+                trimesh->raycast(p0, p1, [&] (uint32_t tri_idx) {
+                    func(mesh_idx, tri_idx, trimesh);
                 });
                 mark_recent_visit(mesh_idx);
             }
@@ -178,48 +203,107 @@ public:
      * @tparam Func Type of the function object to invoke.
      * @param p0 First point in the ray.
      * @param p1 Second point in the ray.
-     * @param func Will be called with the submesh index and triangle index.
+     * @param func Will be called with the submesh index, triangle index and
+     * the submesh, which is kept alive during the call.
      */
     template<typename Func>
     void raycast_cached(const vector3 &p0, const vector3 &p1, Func func) const {
-        m_tree.raycast(p0, p1, [&] (auto tree_node_idx) {
-            auto mesh_idx = m_tree.get_node(tree_node_idx).id;
-            auto trimesh = m_cache[mesh_idx].trimesh;
+        auto tree = get_tree();
+        tree->raycast(p0, p1, [&] (auto tree_node_idx) {
+            auto mesh_idx = tree->get_node(tree_node_idx).id;
+            auto trimesh = get_submesh(mesh_idx);
 
             if (trimesh) {
-                trimesh->raycast(p0, p1, [=] (uint32_t tri_idx) {
-                    func(mesh_idx, tri_idx);
+                trimesh->raycast(p0, p1, [&] (uint32_t tri_idx) {
+                    func(mesh_idx, tri_idx, trimesh);
                 });
             }
         });
     }
 
+    /**
+     * @brief Starts loading the submeshes which are not in the cache and
+     * intersect the AABB of any of the regions swept by its displacement.
+     * Loads are requested in order of increasing distance to the current
+     * AABB of the closest region, thus the submeshes which are needed the
+     * soonest are loaded first when the loader processes requests in order.
+     * @param regions Regions around bodies near this mesh.
+     */
+    void prefetch(const std::vector<prefetch_region> &regions);
+
+    /**
+     * @brief Loads all submeshes which intersect the given AABB and are not
+     * in the cache, waiting for them to be loaded. It is meant for when a
+     * body is about to touch a submesh that was not prefetched in time,
+     * since it stalls the caller until the data is available.
+     * @param aabb Query AABB.
+     */
+    void load_blocking(const AABB &aabb);
+
     /**
      * @brief Get AABB of entire mesh.
      * @return AABB of mesh.
      */
     AABB get_aabb() const {
-        return m_tree.root_aabb();
+        return get_tree()->root_aabb();
+    }
+
+    /**
+     * @brief Returns the tree of submeshes, where the id of each leaf is the
+     * index of a submesh. The tree is never modified once assigned. Instead,
+     * it is replaced atomically when an edit extends the bounds of a submesh,
+     * thus it can be used while `edit_submesh` runs in another thread.
+     * @return The current tree.
+     */
+    std::shared_ptr<const static_tree> get_tree() const {
+        return std::atomic_load(&m_tree);
     }
 
     /**
-     * @brief Returns the number of vertices currently in the cache.
-     * @return The size of the cache in number of vertices.
+     * @brief Returns the number of bytes used by the submeshes in the cache.
+     * @return The size of the cache in bytes.
      */
-    size_t cache_num_vertices() const;
+    size_t cache_size() const {
+        return m_cache_size.load(std::memory_order_relaxed);
+    }
 
     size_t num_submeshes() const {
         return m_cache.size();
     }
 
-    std::shared_ptr<triangle_mesh> get_submesh(size_t idx) {
-        return m_cache[idx].trimesh;
+    std::shared_ptr<triangle_mesh> get_submesh(size_t idx) const {
+        // Submeshes can be assigned and unloaded concurrently in other threads.
+        return std::atomic_load(&m_cache[idx].trimesh);
     }
 
     triangle_vertices get_triangle_vertices(size_t mesh_idx, size_t tri_idx);
 
+    /**
+     * @brief Unloads all submeshes, including edited ones, which reverts them
+     * to the contents of the source.
+     */
     void clear_cache();
 
+    /**
+     * @brief Applies a set of modifications to a submesh, loading it first if
+     * needed. The submesh is copied, modified using
+     * `triangle_mesh::apply_edit` and replaced atomically, thus concurrent
+     * queries see either the previous or the modified submesh.
+     * @remark Edited submeshes are pinned in the cache, since the page loader
+     * would load their original contents. They still count towards the cache
+     * size, thus if many submeshes are edited the cache can stay above
+     * `max_cache_size` and the other submeshes are evicted sooner. They're
+     * only unloaded by `clear_cache`, which reverts the edits.
+     * @remark If the modified submesh extends beyond its previous bounds, a
+     * refit copy of the tree of submeshes replaces the current one
+     * atomically, thus concurrent queries use either tree.
+     * @remark The normals of faces in neighboring submeshes which are
+     * adjacent to the boundary edges of the submesh are not updated.
+     * @param trimesh_idx Index of submesh.
+     * @param edit The modifications.
+     */
+    void edit_submesh(size_t trimesh_idx, const triangle_mesh_edit &edit);
+
     void assign_mesh(size_t index, std::shared_ptr<triangle_mesh>);
 
     auto & get_page_loader() {
@@ -227,12 +311,33 @@ public:
     }
 
     /**
-     * @brief Maximum number of vertices in the cache. Before a new triangle mesh
-     * is loaded, if the number of vertices would exceed this number, the
-     * least recently visited nodes will be unloaded until the new total
-     * number of vertices stays below this value.
+     * @brief Sets the maximum size of the cache in bytes, as per
+     * `triangle_mesh::memory_size`. When a submesh is loaded and the cache
+     * exceeds this size, submeshes which have not been visited recently are
+     * unloaded until it fits again. The cache can exceed this size while
+     * submeshes are being loaded, or if a single submesh is larger. If the
+     * cache exceeds the new size, submeshes are unloaded right away.
+     * @param size The maximum size in bytes.
      */
-    size_t m_max_cache_num_vertices = 1 << 13;
+    void set_max_cache_size(size_t size);
+
+    /**
+     * @brief Returns the maximum size of the cache in bytes.
+     * @return The maximum size of the cache in bytes.
+     */
+    size_t max_cache_size() const {
+        return m_max_cache_size.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the number of times a submesh was unloaded from the
+     * cache. All submeshes in a region which was loaded with `load_blocking`
+     * remain in the cache for as long as this number does not change.
+     * @return Number of submeshes unloaded so far.
+     */
+    size_t num_evictions() const {
+        return m_num_evictions.load(std::memory_order_acquire);
+    }
 
     template<typename VertexIterator, typename IndexIterator>
     friend void create_paged_triangle_mesh(
@@ -252,16 +357,35 @@ public:
     friend void serialize(paged_triangle_mesh_file_input_archive &archive,
                           paged_triangle_mesh &paged_tri_mesh);
 
+    friend void serialize(mapped_output_archive &archive,
+                          paged_triangle_mesh &paged_tri_mesh);
+
+    friend void serialize(paged_triangle_mesh_mapped_loader &loader,
+                          paged_triangle_mesh &paged_tri_mesh);
+
 private:
-    void load_node_if_needed(size_t trimesh_idx);
+    void init_cache_state();
+    void load_node_if_needed(size_t trimesh_idx, bool blocking = false);
     void mark_recent_visit(size_t trimesh_idx);
-    void unload_least_recently_visited_node();
+    bool unload_least_recently_visited_node(size_t except_idx);
 
-    static_tree m_tree;
+    // Only accessed with the atomic operations for `std::shared_ptr` once
+    // the mesh is created or loaded. See `get_tree`.
+    std::shared_ptr<const static_tree> m_tree;
     std::vector<triangle_mesh_node> m_cache;
-    std::vector<size_t> m_lru_indices;
-    std::mutex m_lru_mutex;
     std::unique_ptr<std::atomic<bool>[]> m_is_loading_submesh;
+
+    // Submeshes are evicted using the clock algorithm. Visits set the flag
+    // of a submesh without locking. As the clock hand sweeps around, it
+    // clears the flags it finds set and evicts the first loaded submesh
+    // whose flag was clear, i.e. not visited since the last sweep.
+    std::unique_ptr<std::atomic<bool>[]> m_recently_visited;
+    size_t m_clock_hand {0};
+    std::atomic<size_t> m_cache_size {0};
+    std::atomic<size_t> m_max_cache_size {size_t{1} << 24};
+    std::atomic<size_t> m_num_evictions {0};
+    // Serializes changes to the cache contents and the clock hand.
+    std::mutex m_cache_mutex;
     std::shared_ptr<triangle_mesh_page_loader_base> m_page_loader;
 };
 
@@ -0,0 +1,108 @@
+#ifndef EDYN_SHAPES_ROTATED_MESH_POOL_HPP
+#define EDYN_SHAPES_ROTATED_MESH_POOL_HPP
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include "edyn/math/quaternion.hpp"
+#include "edyn/shapes/convex_mesh.hpp"
+
+namespace edyn {
+
+/**
+ * @brief Storage for the rotated meshes of all polyhedrons in an island,
+ * including the ones in compound shapes. Rotated meshes are allocated in
+ * chunks which are never moved, thus pointers to them remain valid until
+ * they're erased. Erased slots are recycled and keep the capacity of their
+ * vertex and normal arrays, which avoids heap allocations after the island
+ * has warmed up.
+ *
+ * The rotated meshes belonging to the same entity are chained together via
+ * indices, which allows all of them to be updated and erased starting from
+ * the index of the first.
+ */
+class rotated_mesh_pool {
+public:
+    using index_type = uint32_t;
+    static constexpr index_type null_index = std::numeric_limits<index_type>::max();
+
+    rotated_mesh_pool() = default;
+    rotated_mesh_pool(const rotated_mesh_pool &) = delete;
+    rotated_mesh_pool(rotated_mesh_pool &&) = default;
+    rotated_mesh_pool & operator=(const rotated_mesh_pool &) = delete;
+    rotated_mesh_pool & operator=(rotated_mesh_pool &&) = default;
+
+    /**
+     * @brief Creates a rotated mesh.
+     * @param mesh The source convex mesh.
+     * @param orn Orientation of the rigid body.
+     * @param local_orn Orientation of the mesh relative to the rigid body,
+     * i.e. the orientation of a node in a compound shape.
+     * @param next Index of the next rotated mesh of the same entity.
+     * @return Index of the new rotated mesh.
+     */
+    index_type insert(const std::shared_ptr<convex_mesh> &mesh, const quaternion &orn,
+                      const quaternion &local_orn = quaternion_identity,
+                      index_type next = null_index);
+
+    /**
+     * @brief Erases a rotated mesh and all that are chained to it.
+     * @param index Index of the first rotated mesh.
+     */
+    void erase(index_type index);
+
+    /**
+     * @brief Recalculates a rotated mesh and all that are chained to it if
+     * the orientation changed since the last update.
+     * @param index Index of the first rotated mesh.
+     * @param orn New orientation of the rigid body.
+     * @param force Recalculate even if the orientation did not change.
+     */
+    void update(index_type index, const quaternion &orn, bool force = false);
+
+    rotated_mesh & get(index_type index) {
+        return slot_at(index).rotated;
+    }
+
+    const rotated_mesh & get(index_type index) const {
+        return slot_at(index).rotated;
+    }
+
+    /**
+     * @brief Number of rotated meshes in use.
+     */
+    size_t size() const {
+        return m_size;
+    }
+
+private:
+    struct slot {
+        std::shared_ptr<convex_mesh> mesh;
+        rotated_mesh rotated;
+        quaternion local_orientation;
+        // Orientation of the rigid body in the last update.
+        quaternion orientation;
+        // Next rotated mesh of the same entity or next free slot.
+        index_type next;
+    };
+
+    static constexpr index_type chunk_size = 64;
+
+    slot & slot_at(index_type index) {
+        return m_chunks[index / chunk_size][index % chunk_size];
+    }
+
+    const slot & slot_at(index_type index) const {
+        return m_chunks[index / chunk_size][index % chunk_size];
+    }
+
+    std::vector<std::unique_ptr<slot[]>> m_chunks;
+    index_type m_free {null_index};
+    index_type m_capacity {0};
+    size_t m_size {0};
+};
+
+}
+
+#endif // EDYN_SHAPES_ROTATED_MESH_POOL_HPP
@@ -9,6 +9,7 @@
 #include "edyn/shapes/box_shape.hpp"
 #include "edyn/shapes/polyhedron_shape.hpp"
 #include "edyn/shapes/paged_mesh_shape.hpp"
+#include "edyn/shapes/heightfield_shape.hpp"
 #include "edyn/shapes/compound_shape.hpp"
 #include "edyn/comp/shape_index.hpp"
 #include "edyn/util/tuple_util.hpp"
@@ -32,7 +33,8 @@ static const auto dynamic_shapes_tuple = std::tuple<
 static const auto static_shapes_tuple = std::tuple<
     plane_shape,
     mesh_shape,
-    paged_mesh_shape
+    paged_mesh_shape,
+    heightfield_shape
 >{};
 
 // Tuple containing all shape types.
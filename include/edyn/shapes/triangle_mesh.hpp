@@ -2,14 +2,18 @@
 #define EDYN_SHAPES_TRIANGLE_MESH_HPP
 
 #include <cstdint>
+#include <array>
 #include <vector>
+#include <utility>
 #include "edyn/math/vector3.hpp"
 #include "edyn/math/geom.hpp"
+#include "edyn/math/octahedral.hpp"
 #include "edyn/comp/aabb.hpp"
 #include "edyn/util/triangle_util.hpp"
 #include "edyn/collision/static_tree.hpp"
 #include "edyn/util/commutative_pair.hpp"
 #include "edyn/util/flat_nested_array.hpp"
+#include "edyn/util/mappable_vector.hpp"
 
 namespace edyn {
 
@@ -17,16 +21,26 @@ namespace detail {
     struct submesh_builder;
 }
 
+class heightfield;
+struct triangle_mesh_edit;
+
 /**
  * @brief A triangle mesh. Includes adjacency information and a tree to
  * accelerate closest point queries.
+ *
+ * The mesh is stored in a compact form. Vertex positions are quantized to
+ * 16 bits relative to the bounds of the mesh if the resulting error is below
+ * `triangle_mesh_max_quantization_error`, face normals are octahedral-encoded
+ * and the normals of adjacent faces are derived from the edge adjacency
+ * information on demand.
  */
 class triangle_mesh {
 public:
     void initialize();
+    void quantize_vertices();
     void calculate_face_normals();
     void init_edge_indices();
-    void calculate_adjacent_normals();
+    void calculate_edge_convexity();
     void build_triangle_tree();
 
 public:
@@ -49,7 +63,7 @@ public:
     }
 
     size_t num_vertices() const {
-        return m_vertices.size();
+        return m_quantized_vertices.empty() ? m_vertices.size() : m_quantized_vertices.size();
     }
 
     size_t num_edges() const {
@@ -64,23 +78,52 @@ public:
         return m_triangle_tree.root_aabb();
     }
 
+    /**
+     * @brief Number of bytes used by this mesh, including arrays which
+     * reference mapped memory.
+     */
+    size_t memory_size() const;
+
+    /**
+     * @brief Applies a set of modifications to an initialized mesh. Only the
+     * normals, adjacency and edge convexity of the triangles around the
+     * modified ones are recalculated. The triangle tree is refit, or rebuilt
+     * if too many triangles are added.
+     * @remark Added triangles take the place of removed triangles first,
+     * which keeps the indices of all other triangles. If more triangles are
+     * removed than added, the remaining vacant places are filled with the
+     * last triangles in the mesh, whose indices change.
+     * @remark The mesh is modified in place, thus it must not be in use by
+     * another thread. Use `edyn::edit_mesh_shape` to edit the mesh of a
+     * rigid body, which is shared with the island workers.
+     * @param edit The modifications.
+     */
+    void apply_edit(const triangle_mesh_edit &edit);
+
     vector3 get_vertex_position(size_t vertex_idx) const {
-        EDYN_ASSERT(vertex_idx < m_vertices.size());
-        return m_vertices[vertex_idx];
+        if (m_quantized_vertices.empty()) {
+            EDYN_ASSERT(vertex_idx < m_vertices.size());
+            return m_vertices[vertex_idx];
+        }
+
+        EDYN_ASSERT(vertex_idx < m_quantized_vertices.size());
+        auto &q = m_quantized_vertices[vertex_idx];
+        return m_quantization_origin +
+               vector3{scalar(q[0]), scalar(q[1]), scalar(q[2])} * m_quantization_scale;
     }
 
     triangle_vertices get_triangle_vertices(size_t tri_idx) const;
 
     vector3 get_triangle_normal(size_t tri_idx) const {
         EDYN_ASSERT(tri_idx < m_normals.size());
-        return m_normals[tri_idx];
+        return octahedral_decode(m_normals[tri_idx]);
     }
 
     std::array<vector3, 2> get_edge_vertices(size_t edge_idx) const {
         EDYN_ASSERT(edge_idx < m_edge_vertex_indices.size());
         return {
-            m_vertices[m_edge_vertex_indices[edge_idx][0]],
-            m_vertices[m_edge_vertex_indices[edge_idx][1]]
+            get_vertex_position(m_edge_vertex_indices[edge_idx][0]),
+            get_vertex_position(m_edge_vertex_indices[edge_idx][1])
         };
     }
 
@@ -108,13 +151,7 @@ public:
     template<typename Func>
     void visit_all(Func func) const {
         for (size_t i = 0; i < num_triangles(); ++i) {
-            auto verts = triangle_vertices{
-                m_vertices[m_indices[i][0]],
-                m_vertices[m_indices[i][1]],
-                m_vertices[m_indices[i][2]]
-            };
-
-            func(i, verts);
+            func(i, get_triangle_vertices(i));
         }
     }
 
@@ -148,54 +185,108 @@ public:
         return m_face_edge_indices[tri_idx][edge_idx];
     }
 
-    vector3 get_adjacent_face_normal(size_t tri_idx, size_t v_idx) const {
-        return m_adjacent_normals[tri_idx][v_idx];
+    vector3 get_adjacent_face_normal(size_t tri_idx, size_t edge_idx) const {
+        auto mesh_edge_idx = get_face_edge_index(tri_idx, edge_idx);
+        auto &edge_face_indices = m_edge_face_indices[mesh_edge_idx];
+
+        if (edge_face_indices[0] != edge_face_indices[1]) {
+            auto other_face_idx = edge_face_indices[0] == tri_idx ? edge_face_indices[1] : edge_face_indices[0];
+            return get_triangle_normal(other_face_idx);
+        }
+
+        return get_boundary_adjacent_normal(tri_idx, edge_idx);
     }
 
     template<typename Archive>
     friend void serialize(Archive &, triangle_mesh &);
     friend size_t serialization_sizeof(const triangle_mesh &);
     friend struct detail::submesh_builder;
+    friend class heightfield;
 
 private:
-    // Vertex positions.
-    std::vector<vector3> m_vertices;
+    vector3 compute_face_normal(size_t tri_idx) const;
+    bool compute_edge_convexity(size_t edge_idx) const;
+
+    // Whether the position can be quantized relative to the current bounds.
+    bool is_quantizable(const vector3 &position) const;
+    std::array<uint16_t, 3> quantize_position(const vector3 &position) const;
+
+    // Converts quantized vertices back to full precision, which is needed
+    // when a vertex is moved beyond the quantization bounds.
+    void dequantize_vertices();
+
+    // Normal of the face adjacent to an edge which is not shared by another
+    // face in this mesh.
+    vector3 get_boundary_adjacent_normal(size_t tri_idx, size_t edge_idx) const;
+
+    // Assigns the normal of a face adjacent to the boundary edge of a face
+    // which is located outside of this mesh, e.g. in a neighboring submesh.
+    void set_external_adjacent_normal(size_t tri_idx, size_t edge_idx, const vector3 &normal);
+
+private:
+    // Vertex positions. Only used if the vertices are not quantized.
+    mappable_vector<vector3> m_vertices;
+
+    // Vertex positions quantized relative to the bounds of the mesh. The
+    // position is `m_quantization_origin + q * m_quantization_scale`.
+    mappable_vector<std::array<uint16_t, 3>> m_quantized_vertices;
+    vector3 m_quantization_origin {vector3_zero};
+    vector3 m_quantization_scale {vector3_zero};
 
     // Vertex indices for each triangular face. Each element represents the
     // vertex indices of one triangle.
-    std::vector<std::array<index_type, 3>> m_indices;
+    mappable_vector<std::array<index_type, 3>> m_indices;
 
-    // Face normals.
-    std::vector<vector3> m_normals;
+    // Octahedral-encoded face normals.
+    mappable_vector<uint32_t> m_normals;
 
-    // Normal vector of adjacent faces which share an edge with the i-th face.
-    std::vector<std::array<vector3, 3>> m_adjacent_normals;
+    // Octahedral-encoded normals of faces outside of this mesh which share a
+    // boundary edge with a face in this mesh. Sorted by their key, which is
+    // `face_idx * 3 + edge_idx`.
+    mappable_vector<index_type> m_external_adjacent_keys;
+    mappable_vector<uint32_t> m_external_adjacent_normals;
 
     // Vertex indices for each unique edge. Each pair of values represent the
     // vertex indices for one edge.
-    std::vector<commutative_pair<index_type>> m_edge_vertex_indices;
-
-    // Indices of edges for each vertex. Each element is a list of indices of
-    // edges that share the vertex.
-    flat_nested_array<index_type> m_vertex_edge_indices;
+    mappable_vector<commutative_pair<index_type>> m_edge_vertex_indices;
 
     // Each element represents the indices of the three edges of a face.
-    std::vector<std::array<index_type, 3>> m_face_edge_indices;
+    mappable_vector<std::array<index_type, 3>> m_face_edge_indices;
 
     // Indices of the two faces that share the i-th edge. Perimetral edges will
     // have the same value for both faces.
-    std::vector<std::array<index_type, 2>> m_edge_face_indices;
+    mappable_vector<std::array<index_type, 2>> m_edge_face_indices;
 
     // Indicates whether an edge is at the boundary. These edges are associated
     // with a single triangle.
-    std::vector<bool> m_is_boundary_edge;
+    mappable_vector<uint8_t> m_is_boundary_edge;
 
     // Whether an edge is convex.
-    std::vector<bool> m_is_convex_edge;
+    mappable_vector<uint8_t> m_is_convex_edge;
 
     static_tree m_triangle_tree;
 };
 
+/**
+ * @brief A set of modifications to be applied to a `triangle_mesh` at once
+ * using `triangle_mesh::apply_edit`, e.g. to carve a crater. Vertices are
+ * moved and added before triangles are removed and added.
+ */
+struct triangle_mesh_edit {
+    // New positions of existing vertices, paired with their index.
+    std::vector<std::pair<triangle_mesh::index_type, vector3>> moved_vertices;
+
+    // Vertices to be appended to the mesh. Their indices start at the number
+    // of vertices in the mesh before the edit.
+    std::vector<vector3> added_vertices;
+
+    // Indices of the triangles to be removed. Vertices are never removed.
+    std::vector<triangle_mesh::index_type> removed_triangles;
+
+    // Vertex indices of the triangles to be added, in counter-clockwise order.
+    std::vector<std::array<triangle_mesh::index_type, 3>> added_triangles;
+};
+
 }
 
 #endif // EDYN_SHAPES_TRIANGLE_MESH_HPP
@@ -12,8 +12,20 @@ class triangle_mesh_page_loader_base {
 public:
     virtual ~triangle_mesh_page_loader_base() {}
 
+    /**
+     * @brief Starts loading a submesh. The loaded mesh is published via the
+     * signal returned by `on_load_sink`, possibly from another thread.
+     */
     virtual void load(size_t index) = 0;
 
+    /**
+     * @brief Loads a submesh and publishes it before returning. Loaders which
+     * load asynchronously must override this.
+     */
+    virtual void load_blocking(size_t index) {
+        load(index);
+    }
+
     using loaded_mesh_func_t = void(size_t, std::shared_ptr<triangle_mesh>);
     virtual entt::sink<loaded_mesh_func_t> on_load_sink() = 0;
 };
@@ -11,14 +11,16 @@ struct quaternion;
 
 /**
  * @brief Updates the rotated mesh of all polyhedron shapes, including the ones
- * in compound shapes.
- * @param registry Source of shapes.
+ * in compound shapes, whose orientation changed since the last update.
+ * @param registry Source of shapes. Must have a `rotated_mesh_pool` in its
+ * context.
  */
 void update_rotated_meshes(entt::registry &registry);
 
 /**
  * @brief Updates the rotated mesh of a single entity, which is assumed to have
- * either a polyhedron or a compound shape.
+ * either a polyhedron or a compound shape, regardless of whether its
+ * orientation changed.
  * @param registry Data source.
  * @param entity Entity to be updated.
  */
@@ -1,6 +1,8 @@
 #ifndef EDYN_UTIL_COLLISION_UTIL_HPP
 #define EDYN_UTIL_COLLISION_UTIL_HPP
 
+#include <vector>
+#include <utility>
 #include <algorithm>
 #include <entt/entity/fwd.hpp>
 #include <entt/entity/entity.hpp>
@@ -12,6 +14,7 @@
 #include "edyn/collision/contact_point.hpp"
 #include "edyn/collision/contact_manifold.hpp"
 #include "edyn/collision/collision_result.hpp"
+#include "edyn/collision/collision_cache.hpp"
 #include "edyn/constraints/constraint_impulse.hpp"
 
 namespace edyn {
@@ -77,6 +80,19 @@ void detect_collision(std::array<entt::entity, 2> body, collision_result &,
                       const detect_collision_body_view_t &, const com_view_t &,
                       const tuple_of_shape_views_t &);
 
+/**
+ * Detects collision between two bodies using the state stored in the cache to
+ * speed up detection. The previous result is reused if the relative transform
+ * of the bodies has not changed significantly since it was calculated. The
+ * cache is updated with the new state. Pairs of convex shapes whose shape
+ * indices are listed in `gjk_shape_pairs` are collided using GJK/EPA instead
+ * of the dedicated collision function.
+ */
+void detect_collision(std::array<entt::entity, 2> body, collision_result &,
+                      const detect_collision_body_view_t &, const com_view_t &,
+                      const tuple_of_shape_views_t &, collision_cache &,
+                      const std::vector<std::pair<size_t, size_t>> &gjk_shape_pairs);
+
 /**
  * Processes a collision result and inserts/replaces points into the manifold.
  * It also removes points in the manifold that are separating. `new_point_func`
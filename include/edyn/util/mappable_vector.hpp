@@ -0,0 +1,262 @@
+#ifndef EDYN_UTIL_MAPPABLE_VECTOR_HPP
+#define EDYN_UTIL_MAPPABLE_VECTOR_HPP
+
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <type_traits>
+#include "edyn/config/config.h"
+
+namespace edyn {
+
+/**
+ * @brief A contiguous array which either owns its elements, like a
+ * `std::vector`, or references read-only elements stored elsewhere, usually
+ * in a memory-mapped file. The owner of the referenced memory must keep it
+ * alive while the array is in use. Any modification of a referenced array
+ * first copies the elements into owned storage.
+ */
+template<typename T>
+class mappable_vector {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+    using value_type = T;
+    using iterator = T *;
+    using const_iterator = const T *;
+
+    mappable_vector() = default;
+
+    mappable_vector(const mappable_vector &other)
+        : m_vector(other.m_vector)
+        , m_mapped(other.m_mapped)
+    {
+        sync(other);
+    }
+
+    mappable_vector(mappable_vector &&other) noexcept
+        : m_vector(std::move(other.m_vector))
+        , m_mapped(other.m_mapped)
+    {
+        sync(other);
+        other.clear();
+    }
+
+    mappable_vector & operator=(const mappable_vector &other) {
+        if (this != &other) {
+            m_vector = other.m_vector;
+            m_mapped = other.m_mapped;
+            sync(other);
+        }
+        return *this;
+    }
+
+    mappable_vector & operator=(mappable_vector &&other) noexcept {
+        if (this != &other) {
+            m_vector = std::move(other.m_vector);
+            m_mapped = other.m_mapped;
+            sync(other);
+            other.clear();
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Makes this array reference external elements, releasing any
+     * owned storage.
+     * @param data Pointer to the first element. Must be suitably aligned.
+     * @param size Number of elements.
+     */
+    void map(const T *data, size_t size) {
+        m_vector = {};
+        m_mapped = true;
+        m_data = data;
+        m_size = size;
+    }
+
+    bool is_mapped() const {
+        return m_mapped;
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    const T * data() const {
+        return m_data;
+    }
+
+    T * data() {
+        detach();
+        return m_vector.data();
+    }
+
+    const T & operator[](size_t idx) const {
+        EDYN_ASSERT(idx < m_size);
+        return m_data[idx];
+    }
+
+    T & operator[](size_t idx) {
+        EDYN_ASSERT(idx < m_size);
+        detach();
+        return m_vector[idx];
+    }
+
+    const_iterator begin() const {
+        return m_data;
+    }
+
+    const_iterator end() const {
+        return m_data + m_size;
+    }
+
+    iterator begin() {
+        detach();
+        return m_vector.data();
+    }
+
+    iterator end() {
+        detach();
+        return m_vector.data() + m_vector.size();
+    }
+
+    const T & front() const {
+        return (*this)[0];
+    }
+
+    const T & back() const {
+        return (*this)[m_size - 1];
+    }
+
+    void reserve(size_t capacity) {
+        detach();
+        m_vector.reserve(capacity);
+        sync();
+    }
+
+    void resize(size_t size) {
+        detach();
+        m_vector.resize(size);
+        sync();
+    }
+
+    void resize(size_t size, const T &value) {
+        detach();
+        m_vector.resize(size, value);
+        sync();
+    }
+
+    void assign(size_t size, const T &value) {
+        detach();
+        m_vector.assign(size, value);
+        sync();
+    }
+
+    template<typename It>
+    void assign(It first, It last) {
+        detach();
+        m_vector.assign(first, last);
+        sync();
+    }
+
+    void push_back(const T &value) {
+        detach();
+        m_vector.push_back(value);
+        sync();
+    }
+
+    template<typename... Args>
+    T & emplace_back(Args &&... args) {
+        detach();
+        auto &value = m_vector.emplace_back(std::forward<Args>(args)...);
+        sync();
+        return value;
+    }
+
+    iterator insert(iterator pos, const T &value) {
+        auto offset = std::distance(begin(), pos);
+        m_vector.insert(m_vector.begin() + offset, value);
+        sync();
+        return m_vector.data() + offset;
+    }
+
+    template<typename It>
+    iterator insert(iterator pos, It first, It last) {
+        auto offset = std::distance(begin(), pos);
+        m_vector.insert(m_vector.begin() + offset, first, last);
+        sync();
+        return m_vector.data() + offset;
+    }
+
+    iterator erase(iterator pos) {
+        auto offset = std::distance(begin(), pos);
+        m_vector.erase(m_vector.begin() + offset);
+        sync();
+        return m_vector.data() + offset;
+    }
+
+    void pop_back() {
+        detach();
+        m_vector.pop_back();
+        sync();
+    }
+
+    void clear() {
+        m_vector.clear();
+        m_mapped = false;
+        sync();
+    }
+
+    void shrink_to_fit() {
+        detach();
+        m_vector.shrink_to_fit();
+        sync();
+    }
+
+private:
+    // Copies referenced elements into owned storage.
+    void detach() {
+        if (m_mapped) {
+            m_vector.assign(m_data, m_data + m_size);
+            m_mapped = false;
+            sync();
+        }
+    }
+
+    void sync() {
+        m_data = m_vector.data();
+        m_size = m_vector.size();
+    }
+
+    // Shares the referenced elements of `other` if mapped.
+    void sync(const mappable_vector &other) {
+        if (m_mapped) {
+            m_data = other.m_data;
+            m_size = other.m_size;
+        } else {
+            sync();
+        }
+    }
+
+    std::vector<T> m_vector;
+    bool m_mapped {false};
+    const T *m_data {nullptr};
+    size_t m_size {0};
+};
+
+template<typename T>
+struct is_mappable_vector : std::false_type {};
+
+template<typename T>
+struct is_mappable_vector<mappable_vector<T>> : std::true_type {};
+
+template<typename T>
+inline constexpr bool is_mappable_vector_v = is_mappable_vector<T>::value;
+
+}
+
+#endif // EDYN_UTIL_MAPPABLE_VECTOR_HPP
@@ -0,0 +1,238 @@
+#ifndef EDYN_UTIL_RAYCAST_UTIL_HPP
+#define EDYN_UTIL_RAYCAST_UTIL_HPP
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <entt/entity/fwd.hpp>
+#include "edyn/collision/raycast.hpp"
+#include "edyn/collision/query_tree.hpp"
+#include "edyn/comp/aabb.hpp"
+#include "edyn/math/math.hpp"
+#include "edyn/math/vector3.hpp"
+#include "edyn/parallel/parallel_for.hpp"
+
+namespace edyn {
+
+// Number of rays traversed together through the AABB trees.
+inline constexpr size_t raycast_packet_size = 32;
+static_assert(raycast_packet_size <= max_tree_packet_size);
+
+// Number of candidates collected during traversal before they're raycast.
+// Small enough for the hits to cull the rest of the traversal early, large
+// enough for the groups of each shape type to be worth sorting.
+inline constexpr size_t raycast_candidate_batch_size = 64;
+
+// An entity whose AABB is intersected by a ray in a packet.
+struct raycast_candidate {
+    size_t shape_index;
+    scalar entry;
+    entt::entity entity;
+    size_t ray;
+    // Index of the body of the entity in a `query_world`.
+    uint32_t body;
+};
+
+// A group of rays which are processed together.
+struct raycast_packet {
+    size_t size {0};
+    std::array<vector3, raycast_packet_size> p0;
+    std::array<vector3, raycast_packet_size> p1;
+    // Reciprocal of the direction of each ray, for slab tests against AABBs.
+    std::array<vector3, raycast_packet_size> inv_dir;
+    // Only entities whose collision filter collides with this filter can be
+    // hit. No filtering is done if null.
+    std::array<const collision_filter *, raycast_packet_size> filter;
+    std::array<raycast_result *, raycast_packet_size> result;
+    // Whether a ray does not need to be tested anymore.
+    std::array<bool, raycast_packet_size> done;
+
+    void add(vector3 ray_p0, vector3 ray_p1, const collision_filter *ray_filter,
+             raycast_result &ray_result) {
+        EDYN_ASSERT(size < raycast_packet_size);
+        auto dir = ray_p1 - ray_p0;
+        p0[size] = ray_p0;
+        p1[size] = ray_p1;
+        filter[size] = ray_filter;
+        result[size] = &ray_result;
+        done[size] = false;
+
+        // Zero components result in infinite slab parameters, unless the
+        // origin lies on a slab plane, in which case it is zero instead of NaN.
+        for (auto k = 0; k < 3; ++k) {
+            inv_dir[size][k] = dir[k] != 0 ? scalar(1) / dir[k] : EDYN_SCALAR_MAX;
+        }
+
+        ++size;
+    }
+
+    // Fraction of ray `i` where it enters the AABB, or `EDYN_SCALAR_MAX` if the
+    // segment does not intersect it. Branchless slab test.
+    scalar entry_fraction(size_t i, const AABB &aabb) const {
+        auto t1 = (aabb.min - p0[i]) * inv_dir[i];
+        auto t2 = (aabb.max - p0[i]) * inv_dir[i];
+        auto t_near = min(t1, t2);
+        auto t_far = max(t1, t2);
+        auto t_min = std::max(std::max(t_near.x, t_near.y), std::max(t_near.z, scalar(0)));
+        auto t_max = std::min(std::min(t_far.x, t_far.y), std::min(t_far.z, scalar(1)));
+        return t_min <= t_max ? t_min : EDYN_SCALAR_MAX;
+    }
+
+    // Whether ray `i` can hit something in a node, i.e. it is not done and it
+    // enters the node before its closest hit.
+    bool test_node(size_t i, const AABB &aabb) const {
+        return !done[i] && entry_fraction(i, aabb) < result[i]->fraction;
+    }
+
+    // Whether the filter of ray `i` accepts an entity with the given filter.
+    bool accepts(size_t i, const collision_filter &entity_filter) const {
+        return !filter[i] || filters_collide(*filter[i], entity_filter);
+    }
+
+    // Whether the shape of a candidate can still be hit. A shape cannot be
+    // hit before the ray enters its AABB.
+    bool should_raycast(const raycast_candidate &candidate) const {
+        auto i = candidate.ray;
+        return !done[i] && candidate.entry < result[i]->fraction;
+    }
+
+    // Assigns a hit on the shape of a candidate if it is closer.
+    void report(const raycast_candidate &candidate, const shape_raycast_result &res,
+                raycast_mode mode) {
+        auto &ray_result = *result[candidate.ray];
+
+        if (res.fraction < ray_result.fraction) {
+            static_cast<shape_raycast_result &>(ray_result) = res;
+            ray_result.entity = candidate.entity;
+            done[candidate.ray] = mode == raycast_mode::any_hit;
+        }
+    }
+};
+
+/**
+ * @brief Raycasts the candidates collected so far and clears them. Candidates
+ * are grouped by shape type, which allows the shapes of each type to be
+ * raycast in a tight loop instead of visiting the shape of each candidate.
+ * Within a group, candidates are processed in the order the ray enters their
+ * AABB.
+ * @param candidates Candidates collected during traversal.
+ * @param raycast_group Function with signature `void(It first, It last)`
+ * which raycasts a range of candidates of the same shape type.
+ */
+template<typename Func>
+void resolve_raycast_candidates(std::vector<raycast_candidate> &candidates, Func raycast_group) {
+    std::sort(candidates.begin(), candidates.end(), [] (auto &lhs, auto &rhs) {
+        return lhs.shape_index < rhs.shape_index ||
+               (lhs.shape_index == rhs.shape_index && lhs.entry < rhs.entry);
+    });
+
+    auto first = candidates.begin();
+
+    while (first != candidates.end()) {
+        auto last = std::find_if(first, candidates.end(), [&] (auto &candidate) {
+            return candidate.shape_index != first->shape_index;
+        });
+
+        raycast_group(first, last);
+        first = last;
+    }
+
+    candidates.clear();
+}
+
+// Spreads the lower 10 bits of `x` so there are two zero bits between each.
+inline uint32_t raycast_expand_bits(uint32_t x) {
+    x &= 0x3ff;
+    x = (x | (x << 16)) & 0x30000ff;
+    x = (x | (x << 8)) & 0x300f00f;
+    x = (x | (x << 4)) & 0x30c30c3;
+    x = (x | (x << 2)) & 0x9249249;
+    return x;
+}
+
+// Key used to sort rays for coherence. The octant of the direction goes in the
+// highest bits so rays pointing in similar directions are grouped, followed by
+// the Morton code of the midpoint in the bounds of all midpoints.
+inline uint32_t raycast_sort_key(const raycast_query &query, const AABB &bounds) {
+    auto dir = query.p1 - query.p0;
+    auto octant = uint32_t(dir.x < 0) | uint32_t(dir.y < 0) << 1 | uint32_t(dir.z < 0) << 2;
+    auto midpoint = (query.p0 + query.p1) * scalar(0.5);
+    auto extents = bounds.max - bounds.min;
+    uint32_t code = 0;
+
+    for (auto i = 0; i < 3; ++i) {
+        auto t = extents[i] > EDYN_EPSILON ? (midpoint[i] - bounds.min[i]) / extents[i] : scalar(0);
+        auto cell = static_cast<uint32_t>(std::clamp(t, scalar(0), scalar(1)) * scalar(1023));
+        code |= raycast_expand_bits(cell) << i;
+    }
+
+    return octant << 29 | code;
+}
+
+/**
+ * @brief Sorts a batch of rays for coherence, splits them into packets and
+ * invokes `raycast_packet_func` for each packet, in parallel if possible.
+ * @param queries The rays.
+ * @param results The result of each query, in the same order as `queries`.
+ * @param raycast_packet_func Function with signature
+ * `void(raycast_packet &, std::vector<raycast_candidate> &)`, where the vector
+ * is used as scratch memory. It can be invoked from multiple threads
+ * simultaneously.
+ */
+template<typename Func>
+void raycast_in_packets(const std::vector<raycast_query> &queries,
+                        std::vector<raycast_result> &results, Func raycast_packet_func) {
+    results.assign(queries.size(), raycast_result{});
+
+    if (queries.empty()) {
+        return;
+    }
+
+    // Sort ray indices for coherence.
+    auto bounds = AABB{vector3_max, -vector3_max};
+
+    for (auto &query : queries) {
+        auto midpoint = (query.p0 + query.p1) * scalar(0.5);
+        bounds.min = min(bounds.min, midpoint);
+        bounds.max = max(bounds.max, midpoint);
+    }
+
+    auto keys = std::vector<std::pair<uint32_t, size_t>>(queries.size());
+
+    for (size_t i = 0; i < queries.size(); ++i) {
+        keys[i] = {raycast_sort_key(queries[i], bounds), i};
+    }
+
+    std::sort(keys.begin(), keys.end());
+
+    auto process_packet = [&] (size_t packet_index) {
+        auto first = packet_index * raycast_packet_size;
+        auto count = std::min(raycast_packet_size, queries.size() - first);
+        auto packet = raycast_packet{};
+
+        for (size_t i = 0; i < count; ++i) {
+            auto index = keys[first + i].second;
+            auto &query = queries[index];
+            packet.add(query.p0, query.p1, &query.filter, results[index]);
+        }
+
+        auto candidates = std::vector<raycast_candidate>{};
+        raycast_packet_func(packet, candidates);
+    };
+
+    auto num_packets = (queries.size() + raycast_packet_size - 1) / raycast_packet_size;
+
+    if (num_packets < 2 || !can_parallel_for()) {
+        for (size_t i = 0; i < num_packets; ++i) {
+            process_packet(i);
+        }
+    } else {
+        parallel_for(size_t{0}, num_packets, process_packet);
+    }
+}
+
+}
+
+#endif // EDYN_UTIL_RAYCAST_UTIL_HPP
@@ -150,6 +150,18 @@ void set_rigidbody_inertia(entt::registry &, entt::entity, const matrix3x3 &iner
  */
 void set_rigidbody_friction(entt::registry &, entt::entity, scalar);
 
+/**
+ * @brief Applies a set of modifications to the mesh of a static rigid body
+ * with a `mesh_shape`, e.g. to carve a crater. The mesh is shared with the
+ * island workers thus it is copied, edited using
+ * `triangle_mesh::apply_edit` and assigned to the shape. The shape and the
+ * AABB of the rigid body are propagated across island workers.
+ * @param registry Data source.
+ * @param entity Rigid body entity.
+ * @param edit The modifications.
+ */
+void edit_mesh_shape(entt::registry &, entt::entity, const triangle_mesh_edit &edit);
+
 /**
  * @brief Offset the rigid body center of mass. The value represents an offset
  * from the rigid body's origin in object space.
@@ -0,0 +1,296 @@
+#ifndef EDYN_UTIL_SHAPE_QUERY_UTIL_HPP
+#define EDYN_UTIL_SHAPE_QUERY_UTIL_HPP
+
+#include <vector>
+#include <variant>
+#include <algorithm>
+#include <type_traits>
+#include <entt/entity/fwd.hpp>
+#include "edyn/collision/shape_query.hpp"
+#include "edyn/collision/gjk_epa.hpp"
+#include "edyn/collision/collide_gjk.hpp"
+#include "edyn/math/math.hpp"
+#include "edyn/shapes/shapes.hpp"
+#include "edyn/util/aabb_util.hpp"
+#include "edyn/util/triangle_util.hpp"
+
+namespace edyn {
+
+// Distance under which a cast shape is considered to be touching another.
+inline constexpr auto shape_cast_tolerance = scalar(0.001);
+inline constexpr size_t shape_cast_max_iterations = 32;
+
+// The rotated mesh of polyhedrons is only available in the island workers,
+// thus the support point is found using the vertices in object space.
+inline vector3 query_support_point(const polyhedron_shape &sh, const vector3 &pos,
+                                   const quaternion &orn, const vector3 &dir) {
+    auto &vertices = sh.mesh->vertices;
+    auto local_dir = rotate(conjugate(orn), dir);
+    return to_world_space(vertices[sh.mesh->support_vertex_index(vertices, local_dir)], pos, orn);
+}
+
+template<typename ShapeType>
+vector3 query_support_point(const ShapeType &sh, const vector3 &pos,
+                            const quaternion &orn, const vector3 &dir) {
+    return shape_support_point(sh, pos, orn, dir);
+}
+
+template<typename Func>
+void visit_triangle(const triangle_vertices &vertices, Func &func) {
+    func([&] (const vector3 &dir) {
+        auto proj0 = dot(vertices[0], dir);
+        auto proj1 = dot(vertices[1], dir);
+        auto proj2 = dot(vertices[2], dir);
+
+        if (proj0 >= proj1 && proj0 >= proj2) {
+            return vertices[0];
+        }
+
+        return proj1 >= proj2 ? vertices[1] : vertices[2];
+    });
+}
+
+// Calls `func` with the world space support function of each convex piece of
+// a shape whose bounds intersect `aabb`, i.e. the shape itself if it's convex,
+// the children of a compound or the triangles of a mesh. Planes are unbounded
+// and are handled separately.
+template<typename ShapeType, typename Func>
+void visit_convex_pieces(const ShapeType &sh, const vector3 &pos, const quaternion &orn,
+                         const AABB &, Func &func) {
+    static_assert(has_support_function_v<ShapeType>);
+    func([&] (const vector3 &dir) {
+        return query_support_point(sh, pos, orn, dir);
+    });
+}
+
+template<typename Func>
+void visit_convex_pieces(const compound_shape &sh, const vector3 &pos, const quaternion &orn,
+                         const AABB &aabb, Func &func) {
+    auto local_aabb = aabb_to_object_space(aabb, pos, orn);
+
+    sh.visit(local_aabb, [&] (auto &&child, auto node_index) {
+        auto &node = sh.nodes[node_index];
+        auto child_pos = to_world_space(node.position, pos, orn);
+        auto child_orn = orn * node.orientation;
+        visit_convex_pieces(child, child_pos, child_orn, aabb, func);
+    });
+}
+
+template<typename Func>
+void visit_convex_pieces(const mesh_shape &sh, const vector3 &, const quaternion &,
+                         const AABB &aabb, Func &func) {
+    sh.trimesh->visit_triangles(aabb, [&] (auto tri_idx) {
+        visit_triangle(sh.trimesh->get_triangle_vertices(tri_idx), func);
+    });
+}
+
+template<typename Func>
+void visit_convex_pieces(const paged_mesh_shape &sh, const vector3 &, const quaternion &,
+                         const AABB &aabb, Func &func) {
+    // Only submeshes that are already loaded are considered, like in raycasts.
+    sh.trimesh->visit_cached_triangles(aabb, [&] (auto, auto tri_idx, auto &trimesh) {
+        visit_triangle(trimesh->get_triangle_vertices(tri_idx), func);
+    });
+}
+
+template<typename Func>
+void visit_convex_pieces(const heightfield_shape &sh, const vector3 &, const quaternion &,
+                         const AABB &aabb, Func &func) {
+    sh.field->visit_triangles(aabb, [&] (auto tri_idx) {
+        visit_triangle(sh.field->get_triangle_vertices(tri_idx), func);
+    });
+}
+
+template<typename SupportFuncA, typename SupportFuncB>
+bool convex_overlap(const SupportFuncA &supportA, const SupportFuncB &supportB) {
+    auto support = [&] (const vector3 &dir) {
+        auto pointA = supportA(dir);
+        auto pointB = supportB(-dir);
+        return support_vertex{pointA - pointB, pointA, pointB};
+    };
+
+    // With a maximum distance of zero, GJK terminates as soon as a separating
+    // plane is found.
+    auto res = gjk(support, vector3_x, scalar(0));
+    return !res.beyond_max_distance && res.intersecting;
+}
+
+// Conservative advancement: shape A is moved along the displacement by the
+// distance between the shapes divided by the speed at which it approaches
+// shape B along the separating normal, which never causes it to go past the
+// time of impact. The distance is recalculated with GJK until it is under the
+// tolerance.
+template<typename SupportFuncA, typename SupportFuncB>
+bool convex_cast(const SupportFuncA &supportA, const vector3 &displacement,
+                 const SupportFuncB &supportB, scalar max_fraction,
+                 shape_cast_result &result) {
+    auto fraction = scalar(0);
+    auto search_dir = -displacement;
+
+    for (size_t i = 0; i < shape_cast_max_iterations; ++i) {
+        auto offset = displacement * fraction;
+        auto support = [&] (const vector3 &dir) {
+            auto pointA = supportA(dir) + offset;
+            auto pointB = supportB(-dir);
+            return support_vertex{pointA - pointB, pointA, pointB};
+        };
+
+        auto res = gjk(support, search_dir, EDYN_SCALAR_MAX);
+
+        if (res.intersecting) {
+            if (i > 0) {
+                // Went slightly past the surface due to rounding errors. Keep
+                // the normal and point found in the previous iteration.
+                break;
+            }
+
+            // Initially intersecting. Find the penetration normal.
+            auto epa_res = epa_result{};
+
+            if (epa(support, res.simplex, epa_res)) {
+                result.normal = epa_res.normal;
+                result.point = epa_res.pointB;
+            } else {
+                auto len_sqr = length_sqr(displacement);
+                result.normal = len_sqr > EDYN_EPSILON ? -displacement / std::sqrt(len_sqr) : vector3_y;
+                result.point = supportB(result.normal);
+            }
+
+            break;
+        }
+
+        result.normal = res.normal;
+        result.point = res.pointB;
+
+        if (res.distance < shape_cast_tolerance) {
+            break;
+        }
+
+        auto approach_speed = -dot(displacement, res.normal);
+
+        if (approach_speed <= EDYN_EPSILON) {
+            // Moving away from shape B or parallel to it.
+            return false;
+        }
+
+        fraction += res.distance / approach_speed;
+
+        if (fraction > max_fraction) {
+            return false;
+        }
+
+        search_dir = res.normal;
+    }
+
+    result.fraction = fraction;
+    return true;
+}
+
+/**
+ * @brief Performs an overlap query on a source of shapes.
+ * @param query The query shape and its transform.
+ * @param entities The entities intersecting the query shape are appended here.
+ * @param visit_candidates Function with signature
+ * `void(const AABB &, const collision_filter &, Func)` which calls `Func` for
+ * each entity whose AABB intersects the given AABB and whose filter collides
+ * with the given filter. `Func` has signature
+ * `void(entt::entity, auto &&shape, vector3 pos, quaternion orn)`, where
+ * `pos` and `orn` are the origin and orientation of the shape.
+ */
+template<typename CandidateVisitor>
+void perform_overlap(const overlap_query &query, std::vector<entt::entity> &entities,
+                     const CandidateVisitor &visit_candidates) {
+    std::visit([&] (auto &&shA) {
+        auto aabb = shape_aabb(shA, query.pos, query.orn);
+        auto supportA = [&] (const vector3 &dir) {
+            return query_support_point(shA, query.pos, query.orn, dir);
+        };
+
+        visit_candidates(aabb, query.filter, [&] (entt::entity entity, auto &&shB,
+                                                  const vector3 &pos, const quaternion &orn) {
+            using ShapeType = std::decay_t<decltype(shB)>;
+            auto intersecting = false;
+
+            if constexpr(std::is_same_v<ShapeType, plane_shape>) {
+                auto deepest = supportA(-shB.normal);
+                intersecting = dot(deepest, shB.normal) - shB.constant <= 0;
+            } else {
+                auto test_piece = [&] (auto &&supportB) {
+                    if (!intersecting && convex_overlap(supportA, supportB)) {
+                        intersecting = true;
+                    }
+                };
+                visit_convex_pieces(shB, pos, orn, aabb, test_piece);
+            }
+
+            if (intersecting) {
+                entities.push_back(entity);
+            }
+        });
+    }, query.shape);
+}
+
+/**
+ * @brief Performs a shape cast query on a source of shapes.
+ * @param query The query shape and its sweep.
+ * @param visit_candidates See `perform_overlap`.
+ * @return Shape cast result.
+ */
+template<typename CandidateVisitor>
+shape_cast_result perform_shape_cast(const shape_cast_query &query,
+                                     const CandidateVisitor &visit_candidates) {
+    auto result = shape_cast_result{};
+
+    std::visit([&] (auto &&shA) {
+        auto displacement = query.p1 - query.p0;
+        auto aabb = enclosing_aabb(shape_aabb(shA, query.p0, query.orn),
+                                   shape_aabb(shA, query.p1, query.orn));
+        auto supportA = [&] (const vector3 &dir) {
+            return query_support_point(shA, query.p0, query.orn, dir);
+        };
+
+        visit_candidates(aabb, query.filter, [&] (entt::entity entity, auto &&shB,
+                                                  const vector3 &pos, const quaternion &orn) {
+            using ShapeType = std::decay_t<decltype(shB)>;
+            auto max_fraction = std::min(result.fraction, scalar(1));
+            auto res = shape_cast_result{};
+
+            if constexpr(std::is_same_v<ShapeType, plane_shape>) {
+                auto deepest = supportA(-shB.normal);
+                auto distance = dot(deepest, shB.normal) - shB.constant;
+                auto approach_speed = -dot(displacement, shB.normal);
+
+                if (distance <= 0) {
+                    res.fraction = 0;
+                    res.point = deepest - shB.normal * distance;
+                } else if (approach_speed > EDYN_EPSILON) {
+                    res.fraction = distance / approach_speed;
+                    res.point = deepest + displacement * res.fraction;
+                }
+
+                res.normal = shB.normal;
+            } else {
+                auto cast_piece = [&] (auto &&supportB) {
+                    auto piece_res = shape_cast_result{};
+
+                    if (convex_cast(supportA, displacement, supportB, std::min(res.fraction, max_fraction), piece_res) &&
+                        piece_res.fraction < res.fraction) {
+                        res = piece_res;
+                    }
+                };
+                visit_convex_pieces(shB, pos, orn, aabb, cast_piece);
+            }
+
+            if (res.fraction <= max_fraction && res.fraction < result.fraction) {
+                result = res;
+                result.entity = entity;
+            }
+        });
+    }, query.shape);
+
+    return result;
+}
+
+}
+
+#endif // EDYN_UTIL_SHAPE_QUERY_UTIL_HPP
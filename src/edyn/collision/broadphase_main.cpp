@@ -3,10 +3,11 @@
 #include "edyn/comp/aabb.hpp"
 #include "edyn/comp/island.hpp"
 #include "edyn/comp/tree_resident.hpp"
+#include "edyn/comp/collision_filter.hpp"
+#include "edyn/comp/collision_exclusion.hpp"
 #include "edyn/collision/contact_manifold.hpp"
 #include "edyn/collision/contact_manifold_map.hpp"
 #include "edyn/util/constraint_util.hpp"
-#include "edyn/collision/tree_view.hpp"
 #include "edyn/comp/tag.hpp"
 #include "edyn/parallel/parallel_for.hpp"
 #include "edyn/context/settings.hpp"
@@ -17,27 +18,30 @@ namespace edyn {
 broadphase_main::broadphase_main(entt::registry &registry)
     : m_registry(&registry)
 {
-    // Add tree nodes for islands (which have a `tree_view`) and for static and
-    // kinematic entities.
-    registry.on_construct<tree_view>().connect<&broadphase_main::on_construct_tree_view>(*this);
+    // Add tree nodes for procedural entities, which go into the world tree,
+    // and for static and kinematic entities.
+    registry.on_construct<AABB>().connect<&broadphase_main::on_construct_aabb>(*this);
     registry.on_construct<static_tag>().connect<&broadphase_main::on_construct_static_kinematic_tag>(*this);
     registry.on_construct<kinematic_tag>().connect<&broadphase_main::on_construct_static_kinematic_tag>(*this);
     registry.on_destroy<tree_resident>().connect<&broadphase_main::on_destroy_tree_resident>(*this);
+    registry.on_construct<collision_filter>().connect<&broadphase_main::on_update_collision_filter>(*this);
+    registry.on_update<collision_filter>().connect<&broadphase_main::on_update_collision_filter>(*this);
+    registry.on_destroy<collision_filter>().connect<&broadphase_main::on_destroy_collision_filter>(*this);
+    registry.on_construct<collision_exclusion>().connect<&broadphase_main::on_update_collision_filter>(*this);
+    registry.on_update<collision_exclusion>().connect<&broadphase_main::on_update_collision_filter>(*this);
 }
 
-void broadphase_main::on_construct_tree_view(entt::registry &registry, entt::entity entity) {
-  EDYN_ASSERT(registry.all_of<island>(entity));
-
-  auto &view = registry.get<tree_view>(entity);
-    auto id = m_island_tree.create(view.root_aabb(), entity);
-    registry.emplace<tree_resident>(entity, id, true);
+void broadphase_main::on_construct_aabb(entt::registry &, entt::entity entity) {
+    // Perform initialization later when the entity is fully constructed.
+    m_new_aabb_entities.push_back(entity);
 }
 
 void broadphase_main::on_construct_static_kinematic_tag(entt::registry &registry, entt::entity entity) {
-  if (!registry.all_of<AABB>(entity)) return;
+    if (!registry.all_of<AABB>(entity)) return;
 
-  auto &aabb = registry.get<AABB>(entity);
+    auto &aabb = registry.get<AABB>(entity);
     auto id = m_np_tree.create(aabb, entity);
+    update_filter(m_np_tree, id, entity);
     registry.emplace<tree_resident>(entity, id, false);
 }
 
@@ -45,20 +49,101 @@ void broadphase_main::on_destroy_tree_resident(entt::registry &registry, entt::e
     auto &node = registry.get<tree_resident>(entity);
 
     if (node.procedural) {
-        m_island_tree.destroy(node.id);
+        m_tree.destroy(node.id);
     } else {
         m_np_tree.destroy(node.id);
     }
 }
 
+void broadphase_main::on_update_collision_filter(entt::registry &registry, entt::entity entity) {
+    // Entities that are not in a tree yet will have their filter assigned
+    // on insertion.
+    if (auto *node = registry.try_get<tree_resident>(entity)) {
+        update_filter(node->procedural ? m_tree : m_np_tree, node->id, entity);
+    }
+}
+
+void broadphase_main::on_destroy_collision_filter(entt::registry &registry, entt::entity entity) {
+    // The component is still present at this point, thus assign the default
+    // filter directly.
+    if (auto *node = registry.try_get<tree_resident>(entity)) {
+        auto &tree = node->procedural ? m_tree : m_np_tree;
+        tree.set_filter(node->id, collision_filter{}, registry.all_of<collision_exclusion>(entity));
+    }
+}
+
+void broadphase_main::update_static_aabb(entt::entity entity) {
+    // Entities that are not in a tree yet will be inserted with their
+    // current AABB.
+    if (auto *node = m_registry->try_get<tree_resident>(entity)) {
+        EDYN_ASSERT(!node->procedural);
+        m_np_tree.move(node->id, m_registry->get<AABB>(entity));
+    }
+}
+
+void broadphase_main::update_filter(dynamic_tree &tree, tree_node_id_t id, entt::entity entity) {
+    auto filter = collision_filter{};
+
+    if (auto *comp = m_registry->try_get<collision_filter>(entity)) {
+        filter = *comp;
+    }
+
+    tree.set_filter(id, filter, m_registry->all_of<collision_exclusion>(entity));
+}
+
+void broadphase_main::init_new_aabb_entities() {
+    if (m_new_aabb_entities.empty()) {
+        return;
+    }
+
+    auto aabb_view = m_registry->view<AABB>();
+    auto procedural_view = m_registry->view<procedural_tag>();
+    auto resident_view = m_registry->view<tree_resident>();
+
+    for (auto entity : m_new_aabb_entities) {
+        // Entity might've been destroyed, thus skip it. Non-procedural
+        // entities are inserted in the non-procedural tree when they're
+        // tagged.
+        if (!m_registry->valid(entity) ||
+            !procedural_view.contains(entity) ||
+            resident_view.contains(entity)) {
+            continue;
+        }
+
+        auto &aabb = std::get<0>(aabb_view.get(entity));
+        auto id = m_tree.create(aabb, entity);
+        update_filter(m_tree, id, entity);
+        m_registry->emplace<tree_resident>(entity, id, true);
+    }
+
+    m_new_aabb_entities.clear();
+}
+
 void broadphase_main::update() {
-    // Update island AABBs in tree (ignore sleeping islands).
-    auto exclude_sleeping = entt::exclude_t<sleeping_tag>{};
-    auto tree_view_resident_view = m_registry->view<tree_view, tree_resident>(exclude_sleeping);
-    tree_view_resident_view.each([&] (tree_view &tree_view, tree_resident &node) {
-        m_island_tree.move(node.id, tree_view.root_aabb());
+    init_new_aabb_entities();
+
+    // Collision filters can be modified in place in the main registry without
+    // triggering an update signal. Refresh the leaf filters of all entities
+    // that have one, in both trees, so that static and kinematic leaves do
+    // not hold on to stale filters.
+    auto exclusion_view = m_registry->view<collision_exclusion>();
+    m_registry->view<tree_resident, collision_filter>().each(
+        [&] (entt::entity entity, tree_resident &node, collision_filter &filter) {
+        auto &tree = node.procedural ? m_tree : m_np_tree;
+        tree.set_filter(node.id, filter, exclusion_view.contains(entity));
     });
 
+    // Update AABBs of procedural entities in the world tree using the latest
+    // values received from the island workers (ignore sleeping entities).
+    auto exclude_sleeping = entt::exclude_t<sleeping_tag>{};
+    auto proc_aabb_node_view = m_registry->view<tree_resident, AABB, procedural_tag>(exclude_sleeping);
+
+    for (auto entity : proc_aabb_node_view) {
+        auto [node, aabb] = proc_aabb_node_view.get<tree_resident, AABB>(entity);
+        m_tree.move(node.id, aabb);
+        m_awake_nodes.push_back(node.id);
+    }
+
     // Update kinematic AABBs in tree.
     // TODO: only do this for kinematic entities that had their AABB updated.
     auto kinematic_aabb_node_view = m_registry->view<tree_resident, AABB, kinematic_tag>();
@@ -66,164 +151,120 @@ void broadphase_main::update() {
         m_np_tree.move(node.id, aabb);
     });
 
-    // Search for island pairs with intersecting AABBs, i.e. the AABB of the root
-    // node of their trees intersect.
-    auto tree_view_not_sleeping_view = m_registry->view<tree_view>(exclude_sleeping);
-
-    std::vector<entt::entity> awake_island_entities;
-    for (auto entity : tree_view_not_sleeping_view) {
-        awake_island_entities.push_back(entity);
-    }
-
-    if (awake_island_entities.empty()) {
+    if (m_awake_nodes.empty()) {
         return;
     }
 
+    // Search for pairs of entities residing in different islands with
+    // intersecting AABBs. Each awake procedural entity queries the world tree
+    // and the non-procedural tree once.
     const auto aabb_view = m_registry->view<AABB>();
-    const auto tree_view_view = m_registry->view<tree_view>();
+    const auto resident_view = m_registry->view<island_resident>();
     const auto multi_resident_view = m_registry->view<multi_island_resident>();
+    const auto sleeping_view = m_registry->view<sleeping_tag>();
+    auto &manifold_map = m_registry->ctx<contact_manifold_map>();
 
-    if (awake_island_entities.size() > 1) {
-        m_pair_results.resize(awake_island_entities.size());
-
-        parallel_for(size_t{0}, awake_island_entities.size(), [&] (size_t index) {
-            auto island_entityA = awake_island_entities[index];
-            m_pair_results[index] = find_intersecting_islands(island_entityA, aabb_view, multi_resident_view, tree_view_view);
-        });
-
-        auto &manifold_map = m_registry->ctx<contact_manifold_map>();
+    m_pair_results.resize(m_awake_nodes.size());
 
-        for (auto &results : m_pair_results) {
-            for (auto &pair : results) {
-                if (!manifold_map.contains(pair)) {
-                    make_contact_manifold(*m_registry, pair.first, pair.second, m_separation_threshold);
-                }
-            }
-        }
+    auto find_pairs = [&] (size_t index) {
+        auto id = m_awake_nodes[index];
+        m_pair_results[index] = find_intersecting_pairs(id, aabb_view, resident_view,
+                                                        multi_resident_view, sleeping_view);
+    };
 
-        m_pair_results.clear();
+    if (m_awake_nodes.size() > 1 && can_parallel_for()) {
+        parallel_for(size_t{0}, m_awake_nodes.size(), find_pairs);
     } else {
-        for (auto island_entityA : awake_island_entities) {
-            auto pairs = find_intersecting_islands(island_entityA, aabb_view, multi_resident_view, tree_view_view);
+        for (size_t index = 0; index < m_awake_nodes.size(); ++index) {
+            find_pairs(index);
+        }
+    }
 
-            for (auto &pair : pairs) {
+    for (auto &results : m_pair_results) {
+        for (auto &pair : results) {
+            if (!manifold_map.contains(pair)) {
                 make_contact_manifold(*m_registry, pair.first, pair.second, m_separation_threshold);
             }
         }
     }
+
+    m_pair_results.clear();
+    m_awake_nodes.clear();
 }
 
-entity_pair_vector broadphase_main::find_intersecting_islands(entt::entity island_entityA,
-                                                              const aabb_view_t &aabb_view,
-                                                              const multi_resident_view_t &resident_view,
-                                                              const tree_view_view_t &tree_view_view) const {
-  auto &tree_viewA = std::get<0>(tree_view_view.get(island_entityA));
-  auto island_aabb = tree_viewA.root_aabb().inset(m_aabb_offset);
-  entity_pair_vector results;
+entity_pair_vector broadphase_main::find_intersecting_pairs(tree_node_id_t idA,
+                                                            const aabb_view_t &aabb_view,
+                                                            const island_resident_view_t &resident_view,
+                                                            const multi_resident_view_t &multi_resident_view,
+                                                            const sleeping_view_t &sleeping_view) const {
+    auto entityA = m_tree.get_node(idA).entity;
+    auto &filterA = m_tree.get_filter(idA);
+    auto island_entityA = std::get<0>(resident_view.get(entityA)).island_entity;
+    entity_pair_vector results;
 
-    // Query the dynamic tree to find other islands whose AABB intersects the
-    // current island's AABB.
-    m_island_tree.query(island_aabb, [&] (tree_node_id_t idB) {
-        auto island_entityB = m_island_tree.get_node(idB).entity;
+    // Entity hasn't been inserted into an island yet.
+    if (island_entityA == entt::null) {
+        return results;
+    }
+
+    auto &manifold_map = m_registry->ctx<contact_manifold_map>();
+    auto should_collide_func = m_registry->ctx<settings>().should_collide_func;
+    auto aabbA = std::get<0>(aabb_view.get(entityA)).inset(m_aabb_offset);
+
+    // Query the world tree to find procedural entities in other islands.
+    m_tree.query(aabbA, [&] (tree_node_id_t idB) {
+        auto entityB = m_tree.get_node(idB).entity;
+
+        // If both entities are awake, the pair will be found from both sides.
+        // Only consider it once.
+        if (entityB <= entityA && !sleeping_view.contains(entityB)) {
+            return;
+        }
 
-        if (island_entityA == island_entityB) {
+        // Collisions between entities in the same island are handled in the
+        // island worker.
+        auto island_entityB = std::get<0>(resident_view.get(entityB)).island_entity;
+
+        if (island_entityB == entt::null || island_entityA == island_entityB) {
             return;
         }
 
-        // Look for AABB intersections between entities from different islands
-        // and create manifolds.
-        auto &tree_viewB = std::get<0>(tree_view_view.get(island_entityB));
-        auto pairs = intersect_islands(tree_viewA, tree_viewB, aabb_view);
-        results.insert(results.end(), pairs.begin(), pairs.end());
+        if (should_collide(*m_registry, should_collide_func,
+                           entityA, filterA, entityB, m_tree.get_filter(idB)) &&
+            !manifold_map.contains(entityA, entityB)) {
+            auto &aabbB = std::get<0>(aabb_view.get(entityB));
+
+            if (intersect(aabbA, aabbB)) {
+                results.emplace_back(entityA, entityB);
+            }
+        }
     });
 
     // Query the non-procedural dynamic tree to find static and kinematic
-    // entities that are intersecting this island.
-    m_np_tree.query(island_aabb, [&] (tree_node_id_t id_np) {
+    // entities that are intersecting this entity.
+    m_np_tree.query(aabbA, [&] (tree_node_id_t id_np) {
         auto np_entity = m_np_tree.get_node(id_np).entity;
 
         // Only proceed if the non-procedural entity is not in the island,
         // because if it is already in, collisions are handled in the
         // island worker.
-        auto &resident = std::get<0>(resident_view.get(np_entity));
+        auto &resident = std::get<0>(multi_resident_view.get(np_entity));
         if (resident.island_entities.count(island_entityA)) {
             return;
         }
 
-        auto pairs = intersect_island_np(tree_viewA, np_entity, aabb_view);
-        results.insert(results.end(), pairs.begin(), pairs.end());
-    });
-
-    return results;
-}
-
-entity_pair_vector broadphase_main::intersect_islands(const tree_view &tree_viewA, const tree_view &tree_viewB,
-                                                      const aabb_view_t &aabb_view) const {
-    // Query one tree for each node of the other tree. Pick the smaller tree
-    // for the iteration and use the bigger one for the query.
-    if (tree_viewA.size() < tree_viewB.size()) {
-        return intersect_islands_a(tree_viewA, tree_viewB, aabb_view);
-    } else {
-        return intersect_islands_a(tree_viewB, tree_viewA, aabb_view);
-    }
-}
-
-entity_pair_vector broadphase_main::intersect_islands_a(const tree_view &tree_viewA, const tree_view &tree_viewB,
-                                                        const aabb_view_t &aabb_view) const {
-    entity_pair_vector results;
-    auto &manifold_map = m_registry->ctx<contact_manifold_map>();
-
-    // `tree_viewA` is iterated and for each node an AABB query is performed in
-    // `tree_viewB`, thus for better performance `tree_viewA` should be smaller
-    // than `tree_viewB`.
-    tree_viewA.each([&] (const tree_view::tree_node &nodeA) {
-        auto entityA = nodeA.entity;
+        if (should_collide(*m_registry, should_collide_func,
+                           entityA, filterA, np_entity, m_np_tree.get_filter(id_np)) &&
+            !manifold_map.contains(entityA, np_entity)) {
+            auto &np_aabb = std::get<0>(aabb_view.get(np_entity));
 
-        auto aabbA = std::get<0>(aabb_view.get(entityA)).inset(m_aabb_offset);
-
-        tree_viewB.query(aabbA, [&] (tree_node_id_t idB) {
-            auto entityB = tree_viewB.get_node(idB).entity;
-
-            if (should_collide(entityA, entityB) && !manifold_map.contains(entityA, entityB)) {
-              auto &aabbB = std::get<0>(aabb_view.get(entityB));
-
-              if (intersect(aabbA, aabbB)) {
-                results.emplace_back(entityA, entityB);
-              }
+            if (intersect(aabbA, np_aabb)) {
+                results.emplace_back(entityA, np_entity);
             }
-        });
-    });
-
-    return results;
-}
-
-entity_pair_vector broadphase_main::intersect_island_np(const tree_view &island_tree, entt::entity np_entity,
-                                                        const aabb_view_t &aabb_view) const {
-  auto np_aabb = std::get<0>(aabb_view.get(np_entity)).inset(m_aabb_offset);
-  entity_pair_vector results;
-    auto &manifold_map = m_registry->ctx<contact_manifold_map>();
-
-    island_tree.query(np_aabb, [&] (tree_node_id_t idA) {
-        auto entity = island_tree.get_node(idA).entity;
-
-        if (should_collide(entity, np_entity) && !manifold_map.contains(entity, np_entity)) {
-          auto &aabb = std::get<0>(aabb_view.get(entity));
-
-          if (intersect(aabb, np_aabb)) {
-            results.emplace_back(entity, np_entity);
-          }
         }
     });
 
     return results;
 }
 
-bool broadphase_main::should_collide(entt::entity first, entt::entity second) const {
-    // Entities should never be equal because they should come from
-    // different islands at this point.
-    EDYN_ASSERT(first != second);
-    auto &settings = m_registry->ctx<edyn::settings>();
-    return (*settings.should_collide_func)(*m_registry, first, second);
-}
-
 }
@@ -2,8 +2,9 @@
 #include "edyn/collision/tree_node.hpp"
 #include "edyn/comp/aabb.hpp"
 #include "edyn/comp/tree_resident.hpp"
+#include "edyn/comp/collision_filter.hpp"
+#include "edyn/comp/collision_exclusion.hpp"
 #include "edyn/collision/contact_manifold.hpp"
-#include "edyn/collision/tree_view.hpp"
 #include "edyn/comp/tag.hpp"
 #include "edyn/util/constraint_util.hpp"
 #include "edyn/parallel/parallel_for_async.hpp"
@@ -17,7 +18,13 @@ broadphase_worker::broadphase_worker(entt::registry &registry)
     , m_manifold_map(registry)
 {
     registry.on_construct<AABB>().connect<&broadphase_worker::on_construct_aabb>(*this);
+    registry.on_update<AABB>().connect<&broadphase_worker::on_update_aabb>(*this);
     registry.on_destroy<tree_resident>().connect<&broadphase_worker::on_destroy_tree_resident>(*this);
+    registry.on_construct<collision_filter>().connect<&broadphase_worker::on_update_collision_filter>(*this);
+    registry.on_update<collision_filter>().connect<&broadphase_worker::on_update_collision_filter>(*this);
+    registry.on_destroy<collision_filter>().connect<&broadphase_worker::on_destroy_collision_filter>(*this);
+    registry.on_construct<collision_exclusion>().connect<&broadphase_worker::on_update_collision_filter>(*this);
+    registry.on_update<collision_exclusion>().connect<&broadphase_worker::on_update_collision_filter>(*this);
 }
 
 void broadphase_worker::on_construct_aabb(entt::registry &, entt::entity entity) {
@@ -25,6 +32,14 @@ void broadphase_worker::on_construct_aabb(entt::registry &, entt::entity entity)
     m_new_aabb_entities.push_back(entity);
 }
 
+void broadphase_worker::on_update_aabb(entt::registry &registry, entt::entity entity) {
+    // Non-procedural AABBs are only updated when they're modified in the main
+    // registry. Procedural and kinematic nodes are moved in every update.
+    if (auto *node = registry.try_get<tree_resident>(entity); node && !node->procedural) {
+        m_np_tree.move(node->id, registry.get<AABB>(entity));
+    }
+}
+
 void broadphase_worker::on_destroy_tree_resident(entt::registry &registry, entt::entity entity) {
     auto &node = registry.get<tree_resident>(entity);
 
@@ -35,6 +50,33 @@ void broadphase_worker::on_destroy_tree_resident(entt::registry &registry, entt:
     }
 }
 
+void broadphase_worker::on_update_collision_filter(entt::registry &registry, entt::entity entity) {
+    // Entities that are not in a tree yet will have their filter assigned
+    // on insertion.
+    if (auto *node = registry.try_get<tree_resident>(entity)) {
+        update_filter(node->procedural ? m_tree : m_np_tree, node->id, entity);
+    }
+}
+
+void broadphase_worker::on_destroy_collision_filter(entt::registry &registry, entt::entity entity) {
+    // The component is still present at this point, thus assign the default
+    // filter directly.
+    if (auto *node = registry.try_get<tree_resident>(entity)) {
+        auto &tree = node->procedural ? m_tree : m_np_tree;
+        tree.set_filter(node->id, collision_filter{}, registry.all_of<collision_exclusion>(entity));
+    }
+}
+
+void broadphase_worker::update_filter(dynamic_tree &tree, tree_node_id_t id, entt::entity entity) {
+    auto filter = collision_filter{};
+
+    if (auto *comp = m_registry->try_get<collision_filter>(entity)) {
+        filter = *comp;
+    }
+
+    tree.set_filter(id, filter, m_registry->all_of<collision_exclusion>(entity));
+}
+
 void broadphase_worker::init_new_aabb_entities() {
     if (m_new_aabb_entities.empty()) {
         return;
@@ -52,6 +94,7 @@ void broadphase_worker::init_new_aabb_entities() {
         bool procedural = procedural_view.contains(entity);
         auto &tree = procedural ? m_tree : m_np_tree;
         tree_node_id_t id = tree.create(aabb, entity);
+        update_filter(tree, id, entity);
         m_registry->emplace<tree_resident>(entity, id, procedural);
     }
 
@@ -79,38 +122,47 @@ bool broadphase_worker::parallelizable() const {
     });
 }
 
-void broadphase_worker::collide_tree(const dynamic_tree &tree, entt::entity entity,
+void broadphase_worker::collide_tree(const dynamic_tree &tree, tree_node_id_t id,
                                      const AABB &offset_aabb) {
     auto aabb_view = m_registry->view<AABB>();
     auto &settings = m_registry->ctx<edyn::settings>();
+    auto entity = m_tree.get_node(id).entity;
+    auto &filter = m_tree.get_filter(id);
 
-    tree.query(offset_aabb, [&] (tree_node_id_t id) {
-        auto &node = tree.get_node(id);
-        auto collides = (*settings.should_collide_func)(*m_registry, entity, node.entity);
+    tree.query(offset_aabb, [&] (tree_node_id_t id_other) {
+        auto &other_node = tree.get_node(id_other);
+        auto collides = should_collide(*m_registry, settings.should_collide_func,
+                                       entity, filter, other_node.entity, tree.get_filter(id_other));
 
-        if (collides && !m_manifold_map.contains(entity, node.entity)) {
-          auto &other_aabb = std::get<0>(aabb_view.get(node.entity));
+        if (collides && !m_manifold_map.contains(entity, other_node.entity)) {
+          auto &other_aabb = std::get<0>(aabb_view.get(other_node.entity));
 
           if (intersect(offset_aabb, other_aabb)) {
-            make_contact_manifold(*m_registry, entity, node.entity, m_separation_threshold);
+            make_contact_manifold(*m_registry, entity, other_node.entity, m_separation_threshold);
           }
         }
     });
 }
 
-void broadphase_worker::collide_tree_async(const dynamic_tree &tree, entt::entity entity,
+void broadphase_worker::collide_tree_async(const dynamic_tree &tree, tree_node_id_t id,
                                            const AABB &offset_aabb, size_t result_index) {
     auto aabb_view = m_registry->view<AABB>();
     auto &settings = m_registry->ctx<edyn::settings>();
+    auto &node = m_tree.get_node(id);
+    auto &filter = m_tree.get_filter(id);
 
-    tree.query(offset_aabb, [&] (tree_node_id_t id) {
-        auto &node = tree.get_node(id);
+    tree.query(offset_aabb, [&] (tree_node_id_t id_other) {
+        auto &other_node = tree.get_node(id_other);
 
-        if ((*settings.should_collide_func)(*m_registry, entity, node.entity)) {
-          auto &other_aabb = std::get<0>(aabb_view.get(node.entity));
+        // The manifold map is not modified during the parallel section, thus
+        // it is safe to filter out existing manifolds here.
+        if (should_collide(*m_registry, settings.should_collide_func,
+                           node.entity, filter, other_node.entity, tree.get_filter(id_other)) &&
+            !m_manifold_map.contains(node.entity, other_node.entity)) {
+          auto &other_aabb = std::get<0>(aabb_view.get(other_node.entity));
 
           if (intersect(offset_aabb, other_aabb)) {
-            m_pair_results[result_index].emplace_back(entity, node.entity);
+            m_pair_results[result_index].emplace_back(node.entity, other_node.entity);
           }
         }
     });
@@ -120,11 +172,18 @@ void broadphase_worker::common_update() {
     init_new_aabb_entities();
     destroy_separated_manifolds(*m_registry);
 
-    // Update AABBs of procedural nodes in the dynamic tree.
-    auto proc_aabb_node_view = m_registry->view<tree_resident, AABB, procedural_tag>();
-    proc_aabb_node_view.each([&] (tree_resident &node, AABB &aabb) {
-        m_tree.move(node.id, aabb);
-    });
+    // Update AABBs of procedural nodes in the dynamic tree. When the hashed
+    // grid is used, the tree is only needed by raycasts and shape queries,
+    // thus it is updated before it is queried instead.
+    if (m_registry->ctx<settings>().broadphase == broadphase_type::hash_grid) {
+        m_tree_outdated.store(true, std::memory_order_release);
+    } else {
+        auto proc_aabb_node_view = m_registry->view<tree_resident, AABB, procedural_tag>();
+        proc_aabb_node_view.each([&] (tree_resident &node, AABB &aabb) {
+            m_tree.move(node.id, aabb);
+        });
+        m_tree_outdated.store(false, std::memory_order_release);
+    }
 
     // Update kinematic AABBs in non-procedural tree.
     // TODO: only do this for kinematic entities that had their AABB updated.
@@ -134,52 +193,164 @@ void broadphase_worker::common_update() {
     });
 }
 
+void broadphase_worker::update_procedural_tree() const {
+    if (!m_tree_outdated.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    // Queries might run concurrently.
+    auto lock = std::lock_guard(m_tree_mutex);
+
+    if (!m_tree_outdated.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    auto proc_aabb_node_view = m_registry->view<tree_resident, AABB, procedural_tag>();
+    proc_aabb_node_view.each([&] (tree_resident &node, AABB &aabb) {
+        m_tree.move(node.id, aabb);
+    });
+
+    m_tree_outdated.store(false, std::memory_order_release);
+}
+
 void broadphase_worker::update() {
     common_update();
 
+    if (m_registry->ctx<settings>().broadphase == broadphase_type::hash_grid) {
+        build_hash_grid();
+
+        for (size_t index = 0; index < m_grid_nodes.size(); ++index) {
+            collide_grid_element(index);
+        }
+
+        finish_async_update();
+        return;
+    }
+
     // Search for new AABB intersections and create manifolds.
-    auto aabb_proc_view = m_registry->view<AABB, procedural_tag>();
-    aabb_proc_view.each([&] (entt::entity entity, AABB &aabb) {
+    auto aabb_proc_view = m_registry->view<tree_resident, AABB, procedural_tag>();
+    aabb_proc_view.each([&] (tree_resident &node, AABB &aabb) {
         auto offset_aabb = aabb.inset(m_aabb_offset);
-        collide_tree(m_tree, entity, offset_aabb);
-        collide_tree(m_np_tree, entity, offset_aabb);
+        collide_tree(m_tree, node.id, offset_aabb);
+        collide_tree(m_np_tree, node.id, offset_aabb);
     });
 }
 
+void broadphase_worker::build_hash_grid() {
+    auto aabb_proc_view = m_registry->view<tree_resident, AABB, procedural_tag>();
+    aabb_proc_view.each([&] (tree_resident &node, AABB &aabb) {
+        m_grid_nodes.push_back(node.id);
+        m_grid_aabbs.push_back(aabb.inset(m_aabb_offset));
+    });
+
+    m_grid.build(m_grid_aabbs);
+    m_pair_results.resize(m_grid_nodes.size());
+}
+
+void broadphase_worker::collide_grid_element(size_t index) {
+    // The nodes of the procedural tree are only used for their entity and
+    // filter here, which are up to date even if their AABBs are not.
+    auto aabb_view = m_registry->view<AABB>();
+    auto &settings = m_registry->ctx<edyn::settings>();
+    auto &offset_aabb = m_grid_aabbs[index];
+    auto &node = m_tree.get_node(m_grid_nodes[index]);
+    auto &filter = m_tree.get_filter(m_grid_nodes[index]);
+
+    auto add_pair = [&] (size_t other_index) {
+        auto other_id = m_grid_nodes[other_index];
+        auto &other_node = m_tree.get_node(other_id);
+
+        // The manifold map is not modified during the parallel section, thus
+        // it is safe to filter out existing manifolds here.
+        if (should_collide(*m_registry, settings.should_collide_func,
+                           node.entity, filter, other_node.entity, m_tree.get_filter(other_id)) &&
+            !m_manifold_map.contains(node.entity, other_node.entity)) {
+            auto &other_aabb = std::get<0>(aabb_view.get(other_node.entity));
+
+            if (intersect(offset_aabb, other_aabb)) {
+                m_pair_results[index].emplace_back(node.entity, other_node.entity);
+            }
+        }
+    };
+
+    auto grid_index = static_cast<hash_grid::index_type>(index);
+
+    if (m_grid.is_large(grid_index)) {
+        // Elements that are too big to be inserted into the grid are tested
+        // against all others. Pairs of large elements are found from the one
+        // with the smaller index.
+        for (size_t other_index = 0; other_index < m_grid_aabbs.size(); ++other_index) {
+            auto other_grid_index = static_cast<hash_grid::index_type>(other_index);
+
+            if (other_index == index ||
+                (other_index < index && m_grid.is_large(other_grid_index))) {
+                continue;
+            }
+
+            if (intersect(offset_aabb, m_grid_aabbs[other_index])) {
+                add_pair(other_index);
+            }
+        }
+    } else {
+        m_grid.each_pair_of(grid_index, m_grid_aabbs, [&] (auto, auto other_index) {
+            add_pair(other_index);
+        });
+    }
+
+    collide_tree_async(m_np_tree, m_grid_nodes[index], offset_aabb, index);
+}
+
 void broadphase_worker::update_async(job &completion_job) {
     EDYN_ASSERT(parallelizable());
 
     common_update();
+    auto &dispatcher = job_dispatcher::global();
 
-    auto aabb_proc_view = m_registry->view<AABB, procedural_tag>();
+    if (m_registry->ctx<settings>().broadphase == broadphase_type::hash_grid) {
+        // The grid is built in this thread, then the pairs of each element
+        // are found in parallel.
+        build_hash_grid();
+
+        if (m_grid_nodes.empty()) {
+            dispatcher.async(completion_job);
+            return;
+        }
+
+        parallel_for_async(dispatcher, size_t{0}, m_grid_nodes.size(), size_t{1}, completion_job,
+                [this] (size_t index) {
+            collide_grid_element(index);
+        });
+        return;
+    }
+
+    auto aabb_proc_view = m_registry->view<tree_resident, AABB, procedural_tag>();
     size_t count = 0;
     // Have to iterate the view to get the actual size...
-    aabb_proc_view.each([&count] (auto &) { ++count; });
+    for ([[maybe_unused]] auto entity : aabb_proc_view) { ++count; }
     m_pair_results.resize(count);
-    auto &dispatcher = job_dispatcher::global();
 
     parallel_for_each_async(dispatcher, aabb_proc_view.begin(), aabb_proc_view.end(), completion_job,
             [this, aabb_proc_view] (entt::entity entity, size_t index) {
-        auto &aabb = aabb_proc_view.get<AABB>(entity);
+        auto [node, aabb] = aabb_proc_view.get<tree_resident, AABB>(entity);
         auto offset_aabb = aabb.inset(m_aabb_offset);
-        collide_tree_async(m_tree, entity, offset_aabb, index);
-        collide_tree_async(m_np_tree, entity, offset_aabb, index);
+        collide_tree_async(m_tree, node.id, offset_aabb, index);
+        collide_tree_async(m_np_tree, node.id, offset_aabb, index);
     });
 }
 
 void broadphase_worker::finish_async_update() {
     for (auto &pairs : m_pair_results) {
         for (auto &pair : pairs) {
+            // Pairs are found from both sides, thus check again.
             if (!m_manifold_map.contains(pair.first, pair.second)) {
                 make_contact_manifold(*m_registry, pair.first, pair.second, m_separation_threshold);
             }
         }
         pairs.clear();
     }
-}
 
-tree_view broadphase_worker::view() const {
-    return m_tree.view();
+    m_grid_nodes.clear();
+    m_grid_aabbs.clear();
 }
 
 }
@@ -1,4 +1,6 @@
 #include "edyn/collision/collide.hpp"
+#include "edyn/collision/triangle_batch.hpp"
+#include "edyn/collision/contact_reduction.hpp"
 #include "edyn/config/constants.hpp"
 #include "edyn/math/geom.hpp"
 #include "edyn/math/math.hpp"
@@ -6,6 +8,7 @@
 #include "edyn/math/vector2_3_util.hpp"
 #include "edyn/math/vector3.hpp"
 #include "edyn/util/triangle_util.hpp"
+#include <cmath>
 
 namespace edyn {
 
@@ -385,9 +388,29 @@ void collide(const box_shape &box, const triangle_mesh &mesh,
     const auto inset = vector3_one * -contact_breaking_threshold;
     const auto visit_aabb = ctx.aabbA.inset(inset);
 
-    mesh.visit_triangles(visit_aabb, [&] (auto tri_idx) {
-        collide_box_triangle(box, mesh, tri_idx, box_axes, ctx, result);
-    });
+    // Gather candidate triangles and discard the ones that are too far in
+    // front of the box before running the separating axis test.
+    static thread_local triangle_batch batch;
+    batch.gather(mesh, visit_aabb);
+    batch.cull([&] (const vector3 &dir) {
+        return dot(ctx.posA, dir) +
+               std::abs(dot(box_axes[0], dir)) * box.half_extents.x +
+               std::abs(dot(box_axes[1], dir)) * box.half_extents.y +
+               std::abs(dot(box_axes[2], dir)) * box.half_extents.z;
+    }, ctx.threshold);
+
+    // Collect the contact points of all triangles and select the best set
+    // once all of them are known.
+    static thread_local std::vector<collision_result::collision_point> candidates;
+    candidates.clear();
+
+    for (auto tri_idx : batch.indices) {
+        auto tri_result = collision_result{};
+        collide_box_triangle(box, mesh, tri_idx, box_axes, ctx, tri_result);
+        append_contact_points(tri_result, candidates);
+    }
+
+    reduce_contact_points(candidates, result, ctx.cache);
 }
 
 }
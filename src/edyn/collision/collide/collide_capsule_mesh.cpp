@@ -1,9 +1,12 @@
 #include "edyn/collision/collide.hpp"
+#include "edyn/collision/triangle_batch.hpp"
+#include "edyn/collision/contact_reduction.hpp"
 #include "edyn/math/geom.hpp"
 #include "edyn/math/scalar.hpp"
 #include "edyn/util/triangle_util.hpp"
 #include "edyn/util/shape_util.hpp"
 #include "edyn/math/math.hpp"
+#include <cmath>
 
 namespace edyn {
 
@@ -238,9 +241,29 @@ void collide(const capsule_shape &capsule, const triangle_mesh &mesh,
     const auto inset = vector3_one * -contact_breaking_threshold;
     const auto visit_aabb = ctx.aabbA.inset(inset);
 
-    mesh.visit_triangles(visit_aabb, [&] (auto tri_idx) {
-        collide_capsule_triangle(capsule, mesh, tri_idx, capsule_vertices, ctx, result);
-    });
+    // Gather candidate triangles and discard the ones that are too far in
+    // front of the capsule before running the separating axis test.
+    const auto capsule_center = (capsule_vertices[0] + capsule_vertices[1]) / scalar(2);
+    const auto capsule_half_axis = capsule_vertices[0] - capsule_center;
+
+    static thread_local triangle_batch batch;
+    batch.gather(mesh, visit_aabb);
+    batch.cull([&] (const vector3 &dir) {
+        return dot(capsule_center, dir) + std::abs(dot(capsule_half_axis, dir)) + capsule.radius;
+    }, ctx.threshold);
+
+    // Collect the contact points of all triangles and select the best set
+    // once all of them are known.
+    static thread_local std::vector<collision_result::collision_point> candidates;
+    candidates.clear();
+
+    for (auto tri_idx : batch.indices) {
+        auto tri_result = collision_result{};
+        collide_capsule_triangle(capsule, mesh, tri_idx, capsule_vertices, ctx, tri_result);
+        append_contact_points(tri_result, candidates);
+    }
+
+    reduce_contact_points(candidates, result, ctx.cache);
 }
 
 }
@@ -1,36 +1,66 @@
 #include "edyn/collision/collide.hpp"
+#include "edyn/collision/query_tree.hpp"
+#include "edyn/collision/contact_reduction.hpp"
+#include "edyn/util/aabb_util.hpp"
 
 namespace edyn {
 
 void collide(const compound_shape &shA, const compound_shape &shB,
              const collision_context &ctx, collision_result &result) {
-    // Collide every node of B with A. Swap it if B has more nodes than A.
-    if (shA.nodes.size() < shB.nodes.size()) {
-        swap_collide(shA, shB, ctx, result);
-        return;
-    }
-
-    for (auto &nodeB : shB.nodes) {
-        // Create a new collision context with the position of the child of B
-        // in world space.
+    // Traverse both trees simultaneously in A's object space and only collide
+    // the pairs of children whose AABBs intersect.
+    const auto posB_in_A = to_object_space(ctx.posB, ctx.posA, ctx.ornA);
+    const auto ornB_in_A = conjugate(ctx.ornA) * ctx.ornB;
+    const auto inset = vector3_one * -ctx.threshold;
+
+    // Collect the contact points of all pairs of children and select the
+    // best set once all of them are known.
+    static thread_local std::vector<collision_result::collision_point> candidates;
+    candidates.clear();
+
+    auto test_func = [&] (auto &tree_nodeA, auto &tree_nodeB) {
+        auto aabbB = aabb_to_world_space(tree_nodeB.aabb, posB_in_A, ornB_in_A);
+        return intersect(tree_nodeA.aabb, aabbB.inset(inset));
+    };
+
+    auto visit_func = [&] (auto tree_node_idxA, auto tree_node_idxB) {
+        auto &nodeA = shA.nodes[shA.tree.get_node(tree_node_idxA).id];
+        auto &nodeB = shB.nodes[shB.tree.get_node(tree_node_idxB).id];
+
+        // New collision context with the children in world space.
         auto child_ctx = ctx;
+        child_ctx.posA = to_world_space(nodeA.position, ctx.posA, ctx.ornA);
+        child_ctx.ornA = ctx.ornA * nodeA.orientation;
+        child_ctx.aabbA = aabb_to_world_space(nodeA.aabb, ctx.posA, ctx.ornA);
         child_ctx.posB = to_world_space(nodeB.position, ctx.posB, ctx.ornB);
         child_ctx.ornB = ctx.ornB * nodeB.orientation;
+        child_ctx.aabbB = aabb_to_world_space(nodeB.aabb, ctx.posB, ctx.ornB);
+        child_ctx.cache = nullptr;
+
         collision_result child_result;
 
-        // Collide child shape with compound.
-        std::visit([&] (auto &&sh) {
-            collide(shA, sh, child_ctx, child_result);
-        }, nodeB.shape_var);
+        std::visit([&] (auto &&childA) {
+            std::visit([&] (auto &&childB) {
+                collide(childA, childB, child_ctx, child_result);
+            }, nodeB.shape_var);
+        }, nodeA.shape_var);
 
-        // Transform the B elements of the result points from child shape space
-        // into B's space.
+        // Transform the pivots from the children's space into the space of
+        // their compounds.
         for (size_t i = 0; i < child_result.num_points; ++i) {
             auto &child_point = child_result.point[i];
+            child_point.pivotA = to_world_space(child_point.pivotA, nodeA.position, nodeA.orientation);
             child_point.pivotB = to_world_space(child_point.pivotB, nodeB.position, nodeB.orientation);
-            result.maybe_add_point(child_point);
         }
-    }
+
+        append_contact_points(child_result, candidates);
+    };
+
+    uint32_t root_node_idx = 0;
+    traverse_tree_pair(shA.tree, root_node_idx, shB.tree, root_node_idx,
+                       EDYN_NULL_NODE, test_func, visit_func);
+
+    reduce_contact_points(candidates, result, ctx.cache);
 }
 
 }
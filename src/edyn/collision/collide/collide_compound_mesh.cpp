@@ -1,4 +1,5 @@
 #include "edyn/collision/collide.hpp"
+#include "edyn/collision/contact_reduction.hpp"
 #include "edyn/util/aabb_util.hpp"
 #include "edyn/util/triangle_util.hpp"
 
@@ -10,12 +11,18 @@ void collide(const compound_shape &compound, const triangle_mesh &mesh,
     // the compound's AABB and start the tree queries from that node in the
     // child collision tests.
 
+    // Collect the contact points of all children and select the best set
+    // once all of them are known.
+    static thread_local std::vector<collision_result::collision_point> candidates;
+    candidates.clear();
+
     for (auto &node : compound.nodes) {
         // New collision context with child shape in world space.
         auto child_ctx = ctx;
         child_ctx.posA = to_world_space(node.position, ctx.posA, ctx.ornA);
         child_ctx.ornA = ctx.ornA * node.orientation;
         child_ctx.aabbA = aabb_to_world_space(node.aabb, ctx.posA, ctx.ornA);
+        child_ctx.cache = nullptr;
 
         collision_result child_result;
 
@@ -28,9 +35,12 @@ void collide(const compound_shape &compound, const triangle_mesh &mesh,
         for (size_t i = 0; i < child_result.num_points; ++i) {
             auto &child_point = child_result.point[i];
             child_point.pivotA = to_world_space(child_point.pivotA, node.position, node.orientation);
-            result.maybe_add_point(child_point);
         }
+
+        append_contact_points(child_result, candidates);
     }
+
+    reduce_contact_points(candidates, result, ctx.cache);
 }
 
 }
@@ -1,4 +1,6 @@
 #include "edyn/collision/collide.hpp"
+#include "edyn/collision/triangle_batch.hpp"
+#include "edyn/collision/contact_reduction.hpp"
 #include "edyn/math/geom.hpp"
 #include "edyn/math/quaternion.hpp"
 #include "edyn/math/vector2_3_util.hpp"
@@ -6,6 +8,8 @@
 #include "edyn/math/vector3.hpp"
 #include "edyn/shapes/cylinder_shape.hpp"
 #include "edyn/util/triangle_util.hpp"
+#include <cmath>
+#include <algorithm>
 
 namespace edyn {
 
@@ -371,10 +375,32 @@ void collide(const cylinder_shape &cylinder, const triangle_mesh &mesh,
     const auto inset = vector3_one * -contact_breaking_threshold;
     const auto visit_aabb = ctx.aabbA.inset(inset);
 
-    mesh.visit_triangles(visit_aabb, [&] (auto tri_idx) {
+    // Gather candidate triangles and discard the ones that are too far in
+    // front of the cylinder before running the separating axis test.
+    static thread_local triangle_batch batch;
+    batch.gather(mesh, visit_aabb);
+    batch.cull([&] (const vector3 &dir) {
+        // Projection of the cap rim along `dir` depends on the length of the
+        // component of `dir` orthogonal to the axis.
+        auto proj_axis = dot(cylinder_axis, dir);
+        auto proj_radial = std::sqrt(std::max(length_sqr(dir) - proj_axis * proj_axis, scalar(0)));
+        return dot(ctx.posA, dir) + std::abs(proj_axis) * cylinder.half_length +
+               proj_radial * cylinder.radius;
+    }, ctx.threshold);
+
+    // Collect the contact points of all triangles and select the best set
+    // once all of them are known.
+    static thread_local std::vector<collision_result::collision_point> candidates;
+    candidates.clear();
+
+    for (auto tri_idx : batch.indices) {
+        auto tri_result = collision_result{};
         collide_cylinder_triangle(cylinder, mesh, tri_idx,
-                                  cylinder_axis, cylinder_vertices, ctx, result);
-    });
+                                  cylinder_axis, cylinder_vertices, ctx, tri_result);
+        append_contact_points(tri_result, candidates);
+    }
+
+    reduce_contact_points(candidates, result, ctx.cache);
 }
 
 }
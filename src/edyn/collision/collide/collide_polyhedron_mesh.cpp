@@ -1,4 +1,6 @@
 #include "edyn/collision/collide.hpp"
+#include "edyn/collision/triangle_batch.hpp"
+#include "edyn/collision/contact_reduction.hpp"
 #include "edyn/collision/collision_result.hpp"
 #include "edyn/config/constants.hpp"
 #include "edyn/math/vector3.hpp"
@@ -236,9 +238,31 @@ void collide(const polyhedron_shape &poly, const triangle_mesh &mesh,
     const auto inset = vector3_one * -contact_breaking_threshold;
     const auto visit_aabb = ctx.aabbA.inset(inset);
 
-    mesh.visit_triangles(visit_aabb, [&] (auto tri_idx) {
-        collide_polyhedron_triangle(poly, mesh, tri_idx, ctx, result);
-    });
+    // Gather candidate triangles and discard the ones that are too far in
+    // front of the polyhedron before running the separating axis test. Nearby
+    // triangles usually have similar normals thus the support vertex of the
+    // previous one is a good starting point for the next.
+    const auto &rmesh = *poly.rotated;
+    uint16_t hint = 0;
+
+    static thread_local triangle_batch batch;
+    batch.gather(mesh, visit_aabb);
+    batch.cull([&] (const vector3 &dir) {
+        return dot(ctx.posA, dir) + poly.mesh->support_projection(rmesh.vertices, dir, hint);
+    }, ctx.threshold);
+
+    // Collect the contact points of all triangles and select the best set
+    // once all of them are known.
+    static thread_local std::vector<collision_result::collision_point> candidates;
+    candidates.clear();
+
+    for (auto tri_idx : batch.indices) {
+        auto tri_result = collision_result{};
+        collide_polyhedron_triangle(poly, mesh, tri_idx, ctx, tri_result);
+        append_contact_points(tri_result, candidates);
+    }
+
+    reduce_contact_points(candidates, result, ctx.cache);
 }
 
 }
@@ -17,6 +17,9 @@ void max_support_direction(const polyhedron_shape &shA, const rotated_mesh &rota
     scalar max_proj_B = -EDYN_SCALAR_MAX;
     scalar max_distance = -EDYN_SCALAR_MAX;
     auto best_dir = vector3_zero;
+    // Support vertex of the previous face is the starting point of the next
+    // hill-climbing search.
+    uint16_t hintB = 0;
 
     for (size_t i = 0; i < shA.mesh->num_faces(); ++i) {
         auto normal_world = -rotatedA.normals[i]; // Normal pointing towards A.
@@ -29,7 +32,7 @@ void max_support_direction(const polyhedron_shape &shA, const rotated_mesh &rota
 
         // Find point on B that's furthest along the opposite direction
         // of the face normal.
-        auto projB = point_cloud_support_projection(rotatedB.vertices, normal_world) + dot(posB, normal_world);
+        auto projB = shB.mesh->support_projection(rotatedB.vertices, normal_world, hintB) + dot(posB, normal_world);
 
         auto dist = projA - projB;
 
@@ -47,6 +50,23 @@ void max_support_direction(const polyhedron_shape &shA, const rotated_mesh &rota
     projectionB = max_proj_B;
 }
 
+// Checks whether the arcs AB and CD intersect on the Gauss map, where A and B
+// are the normals of the faces sharing an edge of one polyhedron and C and D
+// are the negated normals of the faces sharing an edge of the other. Only
+// pairs of edges whose arcs intersect build a face of the Minkowski difference
+// and thus can produce a separating axis.
+static
+bool is_minkowski_face(const vector3 &a, const vector3 &b,
+                       const vector3 &c, const vector3 &d) {
+    auto bxa = cross(b, a);
+    auto dxc = cross(d, c);
+    auto cba = dot(c, bxa);
+    auto dba = dot(d, bxa);
+    auto adc = dot(a, dxc);
+    auto bdc = dot(b, dxc);
+    return cba * dba < 0 && adc * bdc < 0 && cba * bdc > 0;
+}
+
 void collide(const polyhedron_shape &shA, const polyhedron_shape &shB,
              const collision_context &ctx, collision_result &result) {
     // Calculate collision with shape A in the origin for better floating point
@@ -62,6 +82,23 @@ void collide(const polyhedron_shape &shA, const polyhedron_shape &shB,
     auto &rmeshA = *shA.rotated;
     auto &rmeshB = *shB.rotated;
 
+    // If the shapes were separated along an axis in the previous step, it is
+    // likely they're still separated along the same axis, which would allow
+    // skipping the full separating axis test.
+    uint16_t hintA = 0, hintB = 0;
+
+    if (ctx.cache && ctx.cache->has_separating_axis) {
+        auto dir = rotate(ornA, ctx.cache->separating_axis);
+        auto projA = -shA.mesh->support_projection(rmeshA.vertices, -dir, hintA);
+        auto projB = shB.mesh->support_projection(rmeshB.vertices, dir, hintB) + dot(posB, dir);
+
+        if (projA - projB > threshold) {
+            return;
+        }
+
+        ctx.cache->has_separating_axis = false;
+    }
+
     scalar distance = -EDYN_SCALAR_MAX;
     scalar projectionA = EDYN_SCALAR_MAX;
     scalar projectionB = -EDYN_SCALAR_MAX;
@@ -95,8 +132,20 @@ void collide(const polyhedron_shape &shA, const polyhedron_shape &shB,
     for (size_t i = 0; i < shA.mesh->num_edges(); ++i) {
         auto [vertexA0, vertexA1] = shA.mesh->get_rotated_edge(rmeshA, i);
         auto edgeA = vertexA1 - vertexA0;
+        auto [faceA0, faceA1] = shA.mesh->get_edge_faces(i);
+        auto &normalA0 = rmeshA.normals[faceA0];
+        auto &normalA1 = rmeshA.normals[faceA1];
 
         for (size_t j = 0; j < shB.mesh->num_edges(); ++j) {
+            auto [faceB0, faceB1] = shB.mesh->get_edge_faces(j);
+
+            // Edges of open meshes belong to a single face and can't be pruned.
+            if (faceA0 != faceA1 && faceB0 != faceB1 &&
+                !is_minkowski_face(normalA0, normalA1,
+                                   -rmeshB.normals[faceB0], -rmeshB.normals[faceB1])) {
+                continue;
+            }
+
             auto [vertexB0, vertexB1] = shB.mesh->get_rotated_edge(rmeshB, j);
             auto edgeB = vertexB1 - vertexB0;
             auto dir = cross(edgeA, edgeB);
@@ -110,8 +159,8 @@ void collide(const polyhedron_shape &shA, const polyhedron_shape &shB,
                 dir *= -1;
             }
 
-            auto projA = -point_cloud_support_projection(rmeshA.vertices, -dir);
-            auto projB = point_cloud_support_projection(rmeshB.vertices, dir) + dot(posB, dir);
+            auto projA = -shA.mesh->support_projection(rmeshA.vertices, -dir, hintA);
+            auto projB = shB.mesh->support_projection(rmeshB.vertices, dir, hintB) + dot(posB, dir);
             auto dist = projA - projB;
 
             if (dist > distance) {
@@ -124,6 +173,10 @@ void collide(const polyhedron_shape &shA, const polyhedron_shape &shB,
     }
 
     if (distance > threshold) {
+        if (ctx.cache) {
+            ctx.cache->separating_axis = rotate(conjugate(ornA), sep_axis);
+            ctx.cache->has_separating_axis = true;
+        }
         return;
     }
 
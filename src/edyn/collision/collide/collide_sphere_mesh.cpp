@@ -1,4 +1,6 @@
 #include "edyn/collision/collide.hpp"
+#include "edyn/collision/triangle_batch.hpp"
+#include "edyn/collision/contact_reduction.hpp"
 #include "edyn/math/geom.hpp"
 #include "edyn/math/math.hpp"
 #include "edyn/math/quaternion.hpp"
@@ -106,9 +108,26 @@ void collide(const sphere_shape &sphere, const triangle_mesh &mesh,
     const auto inset = vector3_one * -contact_breaking_threshold;
     const auto visit_aabb = ctx.aabbA.inset(inset);
 
-    mesh.visit_triangles(visit_aabb, [&] (auto tri_idx) {
-        collide_sphere_triangle(sphere, mesh, tri_idx, ctx, result);
-    });
+    // Gather candidate triangles and discard the ones that are too far in
+    // front of the sphere before running the separating axis test.
+    static thread_local triangle_batch batch;
+    batch.gather(mesh, visit_aabb);
+    batch.cull([&] (const vector3 &dir) {
+        return dot(ctx.posA, dir) + sphere.radius;
+    }, ctx.threshold);
+
+    // Collect the contact points of all triangles and select the best set
+    // once all of them are known.
+    static thread_local std::vector<collision_result::collision_point> candidates;
+    candidates.clear();
+
+    for (auto tri_idx : batch.indices) {
+        auto tri_result = collision_result{};
+        collide_sphere_triangle(sphere, mesh, tri_idx, ctx, tri_result);
+        append_contact_points(tri_result, candidates);
+    }
+
+    reduce_contact_points(candidates, result, ctx.cache);
 }
 
 }
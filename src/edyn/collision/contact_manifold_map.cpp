@@ -9,40 +9,143 @@ contact_manifold_map::contact_manifold_map(entt::registry &registry) {
     registry.on_destroy<contact_manifold>().connect<&contact_manifold_map::on_destroy_contact_manifold>(*this);
 }
 
+contact_manifold_map::key_type contact_manifold_map::make_key(entt::entity first, entt::entity second) {
+    auto a = static_cast<key_type>(entt::to_integral(first));
+    auto b = static_cast<key_type>(entt::to_integral(second));
+    return a < b ? (a << 32) | b : (b << 32) | a;
+}
+
+size_t contact_manifold_map::home_slot(key_type key) const {
+    // Fibonacci hashing. Takes the high bits of the product, which depend on
+    // all bits of the key.
+    return static_cast<size_t>((key * UINT64_C(0x9E3779B97F4A7C15)) >> m_shift);
+}
+
+size_t contact_manifold_map::find(key_type key) const {
+    if (m_size == 0) {
+        return npos;
+    }
+
+    auto mask = m_keys.size() - 1;
+
+    for (auto idx = home_slot(key);; idx = (idx + 1) & mask) {
+        if (m_keys[idx] == key) {
+            return idx;
+        }
+
+        if (m_keys[idx] == empty_key) {
+            return npos;
+        }
+    }
+}
+
+void contact_manifold_map::rehash(size_t capacity) {
+    auto keys = std::move(m_keys);
+    auto values = std::move(m_values);
+
+    m_keys.assign(capacity, empty_key);
+    m_values.assign(capacity, entt::null);
+    m_size = 0;
+    m_shift = 64;
+
+    for (auto c = capacity; c > 1; c >>= 1) {
+        --m_shift;
+    }
+
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (keys[i] != empty_key) {
+            insert(keys[i], values[i]);
+        }
+    }
+}
+
+void contact_manifold_map::insert(key_type key, entt::entity value) {
+    // Keep load factor under 3/4.
+    if ((m_size + 1) * 4 > m_keys.size() * 3) {
+        rehash(m_keys.empty() ? 64 : m_keys.size() * 2);
+    }
+
+    auto mask = m_keys.size() - 1;
+    auto idx = home_slot(key);
+
+    while (m_keys[idx] != empty_key) {
+        EDYN_ASSERT(m_keys[idx] != key);
+        idx = (idx + 1) & mask;
+    }
+
+    m_keys[idx] = key;
+    m_values[idx] = value;
+    ++m_size;
+}
+
+void contact_manifold_map::erase(key_type key) {
+    auto idx = find(key);
+
+    if (idx == npos) {
+        return;
+    }
+
+    // Backward shift deletion: move subsequent entries in the same cluster
+    // back into the hole if doing so doesn't place them before their home
+    // slot.
+    auto mask = m_keys.size() - 1;
+    auto next = idx;
+
+    while (true) {
+        next = (next + 1) & mask;
+
+        if (m_keys[next] == empty_key) {
+            break;
+        }
+
+        auto home = home_slot(m_keys[next]);
+
+        // Check whether `home` lies cyclically in the range (idx, next].
+        auto in_range = idx <= next ?
+            (idx < home && home <= next) :
+            (idx < home || home <= next);
+
+        if (!in_range) {
+            m_keys[idx] = m_keys[next];
+            m_values[idx] = m_values[next];
+            idx = next;
+        }
+    }
+
+    m_keys[idx] = empty_key;
+    m_values[idx] = entt::null;
+    --m_size;
+}
+
 bool contact_manifold_map::contains(entity_pair pair) const {
-    return m_pair_map.count(pair) > 0;
+    return contains(pair.first, pair.second);
 }
 
 bool contact_manifold_map::contains(entt::entity first, entt::entity second) const {
-    return contains(std::make_pair(first, second));
+    return find(make_key(first, second)) != npos;
 }
 
 entt::entity contact_manifold_map::get(entity_pair pair) const {
-    EDYN_ASSERT(contains(pair));
-    return m_pair_map.at(pair);
+    return get(pair.first, pair.second);
 }
 
 entt::entity contact_manifold_map::get(entt::entity first, entt::entity second) const {
-    return get(std::make_pair(first, second));
+    auto idx = find(make_key(first, second));
+    EDYN_ASSERT(idx != npos);
+    return m_values[idx];
 }
 
 void contact_manifold_map::on_construct_contact_manifold(entt::registry &registry, entt::entity entity) {
     auto &manifold = registry.get<contact_manifold>(entity);
-    // Insert all permutations.
-    auto p = std::make_pair(manifold.body[0], manifold.body[1]);
-    auto q = std::make_pair(manifold.body[1], manifold.body[0]);
-    EDYN_ASSERT(m_pair_map.count(p) == 0 && m_pair_map.count(q) == 0);
-    m_pair_map[p] = entity;
-    m_pair_map[q] = entity;
+    auto key = make_key(manifold.body[0], manifold.body[1]);
+    EDYN_ASSERT(find(key) == npos);
+    insert(key, entity);
 }
 
 void contact_manifold_map::on_destroy_contact_manifold(entt::registry &registry, entt::entity entity) {
     auto &manifold = registry.get<contact_manifold>(entity);
     // Cleanup cached info.
-    auto p = std::make_pair(manifold.body[0], manifold.body[1]);
-    auto q = std::make_pair(manifold.body[1], manifold.body[0]);
-    m_pair_map.erase(p);
-    m_pair_map.erase(q);
+    erase(make_key(manifold.body[0], manifold.body[1]));
 }
 
 }
@@ -0,0 +1,142 @@
+#include "edyn/collision/contact_reduction.hpp"
+#include "edyn/collision/collision_cache.hpp"
+#include "edyn/math/geom.hpp"
+#include <array>
+#include <algorithm>
+
+namespace edyn {
+
+// Indices of the candidates selected so far. At most `max_contacts` are
+// selected, thus a small fixed array is used instead of one flag per candidate.
+struct reduction_selection {
+    std::array<size_t, max_contacts> indices;
+    size_t count {0};
+
+    bool contains(size_t idx) const {
+        return std::find(indices.begin(), indices.begin() + count, idx) != indices.begin() + count;
+    }
+};
+
+// Finds the candidate with the greatest score among the ones which haven't
+// been selected yet. Returns the number of candidates if none has a positive
+// score, which means all remaining points would be degenerate.
+template<typename ScoreFunc>
+static size_t select_candidate(const std::vector<collision_result::collision_point> &candidates,
+                               const reduction_selection &selection, ScoreFunc score) {
+    auto best_score = scalar(0);
+    auto best_idx = candidates.size();
+
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (selection.contains(i)) continue;
+
+        auto s = score(i);
+
+        if (s > best_score) {
+            best_score = s;
+            best_idx = i;
+        }
+    }
+
+    return best_idx;
+}
+
+void reduce_contact_points(std::vector<collision_result::collision_point> &candidates,
+                           collision_result &result, collision_cache *cache) {
+    for (size_t i = 0; i < result.num_points; ++i) {
+        candidates.push_back(result.point[i]);
+    }
+
+    result.num_points = 0;
+
+    if (candidates.size() <= max_contacts) {
+        for (auto &pt : candidates) {
+            result.add_point(pt);
+        }
+    } else {
+        // Candidates close to a point of the previous selection are preferred.
+        // There are at most `max_contacts` previous points, so this is checked
+        // when needed instead of storing a flag per candidate.
+        auto num_reduced_pivots = cache ? cache->num_reduced_pivots : size_t(0);
+
+        auto preferred = [&] (size_t i) {
+            constexpr auto max_dist_sqr = contact_caching_threshold * contact_caching_threshold;
+
+            for (size_t j = 0; j < num_reduced_pivots; ++j) {
+                if (distance_sqr(candidates[i].pivotA, cache->reduced_pivots[j]) < max_dist_sqr) {
+                    return true;
+                }
+            }
+
+            return false;
+        };
+
+        auto weight = [&] (size_t i) {
+            return preferred(i) ? scalar(1) + contact_reduction_area_hysteresis : scalar(1);
+        };
+
+        auto selection = reduction_selection{};
+        auto select = [&] (size_t i) {
+            selection.indices[selection.count++] = i;
+            result.add_point(candidates[i]);
+        };
+
+        // Deepest point.
+        auto deepest_idx = size_t(0);
+        auto min_distance = EDYN_SCALAR_MAX;
+
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            auto dist = candidates[i].distance;
+
+            if (preferred(i)) {
+                dist -= contact_reduction_depth_hysteresis;
+            }
+
+            if (dist < min_distance) {
+                min_distance = dist;
+                deepest_idx = i;
+            }
+        }
+
+        select(deepest_idx);
+        auto &p0 = candidates[deepest_idx].pivotA;
+
+        // Point furthest from the deepest.
+        auto idx1 = select_candidate(candidates, selection, [&] (size_t i) {
+            return distance_sqr(candidates[i].pivotA, p0) * weight(i);
+        });
+
+        if (idx1 < candidates.size()) {
+            select(idx1);
+            auto &p1 = candidates[idx1].pivotA;
+
+            // Point which forms the largest triangle with the first two.
+            auto idx2 = select_candidate(candidates, selection, [&] (size_t i) {
+                return length_sqr(cross(p1 - p0, candidates[i].pivotA - p0)) * weight(i);
+            });
+
+            if (idx2 < candidates.size()) {
+                select(idx2);
+                auto &p2 = candidates[idx2].pivotA;
+
+                // Point which forms the largest quadrilateral with the first three.
+                auto idx3 = select_candidate(candidates, selection, [&] (size_t i) {
+                    return area_4_points(p0, p1, p2, candidates[i].pivotA) * weight(i);
+                });
+
+                if (idx3 < candidates.size()) {
+                    select(idx3);
+                }
+            }
+        }
+    }
+
+    if (cache) {
+        cache->num_reduced_pivots = result.num_points;
+
+        for (size_t i = 0; i < result.num_points; ++i) {
+            cache->reduced_pivots[i] = result.point[i].pivotA;
+        }
+    }
+}
+
+}
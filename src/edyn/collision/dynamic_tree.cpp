@@ -19,6 +19,7 @@ tree_node_id_t dynamic_tree::allocate() {
         node.child2 = null_tree_node_id;
         node.entity = entt::null;
         node.height = 0;
+        m_filters.emplace_back();
         return id;
     } else {
         auto id = m_free_list;
@@ -28,6 +29,7 @@ tree_node_id_t dynamic_tree::allocate() {
         node.child2 = null_tree_node_id;
         node.entity = entt::null;
         node.height = 0;
+        m_filters[id] = {};
         m_free_list = node.next;
         return id;
     }
@@ -51,6 +53,11 @@ tree_node_id_t dynamic_tree::create(const AABB &aabb, entt::entity entity) {
     return id;
 }
 
+void dynamic_tree::set_filter(tree_node_id_t id, const collision_filter &filter, bool has_exclusion) {
+    EDYN_ASSERT(m_nodes[id].leaf());
+    m_filters[id] = {filter, has_exclusion};
+}
+
 void dynamic_tree::destroy(tree_node_id_t id) {
     EDYN_ASSERT(m_nodes[id].leaf());
     remove(id);
@@ -344,15 +351,23 @@ const tree_node & dynamic_tree::get_node(tree_node_id_t id) const {
     return m_nodes[id];
 }
 
+const tree_leaf_filter & dynamic_tree::get_filter(tree_node_id_t id) const {
+    return m_filters[id];
+}
+
 tree_view dynamic_tree::view() const {
     std::vector<tree_view::tree_node> view_nodes;
+    std::vector<collision_filter> view_filters;
     view_nodes.reserve(m_nodes.size());
+    view_filters.reserve(m_filters.size());
 
-    for (auto &node : m_nodes) {
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+        auto &node = m_nodes[i];
         view_nodes.push_back(tree_view::tree_node{node.entity, node.aabb, node.child1, node.child2});
+        view_filters.push_back(m_filters[i].filter);
     }
 
-    return {view_nodes, m_root};
+    return {view_nodes, view_filters, m_root};
 }
 
 }
@@ -0,0 +1,308 @@
+#include "edyn/collision/gjk_epa.hpp"
+#include "edyn/config/config.h"
+#include <utility>
+#include <algorithm>
+
+namespace edyn {
+
+// Closest point to the origin on a segment. The indices and weights of the
+// vertices of the reduced simplex are written to `indices` and `weights`.
+static vector3 closest_point_segment(const gjk_simplex &simplex, size_t i0, size_t i1,
+                                     std::array<size_t, 4> &indices,
+                                     std::array<scalar, 4> &weights, size_t &count) {
+    auto &a = simplex.vertices[i0].point;
+    auto &b = simplex.vertices[i1].point;
+    auto ab = b - a;
+    auto len_sqr = length_sqr(ab);
+    auto t = len_sqr > EDYN_EPSILON ? dot(-a, ab) / len_sqr : scalar(0);
+
+    if (t <= 0) {
+        indices[0] = i0; weights[0] = 1; count = 1;
+        return a;
+    }
+
+    if (t >= 1) {
+        indices[0] = i1; weights[0] = 1; count = 1;
+        return b;
+    }
+
+    indices[0] = i0; weights[0] = 1 - t;
+    indices[1] = i1; weights[1] = t;
+    count = 2;
+    return a + ab * t;
+}
+
+// Closest point to the origin on a triangle using Voronoi regions.
+static vector3 closest_point_triangle(const gjk_simplex &simplex, size_t i0, size_t i1, size_t i2,
+                                      std::array<size_t, 4> &indices,
+                                      std::array<scalar, 4> &weights, size_t &count) {
+    auto &a = simplex.vertices[i0].point;
+    auto &b = simplex.vertices[i1].point;
+    auto &c = simplex.vertices[i2].point;
+    auto ab = b - a;
+    auto ac = c - a;
+
+    auto d1 = dot(ab, -a);
+    auto d2 = dot(ac, -a);
+
+    if (d1 <= 0 && d2 <= 0) {
+        indices[0] = i0; weights[0] = 1; count = 1;
+        return a;
+    }
+
+    auto d3 = dot(ab, -b);
+    auto d4 = dot(ac, -b);
+
+    if (d3 >= 0 && d4 <= d3) {
+        indices[0] = i1; weights[0] = 1; count = 1;
+        return b;
+    }
+
+    auto vc = d1 * d4 - d3 * d2;
+
+    if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+        auto v = d1 / (d1 - d3);
+        indices[0] = i0; weights[0] = 1 - v;
+        indices[1] = i1; weights[1] = v;
+        count = 2;
+        return a + ab * v;
+    }
+
+    auto d5 = dot(ab, -c);
+    auto d6 = dot(ac, -c);
+
+    if (d6 >= 0 && d5 <= d6) {
+        indices[0] = i2; weights[0] = 1; count = 1;
+        return c;
+    }
+
+    auto vb = d5 * d2 - d1 * d6;
+
+    if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+        auto w = d2 / (d2 - d6);
+        indices[0] = i0; weights[0] = 1 - w;
+        indices[1] = i2; weights[1] = w;
+        count = 2;
+        return a + ac * w;
+    }
+
+    auto va = d3 * d6 - d5 * d4;
+
+    if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) {
+        auto w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        indices[0] = i1; weights[0] = 1 - w;
+        indices[1] = i2; weights[1] = w;
+        count = 2;
+        return b + (c - b) * w;
+    }
+
+    auto sum = va + vb + vc;
+
+    if (std::abs(sum) < EDYN_EPSILON) {
+        // Degenerate triangle. Fall back to the closest edge.
+        return closest_point_segment(simplex, i0, i1, indices, weights, count);
+    }
+
+    auto denom = scalar(1) / sum;
+    auto v = vb * denom;
+    auto w = vc * denom;
+    indices[0] = i0; weights[0] = 1 - v - w;
+    indices[1] = i1; weights[1] = v;
+    indices[2] = i2; weights[2] = w;
+    count = 3;
+    return a + ab * v + ac * w;
+}
+
+vector3 gjk_solve_simplex(gjk_simplex &simplex) {
+    EDYN_ASSERT(simplex.size > 0 && simplex.size <= 4);
+
+    auto indices = std::array<size_t, 4>{};
+    auto weights = std::array<scalar, 4>{};
+    size_t count = 0;
+    vector3 closest;
+
+    switch (simplex.size) {
+    case 1:
+        simplex.weights[0] = 1;
+        return simplex.vertices[0].point;
+    case 2:
+        closest = closest_point_segment(simplex, 0, 1, indices, weights, count);
+        break;
+    case 3:
+        closest = closest_point_triangle(simplex, 0, 1, 2, indices, weights, count);
+        break;
+    case 4: {
+        // Test each face whose plane separates the origin from the opposite
+        // vertex. If there is none, the origin is inside the tetrahedron.
+        // If the tetrahedron is flat, all faces must be tested.
+        constexpr size_t faces[4][4] = {{0, 1, 2, 3}, {0, 2, 3, 1}, {0, 3, 1, 2}, {1, 3, 2, 0}};
+        auto min_dist_sqr = EDYN_SCALAR_MAX;
+        auto inside = true;
+
+        auto &v0 = simplex.vertices[0].point;
+        auto e0 = simplex.vertices[1].point - v0;
+        auto e1 = simplex.vertices[2].point - v0;
+        auto e2 = simplex.vertices[3].point - v0;
+        auto volume = dot(e2, cross(e0, e1));
+        auto scale = length(e0) * length(e1) * length(e2);
+        auto degenerate = std::abs(volume) <= scale * gjk_degenerate_tolerance;
+
+        for (auto &face : faces) {
+            auto &a = simplex.vertices[face[0]].point;
+            auto &b = simplex.vertices[face[1]].point;
+            auto &c = simplex.vertices[face[2]].point;
+            auto &d = simplex.vertices[face[3]].point;
+            auto normal = cross(b - a, c - a);
+            auto sign_origin = dot(-a, normal);
+            auto sign_opposite = dot(d - a, normal);
+
+            if (!degenerate && sign_origin * sign_opposite >= 0) {
+                continue;
+            }
+
+            inside = false;
+            auto face_indices = std::array<size_t, 4>{};
+            auto face_weights = std::array<scalar, 4>{};
+            size_t face_count;
+            auto point = closest_point_triangle(simplex, face[0], face[1], face[2],
+                                                face_indices, face_weights, face_count);
+            auto dist_sqr = length_sqr(point);
+
+            if (dist_sqr < min_dist_sqr) {
+                min_dist_sqr = dist_sqr;
+                closest = point;
+                indices = face_indices;
+                weights = face_weights;
+                count = face_count;
+            }
+        }
+
+        if (inside) {
+            return vector3_zero;
+        }
+        break;
+    }
+    }
+
+    auto reduced = gjk_simplex{};
+
+    for (size_t i = 0; i < count; ++i) {
+        reduced.vertices[i] = simplex.vertices[indices[i]];
+        reduced.weights[i] = weights[i];
+    }
+
+    reduced.size = count;
+    simplex = reduced;
+
+    return closest;
+}
+
+static bool make_epa_face(const epa_polytope &polytope,
+                          uint16_t i0, uint16_t i1, uint16_t i2,
+                          epa_polytope::face &face) {
+    auto &a = polytope.vertices[i0].point;
+    auto &b = polytope.vertices[i1].point;
+    auto &c = polytope.vertices[i2].point;
+    auto normal = cross(b - a, c - a);
+    auto len = length(normal);
+
+    if (len < EDYN_EPSILON) {
+        return false;
+    }
+
+    face.vertices = {i0, i1, i2};
+    face.normal = normal / len;
+    face.distance = dot(face.normal, a);
+    return true;
+}
+
+bool epa_polytope::init(const std::array<support_vertex, 4> &tetrahedron) {
+    std::copy(tetrahedron.begin(), tetrahedron.end(), vertices.begin());
+    num_vertices = tetrahedron.size();
+    num_faces = 0;
+
+    // Make the winding counter-clockwise when seen from outside.
+    auto &v0 = vertices[0].point;
+    auto normal = cross(vertices[1].point - v0, vertices[2].point - v0);
+
+    if (dot(vertices[3].point - v0, normal) > 0) {
+        std::swap(vertices[1], vertices[2]);
+    }
+
+    constexpr uint16_t indices[4][3] = {{0, 1, 2}, {0, 3, 1}, {0, 2, 3}, {1, 3, 2}};
+
+    for (auto &idx : indices) {
+        if (!make_epa_face(*this, idx[0], idx[1], idx[2], faces[num_faces])) {
+            return false;
+        }
+
+        ++num_faces;
+    }
+
+    return true;
+}
+
+size_t epa_polytope::closest_face() const {
+    EDYN_ASSERT(num_faces > 0);
+    auto it = std::min_element(faces.begin(), faces.begin() + num_faces, [] (auto &f0, auto &f1) {
+        return f0.distance < f1.distance;
+    });
+    return static_cast<size_t>(std::distance(faces.begin(), it));
+}
+
+bool epa_polytope::expand(const support_vertex &vertex) {
+    if (num_vertices >= epa_max_vertices) {
+        return false;
+    }
+
+    auto new_idx = static_cast<uint16_t>(num_vertices);
+    vertices[num_vertices++] = vertex;
+
+    // Remove faces visible from the new vertex and collect the edges of the
+    // horizon, which are the edges that belong to a single removed face.
+    std::array<std::pair<uint16_t, uint16_t>, epa_max_horizon_edges> horizon;
+    size_t horizon_size = 0;
+
+    for (auto i = num_faces; i > 0; --i) {
+        auto &face = faces[i - 1];
+
+        if (dot(face.normal, vertex.point - vertices[face.vertices[0]].point) <= 0) {
+            continue;
+        }
+
+        for (size_t j = 0; j < 3; ++j) {
+            auto edge = std::make_pair(face.vertices[j], face.vertices[(j + 1) % 3]);
+            auto horizon_end = horizon.begin() + horizon_size;
+            auto reversed = std::find(horizon.begin(), horizon_end,
+                                      std::make_pair(edge.second, edge.first));
+
+            if (reversed != horizon_end) {
+                *reversed = horizon[--horizon_size];
+            } else if (horizon_size < horizon.size()) {
+                horizon[horizon_size++] = edge;
+            } else {
+                return false;
+            }
+        }
+
+        faces[i - 1] = faces[--num_faces];
+    }
+
+    if (horizon_size == 0 || num_faces + horizon_size > faces.size()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < horizon_size; ++i) {
+        auto &edge = horizon[i];
+
+        if (!make_epa_face(*this, edge.first, edge.second, new_idx, faces[num_faces])) {
+            return false;
+        }
+
+        ++num_faces;
+    }
+
+    return true;
+}
+
+}
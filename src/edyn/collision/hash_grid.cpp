@@ -0,0 +1,139 @@
+#include "edyn/collision/hash_grid.hpp"
+#include "edyn/parallel/parallel_for.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace edyn {
+
+// Number of bits used to represent each cell coordinate in a key.
+static constexpr int64_t cell_coord_bits = 21;
+static constexpr int64_t cell_coord_bias = int64_t(1) << (cell_coord_bits - 1);
+static constexpr int64_t cell_coord_mask = (int64_t(1) << cell_coord_bits) - 1;
+
+// Grids with fewer elements are built in the calling thread, which avoids the
+// overhead of dispatching jobs for little work. Grids built from within a job,
+// e.g. in an island worker, are always built in the calling thread, since the
+// worker must not block while waiting on other jobs.
+static constexpr size_t min_parallel_count = 1024;
+
+template<typename Func>
+static void for_each_element(size_t count, Func func) {
+    if (count < min_parallel_count || !can_parallel_for()) {
+        for (size_t i = 0; i < count; ++i) {
+            func(i);
+        }
+    } else {
+        parallel_for(size_t{0}, count, func);
+    }
+}
+
+static int64_t cell_coord(scalar value, scalar cell_size_inv) {
+    return static_cast<int64_t>(std::floor(value * cell_size_inv));
+}
+
+static hash_grid::key_type pack_cell_coords(int64_t x, int64_t y, int64_t z) {
+    // Coordinates wrap around, which is harmless since the AABBs are tested
+    // for intersection afterwards.
+    auto kx = static_cast<hash_grid::key_type>((x + cell_coord_bias) & cell_coord_mask);
+    auto ky = static_cast<hash_grid::key_type>((y + cell_coord_bias) & cell_coord_mask);
+    auto kz = static_cast<hash_grid::key_type>((z + cell_coord_bias) & cell_coord_mask);
+    return (kx << (cell_coord_bits * 2)) | (ky << cell_coord_bits) | kz;
+}
+
+hash_grid::key_type hash_grid::cell_key(const vector3 &point) const {
+    return pack_cell_coords(cell_coord(point.x, m_cell_size_inv),
+                            cell_coord(point.y, m_cell_size_inv),
+                            cell_coord(point.z, m_cell_size_inv));
+}
+
+void hash_grid::build(const std::vector<AABB> &aabbs) {
+    m_entries.clear();
+    m_large_elements.clear();
+
+    auto num_elements = aabbs.size();
+
+    if (num_elements == 0) {
+        return;
+    }
+
+    // Use the median of the largest dimension of all AABBs as the cell size.
+    m_sizes.resize(num_elements);
+
+    for (size_t i = 0; i < num_elements; ++i) {
+        auto extents = aabbs[i].max - aabbs[i].min;
+        m_sizes[i] = std::max(extents.x, std::max(extents.y, extents.z));
+    }
+
+    auto median = m_sizes.begin() + num_elements / 2;
+    std::nth_element(m_sizes.begin(), median, m_sizes.end());
+    m_cell_size = std::max(*median, EDYN_EPSILON);
+    m_cell_size_inv = scalar(1) / m_cell_size;
+
+    // Count the number of cells each element overlaps and calculate the
+    // offset of its first entry in the entry array.
+    m_offsets.resize(num_elements + 1);
+
+    for_each_element(num_elements, [&] (size_t index) {
+        auto &aabb = aabbs[index];
+        auto count = int64_t{1};
+
+        for (auto i = 0; i < 3; ++i) {
+            auto span = cell_coord(aabb.max[i], m_cell_size_inv) -
+                        cell_coord(aabb.min[i], m_cell_size_inv) + 1;
+            count *= std::min(span, int64_t(max_cells_per_element + 1));
+        }
+
+        // Large elements do not go into the grid.
+        m_offsets[index + 1] = count > int64_t(max_cells_per_element) ? 0 : static_cast<size_t>(count);
+    });
+
+    m_offsets[0] = 0;
+
+    for (size_t i = 0; i < num_elements; ++i) {
+        if (m_offsets[i + 1] == 0) {
+            m_large_elements.push_back(static_cast<index_type>(i));
+        }
+
+        m_offsets[i + 1] += m_offsets[i];
+    }
+
+    // Insert entries for each overlapped cell.
+    m_entries.resize(m_offsets.back());
+
+    for_each_element(num_elements, [&] (size_t index) {
+        auto offset = m_offsets[index];
+
+        if (offset == m_offsets[index + 1]) {
+            return;
+        }
+
+        auto keys = std::array<key_type, max_cells_per_element>{};
+        auto num_keys = cell_keys(aabbs[index], keys);
+
+        for (size_t k = 0; k < num_keys; ++k) {
+            m_entries[offset++] = entry{keys[k], static_cast<index_type>(index)};
+        }
+    });
+
+    std::sort(m_entries.begin(), m_entries.end(), &entry_less);
+}
+
+size_t hash_grid::cell_keys(const AABB &aabb, std::array<key_type, max_cells_per_element> &keys) const {
+    auto x0 = cell_coord(aabb.min.x, m_cell_size_inv), x1 = cell_coord(aabb.max.x, m_cell_size_inv);
+    auto y0 = cell_coord(aabb.min.y, m_cell_size_inv), y1 = cell_coord(aabb.max.y, m_cell_size_inv);
+    auto z0 = cell_coord(aabb.min.z, m_cell_size_inv), z1 = cell_coord(aabb.max.z, m_cell_size_inv);
+    size_t count = 0;
+
+    for (auto x = x0; x <= x1; ++x) {
+        for (auto y = y0; y <= y1; ++y) {
+            for (auto z = z0; z <= z1; ++z) {
+                EDYN_ASSERT(count < max_cells_per_element);
+                keys[count++] = pack_cell_coords(x, y, z);
+            }
+        }
+    }
+
+    return count;
+}
+
+}
@@ -1,19 +1,185 @@
 #include "edyn/collision/narrowphase.hpp"
 #include "edyn/parallel/parallel_for_async.hpp"
 #include "edyn/comp/material.hpp"
+#include "edyn/comp/linvel.hpp"
+#include "edyn/shapes/paged_mesh_shape.hpp"
+#include "edyn/context/settings.hpp"
+#include "edyn/serialization/memory_archive.hpp"
+#include <atomic>
+#include <memory>
 
 namespace edyn {
 
 narrowphase::narrowphase(entt::registry &reg)
     : m_registry(&reg)
+    , m_prefetch_pending(std::make_shared<std::atomic<bool>>(false))
 {}
 
 bool narrowphase::parallelizable() const {
     return m_registry->size<contact_manifold>() > 1;
 }
 
+void narrowphase::assign_collision_caches() {
+    // Manifolds can be created by the broadphase or imported from another
+    // island, thus check for manifolds without a cache before every update.
+    auto manifold_view = m_registry->view<contact_manifold>();
+    auto cache_view = m_registry->view<collision_cache>();
+
+    for (auto entity : manifold_view) {
+        if (!cache_view.contains(entity)) {
+            m_registry->emplace<collision_cache>(entity);
+        }
+    }
+}
+
+// Regions around bodies near each paged mesh, which are passed on to
+// `paged_triangle_mesh::prefetch` in a background job. The context owns the
+// meshes, since the job might outlive the entities referring to them.
+struct prefetch_paged_meshes_context {
+    using prefetch_region = paged_triangle_mesh::prefetch_region;
+    std::vector<std::pair<std::shared_ptr<paged_triangle_mesh>, std::vector<prefetch_region>>> requests;
+    std::shared_ptr<std::atomic<bool>> pending;
+
+    void run() {
+        for (auto &[trimesh, regions] : requests) {
+            trimesh->prefetch(regions);
+        }
+    }
+};
+
+static void prefetch_paged_meshes_job_func(job::data_type &data) {
+    auto archive = memory_input_archive(data.data(), data.size());
+    intptr_t ctx_intptr;
+    archive(ctx_intptr);
+
+    auto *ctx = reinterpret_cast<prefetch_paged_meshes_context *>(ctx_intptr);
+    ctx->run();
+    ctx->pending->store(false, std::memory_order_release);
+    delete ctx;
+}
+
+void narrowphase::prefetch_paged_meshes() {
+    auto paged_mesh_view = m_registry->view<paged_mesh_shape>();
+
+    if (paged_mesh_view.empty()) {
+        return;
+    }
+
+    // Do not pile up jobs if the previous one is still running. The blocking
+    // loads below are still necessary though.
+    auto &settings = m_registry->ctx<const edyn::settings>();
+    auto prefetch = !m_prefetch_pending->load(std::memory_order_acquire);
+
+    if (!prefetch && !settings.paged_mesh_blocking_load) {
+        return;
+    }
+
+    auto manifold_view = m_registry->view<contact_manifold>();
+    auto cache_view = m_registry->view<collision_cache>();
+    auto aabb_view = m_registry->view<AABB>();
+    auto linvel_view = m_registry->view<linvel>();
+
+    // Inflate AABB to load submeshes which are within collision range, as
+    // is done when colliding with a paged mesh.
+    constexpr auto inset = vector3 {
+        -contact_breaking_threshold,
+        -contact_breaking_threshold,
+        -contact_breaking_threshold
+    };
+
+    // Only the regions are collected here, while the registry is not being
+    // modified. Finding and loading the submeshes in them happens in a job.
+    // There are very few paged meshes in a scene thus a linear search for
+    // the regions of each one is sufficient.
+    auto ctx = std::make_unique<prefetch_paged_meshes_context>();
+    auto &requests = ctx->requests;
+
+    for (auto entity : manifold_view) {
+        auto &manifold = std::get<0>(manifold_view.get(entity));
+
+        for (size_t i = 0; i < 2; ++i) {
+            auto mesh_entity = manifold.body[i];
+            auto other_entity = manifold.body[(i + 1) % 2];
+
+            if (!paged_mesh_view.contains(mesh_entity) || !aabb_view.contains(other_entity)) {
+                continue;
+            }
+
+            auto &trimesh = std::get<0>(paged_mesh_view.get(mesh_entity)).trimesh;
+            auto aabb = std::get<0>(aabb_view.get(other_entity)).inset(inset);
+            auto velocity = vector3_zero;
+
+            if (linvel_view.contains(other_entity)) {
+                velocity = std::get<0>(linvel_view.get(other_entity));
+            }
+
+            // Submeshes that are touched right now and were not prefetched
+            // in time can't wait. Querying the mesh is skipped if they were
+            // loaded in a previous step and none has been evicted since.
+            if (settings.paged_mesh_blocking_load) {
+                auto &cache = std::get<0>(cache_view.get(entity));
+                auto num_evictions = trimesh->num_evictions();
+
+                if (!cache.has_paged_mesh_resident_aabb ||
+                    cache.paged_mesh_num_evictions != num_evictions ||
+                    !cache.paged_mesh_resident_aabb.contains(aabb)) {
+                    // Also load the region swept in the next step, so that
+                    // this can be skipped then.
+                    auto step_displacement = velocity * settings.fixed_dt;
+                    auto region = enclosing_aabb(aabb, {aabb.min + step_displacement,
+                                                        aabb.max + step_displacement});
+                    trimesh->load_blocking(region);
+                    cache.paged_mesh_resident_aabb = region;
+                    cache.paged_mesh_num_evictions = num_evictions;
+                    cache.has_paged_mesh_resident_aabb = true;
+                }
+            }
+
+            if (!prefetch) {
+                continue;
+            }
+
+            auto displacement = velocity * settings.paged_mesh_look_ahead_time;
+
+            auto it = std::find_if(requests.begin(), requests.end(),
+                                   [&trimesh] (auto &pair) { return pair.first == trimesh; });
+
+            if (it == requests.end()) {
+                requests.emplace_back(trimesh, std::vector<prefetch_paged_meshes_context::prefetch_region>{});
+                it = std::prev(requests.end());
+            }
+
+            it->second.push_back({aabb, displacement});
+        }
+    }
+
+    if (requests.empty()) {
+        return;
+    }
+
+    auto &dispatcher = job_dispatcher::global();
+
+    // Jobs would never run without workers.
+    if (dispatcher.num_workers() == 0) {
+        ctx->run();
+        return;
+    }
+
+    ctx->pending = m_prefetch_pending;
+    m_prefetch_pending->store(true, std::memory_order_relaxed);
+
+    auto j = job();
+    j.func = &prefetch_paged_meshes_job_func;
+    auto archive = fixed_memory_output_archive(j.data.data(), j.data.size());
+    auto ctx_intptr = reinterpret_cast<intptr_t>(ctx.release());
+    archive(ctx_intptr);
+    dispatcher.async(j);
+}
+
 void narrowphase::update() {
     update_contact_distances(*m_registry);
+    assign_collision_caches();
+    prefetch_paged_meshes();
 
     auto manifold_view = m_registry->view<contact_manifold>();
     update_contact_manifolds(manifold_view.begin(), manifold_view.end(), manifold_view);
@@ -21,6 +187,8 @@ void narrowphase::update() {
 
 void narrowphase::update_async(job &completion_job) {
     update_contact_distances(*m_registry);
+    assign_collision_caches();
+    prefetch_paged_meshes();
 
     EDYN_ASSERT(parallelizable());
 
@@ -30,7 +198,9 @@ void narrowphase::update_async(job &completion_job) {
     auto com_view = m_registry->view<center_of_mass>();
     auto cp_view = m_registry->view<contact_point>();
     auto imp_view = m_registry->view<constraint_impulse>();
+    auto cache_view = m_registry->view<collision_cache>();
     auto shapes_views_tuple = get_tuple_of_shape_views(*m_registry);
+    auto *gjk_shape_pairs = &m_registry->ctx<const settings>().gjk_shape_pairs;
 
     // Resize result collection vectors to allocate one slot for each iteration
     // of the parallel_for.
@@ -39,14 +209,15 @@ void narrowphase::update_async(job &completion_job) {
     auto &dispatcher = job_dispatcher::global();
 
     parallel_for_async(dispatcher, size_t{0}, manifold_view.size(), size_t{1}, completion_job,
-            [this, body_view, tr_view, com_view, manifold_view, cp_view, imp_view, shapes_views_tuple] (size_t index) {
+            [this, body_view, tr_view, com_view, manifold_view, cp_view, imp_view, cache_view, shapes_views_tuple, gjk_shape_pairs] (size_t index) {
         auto entity = manifold_view[index];
         auto &manifold = std::get<0>(manifold_view.get(entity));
+        auto &cache = std::get<0>(cache_view.get(entity));
         collision_result result;
         auto &construction_info = m_cp_construction_infos[index];
         auto &destruction_info = m_cp_destruction_infos[index];
 
-        detect_collision(manifold.body, result, body_view, com_view, shapes_views_tuple);
+        detect_collision(manifold.body, result, body_view, com_view, shapes_views_tuple, cache, *gjk_shape_pairs);
         process_collision(entity, manifold, result, cp_view, imp_view, tr_view, com_view,
                           [&construction_info] (const collision_result::collision_point &rp) {
             construction_info.point[construction_info.count++] = rp;
@@ -0,0 +1,249 @@
+#include "edyn/collision/query_world.hpp"
+#include "edyn/collision/broadphase_main.hpp"
+#include "edyn/comp/position.hpp"
+#include "edyn/comp/orientation.hpp"
+#include "edyn/comp/center_of_mass.hpp"
+#include "edyn/comp/shape_index.hpp"
+#include "edyn/util/shape_query_util.hpp"
+#include <entt/entity/registry.hpp>
+#include <atomic>
+
+namespace edyn {
+
+template<typename Func>
+void query_world::visit_candidates(const AABB &aabb, const collision_filter &filter, Func func) const {
+    for (size_t i = 0; i < m_trees.size(); ++i) {
+        auto &tree = m_trees[i];
+        auto &node_body = m_node_body[i];
+
+        tree.query(aabb, [&] (tree_node_id_t id) {
+            auto body_index = node_body[id];
+
+            if (body_index == null_body_index || !filters_collide(filter, tree.get_filter(id))) {
+                return;
+            }
+
+            auto &body = m_bodies[body_index];
+
+            std::visit([&] (auto &&shape) {
+                func(body.entity, shape, body.pos, body.orn);
+            }, *body.shape);
+        });
+    }
+}
+
+void query_world::cast_packet(raycast_packet &packet, std::vector<raycast_candidate> &candidates,
+                              raycast_mode mode) const {
+    candidates.clear();
+
+    auto raycast_group = [&] (auto first, auto last) {
+        std::visit([&] (auto &&first_shape) {
+            using ShapeType = std::decay_t<decltype(first_shape)>;
+
+            for (auto it = first; it != last; ++it) {
+                if (!packet.should_raycast(*it)) {
+                    continue;
+                }
+
+                auto &body = m_bodies[it->body];
+                auto &shape = *std::get_if<ShapeType>(body.shape.get());
+                auto ctx = raycast_context{body.pos, body.orn, packet.p0[it->ray], packet.p1[it->ray]};
+                packet.report(*it, edyn::raycast(shape, ctx), mode);
+            }
+        }, *m_bodies[first->body].shape);
+    };
+
+    // Rays which are done or which enter the node beyond their closest hit
+    // skip the node and its whole subtree.
+    auto test_node = [&] (const tree_view::tree_node &node, size_t i) {
+        return packet.test_node(i, node.aabb);
+    };
+
+    for (size_t i = 0; i < m_trees.size(); ++i) {
+        auto &tree = m_trees[i];
+        auto &node_body = m_node_body[i];
+
+        tree.traverse_packet(packet.size, test_node, [&] (tree_node_id_t id, size_t ray) {
+            auto body_index = node_body[id];
+
+            if (body_index == null_body_index || !packet.accepts(ray, tree.get_filter(id))) {
+                return;
+            }
+
+            auto &body = m_bodies[body_index];
+            auto entry = packet.entry_fraction(ray, tree.get_node(id).aabb);
+            candidates.push_back({body.shape->index(), entry, body.entity, ray, body_index});
+
+            if (candidates.size() >= raycast_candidate_batch_size) {
+                resolve_raycast_candidates(candidates, raycast_group);
+            }
+        });
+
+        resolve_raycast_candidates(candidates, raycast_group);
+    }
+}
+
+raycast_result query_world::raycast(vector3 p0, vector3 p1, const collision_filter &filter) const {
+    auto result = raycast_result{};
+    auto packet = edyn::raycast_packet{};
+    packet.add(p0, p1, &filter, result);
+
+    auto candidates = std::vector<raycast_candidate>{};
+    cast_packet(packet, candidates, raycast_mode::closest_hit);
+
+    return result;
+}
+
+void query_world::raycast_batch(const std::vector<raycast_query> &queries,
+                                std::vector<raycast_result> &results, raycast_mode mode) const {
+    raycast_in_packets(queries, results, [&] (raycast_packet &packet, std::vector<raycast_candidate> &candidates) {
+        cast_packet(packet, candidates, mode);
+    });
+}
+
+void query_world::overlap(const overlap_query &query, std::vector<entt::entity> &entities) const {
+    perform_overlap(query, entities, [this] (const AABB &aabb, const collision_filter &filter, auto func) {
+        visit_candidates(aabb, filter, func);
+    });
+}
+
+shape_cast_result query_world::shape_cast(const shape_cast_query &query) const {
+    return perform_shape_cast(query, [this] (const AABB &aabb, const collision_filter &filter, auto func) {
+        visit_candidates(aabb, filter, func);
+    });
+}
+
+void query_world::update(entt::registry &registry, shape_cache_t &shapes) {
+    auto index_view = registry.view<shape_index>();
+    auto tr_view = registry.view<position, orientation>();
+    auto com_view = registry.view<center_of_mass>();
+    auto shape_views_tuple = get_tuple_of_shape_views(registry);
+    auto &bphase = registry.ctx<broadphase_main>();
+
+    size_t tree_index = 0;
+    size_t num_bodies = 0;
+
+    bphase.each_tree([&] (const dynamic_tree &tree) {
+        auto &view = m_trees[tree_index] = tree.view();
+        auto &node_body = m_node_body[tree_index];
+        node_body.assign(view.size(), null_body_index);
+        ++tree_index;
+
+        for (tree_node_id_t id = 0; id < view.size(); ++id) {
+            auto &node = view.get_node(id);
+            auto entity = node.entity;
+
+            if (!node.leaf() || entity == entt::null ||
+                !index_view.contains(entity) || !tr_view.contains(entity)) {
+                continue;
+            }
+
+            if (num_bodies == m_bodies.size()) {
+                m_bodies.emplace_back();
+            }
+
+            auto &body = m_bodies[num_bodies];
+            body.entity = entity;
+            body.pos = tr_view.get<position>(entity);
+            body.orn = tr_view.get<orientation>(entity);
+
+            if (com_view.contains(entity)) {
+                auto &com = std::get<0>(com_view.get(entity));
+                body.pos = to_world_space(-com, body.pos, body.orn);
+            }
+
+            // Only shapes which are new or were modified since the last
+            // update are copied.
+            auto &shape = shapes[entity];
+
+            if (!shape) {
+                auto copy = std::make_shared<shapes_variant_t>();
+                auto sh_idx = std::get<0>(index_view.get(entity));
+                visit_shape(sh_idx, entity, shape_views_tuple, [&] (auto &&sh) {
+                    *copy = std::get<0>(sh);
+                });
+
+                // The rotated mesh belongs to the registry. Queries do not use it.
+                if (auto *polyhedron = std::get_if<polyhedron_shape>(copy.get())) {
+                    polyhedron->rotated = nullptr;
+                }
+
+                shape = std::move(copy);
+            }
+
+            body.shape = shape;
+            node_body[id] = static_cast<uint32_t>(num_bodies++);
+        }
+    });
+
+    m_bodies.resize(num_bodies);
+}
+
+std::shared_ptr<const query_world> query_world_source::acquire() const {
+    return std::atomic_load(&m_world);
+}
+
+query_world_buffer::query_world_buffer(entt::registry &registry)
+    : m_registry(&registry)
+    , m_source(std::make_shared<query_world_source>())
+{
+    std::apply([&] (auto ... shape) {
+        ((registry.on_construct<decltype(shape)>().template connect<&query_world_buffer::on_change_shape>(*this),
+          registry.on_update<decltype(shape)>().template connect<&query_world_buffer::on_change_shape>(*this),
+          registry.on_destroy<decltype(shape)>().template connect<&query_world_buffer::on_change_shape>(*this)), ...);
+    }, shapes_tuple);
+}
+
+query_world_buffer::~query_world_buffer() {
+    // Unlike other context variables, the buffer can be removed while the
+    // registry is still in use.
+    std::apply([&] (auto ... shape) {
+        ((m_registry->on_construct<decltype(shape)>().disconnect(*this),
+          m_registry->on_update<decltype(shape)>().disconnect(*this),
+          m_registry->on_destroy<decltype(shape)>().disconnect(*this)), ...);
+    }, shapes_tuple);
+}
+
+void query_world_buffer::on_change_shape(entt::registry &, entt::entity entity) {
+    // Worlds already published keep the previous copy.
+    m_shapes.erase(entity);
+}
+
+void query_world_buffer::publish() {
+    // The back world might still be held by readers who acquired it when it
+    // was in front, in which case it cannot be modified.
+    if (!m_back || m_back.use_count() > 1) {
+        m_back = std::make_shared<query_world>();
+    }
+
+    m_back->update(*m_registry, m_shapes);
+
+    auto previous = std::atomic_exchange(&m_source->m_world, std::shared_ptr<const query_world>(m_back));
+    m_back = std::const_pointer_cast<query_world>(previous);
+}
+
+std::shared_ptr<const query_world> query_world_buffer::acquire() const {
+    return m_source->acquire();
+}
+
+std::shared_ptr<const query_world_source> enable_query_world(entt::registry &registry) {
+    if (auto *buffer = registry.try_ctx<query_world_buffer>()) {
+        return buffer->source();
+    }
+
+    return registry.set<query_world_buffer>(registry).source();
+}
+
+void disable_query_world(entt::registry &registry) {
+    registry.unset<query_world_buffer>();
+}
+
+std::shared_ptr<const query_world> get_query_world(const entt::registry &registry) {
+    if (auto *buffer = registry.try_ctx<query_world_buffer>()) {
+        return buffer->acquire();
+    }
+
+    return {};
+}
+
+}
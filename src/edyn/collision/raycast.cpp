@@ -4,7 +4,6 @@
 #include "edyn/comp/orientation.hpp"
 #include "edyn/comp/center_of_mass.hpp"
 #include "edyn/comp/shape_index.hpp"
-#include "edyn/collision/tree_view.hpp"
 #include "edyn/collision/broadphase_main.hpp"
 #include "edyn/collision/broadphase_worker.hpp"
 #include "edyn/math/geom.hpp"
@@ -12,62 +11,115 @@
 #include "edyn/shapes/shapes.hpp"
 #include "edyn/util/triangle_util.hpp"
 #include "edyn/util/tuple_util.hpp"
+#include "edyn/util/raycast_util.hpp"
+#include "edyn/parallel/job_dispatcher.hpp"
+#include "edyn/parallel/parallel_for.hpp"
 #include <entt/entity/registry.hpp>
+#include <algorithm>
+#include <utility>
+#include <array>
 
 namespace edyn {
 
-raycast_result raycast(entt::registry &registry, vector3 p0, vector3 p1) {
+// Calls `func` with the view of the shape type at `index` in `shapes_tuple`.
+template<typename Func, size_t... Is>
+static void visit_shape_view(const tuple_of_shape_views_t &views_tuple, size_t index,
+                             Func &func, std::index_sequence<Is...>) {
+    ((Is == index ? func(std::get<Is>(views_tuple)) : void()), ...);
+}
+
+// Returns a function that raycasts a packet, with signature
+// `void(raycast_packet &, std::vector<raycast_candidate> &)`, where the vector
+// is used as scratch memory. The rays traverse the broad-phase trees together
+// and the candidates are raycast in groups of the same shape type, see
+// `resolve_raycast_candidates`. Candidates are resolved every
+// `raycast_candidate_batch_size` leaves during traversal, thus the hits found
+// so far cull the remaining nodes. Views are only read thus it can be invoked
+// from multiple threads simultaneously.
+static auto make_packet_raycaster(entt::registry &registry, raycast_mode mode) {
     auto index_view = registry.view<shape_index>();
     auto tr_view = registry.view<position, orientation>();
     auto com_view = registry.view<center_of_mass>();
-    auto tree_view_view = registry.view<tree_view>();
     auto shape_views_tuple = get_tuple_of_shape_views(registry);
 
-    entt::entity hit_entity {entt::null};
-    shape_raycast_result result;
-
-    auto raycast_shape = [&] (entt::entity entity) {
-      auto sh_idx = std::get<0>(index_view.get(entity));
-      auto pos = tr_view.get<position>(entity);
-      auto orn = tr_view.get<orientation>(entity);
+    // This function works both in the coordinator and in an island worker.
+    auto *bphase_main = registry.try_ctx<broadphase_main>();
+    auto *bphase_worker = bphase_main ? nullptr : &registry.ctx<broadphase_worker>();
+
+    return [=] (raycast_packet &packet, std::vector<raycast_candidate> &candidates) {
+        candidates.clear();
+
+        auto raycast_group = [&] (auto first, auto last) {
+            auto raycast_shapes = [&] (auto &&shape_view) {
+                for (auto it = first; it != last; ++it) {
+                    if (!packet.should_raycast(*it)) {
+                        continue;
+                    }
+
+                    auto pos = static_cast<vector3>(tr_view.template get<position>(it->entity));
+                    auto orn = static_cast<quaternion>(tr_view.template get<orientation>(it->entity));
+
+                    if (com_view.contains(it->entity)) {
+                        // Calculate origin using object space center of mass.
+                        auto &com = std::get<0>(com_view.get(it->entity));
+                        pos = to_world_space(-com, pos, orn);
+                    }
+
+                    auto ctx = raycast_context{pos, orn, packet.p0[it->ray], packet.p1[it->ray]};
+                    packet.report(*it, raycast(std::get<0>(shape_view.get(it->entity)), ctx), mode);
+                }
+            };
+
+            visit_shape_view(shape_views_tuple, first->shape_index, raycast_shapes,
+                             std::make_index_sequence<std::tuple_size_v<tuple_of_shape_views_t>>{});
+        };
+
+        // Rays which are done or which enter the node beyond their closest
+        // hit skip the node and its whole subtree.
+        auto test_node = [&] (const tree_node &node, size_t i) {
+            return packet.test_node(i, node.aabb);
+        };
+
+        auto traverse = [&] (const dynamic_tree &tree) {
+            tree.traverse_packet(packet.size, test_node, [&] (tree_node_id_t id, size_t i) {
+                if (!packet.accepts(i, tree.get_filter(id).filter)) {
+                    return;
+                }
 
-      if (com_view.contains(entity)) {
-        // Calculate origin using object space center of mass.
-        auto &com = std::get<0>(com_view.get(entity));
-        pos = to_world_space(-com, pos, orn);
-      }
+                auto &node = tree.get_node(id);
+                auto sh_idx = std::get<0>(index_view.get(node.entity)).value;
+                candidates.push_back({sh_idx, packet.entry_fraction(i, node.aabb), node.entity, i, 0});
 
-      auto ctx = raycast_context{pos, orn, p0, p1};
+                if (candidates.size() >= raycast_candidate_batch_size) {
+                    resolve_raycast_candidates(candidates, raycast_group);
+                }
+            });
 
-        visit_shape(sh_idx, entity, shape_views_tuple, [&] (auto &&shape) {
-          auto res = raycast(std::get<0>(shape), ctx);
+            resolve_raycast_candidates(candidates, raycast_group);
+        };
 
-          if (res.fraction < result.fraction) {
-            result = res;
-            hit_entity = entity;
-          }
-        });
+        if (bphase_main) {
+            bphase_main->each_tree(traverse);
+        } else {
+            bphase_worker->each_tree(traverse);
+        }
     };
+}
 
-    // This function works both in the coordinator and in an island worker.
-    // Pick the available broadphase and raycast their AABB trees.
-    if (registry.try_ctx<broadphase_main>() != nullptr) {
-        auto &bphase = registry.ctx<broadphase_main>();
-        bphase.raycast_islands(p0, p1, [&] (entt::entity island_entity) {
-          auto &tree_view = std::get<0>(tree_view_view.get(island_entity));
-          tree_view.raycast(p0, p1, [&] (tree_node_id_t id) {
-                auto entity = tree_view.get_node(id).entity;
-                raycast_shape(entity);
-            });
-        });
+raycast_result raycast(entt::registry &registry, vector3 p0, vector3 p1) {
+    auto result = raycast_result{};
+    auto packet = raycast_packet{};
+    packet.add(p0, p1, nullptr, result);
 
-        bphase.raycast_non_procedural(p0, p1, raycast_shape);
-    } else {
-        auto &bphase = registry.ctx<broadphase_worker>();
-        bphase.raycast(p0, p1, raycast_shape);
-    }
+    auto candidates = std::vector<raycast_candidate>{};
+    make_packet_raycaster(registry, raycast_mode::closest_hit)(packet, candidates);
 
-    return {result, hit_entity};
+    return result;
+}
+
+void raycast_batch(entt::registry &registry, const std::vector<raycast_query> &queries,
+                   std::vector<raycast_result> &results, raycast_mode mode) {
+    raycast_in_packets(queries, results, make_packet_raycaster(registry, mode));
 }
 
 shape_raycast_result raycast(const box_shape &box, const raycast_context &ctx) {
@@ -409,8 +461,7 @@ shape_raycast_result raycast(const mesh_shape &mesh, const raycast_context &ctx)
 shape_raycast_result raycast(const paged_mesh_shape &paged_mesh, const raycast_context &ctx) {
     shape_raycast_result result;
 
-    paged_mesh.trimesh->raycast_cached(ctx.p0, ctx.p1, [&] (auto submesh_idx, auto tri_idx) {
-        auto trimesh = paged_mesh.trimesh->get_submesh(submesh_idx);
+    paged_mesh.trimesh->raycast_cached(ctx.p0, ctx.p1, [&] (auto submesh_idx, auto tri_idx, auto &trimesh) {
         auto vertices = trimesh->get_triangle_vertices(tri_idx);
         auto normal = trimesh->get_triangle_normal(tri_idx);
         auto t = scalar(0);
@@ -430,4 +481,31 @@ shape_raycast_result raycast(const paged_mesh_shape &paged_mesh, const raycast_c
     return result;
 }
 
+shape_raycast_result raycast(const heightfield_shape &sh, const raycast_context &ctx) {
+    shape_raycast_result result;
+
+    sh.field->raycast(ctx.p0, ctx.p1, [&] (auto tri_idx) {
+        auto vertices = sh.field->get_triangle_vertices(tri_idx);
+        auto normal = sh.field->get_triangle_normal(tri_idx);
+        auto t = scalar(0);
+
+        if (!intersect_segment_triangle(ctx.p0, ctx.p1, vertices, normal, t) ||
+            t < 0 || t > 1) {
+            return false;
+        }
+
+        if (t < result.fraction) {
+            result.fraction = t;
+            result.normal = normal;
+            result.info_var = heightfield_raycast_info{tri_idx};
+        }
+
+        // Cells are visited in order thus the first intersection is the
+        // closest, apart from the other triangle in the same cell.
+        return true;
+    });
+
+    return result;
+}
+
 }
@@ -0,0 +1,107 @@
+#include "edyn/collision/shape_query.hpp"
+#include "edyn/collision/tree_node.hpp"
+#include "edyn/collision/broadphase_main.hpp"
+#include "edyn/collision/broadphase_worker.hpp"
+#include "edyn/comp/position.hpp"
+#include "edyn/comp/orientation.hpp"
+#include "edyn/comp/center_of_mass.hpp"
+#include "edyn/comp/shape_index.hpp"
+#include "edyn/math/math.hpp"
+#include "edyn/shapes/shapes.hpp"
+#include "edyn/util/shape_query_util.hpp"
+#include "edyn/parallel/job_dispatcher.hpp"
+#include "edyn/parallel/parallel_for.hpp"
+#include <entt/entity/registry.hpp>
+
+namespace edyn {
+
+// Returns a function that visits the entities in the broad-phase trees which
+// are candidates for a shape query, as expected by `perform_overlap`. Views are
+// only read thus it can be invoked from multiple threads simultaneously.
+static auto make_candidate_visitor(entt::registry &registry) {
+    auto index_view = registry.view<shape_index>();
+    auto tr_view = registry.view<position, orientation>();
+    auto com_view = registry.view<center_of_mass>();
+    auto shape_views_tuple = get_tuple_of_shape_views(registry);
+
+    // This function works both in the coordinator and in an island worker.
+    auto *bphase_main = registry.try_ctx<broadphase_main>();
+    auto *bphase_worker = bphase_main ? nullptr : &registry.ctx<broadphase_worker>();
+
+    return [=] (const AABB &aabb, const collision_filter &filter, auto func) {
+        auto visit_entity = [&] (entt::entity entity) {
+            auto sh_idx = std::get<0>(index_view.get(entity));
+            auto pos = static_cast<vector3>(tr_view.get<position>(entity));
+            auto orn = static_cast<quaternion>(tr_view.get<orientation>(entity));
+
+            if (com_view.contains(entity)) {
+                // Calculate origin using object space center of mass.
+                auto &com = std::get<0>(com_view.get(entity));
+                pos = to_world_space(-com, pos, orn);
+            }
+
+            visit_shape(sh_idx, entity, shape_views_tuple, [&] (auto &&shape) {
+                func(entity, std::get<0>(shape), pos, orn);
+            });
+        };
+
+        auto query = [&] (const dynamic_tree &tree) {
+            tree.query(aabb, [&] (tree_node_id_t id) {
+                if (filters_collide(filter, tree.get_filter(id).filter)) {
+                    visit_entity(tree.get_node(id).entity);
+                }
+            });
+        };
+
+        if (bphase_main) {
+            bphase_main->each_tree(query);
+        } else {
+            bphase_worker->each_tree(query);
+        }
+    };
+}
+
+void overlap(entt::registry &registry, const overlap_query &query,
+             std::vector<entt::entity> &entities) {
+    perform_overlap(query, entities, make_candidate_visitor(registry));
+}
+
+shape_cast_result shape_cast(entt::registry &registry, const shape_cast_query &query) {
+    return perform_shape_cast(query, make_candidate_visitor(registry));
+}
+
+template<typename Func>
+static void for_each_query(size_t num_queries, Func func) {
+    if (num_queries < 2 || !can_parallel_for()) {
+        for (size_t i = 0; i < num_queries; ++i) {
+            func(i);
+        }
+    } else {
+        parallel_for(size_t{0}, num_queries, func);
+    }
+}
+
+void overlap_batch(entt::registry &registry, const std::vector<overlap_query> &queries,
+                   std::vector<std::vector<entt::entity>> &results) {
+    results.resize(queries.size());
+
+    auto visit_candidates = make_candidate_visitor(registry);
+
+    for_each_query(queries.size(), [&] (size_t index) {
+        results[index].clear();
+        perform_overlap(queries[index], results[index], visit_candidates);
+    });
+}
+
+void shape_cast_batch(entt::registry &registry, const std::vector<shape_cast_query> &queries,
+                      std::vector<shape_cast_result> &results) {
+    results.resize(queries.size());
+
+    auto visit_candidates = make_candidate_visitor(registry);
+
+    for_each_query(queries.size(), [&] (size_t index) {
+        results[index] = perform_shape_cast(queries[index], visit_candidates);
+    });
+}
+
+}
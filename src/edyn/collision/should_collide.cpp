@@ -26,8 +26,7 @@ bool should_collide_default(const entt::registry &registry, entt::entity first,
     auto &filter0 = registry.get<collision_filter>(first);
     auto &filter1 = registry.get<collision_filter>(second);
 
-    if ((filter0.group & filter1.mask) == 0 ||
-        (filter1.group & filter0.mask) == 0) {
+    if (!filters_collide(filter0, filter1)) {
         return false;
     }
 
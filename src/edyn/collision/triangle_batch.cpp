@@ -0,0 +1,29 @@
+#include "edyn/collision/triangle_batch.hpp"
+#include "edyn/shapes/triangle_mesh.hpp"
+
+namespace edyn {
+
+void triangle_batch::clear() {
+    resize(0);
+}
+
+void triangle_batch::resize(size_t size) {
+    indices.resize(size);
+    vx.resize(size); vy.resize(size); vz.resize(size);
+    nx.resize(size); ny.resize(size); nz.resize(size);
+}
+
+void triangle_batch::gather(const triangle_mesh &mesh, const AABB &aabb) {
+    clear();
+
+    mesh.visit_triangles(aabb, [&] (auto tri_idx) {
+        auto v0 = mesh.get_vertex_position(mesh.get_face_vertex_index(tri_idx, 0));
+        auto normal = mesh.get_triangle_normal(tri_idx);
+
+        indices.push_back(static_cast<uint32_t>(tri_idx));
+        vx.push_back(v0.x); vy.push_back(v0.y); vz.push_back(v0.z);
+        nx.push_back(normal.x); ny.push_back(normal.y); nz.push_back(normal.z);
+    });
+}
+
+}
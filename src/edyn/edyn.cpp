@@ -1,7 +1,9 @@
 #include "edyn/edyn.hpp"
 #include "edyn/context/settings.hpp"
 #include "edyn/collision/broadphase_main.hpp"
+#include "edyn/collision/query_world.hpp"
 #include "edyn/sys/update_presentation.hpp"
+#include <algorithm>
 
 namespace edyn {
 
@@ -31,6 +33,7 @@ void detach(entt::registry &registry) {
     registry.unset<contact_manifold_map>();
     registry.unset<island_coordinator>();
     registry.unset<broadphase_main>();
+    registry.unset<query_world_buffer>();
 }
 
 scalar get_fixed_dt(const entt::registry &registry) {
@@ -62,6 +65,11 @@ void update(entt::registry &registry) {
     // between them which will later cause islands to be merged into one.
     registry.ctx<broadphase_main>().update();
 
+    // Publish state for queries in other threads.
+    if (auto *buffer = registry.try_ctx<query_world_buffer>()) {
+        buffer->publish();
+    }
+
     if (is_paused(registry)) {
         snap_presentation(registry);
     } else {
@@ -123,6 +131,40 @@ void set_should_collide(entt::registry &registry, should_collide_func_t func) {
     registry.ctx<island_coordinator>().settings_changed();
 }
 
+broadphase_type get_broadphase_type(const entt::registry &registry) {
+    return registry.ctx<const settings>().broadphase;
+}
+
+void set_broadphase_type(entt::registry &registry, broadphase_type type) {
+    registry.ctx<settings>().broadphase = type;
+    registry.ctx<island_coordinator>().settings_changed();
+}
+
+void set_paged_mesh_prefetch(entt::registry &registry, scalar look_ahead_time,
+                             bool blocking_load) {
+    auto &settings = registry.ctx<edyn::settings>();
+    settings.paged_mesh_look_ahead_time = look_ahead_time;
+    settings.paged_mesh_blocking_load = blocking_load;
+    registry.ctx<island_coordinator>().settings_changed();
+}
+
+void set_gjk_collision(entt::registry &registry, size_t shape_indexA,
+                       size_t shape_indexB, bool enabled) {
+    auto &pairs = registry.ctx<settings>().gjk_shape_pairs;
+    auto it = std::find_if(pairs.begin(), pairs.end(), [&] (auto &pair) {
+        return (pair.first == shape_indexA && pair.second == shape_indexB) ||
+               (pair.first == shape_indexB && pair.second == shape_indexA);
+    });
+
+    if (enabled && it == pairs.end()) {
+        pairs.emplace_back(shape_indexA, shape_indexB);
+    } else if (!enabled && it != pairs.end()) {
+        pairs.erase(it);
+    }
+
+    registry.ctx<island_coordinator>().settings_changed();
+}
+
 bool manifold_exists(entt::registry &registry, entt::entity first, entt::entity second) {
     return manifold_exists(registry, entity_pair{first, second});
 }
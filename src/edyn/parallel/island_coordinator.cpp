@@ -25,6 +25,7 @@
 #include "edyn/context/settings.hpp"
 #include <entt/entity/registry.hpp>
 #include <set>
+#include <algorithm>
 
 namespace edyn {
 
@@ -193,6 +194,7 @@ void island_coordinator::init_new_nodes_and_edges() {
     std::vector<entt::entity> island_entities;
     auto resident_view = m_registry->view<island_resident>();
     auto procedural_view = m_registry->view<procedural_tag>();
+    auto sleeping_view = m_registry->view<sleeping_tag>();
 
     graph.reach(
         procedural_node_indices.begin(), procedural_node_indices.end(),
@@ -255,7 +257,15 @@ void island_coordinator::init_new_nodes_and_edges() {
         },
         [&] () { // connectedComponentFunc
             if (island_entities.empty()) {
-                create_island(m_timestamp, false, connected_nodes, connected_edges);
+                // A new island starts asleep if all of its procedural nodes
+                // have a `sleeping_tag`, e.g. when they're loaded from a
+                // snapshot or when bodies are deliberately created asleep.
+                // Otherwise, the island starts awake.
+                auto sleeping = std::all_of(connected_nodes.begin(), connected_nodes.end(),
+                    [&] (entt::entity entity) {
+                        return !procedural_view.contains(entity) || sleeping_view.contains(entity);
+                    });
+                create_island(m_timestamp, sleeping, connected_nodes, connected_edges);
             } else if (island_entities.size() == 1) {
                 auto island_entity = *island_entities.begin();
                 insert_to_island(island_entity, connected_nodes, connected_edges);
@@ -342,21 +352,6 @@ entt::entity island_coordinator::create_island(double timestamp, bool sleeping,
 
     ctx->send<island_delta>(ctx->m_delta_builder->finish());
 
-    // Create tree_view for this island using the procedural node AABBs. This
-    // ensures expectations will be met after this function call, or else this
-    // island would not have a tree_view until the worker sends an update.
-    dynamic_tree tree;
-    auto aabb_view = m_registry->view<AABB, procedural_tag>();
-
-    for (auto entity : nodes) {
-        if (aabb_view.contains(entity)) {
-            auto &aabb = aabb_view.get<AABB>(entity);
-            tree.create(aabb, entity);
-        }
-    }
-
-    m_registry->emplace<tree_view>(island_entity, tree.view());
-
     return island_entity;
 }
 
@@ -689,9 +684,7 @@ void island_coordinator::split_island(entt::entity split_island_entity) {
     if (connected_components.size() <= 1) return;
 
     // Process any new messages enqueued during the split, such as created
-    // entities that need to have their entity mappings added and the
-    // update AABB `tree_view` of this island, which removes entities that
-    // have moved due to the split.
+    // entities that need to have their entity mappings added.
     ctx->read_messages();
 
     // Map entities to the coordinator space.
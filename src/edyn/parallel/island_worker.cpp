@@ -1,5 +1,6 @@
 #include "edyn/parallel/island_worker.hpp"
 #include "edyn/collision/contact_manifold.hpp"
+#include "edyn/collision/collision_cache.hpp"
 #include "edyn/comp/orientation.hpp"
 #include "edyn/comp/tag.hpp"
 #include "edyn/config/config.h"
@@ -8,6 +9,7 @@
 #include "edyn/comp/island.hpp"
 #include "edyn/shapes/convex_mesh.hpp"
 #include "edyn/shapes/polyhedron_shape.hpp"
+#include "edyn/shapes/mesh_shape.hpp"
 #include "edyn/sys/update_aabbs.hpp"
 #include "edyn/sys/update_inertias.hpp"
 #include "edyn/sys/update_rotated_meshes.hpp"
@@ -20,9 +22,9 @@
 #include "edyn/comp/dirty.hpp"
 #include "edyn/comp/graph_node.hpp"
 #include "edyn/comp/graph_edge.hpp"
-#include "edyn/comp/rotated_mesh_list.hpp"
+#include "edyn/comp/rotated_mesh_handle.hpp"
+#include "edyn/shapes/rotated_mesh_pool.hpp"
 #include "edyn/math/constants.hpp"
-#include "edyn/collision/tree_view.hpp"
 #include "edyn/util/aabb_util.hpp"
 #include "edyn/util/rigidbody.hpp"
 #include "edyn/util/vector.hpp"
@@ -67,6 +69,7 @@ island_worker::island_worker(entt::entity island_entity, const settings &setting
 {
     m_registry.set<entity_graph>();
     m_registry.set<edyn::settings>(settings);
+    m_registry.set<rotated_mesh_pool>();
 
     // Avoid multi-threading issues in the `should_collide` function by
     // pre-allocating the pools required in there.
@@ -94,7 +97,8 @@ void island_worker::init() {
     m_registry.on_destroy<contact_point>().connect<&island_worker::on_destroy_contact_point>(*this);
     m_registry.on_construct<polyhedron_shape>().connect<&island_worker::on_construct_polyhedron_shape>(*this);
     m_registry.on_construct<compound_shape>().connect<&island_worker::on_construct_compound_shape>(*this);
-    m_registry.on_destroy<rotated_mesh_list>().connect<&island_worker::on_destroy_rotated_mesh_list>(*this);
+    m_registry.on_destroy<rotated_mesh_handle>().connect<&island_worker::on_destroy_rotated_mesh_handle>(*this);
+    m_registry.on_update<mesh_shape>().connect<&island_worker::on_update_mesh_shape>(*this);
 
     m_message_queue.sink<island_delta>().connect<&island_worker::on_island_delta>(*this);
     m_message_queue.sink<msg::set_paused>().connect<&island_worker::on_set_paused>(*this);
@@ -118,10 +122,6 @@ void island_worker::init() {
     // imported AABBs.
     m_bphase.update();
 
-    // Assign tree view containing the updated broad-phase tree.
-    auto tview = m_bphase.view();
-    m_registry.emplace<tree_view>(m_island_entity, tview);
-
     m_state = state::step;
 }
 
@@ -226,12 +226,21 @@ void island_worker::on_construct_compound_shape(entt::registry &registry, entt::
     m_new_compound_shapes.push_back(entity);
 }
 
-void island_worker::on_destroy_rotated_mesh_list(entt::registry &registry, entt::entity entity) {
-    auto &rotated = registry.get<rotated_mesh_list>(entity);
-    if (rotated.next != entt::null) {
-        // Cascade delete. Could lead to mega tall call stacks.
-        registry.destroy(rotated.next);
-    }
+void island_worker::on_destroy_rotated_mesh_handle(entt::registry &registry, entt::entity entity) {
+    auto &handle = registry.get<rotated_mesh_handle>(entity);
+    registry.ctx<rotated_mesh_pool>().erase(handle.index);
+}
+
+void island_worker::on_update_mesh_shape(entt::registry &registry, entt::entity entity) {
+    // Collision results cached for an edited mesh are no longer valid even if
+    // the bodies have not moved.
+    auto manifold_view = registry.view<contact_manifold, collision_cache>();
+
+    manifold_view.each([&] (contact_manifold &manifold, collision_cache &cache) {
+        if (manifold.body[0] == entity || manifold.body[1] == entity) {
+            cache.clear();
+        }
+    });
 }
 
 void island_worker::on_island_delta(const island_delta &delta) {
@@ -324,7 +333,7 @@ void island_worker::on_island_delta(const island_delta &delta) {
           update_inertia(m_registry, local_entity);
         }
 
-        if (m_registry.all_of<rotated_mesh_list>(local_entity)) {
+        if (m_registry.all_of<rotated_mesh_handle>(local_entity)) {
           update_rotated_mesh(m_registry, local_entity);
         }
     });
@@ -616,11 +625,6 @@ void island_worker::finish_step() {
 
     m_delta_builder->updated<island_timestamp>(m_island_entity, isle_time);
 
-    // Update tree view.
-    auto tview = m_bphase.view();
-    m_registry.replace<tree_view>(m_island_entity, tview);
-    m_delta_builder->updated(m_island_entity, tview);
-
     maybe_go_to_sleep();
 
     if (settings.external_system_post_step) {
@@ -752,46 +756,47 @@ void island_worker::init_new_shapes() {
     auto orn_view = m_registry.view<orientation>();
     auto polyhedron_view = m_registry.view<polyhedron_shape>();
     auto compound_view = m_registry.view<compound_shape>();
+    auto &pool = m_registry.ctx<rotated_mesh_pool>();
+
+    // Rotated meshes previously assigned to the entity, in case the shape
+    // was replaced, are released before new ones are created.
+    auto reset_handle = [&] (entt::entity entity, rotated_mesh_pool::index_type index) {
+        if (auto *handle = m_registry.try_get<rotated_mesh_handle>(entity)) {
+            pool.erase(handle->index);
+            handle->index = index;
+        } else {
+            m_registry.emplace<rotated_mesh_handle>(entity, index);
+        }
+    };
 
     for (auto entity : m_new_polyhedron_shapes) {
-      auto &polyhedron = std::get<0>(polyhedron_view.get(entity));
-      // A new `rotated_mesh` is assigned to it, replacing another reference
+        auto &polyhedron = std::get<0>(polyhedron_view.get(entity));
+        // A new `rotated_mesh` is assigned to it, replacing another reference
         // that could be already in there, thus preventing concurrent access.
-      auto rotated = make_rotated_mesh(*polyhedron.mesh, std::get<0>(orn_view.get(entity)));
-      auto rotated_ptr = std::make_unique<rotated_mesh>(std::move(rotated));
-        polyhedron.rotated = rotated_ptr.get();
-        m_registry.emplace<rotated_mesh_list>(entity, polyhedron.mesh, std::move(rotated_ptr));
+        auto index = pool.insert(polyhedron.mesh, std::get<0>(orn_view.get(entity)));
+        polyhedron.rotated = &pool.get(index);
+        reset_handle(entity, index);
     }
 
     for (auto entity : m_new_compound_shapes) {
-      auto &compound = std::get<0>(compound_view.get(entity));
-      auto &orn = std::get<0>(orn_view.get(entity));
-      auto prev_rotated_entity = entt::entity{entt::null};
-
-      for (auto &node : compound.nodes) {
-        if (!std::holds_alternative<polyhedron_shape>(node.shape_var)) continue;
-
-        // Assign a `rotated_mesh_list` to this entity for the first
-        // polyhedron and link it with more rotated meshes for the
-        // remaining polyhedrons.
-        auto &polyhedron = std::get<polyhedron_shape>(node.shape_var);
-        auto local_orn = orn * node.orientation;
-        auto rotated = make_rotated_mesh(*polyhedron.mesh, local_orn);
-        auto rotated_ptr = std::make_unique<rotated_mesh>(std::move(rotated));
-        polyhedron.rotated = rotated_ptr.get();
-
-        if (prev_rotated_entity == entt::null) {
-          m_registry.emplace<rotated_mesh_list>(entity, polyhedron.mesh, std::move(rotated_ptr), node.orientation);
-          prev_rotated_entity = entity;
-        } else {
-          auto next = m_registry.create();
-          m_registry.emplace<rotated_mesh_list>(next, polyhedron.mesh, std::move(rotated_ptr), node.orientation);
+        auto &compound = std::get<0>(compound_view.get(entity));
+        auto &orn = std::get<0>(orn_view.get(entity));
+        auto first = rotated_mesh_pool::null_index;
+
+        // Chain the rotated meshes of all polyhedrons in this compound. They're
+        // inserted in reverse order so each one can point to the previous.
+        for (auto it = compound.nodes.rbegin(); it != compound.nodes.rend(); ++it) {
+            auto &node = *it;
+            if (!std::holds_alternative<polyhedron_shape>(node.shape_var)) continue;
+
+            auto &polyhedron = std::get<polyhedron_shape>(node.shape_var);
+            first = pool.insert(polyhedron.mesh, orn, node.orientation, first);
+            polyhedron.rotated = &pool.get(first);
+        }
 
-          auto &prev_rotated_list = m_registry.get<rotated_mesh_list>(prev_rotated_entity);
-          prev_rotated_list.next = next;
-          prev_rotated_entity = next;
+        if (first != rotated_mesh_pool::null_index) {
+            reset_handle(entity, first);
         }
-      }
     }
 
     m_new_polyhedron_shapes.clear();
@@ -967,11 +972,8 @@ entity_graph::connected_components_t island_worker::split() {
         // in `on_destroy_graph_node()`.
     }
 
-    // Refresh island tree view after nodes are removed and send it back to
-    // the coordinator via the message queue.
-    auto tview = m_bphase.view();
-    m_registry.replace<tree_view>(m_island_entity, tview);
-    m_delta_builder->updated(m_island_entity, tview);
+    // Send the destruction of the nodes which were moved into other islands
+    // back to the coordinator via the message queue.
     auto delta = m_delta_builder->finish();
     m_message_queue.send<island_delta>(std::move(delta));
 
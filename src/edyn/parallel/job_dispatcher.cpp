@@ -152,4 +152,8 @@ size_t job_dispatcher::num_workers() const {
     return m_workers.size();
 }
 
+bool job_dispatcher::is_worker_thread() const {
+    return m_workers.count(std::this_thread::get_id()) > 0;
+}
+
 }
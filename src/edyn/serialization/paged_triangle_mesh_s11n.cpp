@@ -4,6 +4,8 @@
 #include "edyn/serialization/math_s11n.hpp"
 #include "edyn/serialization/std_s11n.hpp"
 #include "edyn/serialization/memory_archive.hpp"
+#include "edyn/serialization/mapped_archive.hpp"
+#include "edyn/serialization/mapped_file.hpp"
 #include "edyn/parallel/job_dispatcher.hpp"
 #include "edyn/shapes/triangle_mesh.hpp"
 #include <memory>
@@ -11,6 +13,32 @@
 
 namespace edyn {
 
+// Header of files in the mapped layout. The version must be incremented
+// whenever the layout of any of the serialized types changes. The sizes
+// of the basic types and the byte order are stored since the arrays are
+// stored as raw bytes.
+struct mapped_paged_triangle_mesh_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t scalar_size;
+    uint32_t size_type_size;
+};
+
+static constexpr auto mapped_paged_triangle_mesh_magic = uint32_t{0x4d504445}; // "EDPM"
+static constexpr auto mapped_paged_triangle_mesh_version = uint32_t{2};
+// Read back as a different value on a platform with another byte order.
+static constexpr auto mapped_paged_triangle_mesh_byte_order = uint32_t{0x01020304};
+
+template<typename Archive>
+void serialize(Archive &archive, mapped_paged_triangle_mesh_header &header) {
+    archive(header.magic);
+    archive(header.version);
+    archive(header.byte_order);
+    archive(header.scalar_size);
+    archive(header.size_type_size);
+}
+
 std::string get_submesh_path(const std::string &paged_triangle_mesh_path, size_t index) {
     auto submesh_path = paged_triangle_mesh_path;
     auto dot_pos = submesh_path.rfind('.');
@@ -44,7 +72,8 @@ void serialize(paged_triangle_mesh_file_output_archive &archive,
 
     archive.m_triangle_mesh_index = 0;
 
-    archive(paged_tri_mesh.m_tree);
+    // Output archives do not modify the tree.
+    archive(const_cast<static_tree &>(*paged_tri_mesh.get_tree()));
     auto num_submeshes = paged_tri_mesh.m_cache.size();
     archive(num_submeshes);
 
@@ -71,7 +100,9 @@ void serialize(paged_triangle_mesh_file_output_archive &archive,
 
 void serialize(paged_triangle_mesh_file_input_archive &archive,
                paged_triangle_mesh &paged_tri_mesh) {
-    archive(paged_tri_mesh.m_tree);
+    auto tree = std::make_shared<static_tree>();
+    archive(*tree);
+    paged_tri_mesh.m_tree = tree;
 
     size_t num_submeshes;
     archive(num_submeshes);
@@ -95,12 +126,7 @@ void serialize(paged_triangle_mesh_file_input_archive &archive,
         archive.m_base_offset = archive.tell_position();
     }
 
-    // Resize LRU queue to have the number of submeshes.
-    paged_tri_mesh.m_lru_indices.resize(num_submeshes);
-    std::iota(paged_tri_mesh.m_lru_indices.begin(),
-              paged_tri_mesh.m_lru_indices.end(), 0);
-
-    paged_tri_mesh.m_is_loading_submesh = std::make_unique<std::atomic<bool>[]>(num_submeshes);
+    paged_tri_mesh.init_cache_state();
 }
 
 template<typename Archive>
@@ -121,28 +147,164 @@ void paged_triangle_mesh_file_input_archive::load(size_t index) {
     job_dispatcher::global().async(j);
 }
 
-void load_mesh_job_func(job::data_type &data) {
-    load_mesh_context ctx;
-    auto archive = memory_input_archive(data.data(), data.size());
-    serialize(archive, ctx);
+void paged_triangle_mesh_file_input_archive::load_blocking(size_t index) {
+    auto mesh = read_submesh(index);
+    m_loaded_signal.publish(index, mesh);
+}
 
-    auto *input = reinterpret_cast<paged_triangle_mesh_file_input_archive *>(ctx.m_input);
+std::shared_ptr<triangle_mesh> paged_triangle_mesh_file_input_archive::read_submesh(size_t index) const {
     auto mesh = std::make_shared<triangle_mesh>();
 
-    switch(input->m_mode) {
-    case paged_triangle_mesh_serialization_mode::embedded:
-        input->seek_position(input->m_base_offset + input->m_offsets[ctx.m_index]);
-        serialize(*input, *mesh);
+    switch(m_mode) {
+    case paged_triangle_mesh_serialization_mode::embedded: {
+        // Do not use the file of this archive since its read position would
+        // be shared among all jobs that are loading submeshes in parallel.
+        auto archive = file_input_archive(m_path);
+        archive.seek_position(m_base_offset + m_offsets[index]);
+        serialize(archive, *mesh);
         break;
+    }
     case paged_triangle_mesh_serialization_mode::external: {
-        auto tri_mesh_path = get_submesh_path(input->m_path, ctx.m_index);
+        auto tri_mesh_path = get_submesh_path(m_path, index);
         auto tri_mesh_archive = file_input_archive(tri_mesh_path);
         serialize(tri_mesh_archive, *mesh);
         break;
     }
     }
 
+    return mesh;
+}
+
+void load_mesh_job_func(job::data_type &data) {
+    load_mesh_context ctx;
+    auto archive = memory_input_archive(data.data(), data.size());
+    serialize(archive, ctx);
+
+    auto *input = reinterpret_cast<paged_triangle_mesh_file_input_archive *>(ctx.m_input);
+    auto mesh = input->read_submesh(ctx.m_index);
     input->m_loaded_signal.publish(ctx.m_index, mesh);
 }
 
-}
\ No newline at end of file
+void serialize(mapped_output_archive &archive,
+               paged_triangle_mesh &paged_tri_mesh) {
+    auto header = mapped_paged_triangle_mesh_header{
+        mapped_paged_triangle_mesh_magic,
+        mapped_paged_triangle_mesh_version,
+        mapped_paged_triangle_mesh_byte_order,
+        sizeof(scalar),
+        sizeof(size_t)
+    };
+    archive(header);
+
+    // Output archives do not modify the tree.
+    archive(const_cast<static_tree &>(*paged_tri_mesh.get_tree()));
+    auto num_submeshes = paged_tri_mesh.m_cache.size();
+    archive(num_submeshes);
+
+    for (auto &entry : paged_tri_mesh.m_cache) {
+        archive(entry.num_vertices);
+        archive(entry.num_indices);
+    }
+
+    // The offsets are only known after the submeshes are written. Reserve
+    // space for them and fill them in later.
+    auto offsets_position = archive.tell_position();
+    auto offsets = std::vector<size_t>(num_submeshes, 0);
+
+    for (auto &offset : offsets) {
+        archive(offset);
+    }
+
+    for (size_t i = 0; i < num_submeshes; ++i) {
+        auto &trimesh = paged_tri_mesh.m_cache[i].trimesh;
+        EDYN_ASSERT(trimesh);
+        archive.align();
+        offsets[i] = archive.tell_position();
+        archive(*trimesh);
+    }
+
+    auto end_position = archive.tell_position();
+    archive.seek_position(offsets_position);
+
+    for (auto &offset : offsets) {
+        archive(offset);
+    }
+
+    archive.seek_position(end_position);
+}
+
+paged_triangle_mesh_mapped_loader::paged_triangle_mesh_mapped_loader(const std::string &path)
+    : m_file(std::make_shared<mapped_file>(path))
+{
+    if (!m_file->is_open() || m_file->size() < sizeof(mapped_paged_triangle_mesh_header)) {
+        return;
+    }
+
+    auto header = mapped_paged_triangle_mesh_header{};
+    auto archive = mapped_input_archive(m_file->data(), m_file->size());
+    archive(header);
+
+    m_compatible = header.magic == mapped_paged_triangle_mesh_magic &&
+                   header.version == mapped_paged_triangle_mesh_version &&
+                   header.byte_order == mapped_paged_triangle_mesh_byte_order &&
+                   header.scalar_size == sizeof(scalar) &&
+                   header.size_type_size == sizeof(size_t);
+}
+
+bool paged_triangle_mesh_mapped_loader::is_open() const {
+    return m_file->is_open() && m_compatible;
+}
+
+void serialize(paged_triangle_mesh_mapped_loader &loader,
+               paged_triangle_mesh &paged_tri_mesh) {
+    EDYN_ASSERT(loader.is_open());
+
+    auto archive = mapped_input_archive(loader.m_file->data(), loader.m_file->size());
+    auto header = mapped_paged_triangle_mesh_header{};
+    archive(header);
+
+    // The tree references the mapping. Like the submeshes, it holds a
+    // reference to it, since the loader could be destroyed first.
+    auto tree = std::shared_ptr<static_tree>(new static_tree, [file = loader.m_file] (static_tree *ptr) {
+        delete ptr;
+    });
+    archive(*tree);
+    paged_tri_mesh.m_tree = tree;
+
+    size_t num_submeshes;
+    archive(num_submeshes);
+    paged_tri_mesh.m_cache.resize(num_submeshes);
+
+    for (size_t i = 0; i < num_submeshes; ++i) {
+        auto &entry = paged_tri_mesh.m_cache[i];
+        archive(entry.num_vertices);
+        archive(entry.num_indices);
+    }
+
+    loader.m_offsets.resize(num_submeshes);
+
+    for (size_t i = 0; i < num_submeshes; ++i) {
+        archive(loader.m_offsets[i]);
+    }
+
+    paged_tri_mesh.init_cache_state();
+}
+
+void paged_triangle_mesh_mapped_loader::load(size_t index) {
+    EDYN_ASSERT(index < m_offsets.size());
+    auto begin = m_offsets[index];
+    auto end = index + 1 < m_offsets.size() ? m_offsets[index + 1] : m_file->size();
+
+    // The submesh holds a reference to the mapping, which thus stays valid
+    // while the submesh is in use, even after this loader is destroyed.
+    auto mesh = std::shared_ptr<triangle_mesh>(new triangle_mesh, [file = m_file] (triangle_mesh *ptr) {
+        delete ptr;
+    });
+
+    auto archive = mapped_input_archive(m_file->data() + begin, end - begin);
+    serialize(archive, *mesh);
+
+    m_loaded_signal.publish(index, mesh);
+}
+
+}
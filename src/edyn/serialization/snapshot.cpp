@@ -0,0 +1,74 @@
+#include "edyn/serialization/snapshot.hpp"
+#include "edyn/comp/island.hpp"
+#include <array>
+#include <iterator>
+#include <algorithm>
+
+namespace edyn::detail {
+
+static auto shared_component_ids() {
+    return std::apply([] (auto ... c) {
+        return std::array<entt::id_type, sizeof...(c)>{entt::type_seq<decltype(c)>::value()...};
+    }, shared_components);
+}
+
+void continuous_to_snapshot(continuous &cont) {
+    static const auto ids = shared_component_ids();
+    size_t size = 0;
+
+    for (size_t i = 0; i < cont.size; ++i) {
+        auto it = std::find(ids.begin(), ids.end(), cont.types[i]);
+
+        if (it != ids.end()) {
+            cont.types[size++] = static_cast<entt::id_type>(std::distance(ids.begin(), it));
+        }
+    }
+
+    cont.size = size;
+}
+
+void continuous_from_snapshot(continuous &cont) {
+    static const auto ids = shared_component_ids();
+    size_t size = 0;
+
+    for (size_t i = 0; i < cont.size; ++i) {
+        if (cont.types[i] < ids.size()) {
+            cont.types[size++] = ids[cont.types[i]];
+        }
+    }
+
+    cont.size = size;
+}
+
+void load_snapshot_graph(entt::registry &registry,
+                         const std::vector<entt::entity> &node_entities,
+                         const std::vector<entt::entity> &edge_entities,
+                         const std::vector<entt::entity> &edge_node_entities) {
+    auto &graph = registry.ctx<entity_graph>();
+    auto procedural_view = registry.view<procedural_tag>();
+
+    // Contact points are not part of the graph. They reside in the island of
+    // their contact manifold, which is assigned when the island is created.
+    for (auto entity : registry.view<contact_point>()) {
+        if (!registry.all_of<island_resident>(entity)) {
+            registry.emplace<island_resident>(entity);
+        }
+    }
+
+    // The island coordinator assigns the new nodes and edges to new islands
+    // in the next update.
+    for (auto entity : node_entities) {
+        auto non_connecting = !procedural_view.contains(entity);
+        auto node_index = graph.insert_node(entity, non_connecting);
+        registry.emplace<graph_node>(entity, node_index);
+    }
+
+    for (size_t i = 0; i < edge_entities.size(); ++i) {
+        auto &node0 = registry.get<graph_node>(edge_node_entities[i * 2]);
+        auto &node1 = registry.get<graph_node>(edge_node_entities[i * 2 + 1]);
+        auto edge_index = graph.insert_edge(edge_entities[i], node0.node_index, node1.node_index);
+        registry.emplace<graph_edge>(edge_entities[i], edge_index);
+    }
+}
+
+}
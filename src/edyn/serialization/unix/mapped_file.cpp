@@ -0,0 +1,49 @@
+#include "edyn/serialization/mapped_file.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace edyn {
+
+bool mapped_file::open(const std::string &path) {
+    close();
+
+    auto fd = ::open(path.c_str(), O_RDONLY);
+
+    if (fd == -1) {
+        return false;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) == -1 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    auto size = static_cast<size_t>(st.st_size);
+    auto *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping remains valid after the file descriptor is closed.
+    ::close(fd);
+
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    m_data = static_cast<const uint8_t *>(data);
+    m_size = size;
+
+    return true;
+}
+
+void mapped_file::close() {
+    if (m_data) {
+        munmap(const_cast<uint8_t *>(m_data), m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
+
+}
@@ -10,6 +10,7 @@ void convex_mesh::initialize() {
     shift_to_centroid();
     calculate_normals();
     calculate_edges();
+    calculate_adjacency();
 
 #ifdef EDYN_DEBUG
     validate();
@@ -77,10 +78,12 @@ void convex_mesh::calculate_normals() {
 
 void convex_mesh::calculate_edges() {
     edges.clear();
+    edge_faces.clear();
 
     for (size_t i = 0; i < num_faces(); ++i) {
         const auto first = faces[i * 2];
         const auto count = faces[i * 2 + 1];
+        const auto face_idx = static_cast<uint16_t>(i);
 
         for (size_t j = 0; j < count; ++j) {
             auto contains = false;
@@ -90,6 +93,8 @@ void convex_mesh::calculate_edges() {
             for (size_t k = 0; k < edges.size(); k += 2) {
                 if ((edges[k] == i0 && edges[k + 1] == i1) ||
                     (edges[k] == i1 && edges[k + 1] == i0)) {
+                    // Second face sharing this edge.
+                    edge_faces[k + 1] = face_idx;
                     contains = true;
                     break;
                 }
@@ -98,11 +103,90 @@ void convex_mesh::calculate_edges() {
             if (!contains) {
                 edges.push_back(i0);
                 edges.push_back(i1);
+                edge_faces.push_back(face_idx);
+                edge_faces.push_back(face_idx);
             }
         }
     }
 }
 
+void convex_mesh::calculate_adjacency() {
+    // Count neighbors of each vertex then write them in place using the
+    // prefix sum of the counts as offsets.
+    adjacency_offsets.assign(vertices.size() + 1, 0);
+
+    for (auto idx : edges) {
+        ++adjacency_offsets[idx + 1];
+    }
+
+    for (size_t i = 1; i < adjacency_offsets.size(); ++i) {
+        adjacency_offsets[i] += adjacency_offsets[i - 1];
+    }
+
+    adjacency.resize(edges.size());
+    auto cursor = std::vector<uint32_t>(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+
+    for (size_t i = 0; i < edges.size(); i += 2) {
+        auto i0 = edges[i];
+        auto i1 = edges[i + 1];
+        adjacency[cursor[i0]++] = i1;
+        adjacency[cursor[i1]++] = i0;
+    }
+}
+
+uint16_t convex_mesh::support_vertex_index(const std::vector<vector3> &points,
+                                           const vector3 &dir, uint16_t start) const {
+    EDYN_ASSERT(points.size() == vertices.size());
+    EDYN_ASSERT(start < points.size());
+
+    // Linear search if adjacency isn't available.
+    if (adjacency_offsets.size() != points.size() + 1) {
+        uint16_t sup_idx = 0;
+        auto max_proj = -EDYN_SCALAR_MAX;
+
+        for (size_t i = 0; i < points.size(); ++i) {
+            auto proj = dot(points[i], dir);
+
+            if (proj > max_proj) {
+                max_proj = proj;
+                sup_idx = static_cast<uint16_t>(i);
+            }
+        }
+
+        return sup_idx;
+    }
+
+    // Move to the neighbor with greatest projection until no neighbor is
+    // further along the direction. Since the mesh is convex, a local maximum
+    // is also the global maximum.
+    auto current = start;
+    auto max_proj = dot(points[current], dir);
+
+    while (true) {
+        auto next = current;
+        auto begin = adjacency_offsets[current];
+        auto end = adjacency_offsets[current + 1];
+
+        for (auto i = begin; i < end; ++i) {
+            auto neighbor = adjacency[i];
+            auto proj = dot(points[neighbor], dir);
+
+            if (proj > max_proj) {
+                max_proj = proj;
+                next = neighbor;
+            }
+        }
+
+        if (next == current) {
+            break;
+        }
+
+        current = next;
+    }
+
+    return current;
+}
+
 #ifdef EDYN_DEBUG
 void convex_mesh::validate() const {
     // Check if all faces are flat.
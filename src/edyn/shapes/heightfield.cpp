@@ -0,0 +1,400 @@
+#include "edyn/shapes/heightfield.hpp"
+#include "edyn/shapes/triangle_mesh.hpp"
+#include <limits>
+#include <memory>
+#include <cstdint>
+
+namespace edyn {
+
+heightfield::heightfield(size_t num_rows, size_t num_columns, scalar cell_size,
+                         const std::vector<scalar> &heights, const vector3 &origin)
+    : m_num_rows(static_cast<uint32_t>(num_rows))
+    , m_num_columns(static_cast<uint32_t>(num_columns))
+    , m_cell_size(cell_size)
+    , m_origin(origin)
+{
+    EDYN_ASSERT(num_rows > 1 && num_columns > 1);
+    EDYN_ASSERT(heights.size() == num_rows * num_columns);
+    EDYN_ASSERT(cell_size > 0);
+
+    auto [min_it, max_it] = std::minmax_element(heights.begin(), heights.end());
+    m_min_height = *min_it;
+
+    constexpr auto max_quantized = scalar(std::numeric_limits<height_type>::max());
+    auto range = *max_it - *min_it;
+    m_height_scale = range > EDYN_EPSILON ? range / max_quantized : scalar(1);
+
+    m_heights.reserve(heights.size());
+
+    for (auto h : heights) {
+        auto q = std::round((h - m_min_height) / m_height_scale);
+        m_heights.push_back(static_cast<height_type>(std::clamp(q, scalar(0), max_quantized)));
+    }
+
+    auto [qmin_it, qmax_it] = std::minmax_element(m_heights.begin(), m_heights.end());
+    m_aabb.min = m_origin + vector3{0, m_min_height + m_height_scale * *qmin_it, 0};
+    m_aabb.max = m_origin + vector3{(m_num_columns - 1) * m_cell_size,
+                                    m_min_height + m_height_scale * *qmax_it,
+                                    (m_num_rows - 1) * m_cell_size};
+}
+
+void heightfield::set_materials(const std::vector<material_type> &indices,
+                                const std::vector<material> &materials) {
+    EDYN_ASSERT(indices.empty() || indices.size() == num_triangles() / 2);
+    EDYN_ASSERT(std::all_of(indices.begin(), indices.end(), [&] (auto index) {
+        return index < materials.size();
+    }));
+    m_materials = indices;
+    m_material_table = materials;
+}
+
+triangle_vertices heightfield::get_triangle_vertices(size_t tri_idx) const {
+    size_t row, column, side;
+    get_triangle_cell(tri_idx, row, column, side);
+
+    auto v00 = get_vertex_position(row, column);
+    auto v11 = get_vertex_position(row + 1, column + 1);
+
+    if (side == 0) {
+        return {v00, get_vertex_position(row + 1, column), v11};
+    } else {
+        return {v00, v11, get_vertex_position(row, column + 1)};
+    }
+}
+
+vector3 heightfield::get_triangle_normal(size_t tri_idx) const {
+    auto vertices = get_triangle_vertices(tri_idx);
+    auto e0 = vertices[1] - vertices[0];
+    auto e1 = vertices[2] - vertices[1];
+    return normalize(cross(e0, e1));
+}
+
+bool heightfield::get_cell_range(const AABB &aabb, size_t &row_begin, size_t &column_begin,
+                                 size_t &row_end, size_t &column_end) const {
+    auto inv_cell_size = scalar(1) / m_cell_size;
+    auto x_min = (aabb.min.x - m_origin.x) * inv_cell_size;
+    auto x_max = (aabb.max.x - m_origin.x) * inv_cell_size;
+    auto z_min = (aabb.min.z - m_origin.z) * inv_cell_size;
+    auto z_max = (aabb.max.z - m_origin.z) * inv_cell_size;
+    auto num_cells_x = scalar(m_num_columns - 1);
+    auto num_cells_z = scalar(m_num_rows - 1);
+
+    if (x_max < 0 || z_max < 0 || x_min > num_cells_x || z_min > num_cells_z) {
+        return false;
+    }
+
+    auto to_cell = [] (scalar coord, scalar num_cells) {
+        return static_cast<size_t>(std::clamp(std::floor(coord), scalar(0), num_cells - 1));
+    };
+
+    column_begin = to_cell(x_min, num_cells_x);
+    column_end = to_cell(x_max, num_cells_x);
+    row_begin = to_cell(z_min, num_cells_z);
+    row_end = to_cell(z_max, num_cells_z);
+
+    return true;
+}
+
+void heightfield::get_cell_height_range(size_t row, size_t column,
+                                        scalar &min_height, scalar &max_height) const {
+    EDYN_ASSERT(row + 1 < m_num_rows && column + 1 < m_num_columns);
+    auto *h0 = &m_heights[row * m_num_columns + column];
+    auto *h1 = h0 + m_num_columns;
+    auto qmin = std::min(std::min(h0[0], h0[1]), std::min(h1[0], h1[1]));
+    auto qmax = std::max(std::max(h0[0], h0[1]), std::max(h1[0], h1[1]));
+    min_height = m_origin.y + m_min_height + m_height_scale * qmin;
+    max_height = m_origin.y + m_min_height + m_height_scale * qmax;
+}
+
+bool heightfield::intersects_cells(const AABB &aabb, size_t row_begin, size_t column_begin,
+                                   size_t row_end, size_t column_end) const {
+    auto qmin = std::numeric_limits<height_type>::max();
+    auto qmax = std::numeric_limits<height_type>::min();
+
+    for (auto row = row_begin; row <= row_end + 1; ++row) {
+        for (auto column = column_begin; column <= column_end + 1; ++column) {
+            auto q = m_heights[row * m_num_columns + column];
+            qmin = std::min(qmin, q);
+            qmax = std::max(qmax, q);
+        }
+    }
+
+    return aabb.max.y >= m_origin.y + m_min_height + m_height_scale * qmin &&
+           aabb.min.y <= m_origin.y + m_min_height + m_height_scale * qmax;
+}
+
+void heightfield::get_tile_cell_range(size_t tile_idx, size_t &row_begin, size_t &column_begin,
+                                      size_t &row_end, size_t &column_end) const {
+    EDYN_ASSERT(tile_idx < num_tiles());
+    row_begin = tile_idx / num_tile_columns() * tile_size;
+    column_begin = tile_idx % num_tile_columns() * tile_size;
+    row_end = std::min(row_begin + tile_size, size_t(m_num_rows - 1)) - 1;
+    column_end = std::min(column_begin + tile_size, size_t(m_num_columns - 1)) - 1;
+}
+
+void heightfield::build_tile_patch(size_t tile_idx, triangle_mesh &mesh) const {
+    EDYN_ASSERT(mesh.num_triangles() == 0);
+    size_t row_begin, column_begin, row_end, column_end;
+    get_tile_cell_range(tile_idx, row_begin, column_begin, row_end, column_end);
+    build_patch(row_begin, column_begin, row_end, column_end, mesh);
+}
+
+size_t heightfield::get_tile_triangle_index(size_t tile_idx, size_t patch_tri_idx) const {
+    size_t row_begin, column_begin, row_end, column_end;
+    get_tile_cell_range(tile_idx, row_begin, column_begin, row_end, column_end);
+
+    auto num_columns = column_end - column_begin + 1;
+    auto cell_idx = patch_tri_idx / 2;
+    auto row = row_begin + cell_idx / num_columns;
+    auto column = column_begin + cell_idx % num_columns;
+    EDYN_ASSERT(row <= row_end);
+
+    return get_cell_triangle_index(row, column) + patch_tri_idx % 2;
+}
+
+size_t heightfield::get_adjacent_triangle_index(size_t tri_idx, size_t edge_idx) const {
+    EDYN_ASSERT(edge_idx < 3);
+    size_t row, column, side;
+    get_triangle_cell(tri_idx, row, column, side);
+
+    // The diagonal is shared by both triangles of a cell. The other edges
+    // are shared with the opposite triangle of a neighboring cell.
+    if ((side == 0 && edge_idx == 2) || (side == 1 && edge_idx == 0)) {
+        return tri_idx ^ 1;
+    }
+
+    if (side == 0) {
+        if (edge_idx == 0) {
+            return column > 0 ? get_cell_triangle_index(row, column - 1) + 1 : SIZE_MAX;
+        }
+
+        return row + 2 < m_num_rows ? get_cell_triangle_index(row + 1, column) + 1 : SIZE_MAX;
+    }
+
+    if (edge_idx == 1) {
+        return column + 2 < m_num_columns ? get_cell_triangle_index(row, column + 1) : SIZE_MAX;
+    }
+
+    return row > 0 ? get_cell_triangle_index(row - 1, column) : SIZE_MAX;
+}
+
+void heightfield::build_patch(size_t row_begin, size_t column_begin,
+                              size_t row_end, size_t column_end,
+                              triangle_mesh &mesh) const {
+    using index_type = triangle_mesh::index_type;
+    const auto R = static_cast<index_type>(row_end - row_begin + 1);
+    const auto C = static_cast<index_type>(column_end - column_begin + 1);
+
+    auto vertex_index = [C] (index_type r, index_type c) {
+        return r * (C + 1) + c;
+    };
+
+    mesh.m_vertices.reserve((R + 1) * (C + 1));
+
+    for (index_type r = 0; r <= R; ++r) {
+        for (index_type c = 0; c <= C; ++c) {
+            mesh.m_vertices.push_back(get_vertex_position(row_begin + r, column_begin + c));
+        }
+    }
+
+    // Same triangulation as `get_triangle_vertices`.
+    mesh.m_indices.reserve(R * C * 2);
+
+    for (index_type r = 0; r < R; ++r) {
+        for (index_type c = 0; c < C; ++c) {
+            auto v00 = vertex_index(r, c);
+            auto v01 = vertex_index(r, c + 1);
+            auto v10 = vertex_index(r + 1, c);
+            auto v11 = vertex_index(r + 1, c + 1);
+            mesh.m_indices.push_back({v00, v10, v11});
+            mesh.m_indices.push_back({v00, v11, v01});
+        }
+    }
+
+    mesh.calculate_face_normals();
+
+    // The edges are derived from the grid topology instead of searching for
+    // shared edges. Horizontal edges (along x) come first, followed by the
+    // vertical edges (along z) and then the diagonals.
+    const auto num_horizontal = (R + 1) * C;
+    const auto num_vertical = R * (C + 1);
+    const auto num_diagonal = R * C;
+    const auto num_edges = num_horizontal + num_vertical + num_diagonal;
+
+    auto horizontal_edge = [C] (index_type r, index_type c) {
+        return r * C + c;
+    };
+    auto vertical_edge = [=] (index_type r, index_type c) {
+        return num_horizontal + r * (C + 1) + c;
+    };
+    auto diagonal_edge = [=] (index_type r, index_type c) {
+        return num_horizontal + num_vertical + r * C + c;
+    };
+
+    mesh.m_edge_vertex_indices.resize(num_edges);
+
+    for (index_type r = 0; r <= R; ++r) {
+        for (index_type c = 0; c <= C; ++c) {
+            if (c < C) {
+                mesh.m_edge_vertex_indices[horizontal_edge(r, c)] = {vertex_index(r, c), vertex_index(r, c + 1)};
+            }
+            if (r < R) {
+                mesh.m_edge_vertex_indices[vertical_edge(r, c)] = {vertex_index(r, c), vertex_index(r + 1, c)};
+            }
+            if (r < R && c < C) {
+                mesh.m_edge_vertex_indices[diagonal_edge(r, c)] = {vertex_index(r, c), vertex_index(r + 1, c + 1)};
+            }
+        }
+    }
+
+    constexpr auto idx_max = std::numeric_limits<index_type>::max();
+    mesh.m_face_edge_indices.resize(R * C * 2);
+    mesh.m_edge_face_indices.assign(num_edges, {idx_max, idx_max});
+
+    auto assign_edge_face = [&] (index_type edge_idx, index_type face_idx) {
+        auto &edge_face_indices = mesh.m_edge_face_indices[edge_idx];
+
+        if (edge_face_indices[0] == idx_max) {
+            edge_face_indices[0] = face_idx;
+        } else {
+            edge_face_indices[1] = face_idx;
+        }
+    };
+
+    for (index_type r = 0; r < R; ++r) {
+        for (index_type c = 0; c < C; ++c) {
+            auto face_idx = (r * C + c) * 2;
+            // Edge `i` connects the i-th and (i+1)-th vertices of a face.
+            mesh.m_face_edge_indices[face_idx] = {vertical_edge(r, c), horizontal_edge(r + 1, c), diagonal_edge(r, c)};
+            mesh.m_face_edge_indices[face_idx + 1] = {diagonal_edge(r, c), vertical_edge(r, c + 1), horizontal_edge(r, c)};
+
+            for (index_type i = 0; i < 2; ++i) {
+                for (auto edge_idx : mesh.m_face_edge_indices[face_idx + i]) {
+                    assign_edge_face(edge_idx, face_idx + i);
+                }
+            }
+        }
+    }
+
+    mesh.m_is_boundary_edge.resize(num_edges);
+
+    for (index_type edge_idx = 0; edge_idx < num_edges; ++edge_idx) {
+        auto &edge_face_indices = mesh.m_edge_face_indices[edge_idx];
+        auto is_boundary_edge = edge_face_indices[1] == idx_max;
+        mesh.m_is_boundary_edge[edge_idx] = is_boundary_edge;
+
+        if (is_boundary_edge) {
+            edge_face_indices[1] = edge_face_indices[0];
+        }
+    }
+
+    mesh.calculate_edge_convexity();
+
+    // Edges on the border of the range which are shared with cells outside
+    // of it take the normal of the triangle on the other side. Otherwise,
+    // they would be treated as boundary edges and generate bogus contact
+    // normals.
+    for (index_type r = 0; r < R; ++r) {
+        for (index_type c = 0; c < C; ++c) {
+            for (index_type i = 0; i < 2; ++i) {
+                auto face_idx = (r * C + c) * 2 + i;
+                auto tri_idx = get_cell_triangle_index(row_begin + r, column_begin + c) + i;
+
+                for (index_type j = 0; j < 3; ++j) {
+                    auto edge_idx = mesh.m_face_edge_indices[face_idx][j];
+
+                    if (!mesh.m_is_boundary_edge[edge_idx]) {
+                        continue;
+                    }
+
+                    auto other_tri_idx = get_adjacent_triangle_index(tri_idx, j);
+
+                    if (other_tri_idx == SIZE_MAX) {
+                        continue;
+                    }
+
+                    // Same as `triangle_mesh::compute_edge_convexity`.
+                    auto other_normal = get_triangle_normal(other_tri_idx);
+                    auto &indices = mesh.m_indices[face_idx];
+                    auto edge_dir = mesh.m_vertices[indices[(j + 1) % 3]] - mesh.m_vertices[indices[j]];
+                    auto edge_normal = cross(mesh.get_triangle_normal(face_idx), edge_dir);
+                    mesh.m_is_convex_edge[edge_idx] = dot(other_normal, edge_normal) < -EDYN_EPSILON;
+                    mesh.set_external_adjacent_normal(face_idx, j, other_normal);
+                }
+            }
+        }
+    }
+
+    mesh.build_triangle_tree();
+}
+
+const material * heightfield::get_material(const vector3 &point) const {
+    if (m_materials.empty()) {
+        return nullptr;
+    }
+
+    auto inv_cell_size = scalar(1) / m_cell_size;
+    auto x = (point.x - m_origin.x) * inv_cell_size;
+    auto z = (point.z - m_origin.z) * inv_cell_size;
+    auto column = static_cast<size_t>(std::clamp(std::floor(x), scalar(0), scalar(m_num_columns - 2)));
+    auto row = static_cast<size_t>(std::clamp(std::floor(z), scalar(0), scalar(m_num_rows - 2)));
+    auto index = m_materials[row * (m_num_columns - 1) + column];
+    EDYN_ASSERT(index < m_material_table.size());
+
+    return &m_material_table[index];
+}
+
+// A patch which was built recently in the current thread.
+struct heightfield_patch_entry {
+    std::weak_ptr<heightfield> field;
+    size_t tile_idx;
+    std::shared_ptr<const triangle_mesh> patch;
+    uint64_t last_use;
+};
+
+// Enough for the tiles under a few bodies, since one body overlaps at most
+// four tiles unless it is larger than a tile.
+static constexpr size_t max_cached_heightfield_patches = 16;
+
+std::shared_ptr<const triangle_mesh> get_heightfield_patch(const std::shared_ptr<heightfield> &field,
+                                                           size_t tile_idx) {
+    static thread_local std::vector<heightfield_patch_entry> cache;
+    static thread_local uint64_t use_count {0};
+    ++use_count;
+
+    for (auto &entry : cache) {
+        // Compare control blocks, since another heightfield could have been
+        // allocated at the address of an expired one.
+        if (entry.tile_idx != tile_idx ||
+            entry.field.owner_before(field) || field.owner_before(entry.field) ||
+            entry.field.expired()) {
+            continue;
+        }
+
+        entry.last_use = use_count;
+        return entry.patch;
+    }
+
+    auto entry = heightfield_patch_entry{};
+    entry.field = field;
+    entry.tile_idx = tile_idx;
+    entry.last_use = use_count;
+
+    auto patch = std::make_shared<triangle_mesh>();
+    field->build_tile_patch(tile_idx, *patch);
+    entry.patch = patch;
+
+    if (cache.size() < max_cached_heightfield_patches) {
+        cache.push_back(std::move(entry));
+    } else {
+        // Replace least recently used patch.
+        auto lru = std::min_element(cache.begin(), cache.end(), [] (auto &lhs, auto &rhs) {
+            return lhs.last_use < rhs.last_use;
+        });
+        *lru = std::move(entry);
+    }
+
+    return patch;
+}
+
+}
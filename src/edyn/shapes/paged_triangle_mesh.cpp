@@ -1,93 +1,264 @@
 #include "edyn/shapes/paged_triangle_mesh.hpp"
-#include "edyn/parallel/parallel_for.hpp"
 #include <atomic>
-#include <limits>
+#include <algorithm>
 #include <mutex>
 #include <entt/entity/registry.hpp>
 
 namespace edyn {
 
 paged_triangle_mesh::paged_triangle_mesh(std::shared_ptr<triangle_mesh_page_loader_base> loader)
-    : m_page_loader(loader)
+    : m_tree(std::make_shared<static_tree>())
+    , m_page_loader(loader)
 {
     m_page_loader->on_load_sink().connect<&paged_triangle_mesh::assign_mesh>(*this);
 }
 
-size_t paged_triangle_mesh::cache_num_vertices() const {
-    size_t count = 0;
+void paged_triangle_mesh::init_cache_state() {
+    auto num_submeshes = m_cache.size();
+    m_is_loading_submesh = std::make_unique<std::atomic<bool>[]>(num_submeshes);
+    m_recently_visited = std::make_unique<std::atomic<bool>[]>(num_submeshes);
+    m_clock_hand = 0;
+
+    size_t size = 0;
 
     for (auto &node : m_cache) {
-        if (!node.trimesh) {
-            continue;
+        if (node.trimesh) {
+            size += node.trimesh->memory_size();
         }
-
-        count += node.num_vertices;
     }
 
-    return count;
+    m_cache_size.store(size, std::memory_order_relaxed);
 }
 
-void paged_triangle_mesh::load_node_if_needed(size_t trimesh_idx) {
+void paged_triangle_mesh::load_node_if_needed(size_t trimesh_idx, bool blocking) {
     EDYN_ASSERT(m_is_loading_submesh && trimesh_idx < m_cache.size());
     auto already_loading = m_is_loading_submesh[trimesh_idx].exchange(true, std::memory_order_relaxed);
 
-    if (already_loading) {
+    // A blocking load does not wait for a pending asynchronous load of the
+    // same submesh. It loads it again instead and the first one to finish
+    // is replaced by the second, which has the same contents.
+    if (already_loading && !blocking) {
         return;
     }
 
-    auto &node = m_cache[trimesh_idx];
-
-    if (node.trimesh) {
-        m_is_loading_submesh[trimesh_idx].store(false, std::memory_order_relaxed);
+    if (get_submesh(trimesh_idx)) {
+        if (!already_loading) {
+            m_is_loading_submesh[trimesh_idx].store(false, std::memory_order_relaxed);
+        }
         return;
     }
 
-    EDYN_ASSERT(node.num_vertices < m_max_cache_num_vertices);
-    // Load triangle mesh into cache. Clear cache if it would go
-    // above limits.
-    while (cache_num_vertices() + node.num_vertices > m_max_cache_num_vertices) {
-        unload_least_recently_visited_node();
+    // The cache is trimmed to fit the budget once the submesh is assigned,
+    // when its size is known.
+    if (blocking) {
+        m_page_loader->load_blocking(trimesh_idx);
+    } else {
+        m_page_loader->load(trimesh_idx);
+    }
+}
+
+static scalar aabb_distance_sqr(const AABB &b0, const AABB &b1) {
+    auto gap = max(max(b0.min - b1.max, b1.min - b0.max), vector3_zero);
+    return length_sqr(gap);
+}
+
+void paged_triangle_mesh::prefetch(const std::vector<prefetch_region> &regions) {
+    // Pairs of squared distance and submesh index.
+    auto candidates = std::vector<std::pair<scalar, size_t>>{};
+    auto tree = get_tree();
+
+    for (auto &region : regions) {
+        auto swept_aabb = enclosing_aabb(region.aabb, {
+            region.aabb.min + region.displacement,
+            region.aabb.max + region.displacement
+        });
+
+        tree->query(swept_aabb, [&] (auto tree_node_idx) {
+            auto node = tree->get_node(tree_node_idx);
+
+            if (!get_submesh(node.id) &&
+                !m_is_loading_submesh[node.id].load(std::memory_order_relaxed)) {
+                candidates.emplace_back(aabb_distance_sqr(region.aabb, node.aabb), node.id);
+            }
+        });
+    }
+
+    // Sort by distance and index so that the closest occurrence of each
+    // submesh comes first.
+    std::sort(candidates.begin(), candidates.end());
+
+    for (auto &[dist_sqr, mesh_idx] : candidates) {
+        // Repeated submeshes are skipped since they're loading already.
+        load_node_if_needed(mesh_idx);
     }
+}
 
-    m_page_loader->load(trimesh_idx);
+void paged_triangle_mesh::load_blocking(const AABB &aabb) {
+    auto tree = get_tree();
+    tree->query(aabb, [&] (auto tree_node_idx) {
+        auto mesh_idx = tree->get_node(tree_node_idx).id;
+
+        if (!get_submesh(mesh_idx)) {
+            load_node_if_needed(mesh_idx, true);
+        }
+    });
 }
 
 void paged_triangle_mesh::mark_recent_visit(size_t trimesh_idx) {
-    auto lock = std::lock_guard(m_lru_mutex);
-    auto it = std::find(m_lru_indices.begin(), m_lru_indices.end(), trimesh_idx);
-    std::rotate(m_lru_indices.begin(), it, it + 1);
+    // Check before storing to avoid writing to a cache line shared among
+    // threads in the common case where the flag is already set.
+    auto &visited = m_recently_visited[trimesh_idx];
+
+    if (!visited.load(std::memory_order_relaxed)) {
+        visited.store(true, std::memory_order_relaxed);
+    }
 }
 
-void paged_triangle_mesh::unload_least_recently_visited_node() {
-    auto lock = std::lock_guard(m_lru_mutex);
+bool paged_triangle_mesh::unload_least_recently_visited_node(size_t except_idx) {
+    // Must be called with `m_cache_mutex` locked. Two turns of the clock are
+    // enough to find a submesh since the first clears all flags.
+    auto num_submeshes = m_cache.size();
 
-    for (auto it = m_lru_indices.rbegin(); it != m_lru_indices.rend(); ++it) {
-        auto &node = m_cache[*it];
-        if (node.trimesh) {
-            node.trimesh.reset();
-            break;
+    for (size_t i = 0; i < 2 * num_submeshes; ++i) {
+        auto idx = m_clock_hand;
+        m_clock_hand = (m_clock_hand + 1) % num_submeshes;
+
+        if (idx == except_idx || m_cache[idx].is_edited ||
+            m_recently_visited[idx].exchange(false, std::memory_order_relaxed)) {
+            continue;
+        }
+
+        auto trimesh = std::atomic_exchange(&m_cache[idx].trimesh, std::shared_ptr<triangle_mesh>{});
+
+        if (trimesh) {
+            m_cache_size.fetch_sub(trimesh->memory_size(), std::memory_order_relaxed);
+            m_num_evictions.fetch_add(1, std::memory_order_release);
+            return true;
         }
     }
+
+    return false;
 }
 
 triangle_vertices paged_triangle_mesh::get_triangle_vertices(size_t mesh_idx, size_t tri_idx) {
     EDYN_ASSERT(mesh_idx < m_cache.size());
-    EDYN_ASSERT(m_cache[mesh_idx].trimesh);
-    return m_cache[mesh_idx].trimesh->get_triangle_vertices(tri_idx);
+    auto trimesh = get_submesh(mesh_idx);
+    EDYN_ASSERT(trimesh);
+    return trimesh->get_triangle_vertices(tri_idx);
 }
 
 void paged_triangle_mesh::clear_cache() {
-    for (auto &node : m_cache) {
-        node.trimesh.reset();
+    auto lock = std::lock_guard(m_cache_mutex);
+
+    for (size_t idx = 0; idx < m_cache.size(); ++idx) {
+        std::atomic_store(&m_cache[idx].trimesh, std::shared_ptr<triangle_mesh>{});
+        m_cache[idx].is_edited = false;
+        m_recently_visited[idx].store(false, std::memory_order_relaxed);
     }
+
+    m_clock_hand = 0;
+    m_cache_size.store(0, std::memory_order_relaxed);
+    m_num_evictions.fetch_add(1, std::memory_order_release);
+}
+
+void paged_triangle_mesh::set_max_cache_size(size_t size) {
+    auto lock = std::lock_guard(m_cache_mutex);
+    m_max_cache_size.store(size, std::memory_order_relaxed);
+
+    // No submesh is spared, thus pass an invalid index.
+    while (m_cache_size.load(std::memory_order_relaxed) > size &&
+           unload_least_recently_visited_node(m_cache.size()));
 }
 
 void paged_triangle_mesh::assign_mesh(size_t index, std::shared_ptr<triangle_mesh> mesh) {
-    // Use lock to prevent assigning to the same trimesh shared_ptr concurrently
-    // if `unload_least_recently_visited_node` is executing in another thread.
-    auto lock = std::lock_guard(m_lru_mutex);
-    m_cache[index].trimesh = mesh;
+    // Lock to keep the cache size consistent with its contents, since meshes
+    // can be assigned from multiple loading jobs concurrently.
+    auto lock = std::lock_guard(m_cache_mutex);
+
+    // A load of an edited submesh that was requested before the edit would
+    // revert it.
+    if (m_cache[index].is_edited) {
+        m_is_loading_submesh[index].store(false, std::memory_order_release);
+        return;
+    }
+
+    auto previous = std::atomic_exchange(&m_cache[index].trimesh, mesh);
+
+    // The same submesh might have been loaded twice if a blocking load was
+    // requested while it was being loaded asynchronously.
+    if (previous) {
+        m_cache_size.fetch_sub(previous->memory_size(), std::memory_order_relaxed);
+    }
+
+    m_cache_size.fetch_add(mesh->memory_size(), std::memory_order_relaxed);
+
+    // Give the new submesh a chance to be visited before it can be evicted.
+    m_recently_visited[index].store(true, std::memory_order_relaxed);
     m_is_loading_submesh[index].store(false, std::memory_order_release);
+
+    while (m_cache_size.load(std::memory_order_relaxed) > max_cache_size() &&
+           unload_least_recently_visited_node(index));
+}
+
+void paged_triangle_mesh::edit_submesh(size_t trimesh_idx, const triangle_mesh_edit &edit) {
+    EDYN_ASSERT(trimesh_idx < m_cache.size());
+
+    // The submesh is copied with the lock held, thus it cannot be replaced by
+    // a concurrent edit or load in the meantime, which would be lost. The lock
+    // also serializes concurrent edits, thus a refit tree includes the bounds
+    // of all previous edits.
+    auto lock = std::unique_lock(m_cache_mutex);
+    auto trimesh = get_submesh(trimesh_idx);
+
+    // Loaded submeshes are assigned with the lock held, thus it is released
+    // while loading. The submesh could be evicted again before the lock is
+    // reacquired, in which case it is loaded once more.
+    while (!trimesh) {
+        lock.unlock();
+        load_node_if_needed(trimesh_idx, true);
+        lock.lock();
+        trimesh = get_submesh(trimesh_idx);
+    }
+
+    auto edited = std::make_shared<triangle_mesh>(*trimesh);
+    edited->apply_edit(edit);
+
+    auto previous = std::atomic_exchange(&m_cache[trimesh_idx].trimesh, edited);
+    m_cache[trimesh_idx].is_edited = true;
+
+    if (previous) {
+        m_cache_size.fetch_sub(previous->memory_size(), std::memory_order_relaxed);
+    }
+
+    m_cache_size.fetch_add(edited->memory_size(), std::memory_order_relaxed);
+
+    // Bounds of each submesh as currently stored in the tree.
+    auto tree = get_tree();
+    auto submesh_aabbs = std::vector<AABB>(m_cache.size());
+
+    tree->query(tree->root_aabb(), [&] (auto tree_node_idx) {
+        auto node = tree->get_node(tree_node_idx);
+        submesh_aabbs[node.id] = node.aabb;
+    });
+
+    if (submesh_aabbs[trimesh_idx].contains(edited->get_aabb())) {
+        return;
+    }
+
+    // Other threads might be traversing the current tree, thus a copy is
+    // refit and replaces it. Use the exact bounds of loaded submeshes, since
+    // the bounds stored in the tree are slightly enlarged.
+    auto refit_tree = std::make_shared<static_tree>(*tree);
+
+    refit_tree->refit([&] (uint32_t &id) {
+        if (auto submesh = get_submesh(id)) {
+            return submesh->get_aabb();
+        }
+
+        return submesh_aabbs[id];
+    });
+
+    std::atomic_store(&m_tree, std::shared_ptr<const static_tree>(refit_tree));
 }
 
 }
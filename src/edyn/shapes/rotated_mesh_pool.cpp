@@ -0,0 +1,83 @@
+#include "edyn/shapes/rotated_mesh_pool.hpp"
+#include "edyn/sys/update_rotated_meshes.hpp"
+#include "edyn/config/constants.hpp"
+#include "edyn/config/config.h"
+#include <cmath>
+
+namespace edyn {
+
+static bool orientation_changed(const quaternion &q0, const quaternion &q1) {
+    return std::abs(q0.x - q1.x) > rotated_mesh_orientation_tolerance ||
+           std::abs(q0.y - q1.y) > rotated_mesh_orientation_tolerance ||
+           std::abs(q0.z - q1.z) > rotated_mesh_orientation_tolerance ||
+           std::abs(q0.w - q1.w) > rotated_mesh_orientation_tolerance;
+}
+
+rotated_mesh_pool::index_type rotated_mesh_pool::insert(const std::shared_ptr<convex_mesh> &mesh,
+                                                        const quaternion &orn,
+                                                        const quaternion &local_orn,
+                                                        index_type next) {
+    if (m_free == null_index) {
+        m_chunks.push_back(std::make_unique<slot[]>(chunk_size));
+
+        // Link the slots of the new chunk into the free list in order.
+        for (index_type i = 0; i < chunk_size; ++i) {
+            auto idx = m_capacity + i;
+            slot_at(idx).next = i + 1 < chunk_size ? idx + 1 : null_index;
+        }
+
+        m_free = m_capacity;
+        m_capacity += chunk_size;
+    }
+
+    auto index = m_free;
+    auto &s = slot_at(index);
+    m_free = s.next;
+
+    s.mesh = mesh;
+    s.local_orientation = local_orn;
+    s.orientation = orn;
+    s.next = next;
+
+    // Resizing a recycled slot reuses the memory of its previous mesh if
+    // it's large enough.
+    s.rotated.vertices.resize(mesh->vertices.size());
+    s.rotated.normals.resize(mesh->normals.size());
+    update_rotated_mesh(s.rotated, *mesh, orn * local_orn);
+
+    ++m_size;
+
+    return index;
+}
+
+void rotated_mesh_pool::erase(index_type index) {
+    while (index != null_index) {
+        auto &s = slot_at(index);
+        auto next = s.next;
+
+        // Release the mesh but keep the rotated arrays around for reuse.
+        s.mesh.reset();
+        s.next = m_free;
+        m_free = index;
+
+        EDYN_ASSERT(m_size > 0);
+        --m_size;
+
+        index = next;
+    }
+}
+
+void rotated_mesh_pool::update(index_type index, const quaternion &orn, bool force) {
+    while (index != null_index) {
+        auto &s = slot_at(index);
+
+        if (force || orientation_changed(s.orientation, orn)) {
+            s.orientation = orn;
+            update_rotated_mesh(s.rotated, *s.mesh, orn * s.local_orientation);
+        }
+
+        index = s.next;
+    }
+}
+
+}
@@ -1,32 +1,161 @@
 #include "edyn/shapes/triangle_mesh.hpp"
+#include "edyn/config/constants.hpp"
+#include "edyn/parallel/parallel_for.hpp"
+#include <algorithm>
+#include <functional>
 #include <limits>
-#include <set>
+#include <unordered_map>
 
 namespace edyn {
 
+// Meshes with fewer elements are processed in the calling thread, which avoids
+// the overhead of dispatching jobs. Meshes created on the fly from within a job,
+// such as submeshes of a paged mesh, are always processed in the calling thread,
+// since a worker must not block waiting on other jobs. Meshes can also be
+// created before the job dispatcher is started.
+static constexpr size_t min_parallel_count = 4096;
+
+static bool should_parallelize(size_t count) {
+    return count >= min_parallel_count && can_parallel_for();
+}
+
+template<typename Func>
+static void for_each_index(size_t count, Func func) {
+    if (should_parallelize(count)) {
+        parallel_for(size_t{0}, count, func);
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            func(i);
+        }
+    }
+}
+
+template<typename T>
+static size_t array_memory_size(const mappable_vector<T> &array) {
+    return array.size() * sizeof(T);
+}
+
+size_t triangle_mesh::memory_size() const {
+    return sizeof(*this) +
+        array_memory_size(m_vertices) +
+        array_memory_size(m_quantized_vertices) +
+        array_memory_size(m_indices) +
+        array_memory_size(m_normals) +
+        array_memory_size(m_external_adjacent_keys) +
+        array_memory_size(m_external_adjacent_normals) +
+        array_memory_size(m_edge_vertex_indices) +
+        array_memory_size(m_face_edge_indices) +
+        array_memory_size(m_edge_face_indices) +
+        array_memory_size(m_is_boundary_edge) +
+        array_memory_size(m_is_convex_edge) +
+        m_triangle_tree.memory_size();
+}
+
 void triangle_mesh::initialize() {
     // Order is important.
+    quantize_vertices();
     calculate_face_normals();
     init_edge_indices();
-    calculate_adjacent_normals();
+    calculate_edge_convexity();
     build_triangle_tree();
 }
 
-void triangle_mesh::calculate_face_normals() {
-    m_normals.reserve(m_indices.size());
+void triangle_mesh::quantize_vertices() {
+    if (m_vertices.empty()) {
+        return;
+    }
+
+    auto aabb = AABB{m_vertices.front(), m_vertices.front()};
+
+    for (auto &v : m_vertices) {
+        aabb.min = min(aabb.min, v);
+        aabb.max = max(aabb.max, v);
+    }
+
+    constexpr auto max_quantized = scalar(std::numeric_limits<uint16_t>::max());
+    auto extent = aabb.max - aabb.min;
+    auto scale = extent / max_quantized;
+
+    // Keep full precision if the error would be too large.
+    if (std::max({scale.x, scale.y, scale.z}) * scalar(0.5) > triangle_mesh_max_quantization_error) {
+        return;
+    }
+
+    m_quantization_origin = aabb.min;
+    m_quantization_scale = scale;
+    m_quantized_vertices.resize(m_vertices.size());
+
+    for_each_index(m_vertices.size(), [&] (size_t vertex_idx) {
+        m_quantized_vertices[vertex_idx] = quantize_position(m_vertices[vertex_idx]);
+    });
+
+    m_vertices.clear();
+    m_vertices.shrink_to_fit();
+}
+
+std::array<uint16_t, 3> triangle_mesh::quantize_position(const vector3 &position) const {
+    constexpr auto max_quantized = scalar(std::numeric_limits<uint16_t>::max());
+    auto q = std::array<uint16_t, 3>{};
+
+    for (size_t i = 0; i < 3; ++i) {
+        auto f = m_quantization_scale[i] > 0 ?
+            std::round((position[i] - m_quantization_origin[i]) / m_quantization_scale[i]) : scalar(0);
+        q[i] = static_cast<uint16_t>(std::clamp(f, scalar(0), max_quantized));
+    }
 
-    for (auto indices : m_indices) {
-        auto e0 = m_vertices[indices[1]] - m_vertices[indices[0]];
-        auto e1 = m_vertices[indices[2]] - m_vertices[indices[1]];
-        auto normal = normalize(cross(e0, e1));
-        m_normals.push_back(normal);
+    return q;
+}
+
+bool triangle_mesh::is_quantizable(const vector3 &position) const {
+    auto q = quantize_position(position);
+    auto decoded = m_quantization_origin +
+                   vector3{scalar(q[0]), scalar(q[1]), scalar(q[2])} * m_quantization_scale;
+
+    for (size_t i = 0; i < 3; ++i) {
+        if (std::abs(decoded[i] - position[i]) > triangle_mesh_max_quantization_error) {
+            return false;
+        }
     }
+
+    return true;
+}
+
+void triangle_mesh::dequantize_vertices() {
+    auto vertices = std::vector<vector3>(m_quantized_vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        vertices[i] = get_vertex_position(i);
+    }
+
+    m_vertices.assign(vertices.begin(), vertices.end());
+    m_quantized_vertices.clear();
+    m_quantized_vertices.shrink_to_fit();
+    m_quantization_origin = m_quantization_scale = vector3_zero;
+}
+
+void triangle_mesh::calculate_face_normals() {
+    m_normals.resize(m_indices.size());
+
+    for_each_index(m_indices.size(), [&] (size_t i) {
+        m_normals[i] = octahedral_encode(compute_face_normal(i));
+    });
+}
+
+vector3 triangle_mesh::compute_face_normal(size_t tri_idx) const {
+    auto vertices = get_triangle_vertices(tri_idx);
+    auto e0 = vertices[1] - vertices[0];
+    auto e1 = vertices[2] - vertices[1];
+    return normalize(cross(e0, e1));
 }
 
 void triangle_mesh::init_edge_indices() {
     constexpr auto idx_max = std::numeric_limits<index_type>::max();
     m_face_edge_indices.resize(m_indices.size());
-    auto vertex_edge_indices = std::vector<std::set<index_type>>(m_vertices.size());
+
+    // Map of vertex index pairs (smallest index in the upper 32 bits) to edge
+    // index. Edges are still numbered in the order they're first found.
+    auto edge_map = std::unordered_map<uint64_t, index_type>{};
+    edge_map.reserve(m_indices.size() * 3 / 2);
 
     for (size_t face_idx = 0; face_idx < m_indices.size(); ++face_idx) {
         auto indices = m_indices[face_idx];
@@ -35,25 +164,15 @@ void triangle_mesh::init_edge_indices() {
             auto j = (i + 1) % 3;
             auto i0 = indices[i];
             auto i1 = indices[j];
-            auto pair = commutative_pair(i0, i1);
-            auto edge_idx = SIZE_MAX;
-
-            for (size_t k = 0; k < m_edge_vertex_indices.size(); ++k) {
-                if (m_edge_vertex_indices[k] == pair) {
-                    edge_idx = k;
-                    break;
-                }
-            }
+            auto key = (uint64_t(std::min(i0, i1)) << 32) | uint64_t(std::max(i0, i1));
+            auto [it, inserted] = edge_map.emplace(key, static_cast<index_type>(m_edge_vertex_indices.size()));
+            auto edge_idx = it->second;
 
-            if (edge_idx == SIZE_MAX) {
-                edge_idx = m_edge_vertex_indices.size();
-                m_edge_vertex_indices.push_back(pair);
+            if (inserted) {
+                m_edge_vertex_indices.push_back(commutative_pair(i0, i1));
                 m_edge_face_indices.push_back({idx_max, idx_max});
             }
 
-            vertex_edge_indices[i0].insert(edge_idx);
-            vertex_edge_indices[i1].insert(edge_idx);
-
             m_face_edge_indices[face_idx][i] = edge_idx;
 
             auto &edge_face_indices = m_edge_face_indices[edge_idx];
@@ -66,14 +185,6 @@ void triangle_mesh::init_edge_indices() {
         }
     }
 
-    for (auto edge_indices : vertex_edge_indices) {
-        m_vertex_edge_indices.push_array();
-
-        for (auto edge_idx : edge_indices) {
-            m_vertex_edge_indices.push_back(edge_idx);
-        }
-    }
-
     m_is_boundary_edge.resize(m_edge_vertex_indices.size());
 
     // Edges with a single valid _edge face index_ are at the boundary.
@@ -92,63 +203,457 @@ void triangle_mesh::init_edge_indices() {
     }
 }
 
-void triangle_mesh::calculate_adjacent_normals() {
-    m_adjacent_normals.resize(m_indices.size());
-    m_is_convex_edge.resize(m_edge_vertex_indices.size());
+void triangle_mesh::calculate_edge_convexity() {
+    // Elements of a `std::vector<bool>` cannot be written concurrently.
+    auto is_convex_edge = std::vector<uint8_t>(m_edge_face_indices.size());
 
-    for (size_t face_idx = 0; face_idx < m_indices.size(); ++face_idx) {
-        for (size_t i = 0; i < 3; ++i) {
-            auto edge_idx = m_face_edge_indices[face_idx][i];
-            auto &edge_face_indices = m_edge_face_indices[edge_idx];
-            auto other_face_idx = edge_face_indices[0] == face_idx ? edge_face_indices[1] : edge_face_indices[0];
-
-            auto vertex_idx0 = m_indices[face_idx][i];
-            auto vertex_idx1 = m_indices[face_idx][(i + 1) % 3];
-            auto edge_dir = m_vertices[vertex_idx1] - m_vertices[vertex_idx0];
-            auto edge_normal = cross(m_normals[face_idx], edge_dir);
-
-            if (other_face_idx == face_idx) {
-                // This is a boundary edge. Make adjacent normal point slightly
-                // away in the edge direction to form a near 180 degree angle.
-                m_adjacent_normals[face_idx][i] = -normalize(m_normals[face_idx] + edge_normal * 0.1);
-                // Boundary edges are always convex.
-                m_is_convex_edge[edge_idx] = true;
-            } else {
-                auto other_normal = m_normals[other_face_idx];
-                m_adjacent_normals[face_idx][i] = other_normal;
+    for_each_index(m_edge_face_indices.size(), [&] (size_t edge_idx) {
+        is_convex_edge[edge_idx] = compute_edge_convexity(edge_idx);
+    });
 
-                // Calculate edge convexity.
-                auto is_convex = dot(other_normal, edge_normal) < -EDYN_EPSILON;
-                m_is_convex_edge[edge_idx] = is_convex;
-            }
-        }
+    m_is_convex_edge.assign(is_convex_edge.begin(), is_convex_edge.end());
+}
+
+bool triangle_mesh::compute_edge_convexity(size_t edge_idx) const {
+    auto &edge_face_indices = m_edge_face_indices[edge_idx];
+
+    if (edge_face_indices[0] == edge_face_indices[1]) {
+        // Boundary edges are always convex.
+        return true;
+    }
+
+    auto face_idx = edge_face_indices[0];
+    auto i = size_t(0);
+
+    while (m_face_edge_indices[face_idx][i] != edge_idx) {
+        ++i;
     }
+
+    auto vertex_idx0 = m_indices[face_idx][i];
+    auto vertex_idx1 = m_indices[face_idx][(i + 1) % 3];
+    auto edge_dir = get_vertex_position(vertex_idx1) - get_vertex_position(vertex_idx0);
+    auto edge_normal = cross(get_triangle_normal(face_idx), edge_dir);
+    auto other_normal = get_triangle_normal(edge_face_indices[1]);
+
+    return dot(other_normal, edge_normal) < -EDYN_EPSILON;
 }
 
 void triangle_mesh::build_triangle_tree() {
-    std::vector<AABB> aabbs;
-    aabbs.reserve(num_triangles());
+    std::vector<AABB> aabbs(num_triangles());
 
-    for (size_t i = 0; i < num_triangles(); ++i) {
+    for_each_index(num_triangles(), [&] (size_t i) {
         auto verts = get_triangle_vertices(i);
-        auto tri_aabb = get_triangle_aabb(verts);
-        aabbs.push_back(tri_aabb);
-    }
+        aabbs[i] = get_triangle_aabb(verts);
+    });
 
     auto report_leaf = [] (static_tree::tree_node &node, auto ids_begin, auto ids_end) {
         node.id = *ids_begin;
     };
-    m_triangle_tree.build(aabbs.begin(), aabbs.end(), report_leaf);
+    m_triangle_tree.build(aabbs.begin(), aabbs.end(), report_leaf, 1, should_parallelize(aabbs.size()));
+}
+
+void triangle_mesh::apply_edit(const triangle_mesh_edit &edit) {
+    constexpr auto idx_max = std::numeric_limits<index_type>::max();
+    EDYN_ASSERT(!m_triangle_tree.empty());
+
+    auto num_initial_triangles = num_triangles();
+    auto num_initial_vertices = num_vertices();
+
+    auto moved = std::vector<index_type>{};
+    moved.reserve(edit.moved_vertices.size());
+
+    for (auto &[vertex_idx, position] : edit.moved_vertices) {
+        EDYN_ASSERT(vertex_idx < num_initial_vertices);
+        moved.push_back(vertex_idx);
+    }
+
+    std::sort(moved.begin(), moved.end());
+
+    // Existing vertices which are moved or referenced by added triangles.
+    // All triangles which contain one of them intersect the bounds of their
+    // positions prior to the edit, which are still stored in the tree.
+    auto region_vertices = moved;
+
+    for (auto &indices : edit.added_triangles) {
+        for (auto vertex_idx : indices) {
+            EDYN_ASSERT(vertex_idx < num_initial_vertices + edit.added_vertices.size());
+
+            if (vertex_idx < num_initial_vertices) {
+                region_vertices.push_back(vertex_idx);
+            }
+        }
+    }
+
+    auto face_dirty = std::vector<uint8_t>(num_initial_triangles);
+    auto edge_dirty = std::vector<uint8_t>(num_edges());
+
+    // Map of vertex index pairs to edge index for the edges around the region,
+    // with the same keys as in `init_edge_indices`.
+    auto edge_key = [] (index_type i0, index_type i1) {
+        return (uint64_t(std::min(i0, i1)) << 32) | uint64_t(std::max(i0, i1));
+    };
+    auto edge_map = std::unordered_map<uint64_t, index_type>{};
+
+    // Region containing the previous bounds of all triangles which change,
+    // used to refit the tree locally.
+    auto changed_aabb = AABB{vector3_max, -vector3_max};
+
+    for (auto face_idx : edit.removed_triangles) {
+        EDYN_ASSERT(face_idx < num_initial_triangles);
+        changed_aabb = enclosing_aabb(changed_aabb, get_triangle_aabb(get_triangle_vertices(face_idx)));
+    }
+
+    if (!region_vertices.empty()) {
+        auto region_aabb = AABB{get_vertex_position(region_vertices.front()),
+                                get_vertex_position(region_vertices.front())};
+
+        for (auto vertex_idx : region_vertices) {
+            auto v = get_vertex_position(vertex_idx);
+            region_aabb.min = min(region_aabb.min, v);
+            region_aabb.max = max(region_aabb.max, v);
+        }
+
+        changed_aabb = enclosing_aabb(changed_aabb, region_aabb);
+
+        m_triangle_tree.query(region_aabb, [&] (auto tree_node_idx) {
+            auto face_idx = m_triangle_tree.get_node(tree_node_idx).id;
+
+            for (size_t i = 0; i < 3; ++i) {
+                auto vertex_idx0 = get_face_vertex_index(face_idx, i);
+                auto vertex_idx1 = get_face_vertex_index(face_idx, (i + 1) % 3);
+                edge_map.emplace(edge_key(vertex_idx0, vertex_idx1), get_face_edge_index(face_idx, i));
+
+                if (std::binary_search(moved.begin(), moved.end(), vertex_idx0)) {
+                    face_dirty[face_idx] = true;
+                }
+            }
+        });
+    }
+
+    // Move and add vertices. Keep them quantized if possible.
+    if (!m_quantized_vertices.empty()) {
+        auto fits = std::all_of(edit.moved_vertices.begin(), edit.moved_vertices.end(),
+                                [&] (auto &pair) { return is_quantizable(pair.second); }) &&
+                    std::all_of(edit.added_vertices.begin(), edit.added_vertices.end(),
+                                [&] (auto &v) { return is_quantizable(v); });
+
+        if (!fits) {
+            dequantize_vertices();
+        }
+    }
+
+    if (m_quantized_vertices.empty()) {
+        for (auto &[vertex_idx, position] : edit.moved_vertices) {
+            m_vertices[vertex_idx] = position;
+        }
+
+        for (auto &position : edit.added_vertices) {
+            m_vertices.push_back(position);
+        }
+    } else {
+        for (auto &[vertex_idx, position] : edit.moved_vertices) {
+            m_quantized_vertices[vertex_idx] = quantize_position(position);
+        }
+
+        for (auto &position : edit.added_vertices) {
+            m_quantized_vertices.push_back(quantize_position(position));
+        }
+    }
+
+    auto erase_external_adjacent = [&] (index_type face_idx) {
+        auto first = std::lower_bound(m_external_adjacent_keys.begin(), m_external_adjacent_keys.end(), face_idx * 3);
+        auto last = std::lower_bound(first, m_external_adjacent_keys.end(), face_idx * 3 + 3);
+
+        for (auto count = std::distance(first, last); count > 0; --count) {
+            auto idx = std::distance(m_external_adjacent_keys.begin(), first);
+            m_external_adjacent_normals.erase(m_external_adjacent_normals.begin() + idx);
+            first = m_external_adjacent_keys.erase(first);
+        }
+    };
+
+    // Detach removed triangles from their edges. Edges left without faces
+    // are removed later unless an added triangle takes them.
+    auto removed = edit.removed_triangles;
+    std::sort(removed.begin(), removed.end());
+    removed.erase(std::unique(removed.begin(), removed.end()), removed.end());
+    auto orphan_edges = std::vector<index_type>{};
+
+    for (auto face_idx : removed) {
+        for (size_t i = 0; i < 3; ++i) {
+            auto edge_idx = get_face_edge_index(face_idx, i);
+            auto edge_face_indices = get_edge_face_indices(edge_idx);
+
+            if (edge_face_indices[0] != face_idx && edge_face_indices[1] != face_idx) {
+                continue;
+            }
+
+            if (edge_face_indices[0] == edge_face_indices[1]) {
+                m_edge_face_indices[edge_idx] = {idx_max, idx_max};
+                orphan_edges.push_back(edge_idx);
+            } else {
+                auto other_idx = edge_face_indices[0] == face_idx ? edge_face_indices[1] : edge_face_indices[0];
+                m_edge_face_indices[edge_idx] = {other_idx, other_idx};
+                m_is_boundary_edge[edge_idx] = true;
+            }
+
+            edge_dirty[edge_idx] = true;
+        }
+
+        erase_external_adjacent(face_idx);
+    }
+
+    // Add triangles, taking the place of removed triangles first, and attach
+    // them to existing edges or to new edges.
+    for (size_t k = 0; k < edit.added_triangles.size(); ++k) {
+        auto &indices = edit.added_triangles[k];
+        index_type face_idx;
+
+        if (k < removed.size()) {
+            face_idx = removed[k];
+            m_indices[face_idx] = indices;
+        } else {
+            face_idx = static_cast<index_type>(num_triangles());
+            m_indices.push_back(indices);
+            m_normals.push_back(0);
+            m_face_edge_indices.push_back({});
+            face_dirty.push_back(false);
+        }
+
+        face_dirty[face_idx] = true;
+
+        for (size_t i = 0; i < 3; ++i) {
+            auto vertex_idx0 = indices[i];
+            auto vertex_idx1 = indices[(i + 1) % 3];
+            auto [it, inserted] = edge_map.emplace(edge_key(vertex_idx0, vertex_idx1),
+                                                   static_cast<index_type>(num_edges()));
+            auto edge_idx = it->second;
+
+            if (inserted) {
+                m_edge_vertex_indices.push_back(commutative_pair(vertex_idx0, vertex_idx1));
+                m_edge_face_indices.push_back({idx_max, idx_max});
+                m_is_boundary_edge.push_back(true);
+                m_is_convex_edge.push_back(true);
+                edge_dirty.push_back(false);
+            }
+
+            m_face_edge_indices[face_idx][i] = edge_idx;
+            auto edge_face_indices = get_edge_face_indices(edge_idx);
+
+            if (edge_face_indices[0] == idx_max) {
+                m_edge_face_indices[edge_idx] = {face_idx, face_idx};
+                m_is_boundary_edge[edge_idx] = true;
+            } else {
+                m_edge_face_indices[edge_idx] = {edge_face_indices[0], face_idx};
+                m_is_boundary_edge[edge_idx] = false;
+            }
+
+            edge_dirty[edge_idx] = true;
+        }
+    }
+
+    // Fill the remaining vacant places with the last triangles. Removed
+    // triangles are sorted thus these are the last vacant places, which are
+    // processed in descending order so that the last triangle is never vacant.
+    // The original index of the moved triangles is kept to update the tree.
+    auto vacant_faces = std::vector<uint32_t>{};
+    auto original_face_indices = std::unordered_map<index_type, index_type>{};
+
+    for (auto k = removed.size(); k-- > edit.added_triangles.size();) {
+        auto face_idx = removed[k];
+        auto last_idx = static_cast<index_type>(num_triangles() - 1);
+        vacant_faces.push_back(face_idx);
+
+        if (face_idx != last_idx) {
+            m_indices[face_idx] = m_indices[last_idx];
+            m_normals[face_idx] = m_normals[last_idx];
+            m_face_edge_indices[face_idx] = m_face_edge_indices[last_idx];
+            face_dirty[face_idx] = face_dirty[last_idx];
+
+            for (size_t i = 0; i < 3; ++i) {
+                auto &edge_face_indices = m_edge_face_indices[m_face_edge_indices[face_idx][i]];
+
+                for (auto &idx : edge_face_indices) {
+                    if (idx == last_idx) {
+                        idx = face_idx;
+                    }
+                }
+            }
+
+            // Move external adjacent normals to the new keys, which are all
+            // smaller than the keys of the last triangle.
+            auto first = std::lower_bound(m_external_adjacent_keys.begin(), m_external_adjacent_keys.end(), last_idx * 3);
+
+            while (first != m_external_adjacent_keys.end() && *first < last_idx * 3 + 3) {
+                auto idx = std::distance(m_external_adjacent_keys.begin(), first);
+                auto key = face_idx * 3 + (*first - last_idx * 3);
+                auto normal = m_external_adjacent_normals[idx];
+                m_external_adjacent_normals.erase(m_external_adjacent_normals.begin() + idx);
+                m_external_adjacent_keys.erase(first);
+
+                auto pos = std::lower_bound(m_external_adjacent_keys.begin(), m_external_adjacent_keys.end(), key);
+                auto pos_idx = std::distance(m_external_adjacent_keys.begin(), pos);
+                m_external_adjacent_keys.insert(pos, key);
+                m_external_adjacent_normals.insert(m_external_adjacent_normals.begin() + pos_idx, normal);
+                first = std::lower_bound(m_external_adjacent_keys.begin(), m_external_adjacent_keys.end(), last_idx * 3);
+            }
+
+            auto it = original_face_indices.find(last_idx);
+            auto original_idx = it != original_face_indices.end() ? it->second : last_idx;
+
+            if (it != original_face_indices.end()) {
+                original_face_indices.erase(it);
+            }
+
+            original_face_indices[face_idx] = original_idx;
+        }
+
+        m_indices.pop_back();
+        m_normals.pop_back();
+        m_face_edge_indices.pop_back();
+        face_dirty.pop_back();
+    }
+
+    EDYN_ASSERT(num_triangles() > 0);
+
+    // Remove edges without faces by moving the last edge in their place.
+    std::sort(orphan_edges.begin(), orphan_edges.end(), std::greater<index_type>{});
+    orphan_edges.erase(std::unique(orphan_edges.begin(), orphan_edges.end()), orphan_edges.end());
+
+    for (auto edge_idx : orphan_edges) {
+        if (get_edge_face_indices(edge_idx)[0] != idx_max) {
+            // Taken by an added triangle.
+            continue;
+        }
+
+        auto last_idx = static_cast<index_type>(num_edges() - 1);
+
+        if (edge_idx != last_idx) {
+            m_edge_vertex_indices[edge_idx] = m_edge_vertex_indices[last_idx];
+            m_edge_face_indices[edge_idx] = m_edge_face_indices[last_idx];
+            m_is_boundary_edge[edge_idx] = m_is_boundary_edge[last_idx];
+            m_is_convex_edge[edge_idx] = m_is_convex_edge[last_idx];
+            edge_dirty[edge_idx] = edge_dirty[last_idx];
+
+            for (auto face_idx : get_edge_face_indices(edge_idx)) {
+                for (auto &idx : m_face_edge_indices[face_idx]) {
+                    if (idx == last_idx) {
+                        idx = edge_idx;
+                    }
+                }
+            }
+        }
+
+        m_edge_vertex_indices.pop_back();
+        m_edge_face_indices.pop_back();
+        m_is_boundary_edge.pop_back();
+        m_is_convex_edge.pop_back();
+        edge_dirty.pop_back();
+    }
+
+    // Recalculate normals of modified triangles, then the convexity of their
+    // edges and of the edges whose adjacency changed.
+    for (size_t face_idx = 0; face_idx < num_triangles(); ++face_idx) {
+        if (face_dirty[face_idx]) {
+            m_normals[face_idx] = octahedral_encode(compute_face_normal(face_idx));
+
+            for (size_t i = 0; i < 3; ++i) {
+                edge_dirty[get_face_edge_index(face_idx, i)] = true;
+            }
+        }
+    }
+
+    for (size_t edge_idx = 0; edge_idx < num_edges(); ++edge_idx) {
+        if (edge_dirty[edge_idx]) {
+            m_is_convex_edge[edge_idx] = compute_edge_convexity(edge_idx);
+        }
+    }
+
+    // Insertions degrade the quality of the tree. Rebuild it if many.
+    auto num_appended = num_triangles() > num_initial_triangles ? num_triangles() - num_initial_triangles : 0;
+
+    if (num_appended * 4 > num_triangles()) {
+        build_triangle_tree();
+        return;
+    }
+
+    // If no triangles were added or removed, only the changed triangles and
+    // their ancestors need updating, as long as they remain within bounds.
+    if (num_appended == 0 && vacant_faces.empty()) {
+        auto updated = m_triangle_tree.refit_region(changed_aabb, [&] (uint32_t id, AABB &aabb) {
+            if (face_dirty[id]) {
+                aabb = get_triangle_aabb(get_triangle_vertices(id));
+                return true;
+            }
+
+            return false;
+        });
+
+        if (updated) {
+            return;
+        }
+    }
+
+    m_triangle_tree.remove_leaves(vacant_faces);
+
+    for (auto face_idx = num_initial_triangles; face_idx < num_triangles(); ++face_idx) {
+        m_triangle_tree.insert_leaf(face_idx, get_triangle_aabb(get_triangle_vertices(face_idx)));
+    }
+
+    auto new_face_indices = std::unordered_map<index_type, index_type>{};
+
+    for (auto [face_idx, original_idx] : original_face_indices) {
+        new_face_indices[original_idx] = face_idx;
+    }
+
+    m_triangle_tree.refit([&] (uint32_t &id) {
+        if (auto it = new_face_indices.find(id); it != new_face_indices.end()) {
+            id = it->second;
+        }
+
+        return get_triangle_aabb(get_triangle_vertices(id));
+    });
 }
 
 triangle_vertices triangle_mesh::get_triangle_vertices(size_t tri_idx) const {
     EDYN_ASSERT(tri_idx < m_indices.size());
     auto indices = m_indices[tri_idx];
     return {
-        m_vertices[indices[0]],
-        m_vertices[indices[1]],
-        m_vertices[indices[2]]
+        get_vertex_position(indices[0]),
+        get_vertex_position(indices[1]),
+        get_vertex_position(indices[2])
     };
 }
 
+vector3 triangle_mesh::get_boundary_adjacent_normal(size_t tri_idx, size_t edge_idx) const {
+    auto key = static_cast<index_type>(tri_idx * 3 + edge_idx);
+    auto it = std::lower_bound(m_external_adjacent_keys.begin(), m_external_adjacent_keys.end(), key);
+
+    if (it != m_external_adjacent_keys.end() && *it == key) {
+        auto idx = std::distance(m_external_adjacent_keys.begin(), it);
+        return octahedral_decode(m_external_adjacent_normals[idx]);
+    }
+
+    // Make adjacent normal point slightly away in the edge direction to form
+    // a near 180 degree angle.
+    auto vertex_idx0 = m_indices[tri_idx][edge_idx];
+    auto vertex_idx1 = m_indices[tri_idx][(edge_idx + 1) % 3];
+    auto edge_dir = get_vertex_position(vertex_idx1) - get_vertex_position(vertex_idx0);
+    auto normal = get_triangle_normal(tri_idx);
+    auto edge_normal = cross(normal, edge_dir);
+    return -normalize(normal + edge_normal * 0.1);
+}
+
+void triangle_mesh::set_external_adjacent_normal(size_t tri_idx, size_t edge_idx, const vector3 &normal) {
+    auto key = static_cast<index_type>(tri_idx * 3 + edge_idx);
+    auto it = std::lower_bound(m_external_adjacent_keys.begin(), m_external_adjacent_keys.end(), key);
+    auto idx = std::distance(m_external_adjacent_keys.begin(), it);
+
+    if (it != m_external_adjacent_keys.end() && *it == key) {
+        m_external_adjacent_normals[idx] = octahedral_encode(normal);
+    } else {
+        m_external_adjacent_keys.insert(it, key);
+        m_external_adjacent_normals.insert(m_external_adjacent_normals.begin() + idx, octahedral_encode(normal));
+    }
+}
+
 }
@@ -1,71 +1,45 @@
 #include "edyn/sys/update_rotated_meshes.hpp"
-#include "edyn/comp/position.hpp"
 #include "edyn/comp/orientation.hpp"
-#include "edyn/comp/rotated_mesh_list.hpp"
+#include "edyn/comp/rotated_mesh_handle.hpp"
+#include "edyn/math/matrix3x3.hpp"
+#include "edyn/config/config.h"
 #include <entt/entity/registry.hpp>
-#include <variant>
 
 namespace edyn {
 
-static void update_rotated_mesh_vertices(rotated_mesh &rotated, const convex_mesh &mesh,
-                                         const quaternion &orn) {
-    EDYN_ASSERT(mesh.vertices.size() == rotated.vertices.size());
+// Rotating a vector by a matrix is cheaper than rotating it by a quaternion,
+// thus the orientation is converted once for all vertices and normals.
+static void rotate_points(const std::vector<vector3> &points, std::vector<vector3> &rotated,
+                          const matrix3x3 &basis) {
+    EDYN_ASSERT(points.size() == rotated.size());
 
-    for (size_t i = 0; i < mesh.vertices.size(); ++i) {
-        auto &vertex_local = mesh.vertices[i];
-        rotated.vertices[i] = rotate(orn, vertex_local);
-    }
-}
-
-static void update_rotated_mesh_normals(rotated_mesh &rotated, const convex_mesh &mesh,
-                                        const quaternion &orn) {
-    EDYN_ASSERT(mesh.normals.size() == rotated.normals.size());
-
-    for (size_t i = 0; i < mesh.normals.size(); ++i) {
-        auto &normal_local = mesh.normals[i];
-        rotated.normals[i] = rotate(orn, normal_local);
+    for (size_t i = 0; i < points.size(); ++i) {
+        rotated[i] = basis * points[i];
     }
 }
 
 void update_rotated_mesh(rotated_mesh &rotated, const convex_mesh &mesh,
                          const quaternion &orn) {
-    update_rotated_mesh_vertices(rotated, mesh, orn);
-    update_rotated_mesh_normals(rotated, mesh, orn);
-}
-
-template<typename RotatedView, typename OrientationView>
-void update_rotated_mesh(entt::entity entity, RotatedView &rotated_view, OrientationView &orn_view) {
-    auto &orn = orn_view.template get<orientation>(entity);
-    auto &rotated_list = rotated_view.template get<rotated_mesh_list>(entity);
-
-    auto *rot_list_ptr = &rotated_list;
-
-    while(true) {
-        // TODO: `rot_list_ptr->orientation` is often `quaternion_identity`.
-        // What could be done to avoid this often unnecessary multiplication?
-        update_rotated_mesh(*rot_list_ptr->rotated, *rot_list_ptr->mesh, orn * rot_list_ptr->orientation);
-
-        if (rot_list_ptr->next == entt::null) {
-            break;
-        }
-
-        rot_list_ptr = &std::get<0>(rotated_view.get(rot_list_ptr->next));
-    }
+    auto basis = to_matrix3x3(orn);
+    rotate_points(mesh.vertices, rotated.vertices, basis);
+    rotate_points(mesh.normals, rotated.normals, basis);
 }
 
 void update_rotated_mesh(entt::registry &registry, entt::entity entity) {
-    auto rotated_view = registry.view<rotated_mesh_list>();
-    auto orn_view = registry.view<orientation>();
-    update_rotated_mesh(entity, rotated_view, orn_view);
+    auto &pool = registry.ctx<rotated_mesh_pool>();
+    auto &handle = registry.get<rotated_mesh_handle>(entity);
+    auto &orn = registry.get<orientation>(entity);
+    pool.update(handle.index, orn, true);
 }
 
 void update_rotated_meshes(entt::registry &registry) {
-    auto rotated_view = registry.view<rotated_mesh_list>();
-    auto view = registry.view<orientation, rotated_mesh_list>();
+    auto &pool = registry.ctx<rotated_mesh_pool>();
+    auto view = registry.view<orientation, rotated_mesh_handle>();
 
-    for (auto entity : view) {
-        update_rotated_mesh(entity, rotated_view, view);
-    }
+    view.each([&] (orientation &orn, rotated_mesh_handle &handle) {
+        // Only recalculated if the orientation changed.
+        pool.update(handle.index, orn);
+    });
 }
 
 }
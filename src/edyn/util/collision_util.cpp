@@ -5,6 +5,7 @@
 #include "edyn/util/constraint_util.hpp"
 #include "edyn/constraints/contact_constraint.hpp"
 #include "edyn/collision/collide.hpp"
+#include "edyn/collision/collide_gjk.hpp"
 #include "edyn/comp/continuous.hpp"
 #include "edyn/comp/tag.hpp"
 
@@ -47,8 +48,23 @@ void merge_point(const collision_result::collision_point &rp, contact_point &cp)
 void create_contact_constraint(entt::registry &registry,
                                entt::entity contact_entity,
                                contact_point &cp) {
-    auto &materialA = registry.get<material>(cp.body[0]);
-    auto &materialB = registry.get<material>(cp.body[1]);
+    auto materialA = registry.get<material>(cp.body[0]);
+    auto materialB = registry.get<material>(cp.body[1]);
+
+    // Heightfields can assign a material to each cell, which replaces the
+    // material of the rigid body. Their pivots are in the space of the grid
+    // since heightfields ignore the transform of the rigid body.
+    if (auto *shape = registry.try_get<heightfield_shape>(cp.body[0])) {
+        if (auto *cell_material = shape->field->get_material(cp.pivotA)) {
+            materialA = *cell_material;
+        }
+    }
+
+    if (auto *shape = registry.try_get<heightfield_shape>(cp.body[1])) {
+        if (auto *cell_material = shape->field->get_material(cp.pivotB)) {
+            materialB = *cell_material;
+        }
+    }
 
     cp.restitution = materialA.restitution * materialB.restitution;
     cp.friction = materialA.friction * materialB.friction;
@@ -174,9 +190,10 @@ void destroy_contact_point(entt::registry &registry, entt::entity manifold_entit
     registry.get_or_emplace<dirty>(manifold_entity).updated<contact_manifold>();
 }
 
-void detect_collision(std::array<entt::entity, 2> body, collision_result &result,
-                      const detect_collision_body_view_t &body_view, const com_view_t &com_view,
-                      const tuple_of_shape_views_t &views_tuple) {
+static void detect_collision(std::array<entt::entity, 2> body, collision_result &result,
+                             const detect_collision_body_view_t &body_view, const com_view_t &com_view,
+                             const tuple_of_shape_views_t &views_tuple, collision_cache *cache,
+                             const std::vector<std::pair<size_t, size_t>> *gjk_shape_pairs) {
     auto [aabbA, posA, ornA] = body_view.get<AABB, position, orientation>(body[0]);
     auto [aabbB, posB, ornB] = body_view.get<AABB, position, orientation>(body[1]);
     const auto offset = vector3_one * -contact_breaking_threshold;
@@ -185,32 +202,116 @@ void detect_collision(std::array<entt::entity, 2> body, collision_result &result
     // a manifold is allowed to exist whilst the AABB separation is smaller
     // than `manifold.separation_threshold` which is greater than the
     // contact breaking threshold.
-    if (intersect(aabbA.inset(offset), aabbB)) {
-        auto originA = static_cast<vector3>(posA);
-        auto originB = static_cast<vector3>(posB);
+    if (!intersect(aabbA.inset(offset), aabbB)) {
+        result.num_points = 0;
 
-        if (com_view.contains(body[0])) {
-          auto &com = std::get<0>(com_view.get(body[0]));
-          originA = to_world_space(-com, posA, ornA);
+        if (cache) {
+            cache->clear();
         }
 
-        if (com_view.contains(body[1])) {
-          auto &com = std::get<0>(com_view.get(body[1]));
-          originB = to_world_space(-com, posB, ornB);
+        return;
+    }
+
+    auto originA = static_cast<vector3>(posA);
+    auto originB = static_cast<vector3>(posB);
+
+    if (com_view.contains(body[0])) {
+      auto &com = std::get<0>(com_view.get(body[0]));
+      originA = to_world_space(-com, posA, ornA);
+    }
+
+    if (com_view.contains(body[1])) {
+      auto &com = std::get<0>(com_view.get(body[1]));
+      originB = to_world_space(-com, posB, ornB);
+    }
+
+    auto shape_indexA = body_view.get<shape_index>(body[0]);
+    auto shape_indexB = body_view.get<shape_index>(body[1]);
+
+    // Paged meshes load submeshes asynchronously thus the result might change
+    // even if the bodies do not move relative to one another.
+    const auto paged_mesh_index = get_shape_index<paged_mesh_shape>();
+    const auto cacheable = cache &&
+                           shape_indexA.value != paged_mesh_index &&
+                           shape_indexB.value != paged_mesh_index;
+    auto conj_ornA = conjugate(ornA);
+    auto rel_position = rotate(conj_ornA, originB - originA);
+    auto rel_orientation = conj_ornA * ornB;
+
+    if (cacheable && cache->has_result) {
+        constexpr auto linear_tolerance_sqr = collision_cache_linear_tolerance * collision_cache_linear_tolerance;
+        // Cosine of half the angular tolerance, using the small angle approximation.
+        constexpr auto min_orientation_dot = scalar(1) -
+            collision_cache_angular_tolerance * collision_cache_angular_tolerance / scalar(8);
+
+        if (distance_sqr(rel_position, cache->rel_position) < linear_tolerance_sqr &&
+            std::abs(dot(rel_orientation, cache->rel_orientation)) > min_orientation_dot) {
+            // Reuse previous result. Normals are brought back into world space
+            // and distances are recalculated using the current transforms.
+            result = cache->result;
+
+            for (size_t i = 0; i < result.num_points; ++i) {
+                auto &pt = result.point[i];
+                pt.normal = rotate(ornA, pt.normal);
+                auto pivotA_world = to_world_space(pt.pivotA, originA, ornA);
+                auto pivotB_world = to_world_space(pt.pivotB, originB, ornB);
+                pt.distance = dot(pt.normal, pivotA_world - pivotB_world);
+            }
+
+            return;
         }
+    }
+
+    auto ctx = collision_context{originA, ornA, aabbA, originB, ornB, aabbB, contact_breaking_threshold, cache};
+    auto use_gjk = false;
+
+    if (gjk_shape_pairs) {
+        use_gjk = std::find_if(gjk_shape_pairs->begin(), gjk_shape_pairs->end(), [&] (auto &pair) {
+            return (pair.first == shape_indexA.value && pair.second == shape_indexB.value) ||
+                   (pair.first == shape_indexB.value && pair.second == shape_indexA.value);
+        }) != gjk_shape_pairs->end();
+    }
+
+    visit_shape(shape_indexA, body[0], views_tuple, [&] (auto &&shA) {
+        visit_shape(shape_indexB, body[1], views_tuple, [&] (auto &&shB) {
+          using ShapeAType = std::decay_t<decltype(std::get<0>(shA))>;
+          using ShapeBType = std::decay_t<decltype(std::get<0>(shB))>;
 
-        auto shape_indexA = body_view.get<shape_index>(body[0]);
-        auto shape_indexB = body_view.get<shape_index>(body[1]);
-        auto ctx = collision_context{originA, ornA, aabbA, originB, ornB, aabbB, contact_breaking_threshold};
+          if constexpr(has_support_function_v<ShapeAType> && has_support_function_v<ShapeBType>) {
+              if (use_gjk) {
+                  collide_gjk(std::get<0>(shA), std::get<0>(shB), ctx, result);
+                  return;
+              }
+          }
 
-        visit_shape(shape_indexA, body[0], views_tuple, [&] (auto &&shA) {
-            visit_shape(shape_indexB, body[1], views_tuple, [&] (auto &&shB) {
-              collide(std::get<0>(shA), std::get<0>(shB), ctx, result);
-            });
+          collide(std::get<0>(shA), std::get<0>(shB), ctx, result);
         });
-    } else {
-        result.num_points = 0;
+    });
+
+    if (cacheable) {
+        cache->rel_position = rel_position;
+        cache->rel_orientation = rel_orientation;
+        cache->result = result;
+        cache->has_result = true;
+
+        for (size_t i = 0; i < result.num_points; ++i) {
+            auto &pt = cache->result.point[i];
+            pt.normal = rotate(conj_ornA, pt.normal);
+        }
     }
 }
 
+void detect_collision(std::array<entt::entity, 2> body, collision_result &result,
+                      const detect_collision_body_view_t &body_view, const com_view_t &com_view,
+                      const tuple_of_shape_views_t &views_tuple) {
+    detect_collision(body, result, body_view, com_view, views_tuple, nullptr, nullptr);
+}
+
+void detect_collision(std::array<entt::entity, 2> body, collision_result &result,
+                      const detect_collision_body_view_t &body_view, const com_view_t &com_view,
+                      const tuple_of_shape_views_t &views_tuple, collision_cache &cache,
+                      const std::vector<std::pair<size_t, size_t>> &gjk_shape_pairs) {
+    detect_collision(body, result, body_view, com_view, views_tuple, &cache, &gjk_shape_pairs);
+}
+
 }
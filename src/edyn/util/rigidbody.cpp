@@ -22,6 +22,7 @@
 #include "edyn/util/aabb_util.hpp"
 #include "edyn/util/tuple_util.hpp"
 #include "edyn/parallel/island_coordinator.hpp"
+#include "edyn/collision/broadphase_main.hpp"
 #include "edyn/context/settings.hpp"
 #include "edyn/edyn.hpp"
 
@@ -250,6 +251,21 @@ void set_rigidbody_friction(entt::registry &registry, entt::entity entity, scala
     });
 }
 
+void edit_mesh_shape(entt::registry &registry, entt::entity entity, const triangle_mesh_edit &edit) {
+    EDYN_ASSERT(registry.all_of<static_tag>(entity));
+
+    auto shape = mesh_shape{std::make_shared<triangle_mesh>(*registry.get<mesh_shape>(entity).trimesh)};
+    shape.trimesh->apply_edit(edit);
+    registry.replace<mesh_shape>(entity, shape);
+
+    auto &pos = registry.get<position>(entity);
+    auto &orn = registry.get<orientation>(entity);
+    registry.replace<AABB>(entity, shape_aabb(shape, pos, orn));
+    registry.ctx<broadphase_main>().update_static_aabb(entity);
+
+    refresh<mesh_shape, AABB>(registry, entity);
+}
+
 void set_center_of_mass(entt::registry &registry, entt::entity entity, const vector3 &com) {
     auto &coordinator = registry.ctx<island_coordinator>();
     coordinator.set_center_of_mass(entity, com);
@@ -1,5 +1,9 @@
 #include "../common/common.hpp"
 
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
 TEST(test_broadphase, collision_filtering) {
     entt::registry registry;
     edyn::init();
@@ -33,4 +37,189 @@ TEST(test_broadphase, collision_filtering) {
 
     edyn::detach(registry);
     edyn::deinit();
-}
\ No newline at end of file
+}
+
+TEST(test_broadphase, tree_node_collision_filtering) {
+    entt::registry registry;
+    edyn::init();
+    edyn::attach(registry);
+
+    auto def = edyn::rigidbody_def{};
+    def.shape = edyn::box_shape{0.5, 0.5, 0.5};
+    auto first = edyn::make_rigidbody(registry, def);
+    auto second = edyn::make_rigidbody(registry, def);
+
+    edyn::tree_leaf_filter filter0 {};
+    filter0.filter.group = 0x1;
+    filter0.filter.mask = ~0x2;
+
+    edyn::tree_leaf_filter filter1 {};
+    filter1.filter.group = 0x2;
+    filter1.filter.mask = ~0x1;
+
+    auto func = &edyn::should_collide_default;
+
+    // Rejected by the leaf filters without registry access.
+    ASSERT_FALSE(edyn::should_collide(registry, func, first, filter0, second, filter1));
+
+    filter1.filter.mask = ~0ULL;
+    filter0.filter.mask = ~0ULL;
+    ASSERT_TRUE(edyn::should_collide(registry, func, first, filter0, second, filter1));
+    ASSERT_FALSE(edyn::should_collide(registry, func, first, filter0, first, filter0));
+
+    // Exclusions are checked in the registry.
+    edyn::exclude_collision(registry, first, second);
+    filter0.has_exclusion = true;
+    filter1.has_exclusion = true;
+    ASSERT_FALSE(edyn::should_collide(registry, func, first, filter0, second, filter1));
+
+    edyn::detach(registry);
+    edyn::deinit();
+}
+
+// Creates a grid of spheres almost touching their neighbors, a large box
+// right above them and a static floor right below. The dynamic bodies are
+// connected by constraints, thus they're all in the same island and their
+// pairs are found by the broadphase of the island worker. Returns the pairs
+// which must have a contact manifold.
+TEST(test_broadphase, static_filter_edited_in_place) {
+    entt::registry registry;
+    edyn::init();
+    edyn::attach(registry);
+    edyn::set_gravity(registry, edyn::vector3_zero);
+
+    auto def = edyn::rigidbody_def{};
+    def.kind = edyn::rigidbody_kind::rb_static;
+    def.shape = edyn::box_shape{10, 0.1, 10};
+    auto floor = edyn::make_rigidbody(registry, def);
+
+    def.kind = edyn::rigidbody_kind::rb_dynamic;
+    def.shape = edyn::box_shape{0.5, 0.5, 0.5};
+    def.position = {0, 0.5, 0};
+    auto box = edyn::make_rigidbody(registry, def);
+
+    // Modified without an update signal after the floor was inserted into
+    // the non-procedural tree.
+    registry.get<edyn::collision_filter>(floor).mask = 0;
+
+    for (auto i = 0; i < 20; ++i) {
+        edyn::update(registry);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_FALSE(edyn::manifold_exists(registry, box, floor));
+
+    registry.get<edyn::collision_filter>(floor).mask = ~0ULL;
+
+    // Island workers run asynchronously.
+    for (auto i = 0; i < 500 && !edyn::manifold_exists(registry, box, floor); ++i) {
+        edyn::update(registry);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_TRUE(edyn::manifold_exists(registry, box, floor));
+
+    edyn::detach(registry);
+    edyn::deinit();
+}
+
+static std::vector<std::pair<entt::entity, entt::entity>>
+make_island_with_pairs(entt::registry &registry, std::vector<std::pair<entt::entity, entt::entity>> &non_pairs) {
+    constexpr auto size = 5;
+    constexpr auto spacing = edyn::scalar(1.01);
+    std::vector<std::pair<entt::entity, entt::entity>> pairs;
+    entt::entity spheres[size][size];
+
+    auto def = edyn::rigidbody_def{};
+    def.shape = edyn::sphere_shape{0.5};
+
+    for (auto x = 0; x < size; ++x) {
+        for (auto z = 0; z < size; ++z) {
+            def.position = edyn::vector3{x * spacing, 0, z * spacing};
+            spheres[x][z] = edyn::make_rigidbody(registry, def);
+
+            if (x > 0) {
+                pairs.emplace_back(spheres[x - 1][z], spheres[x][z]);
+            }
+
+            if (z > 0) {
+                pairs.emplace_back(spheres[x][z - 1], spheres[x][z]);
+            }
+
+            if (x > 0 && z > 0) {
+                non_pairs.emplace_back(spheres[x - 1][z - 1], spheres[x][z]);
+            }
+        }
+    }
+
+    // Spans too many cells to be inserted in the hashed grid.
+    auto center = edyn::vector3{2 * spacing, 0, 2 * spacing};
+    def.shape = edyn::box_shape{3.5, 0.1, 3.5};
+    def.position = center + edyn::vector3{0, 0.61, 0};
+    auto box = edyn::make_rigidbody(registry, def);
+
+    def.kind = edyn::rigidbody_kind::rb_static;
+    def.shape = edyn::box_shape{10, 0.1, 10};
+    def.position = center - edyn::vector3{0, 0.61, 0};
+    auto floor = edyn::make_rigidbody(registry, def);
+
+    for (auto x = 0; x < size; ++x) {
+        for (auto z = 0; z < size; ++z) {
+            pairs.emplace_back(box, spheres[x][z]);
+            pairs.emplace_back(floor, spheres[x][z]);
+
+            auto next = x * size + z + 1;
+
+            if (next < size * size) {
+                edyn::make_constraint<edyn::null_constraint>(registry, spheres[x][z], spheres[next / size][next % size]);
+            }
+        }
+    }
+
+    edyn::make_constraint<edyn::null_constraint>(registry, box, spheres[0][0]);
+    non_pairs.emplace_back(box, floor);
+
+    return pairs;
+}
+
+static void test_island_worker_pairs(edyn::broadphase_type type) {
+    entt::registry registry;
+    edyn::init();
+    edyn::attach(registry);
+    edyn::set_broadphase_type(registry, type);
+    edyn::set_gravity(registry, edyn::vector3_zero);
+
+    std::vector<std::pair<entt::entity, entt::entity>> non_pairs;
+    auto pairs = make_island_with_pairs(registry, non_pairs);
+
+    auto all_exist = [&] {
+        return std::all_of(pairs.begin(), pairs.end(), [&] (auto &pair) {
+            return edyn::manifold_exists(registry, pair.first, pair.second);
+        });
+    };
+
+    // Island workers run asynchronously.
+    for (auto i = 0; i < 500 && !all_exist(); ++i) {
+        edyn::update(registry);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    for (auto &pair : pairs) {
+        ASSERT_TRUE(edyn::manifold_exists(registry, pair.first, pair.second));
+    }
+
+    for (auto &pair : non_pairs) {
+        ASSERT_FALSE(edyn::manifold_exists(registry, pair.first, pair.second));
+    }
+
+    edyn::detach(registry);
+    edyn::deinit();
+}
+
+TEST(test_broadphase, island_worker_tree_pairs) {
+    test_island_worker_pairs(edyn::broadphase_type::dynamic_tree);
+}
+
+TEST(test_broadphase, island_worker_hash_grid_pairs) {
+    test_island_worker_pairs(edyn::broadphase_type::hash_grid);
+}
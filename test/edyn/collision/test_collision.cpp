@@ -9,7 +9,11 @@
 #include "edyn/shapes/polyhedron_shape.hpp"
 #include "edyn/util/shape_util.hpp"
 #include <edyn/collision/collide.hpp>
+#include <edyn/collision/collide_gjk.hpp>
+#include <edyn/collision/triangle_batch.hpp>
+#include <set>
 #include <memory>
+#include <random>
 
 TEST(test_collision, collide_box_box_face_face) {
     auto box = edyn::box_shape{edyn::vector3{0.5, 0.5, 0.5}};
@@ -148,6 +152,87 @@ TEST(test_collision, collide_polyhedron_sphere) {
     ASSERT_SCALAR_EQ(pt.distance, 0.2071067812);
 }
 
+TEST(test_collision, collide_polyhedron_polyhedron_edges) {
+    // Edge pairs which do not form a face of the Minkowski difference are
+    // skipped. The results must match the dedicated box-box collision, which
+    // tests all pairs of edges.
+    auto mesh = std::make_shared<edyn::convex_mesh>();
+    edyn::make_box_mesh({0.5, 0.5, 0.5}, mesh->vertices, mesh->indices, mesh->faces);
+    mesh->initialize();
+    auto box = edyn::box_shape{0.5, 0.5, 0.5};
+
+    auto rng = std::mt19937(5);
+    auto dist = std::uniform_real_distribution<edyn::scalar>(-1, 1);
+    auto offset_dist = std::uniform_real_distribution<edyn::scalar>(0.9, 1.4);
+    auto random_orientation = [&] () {
+        auto axis = edyn::normalize(edyn::vector3{dist(rng), dist(rng), dist(rng)});
+        return edyn::quaternion_axis_angle(axis, dist(rng) * edyn::pi);
+    };
+
+    auto deepest = [] (const edyn::collision_result &result) {
+        auto idx = size_t(0);
+
+        for (size_t i = 1; i < result.num_points; ++i) {
+            if (result.point[i].distance < result.point[idx].distance) {
+                idx = i;
+            }
+        }
+
+        return result.point[idx];
+    };
+
+    size_t num_edge_contacts = 0;
+
+    for (size_t i = 0; i < 200; ++i) {
+        auto ctx = edyn::collision_context{};
+        ctx.posA = edyn::vector3_zero;
+        ctx.ornA = random_orientation();
+        ctx.posB = edyn::normalize(edyn::vector3{dist(rng), dist(rng), dist(rng)}) * offset_dist(rng);
+        ctx.ornB = random_orientation();
+        ctx.threshold = 0.02;
+
+        auto box_result = edyn::collision_result{};
+        edyn::collide(box, box, ctx, box_result);
+
+        if (box_result.num_points == 0 || deepest(box_result).distance > 0) {
+            continue;
+        }
+
+        auto rotatedA = edyn::make_rotated_mesh(*mesh, ctx.ornA);
+        auto rotatedB = edyn::make_rotated_mesh(*mesh, ctx.ornB);
+        auto polyhedronA = edyn::polyhedron_shape{};
+        polyhedronA.mesh = mesh;
+        polyhedronA.rotated = &rotatedA;
+        auto polyhedronB = edyn::polyhedron_shape{};
+        polyhedronB.mesh = mesh;
+        polyhedronB.rotated = &rotatedB;
+
+        auto result = edyn::collision_result{};
+        edyn::collide(polyhedronA, polyhedronB, ctx, result);
+        ASSERT_GT(result.num_points, 0);
+
+        auto expected = deepest(box_result);
+        auto point = deepest(result);
+        ASSERT_NEAR(point.distance, expected.distance, 0.001);
+        ASSERT_GT(edyn::dot(point.normal, expected.normal), 0.999);
+
+        // Whether the normal is not parallel to a face of either box.
+        auto on_face = false;
+
+        for (auto &normal : rotatedA.normals) {
+            on_face |= std::abs(edyn::dot(normal, expected.normal)) > 0.9999;
+        }
+
+        for (auto &normal : rotatedB.normals) {
+            on_face |= std::abs(edyn::dot(normal, expected.normal)) > 0.9999;
+        }
+
+        num_edge_contacts += on_face ? 0 : 1;
+    }
+
+    ASSERT_GT(num_edge_contacts, 0);
+}
+
 TEST(test_collision, collide_capsule_cylinder_parallel) {
     auto capsule = edyn::capsule_shape{0.1, 0.2};
     auto cylinder = edyn::cylinder_shape{0.2, 0.5};
@@ -490,4 +575,252 @@ TEST(test_collision, collide_cylinder_box_face_face) {
         ASSERT_TRUE(containsA);
         ASSERT_TRUE(containsB);
     }
-}
\ No newline at end of file
+}
+
+TEST(test_collision, collide_gjk_box_box_separated) {
+    auto box = edyn::box_shape{edyn::vector3{0.5, 0.5, 0.5}};
+    auto ctx = edyn::collision_context{};
+    ctx.posA = edyn::vector3{0, 0, 0};
+    ctx.ornA = edyn::quaternion_identity;
+    ctx.posB = edyn::vector3{0, 1.01, 0};
+    ctx.ornB = edyn::quaternion_identity;
+    ctx.threshold = 0.02;
+    auto result = edyn::collision_result{};
+    edyn::collide_gjk(box, box, ctx, result);
+    ASSERT_EQ(result.num_points, 1);
+    ASSERT_NEAR(result.point[0].distance, 0.01, 0.0001);
+    ASSERT_NEAR(result.point[0].normal.y, -1, 0.0001);
+
+    ctx.posB.y = 1.1;
+    result = edyn::collision_result{};
+    edyn::collide_gjk(box, box, ctx, result);
+    ASSERT_EQ(result.num_points, 0);
+}
+
+TEST(test_collision, collide_gjk_box_sphere_penetrating) {
+    auto box = edyn::box_shape{edyn::vector3{0.5, 0.5, 0.5}};
+    auto sphere = edyn::sphere_shape{0.5};
+    auto ctx = edyn::collision_context{};
+    ctx.posA = edyn::vector3{0, 0, 0};
+    ctx.ornA = edyn::quaternion_identity;
+    ctx.posB = edyn::vector3{0.9, 0, 0};
+    ctx.ornB = edyn::quaternion_identity;
+    ctx.threshold = 0.02;
+    auto result = edyn::collision_result{};
+    edyn::collide_gjk(box, sphere, ctx, result);
+    ASSERT_EQ(result.num_points, 1);
+    ASSERT_NEAR(result.point[0].distance, -0.1, 0.001);
+    ASSERT_NEAR(result.point[0].normal.x, -1, 0.001);
+    ASSERT_NEAR(result.point[0].pivotA.x, 0.5, 0.001);
+}
+
+TEST(test_collision, collide_gjk_sphere_sphere_penetrating) {
+    // Curved shapes make EPA expand the polytope until the tolerance or the
+    // maximum number of iterations is reached.
+    auto sphere = edyn::sphere_shape{0.5};
+    auto dir = edyn::normalize(edyn::vector3{0.3, 0.4, 0.2});
+    auto ctx = edyn::collision_context{};
+    ctx.posA = edyn::vector3{0, 0, 0};
+    ctx.ornA = edyn::quaternion_identity;
+    ctx.posB = dir * edyn::scalar(0.6);
+    ctx.ornB = edyn::quaternion_identity;
+    ctx.threshold = 0.02;
+    auto result = edyn::collision_result{};
+    edyn::collide_gjk(sphere, sphere, ctx, result);
+    ASSERT_EQ(result.num_points, 1);
+    ASSERT_NEAR(result.point[0].distance, -0.4, 0.01);
+    ASSERT_GT(edyn::dot(result.point[0].normal, -dir), 0.99);
+}
+
+TEST(test_collision, epa_polytope_capacity) {
+    auto support = [] (const edyn::vector3 &dir) {
+        auto point = edyn::normalize(dir);
+        return edyn::support_vertex{point, point, edyn::vector3_zero};
+    };
+
+    auto polytope = edyn::epa_polytope{};
+    ASSERT_TRUE(polytope.init({support({1, 1, 1}), support({-1, -1, 1}),
+                               support({-1, 1, -1}), support({1, -1, -1})}));
+
+    // Expand towards the closest face more times than there is room for.
+    size_t num_expansions = 0;
+
+    for (size_t i = 0; i < edyn::epa_max_iterations * 2; ++i) {
+        auto &face = polytope.faces[polytope.closest_face()];
+
+        if (!polytope.expand(support(face.normal))) {
+            break;
+        }
+
+        ++num_expansions;
+        ASSERT_LE(polytope.num_faces, edyn::epa_max_faces);
+    }
+
+    ASSERT_EQ(num_expansions, edyn::epa_max_iterations);
+    ASSERT_EQ(polytope.num_vertices, edyn::epa_max_vertices);
+    ASSERT_EQ(polytope.num_faces, edyn::epa_max_faces);
+}
+
+TEST(test_collision, swapped_pair_keeps_cache) {
+    constexpr size_t num_rows = 9, num_columns = 9;
+    auto heights = std::vector<edyn::scalar>(num_rows * num_columns, 0);
+    auto field = std::make_shared<edyn::heightfield>(num_rows, num_columns, 0.5, heights,
+                                                     edyn::vector3{-2, 0, -2});
+    auto heightfield = edyn::heightfield_shape{field};
+    auto box = edyn::box_shape{edyn::vector3{0.5, 0.5, 0.5}};
+
+    auto cache = edyn::collision_cache{};
+    auto ctx = edyn::collision_context{};
+    ctx.posA = edyn::vector3_zero;
+    ctx.ornA = edyn::quaternion_identity;
+    ctx.aabbA = field->get_aabb();
+    ctx.posB = edyn::vector3{0.1, 0.49, 0.2};
+    ctx.ornB = edyn::quaternion_identity;
+    ctx.aabbB = edyn::shape_aabb(box, ctx.posB, ctx.ornB);
+    ctx.threshold = 0.02;
+    ctx.cache = &cache;
+
+    // The heightfield-box pair is swapped, and box-mesh stores the pivots
+    // on the box selected in contact reduction.
+    auto result = edyn::collision_result{};
+    edyn::collide(heightfield, box, ctx, result);
+    ASSERT_EQ(result.num_points, 4);
+    ASSERT_EQ(cache.num_reduced_pivots, result.num_points);
+
+    for (size_t i = 0; i < result.num_points; ++i) {
+        ASSERT_VECTOR3_EQ(cache.reduced_pivots[i], result.point[i].pivotB);
+    }
+}
+
+// Creates a bumpy grid with `size * size` quads, split in two triangles each.
+static std::shared_ptr<edyn::triangle_mesh> make_bumpy_mesh(size_t size) {
+    auto vertices = std::vector<edyn::vector3>{};
+    auto indices = std::vector<uint32_t>{};
+
+    for (size_t i = 0; i <= size; ++i) {
+        for (size_t j = 0; j <= size; ++j) {
+            auto x = edyn::scalar(i), z = edyn::scalar(j);
+            vertices.push_back({x, edyn::scalar(0.3) * std::sin(x * edyn::scalar(0.7)) +
+                                   edyn::scalar(0.2) * std::cos(z * edyn::scalar(0.9)), z});
+        }
+    }
+
+    for (uint32_t i = 0; i < size; ++i) {
+        for (uint32_t j = 0; j < size; ++j) {
+            auto v00 = uint32_t(i * (size + 1) + j);
+            auto v01 = v00 + 1;
+            auto v10 = v00 + uint32_t(size + 1);
+            auto v11 = v10 + 1;
+            indices.insert(indices.end(), {v00, v01, v11});
+            indices.insert(indices.end(), {v00, v11, v10});
+        }
+    }
+
+    auto trimesh = std::make_shared<edyn::triangle_mesh>();
+    trimesh->insert_vertices(vertices.begin(), vertices.end());
+    trimesh->insert_indices(indices.begin(), indices.end());
+    trimesh->initialize();
+    return trimesh;
+}
+
+TEST(test_collision, triangle_batch_gather) {
+    auto trimesh = make_bumpy_mesh(16);
+    auto aabb = edyn::AABB{{2.5, -1, 3.2}, {6.1, 1, 5.7}};
+
+    auto batch = edyn::triangle_batch{};
+    batch.gather(*trimesh, aabb);
+
+    auto expected = std::set<uint32_t>{};
+    trimesh->visit_triangles(aabb, [&] (auto tri_idx) {
+        expected.insert(static_cast<uint32_t>(tri_idx));
+    });
+
+    ASSERT_FALSE(expected.empty());
+    ASSERT_EQ(batch.size(), expected.size());
+    ASSERT_EQ(std::set<uint32_t>(batch.indices.begin(), batch.indices.end()), expected);
+
+    // The coordinates in each array belong to the triangle at the same index.
+    for (size_t i = 0; i < batch.size(); ++i) {
+        auto tri_idx = batch.indices[i];
+        auto v0 = trimesh->get_vertex_position(trimesh->get_face_vertex_index(tri_idx, 0));
+        auto normal = trimesh->get_triangle_normal(tri_idx);
+        ASSERT_VECTOR3_EQ((edyn::vector3{batch.vx[i], batch.vy[i], batch.vz[i]}), v0);
+        ASSERT_VECTOR3_EQ((edyn::vector3{batch.nx[i], batch.ny[i], batch.nz[i]}), normal);
+    }
+
+    // Gathering again replaces the previous contents.
+    batch.gather(*trimesh, edyn::AABB{{-10, -10, -10}, {-9, -9, -9}});
+    ASSERT_EQ(batch.size(), 0);
+    ASSERT_TRUE(batch.vx.empty() && batch.nz.empty());
+}
+
+TEST(test_collision, triangle_batch_cull) {
+    auto trimesh = make_bumpy_mesh(16);
+    auto center = edyn::vector3{8.3, 1.6, 7.6};
+    auto radius = edyn::scalar(1.5);
+    auto threshold = edyn::scalar(0.02);
+    auto aabb = edyn::AABB{center - edyn::vector3_one * radius, center + edyn::vector3_one * radius};
+
+    auto batch = edyn::triangle_batch{};
+    batch.gather(*trimesh, aabb);
+    auto gathered = batch.indices;
+
+    batch.cull([&] (const edyn::vector3 &dir) {
+        return edyn::dot(center, dir) + radius;
+    }, threshold);
+
+    // Triangles are kept if the sphere is not further than the threshold
+    // in front of their plane, in the order they were gathered.
+    auto expected = std::vector<uint32_t>{};
+
+    for (auto tri_idx : gathered) {
+        auto v0 = trimesh->get_vertex_position(trimesh->get_face_vertex_index(tri_idx, 0));
+        auto normal = trimesh->get_triangle_normal(tri_idx);
+        auto distance = edyn::dot(center - v0, normal) - radius;
+
+        if (distance <= threshold) {
+            expected.push_back(tri_idx);
+        }
+    }
+
+    ASSERT_LT(expected.size(), gathered.size());
+    ASSERT_FALSE(expected.empty());
+    ASSERT_EQ(batch.indices, expected);
+    ASSERT_EQ(batch.vx.size(), batch.size());
+    ASSERT_EQ(batch.nz.size(), batch.size());
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        auto normal = trimesh->get_triangle_normal(batch.indices[i]);
+        ASSERT_VECTOR3_EQ((edyn::vector3{batch.nx[i], batch.ny[i], batch.nz[i]}), normal);
+    }
+}
+
+TEST(test_collision, collide_sphere_mesh_culled) {
+    // Culled triangles do not affect the contact on a flat mesh.
+    auto vertices = std::vector<edyn::vector3>{};
+    auto indices = std::vector<uint32_t>{};
+    edyn::make_plane_mesh(8, 8, 9, 9, vertices, indices);
+
+    auto trimesh = edyn::triangle_mesh{};
+    trimesh.insert_vertices(vertices.begin(), vertices.end());
+    trimesh.insert_indices(indices.begin(), indices.end());
+    trimesh.initialize();
+
+    auto sphere = edyn::sphere_shape{0.5};
+    auto ctx = edyn::collision_context{};
+    ctx.posA = {0.3, 0.45, -0.2};
+    ctx.ornA = edyn::quaternion_identity;
+    ctx.posB = edyn::vector3_zero;
+    ctx.ornB = edyn::quaternion_identity;
+    ctx.aabbA = edyn::shape_aabb(sphere, ctx.posA, ctx.ornA);
+    ctx.threshold = edyn::contact_breaking_threshold;
+
+    auto result = edyn::collision_result{};
+    edyn::collide(sphere, trimesh, ctx, result);
+    ASSERT_GT(result.num_points, 0);
+
+    for (size_t i = 0; i < result.num_points; ++i) {
+        ASSERT_SCALAR_EQ(result.point[i].distance, -0.05);
+        ASSERT_VECTOR3_EQ(result.point[i].normal, edyn::vector3_y);
+    }
+}
@@ -0,0 +1,114 @@
+#include "../common/common.hpp"
+
+#include <vector>
+
+// Creates a manifold between two new bodies and returns its entity.
+static entt::entity make_manifold(entt::registry &registry, entt::entity body0, entt::entity body1) {
+    auto manifold = edyn::contact_manifold{};
+    manifold.body = {body0, body1};
+    auto entity = registry.create();
+    registry.emplace<edyn::contact_manifold>(entity, manifold);
+    return entity;
+}
+
+TEST(test_contact_manifold_map, insert) {
+    auto registry = entt::registry{};
+    auto map = edyn::contact_manifold_map(registry);
+
+    auto body0 = registry.create();
+    auto body1 = registry.create();
+    auto body2 = registry.create();
+    ASSERT_FALSE(map.contains(body0, body1));
+
+    auto manifold = make_manifold(registry, body1, body0);
+
+    // The order of the entities does not matter.
+    ASSERT_TRUE(map.contains(body0, body1));
+    ASSERT_TRUE(map.contains(body1, body0));
+    ASSERT_TRUE(map.contains(edyn::entity_pair{body0, body1}));
+    ASSERT_EQ(map.get(body0, body1), manifold);
+    ASSERT_EQ(map.get(body1, body0), manifold);
+
+    ASSERT_FALSE(map.contains(body0, body2));
+    ASSERT_FALSE(map.contains(body1, body2));
+}
+
+TEST(test_contact_manifold_map, erase) {
+    auto registry = entt::registry{};
+    auto map = edyn::contact_manifold_map(registry);
+
+    // Pairs sharing the same body, which are likely to end up in the same
+    // cluster of slots.
+    auto hub = registry.create();
+    auto bodies = std::vector<entt::entity>{};
+    auto manifolds = std::vector<entt::entity>{};
+
+    for (size_t i = 0; i < 40; ++i) {
+        bodies.push_back(registry.create());
+        manifolds.push_back(make_manifold(registry, hub, bodies.back()));
+    }
+
+    // Erase every other manifold. The remaining ones must still be found,
+    // which requires the entries after each erased slot to be shifted back.
+    for (size_t i = 0; i < bodies.size(); i += 2) {
+        registry.destroy(manifolds[i]);
+    }
+
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        if (i % 2 == 0) {
+            ASSERT_FALSE(map.contains(hub, bodies[i]));
+        } else {
+            ASSERT_TRUE(map.contains(hub, bodies[i]));
+            ASSERT_EQ(map.get(bodies[i], hub), manifolds[i]);
+        }
+    }
+
+    // Erased pairs can be inserted again.
+    for (size_t i = 0; i < bodies.size(); i += 2) {
+        manifolds[i] = make_manifold(registry, bodies[i], hub);
+    }
+
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        ASSERT_EQ(map.get(hub, bodies[i]), manifolds[i]);
+    }
+}
+
+TEST(test_contact_manifold_map, rehash) {
+    auto registry = entt::registry{};
+    auto map = edyn::contact_manifold_map(registry);
+
+    // Far more pairs than the initial capacity, which makes the table grow
+    // several times.
+    constexpr size_t num_bodies = 64;
+    auto bodies = std::vector<entt::entity>(num_bodies);
+    registry.create(bodies.begin(), bodies.end());
+
+    auto manifolds = std::vector<entt::entity>{};
+
+    for (size_t i = 0; i < num_bodies; ++i) {
+        for (size_t j = i + 1; j < num_bodies; j += 3) {
+            manifolds.push_back(make_manifold(registry, bodies[i], bodies[j]));
+        }
+    }
+
+    ASSERT_GT(manifolds.size(), 512);
+
+    for (auto entity : manifolds) {
+        auto &manifold = registry.get<edyn::contact_manifold>(entity);
+        ASSERT_EQ(map.get(manifold.body[0], manifold.body[1]), entity);
+    }
+
+    // Pairs which were never inserted.
+    for (size_t i = 0; i < num_bodies; ++i) {
+        for (size_t j = i + 2; j < num_bodies; j += 3) {
+            ASSERT_FALSE(map.contains(bodies[i], bodies[j]));
+        }
+    }
+
+    // Empty the table.
+    for (auto entity : manifolds) {
+        auto manifold = registry.get<edyn::contact_manifold>(entity);
+        registry.destroy(entity);
+        ASSERT_FALSE(map.contains(manifold.body[0], manifold.body[1]));
+    }
+}
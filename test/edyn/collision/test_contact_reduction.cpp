@@ -0,0 +1,119 @@
+#include "../common/common.hpp"
+#include <edyn/collision/contact_reduction.hpp>
+#include <edyn/collision/collision_cache.hpp>
+
+#include <random>
+#include <vector>
+#include <algorithm>
+
+using collision_point = edyn::collision_result::collision_point;
+
+static collision_point make_point(edyn::scalar x, edyn::scalar z, edyn::scalar distance) {
+    auto pivot = edyn::vector3{x, 0, z};
+    return {pivot, pivot, edyn::vector3_y, distance, edyn::contact_normal_attachment::none};
+}
+
+// Pivots of the points in a result, sorted.
+static std::vector<std::array<edyn::scalar, 3>> sorted_pivots(const edyn::collision_result &result) {
+    auto pivots = std::vector<std::array<edyn::scalar, 3>>{};
+
+    for (size_t i = 0; i < result.num_points; ++i) {
+        auto &p = result.point[i].pivotA;
+        pivots.push_back({p.x, p.y, p.z});
+    }
+
+    std::sort(pivots.begin(), pivots.end());
+    return pivots;
+}
+
+TEST(test_contact_reduction, few_candidates) {
+    auto candidates = std::vector<collision_point>{make_point(0, 0, -0.01), make_point(1, 0, 0.01)};
+    auto result = edyn::collision_result{};
+    result.add_point(make_point(0, 1, 0));
+
+    edyn::reduce_contact_points(candidates, result, nullptr);
+    ASSERT_EQ(result.num_points, 3);
+}
+
+TEST(test_contact_reduction, order_independent) {
+    auto rng = std::mt19937(7);
+    auto pos_dist = std::uniform_real_distribution<edyn::scalar>(-1, 1);
+    auto depth_dist = std::uniform_real_distribution<edyn::scalar>(-0.02, 0);
+    auto points = std::vector<collision_point>{};
+
+    for (size_t i = 0; i < 300; ++i) {
+        points.push_back(make_point(pos_dist(rng), pos_dist(rng), depth_dist(rng)));
+    }
+
+    auto deepest = std::min_element(points.begin(), points.end(), [] (auto &lhs, auto &rhs) {
+        return lhs.distance < rhs.distance;
+    });
+
+    auto reduce = [] (std::vector<collision_point> candidates) {
+        auto result = edyn::collision_result{};
+        edyn::reduce_contact_points(candidates, result, nullptr);
+        return result;
+    };
+
+    auto result = reduce(points);
+    ASSERT_EQ(result.num_points, edyn::max_contacts);
+    ASSERT_EQ(result.point[0].pivotA, deepest->pivotA);
+
+    for (size_t i = 0; i < 5; ++i) {
+        std::shuffle(points.begin(), points.end(), rng);
+        ASSERT_EQ(sorted_pivots(reduce(points)), sorted_pivots(result));
+    }
+}
+
+TEST(test_contact_reduction, prefers_previous_points) {
+    // Two nearly equivalent rectangles. The outer one is slightly deeper and
+    // larger, thus it is selected unless the inner one was selected before.
+    // Their points are further apart than the caching threshold.
+    auto candidates = std::vector<collision_point>{};
+
+    for (auto x : {-1, 1}) {
+        for (auto z : {-1, 1}) {
+            candidates.push_back(make_point(x, z, -0.010));
+            candidates.push_back(make_point(x * 1.045, z, -0.011));
+        }
+    }
+
+    auto is_outer = [] (const collision_point &pt) {
+        return std::abs(pt.pivotA.x) > 1;
+    };
+
+    auto cache = edyn::collision_cache{};
+    auto result = edyn::collision_result{};
+    auto scratch = candidates;
+    edyn::reduce_contact_points(scratch, result, &cache);
+    ASSERT_EQ(result.num_points, edyn::max_contacts);
+
+    for (size_t i = 0; i < result.num_points; ++i) {
+        ASSERT_TRUE(is_outer(result.point[i]));
+    }
+
+    // The selection is stored in the cache.
+    ASSERT_EQ(cache.num_reduced_pivots, result.num_points);
+
+    for (size_t i = 0; i < result.num_points; ++i) {
+        ASSERT_EQ(cache.reduced_pivots[i], result.point[i].pivotA);
+    }
+
+    // Select the inner square in the previous step.
+    cache.num_reduced_pivots = 0;
+
+    for (auto &pt : candidates) {
+        if (!is_outer(pt)) {
+            cache.reduced_pivots[cache.num_reduced_pivots++] = pt.pivotA;
+        }
+    }
+
+    result = edyn::collision_result{};
+    scratch = candidates;
+    edyn::reduce_contact_points(scratch, result, &cache);
+    ASSERT_EQ(result.num_points, edyn::max_contacts);
+
+    for (size_t i = 0; i < result.num_points; ++i) {
+        ASSERT_FALSE(is_outer(result.point[i]));
+    }
+}
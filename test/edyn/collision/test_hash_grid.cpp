@@ -0,0 +1,72 @@
+#include "../common/common.hpp"
+#include <edyn/collision/hash_grid.hpp>
+
+#include <set>
+#include <random>
+
+TEST(test_hash_grid, same_pairs_as_brute_force) {
+    edyn::init();
+
+    std::mt19937 rng(1337);
+    std::uniform_real_distribution<edyn::scalar> pos_dist(-10, 10);
+    std::uniform_real_distribution<edyn::scalar> size_dist(0.2, 0.6);
+    std::vector<edyn::AABB> aabbs;
+
+    for (auto i = 0; i < 1000; ++i) {
+        auto center = edyn::vector3{pos_dist(rng), pos_dist(rng), pos_dist(rng)};
+        auto half_size = edyn::vector3_one * size_dist(rng);
+        aabbs.push_back({center - half_size, center + half_size});
+    }
+
+    // Add a few large ones which should not go into the grid.
+    aabbs.push_back({edyn::vector3{-8, -8, -8}, edyn::vector3{-2, -2, -2}});
+    aabbs.push_back({edyn::vector3{-20, -1, -1}, edyn::vector3{20, 1, 1}});
+
+    edyn::hash_grid grid;
+    grid.build(aabbs);
+
+    ASSERT_EQ(grid.large_elements().size(), 2);
+
+    std::set<std::pair<size_t, size_t>> grid_pairs;
+    grid.each_pair(aabbs, [&] (auto idxA, auto idxB) {
+        auto pair = std::make_pair(std::min<size_t>(idxA, idxB), std::max<size_t>(idxA, idxB));
+        // Each pair must be reported only once.
+        ASSERT_EQ(grid_pairs.count(pair), 0);
+        grid_pairs.insert(pair);
+    });
+
+    std::set<std::pair<size_t, size_t>> brute_force_pairs;
+    auto &large = grid.large_elements();
+
+    for (size_t i = 0; i < aabbs.size(); ++i) {
+        if (std::find(large.begin(), large.end(), i) != large.end()) continue;
+
+        for (size_t j = i + 1; j < aabbs.size(); ++j) {
+            if (std::find(large.begin(), large.end(), j) != large.end()) continue;
+
+            if (edyn::intersect(aabbs[i], aabbs[j])) {
+                brute_force_pairs.emplace(i, j);
+            }
+        }
+    }
+
+    ASSERT_EQ(grid_pairs, brute_force_pairs);
+
+    // Querying the pairs of each element finds the same pairs.
+    std::set<std::pair<size_t, size_t>> element_pairs;
+
+    for (edyn::hash_grid::index_type i = 0; i < aabbs.size(); ++i) {
+        ASSERT_EQ(grid.is_large(i), std::find(large.begin(), large.end(), i) != large.end());
+
+        grid.each_pair_of(i, aabbs, [&] (auto idxA, auto idxB) {
+            ASSERT_EQ(idxA, i);
+            ASSERT_GT(idxB, idxA);
+            ASSERT_EQ(element_pairs.count({idxA, idxB}), 0);
+            element_pairs.emplace(idxA, idxB);
+        });
+    }
+
+    ASSERT_EQ(element_pairs, brute_force_pairs);
+
+    edyn::deinit();
+}
@@ -0,0 +1,212 @@
+#include "../common/common.hpp"
+#include <edyn/collision/static_tree.hpp>
+
+#include <set>
+#include <random>
+#include <algorithm>
+#include <vector>
+#include <utility>
+
+// Creates a dynamic tree with boxes scattered in a cube and returns the box
+// of each leaf.
+static std::vector<edyn::AABB> make_random_tree(edyn::dynamic_tree &tree, size_t count, unsigned seed) {
+    auto rng = std::mt19937(seed);
+    auto pos_dist = std::uniform_real_distribution<edyn::scalar>(-20, 20);
+    auto size_dist = std::uniform_real_distribution<edyn::scalar>(0.1, 2);
+    auto boxes = std::vector<edyn::AABB>{};
+
+    for (size_t i = 0; i < count; ++i) {
+        auto min = edyn::vector3{pos_dist(rng), pos_dist(rng), pos_dist(rng)};
+        auto max = min + edyn::vector3{size_dist(rng), size_dist(rng), size_dist(rng)};
+        boxes.push_back({min, max});
+        tree.create(boxes.back(), entt::entity(i));
+    }
+
+    return boxes;
+}
+
+static std::vector<edyn::AABB> make_random_queries(size_t count, unsigned seed) {
+    auto rng = std::mt19937(seed);
+    auto pos_dist = std::uniform_real_distribution<edyn::scalar>(-22, 22);
+    auto size_dist = std::uniform_real_distribution<edyn::scalar>(0.5, 8);
+    auto queries = std::vector<edyn::AABB>{};
+
+    for (size_t i = 0; i < count; ++i) {
+        auto min = edyn::vector3{pos_dist(rng), pos_dist(rng), pos_dist(rng)};
+        queries.push_back({min, min + edyn::vector3{size_dist(rng), size_dist(rng), size_dist(rng)}});
+    }
+
+    return queries;
+}
+
+// Pairs of entity and query index found by querying one AABB at a time.
+static std::set<std::pair<entt::entity, size_t>> query_one_by_one(const edyn::dynamic_tree &tree,
+                                                                 const std::vector<edyn::AABB> &queries) {
+    auto pairs = std::set<std::pair<entt::entity, size_t>>{};
+
+    for (size_t i = 0; i < queries.size(); ++i) {
+        tree.query(queries[i], [&] (edyn::tree_node_id_t id) {
+            pairs.emplace(tree.get_node(id).entity, i);
+        });
+    }
+
+    return pairs;
+}
+
+TEST(test_query_tree, packet_matches_single_queries) {
+    auto tree = edyn::dynamic_tree{};
+    make_random_tree(tree, 500, 1);
+
+    for (size_t num_queries : {size_t{1}, size_t{17}, edyn::max_tree_packet_size}) {
+        auto queries = make_random_queries(num_queries, unsigned(num_queries));
+        auto pairs = std::set<std::pair<entt::entity, size_t>>{};
+        auto num_visits = size_t{0};
+
+        tree.traverse_packet(queries.size(), [&] (const edyn::tree_node &node, size_t i) {
+            return edyn::intersect(node.aabb, queries[i]);
+        }, [&] (edyn::tree_node_id_t id, size_t i) {
+            pairs.emplace(tree.get_node(id).entity, i);
+            ++num_visits;
+        });
+
+        // Each leaf is visited at most once per query.
+        ASSERT_EQ(num_visits, pairs.size());
+        ASSERT_EQ(pairs, query_one_by_one(tree, queries));
+    }
+}
+
+TEST(test_query_tree, packet_queries_leave_early) {
+    auto tree = edyn::dynamic_tree{};
+    make_random_tree(tree, 200, 2);
+
+    // Queries which stop being tested once they hit something, which is how
+    // rays in `any_hit` mode are terminated.
+    auto queries = make_random_queries(32, 3);
+    auto done = std::vector<bool>(queries.size(), false);
+    auto num_hits = std::vector<size_t>(queries.size(), 0);
+
+    tree.traverse_packet(queries.size(), [&] (const edyn::tree_node &node, size_t i) {
+        return !done[i] && edyn::intersect(node.aabb, queries[i]);
+    }, [&] (edyn::tree_node_id_t, size_t i) {
+        done[i] = true;
+        ++num_hits[i];
+    });
+
+    auto pairs = query_one_by_one(tree, queries);
+
+    for (size_t i = 0; i < queries.size(); ++i) {
+        auto hit = std::any_of(pairs.begin(), pairs.end(), [i] (auto &pair) { return pair.second == i; });
+        ASSERT_EQ(num_hits[i], hit ? 1 : 0);
+    }
+}
+
+// A tree where each internal node has a leaf as its first child, i.e. a
+// linked list, which is deeper than the inline capacity of the traversal
+// stack.
+struct chain_tree {
+    struct node {
+        edyn::AABB aabb;
+        size_t child1;
+        size_t child2;
+
+        bool leaf() const {
+            return child1 == null_id;
+        }
+    };
+
+    static constexpr size_t null_id = SIZE_MAX;
+
+    std::vector<node> nodes;
+
+    chain_tree(size_t num_leaves) {
+        auto aabb = edyn::AABB{edyn::vector3_zero, edyn::vector3_one};
+
+        for (size_t i = 0; i + 1 < num_leaves; ++i) {
+            nodes.push_back({aabb, nodes.size() + 1, nodes.size() + 2});
+            nodes.push_back({aabb, null_id, null_id});
+        }
+
+        nodes.push_back({aabb, null_id, null_id});
+    }
+
+    const node & get_node(size_t id) const {
+        return nodes[id];
+    }
+};
+
+TEST(test_query_tree, deep_tree_packet) {
+    constexpr size_t num_leaves = 300;
+    auto tree = chain_tree(num_leaves);
+    auto visits = std::set<std::pair<size_t, size_t>>{};
+
+    edyn::traverse_tree_packet(tree, size_t{0}, chain_tree::null_id, 3, [] (auto &, size_t i) {
+        return i != 1;
+    }, [&] (size_t id, size_t i) {
+        ASSERT_TRUE(visits.emplace(id, i).second);
+    });
+
+    ASSERT_EQ(visits.size(), num_leaves * 2);
+}
+
+// Builds a static tree with the given boxes, where the id of each leaf is the
+// index of its box.
+static edyn::static_tree make_static_tree(const std::vector<edyn::AABB> &boxes) {
+    auto report_leaf = [] (edyn::static_tree::tree_node &node, auto ids_begin, auto) {
+        node.id = *ids_begin;
+    };
+
+    auto tree = edyn::static_tree{};
+    tree.build(boxes.begin(), boxes.end(), report_leaf);
+    return tree;
+}
+
+TEST(test_query_tree, pair_matches_brute_force) {
+    auto boxesA = make_random_queries(300, 4);
+    auto boxesB = make_random_queries(200, 5);
+    auto treeA = make_static_tree(boxesA);
+    auto treeB = make_static_tree(boxesB);
+    auto pairs = std::set<std::pair<uint32_t, uint32_t>>{};
+
+    // The boxes of the nodes are conservative, thus the exact boxes are
+    // tested when both nodes are leaves.
+    edyn::traverse_tree_pair(treeA, uint32_t{0}, treeB, uint32_t{0}, edyn::EDYN_NULL_NODE,
+                             [&] (auto &nodeA, auto &nodeB) {
+        if (nodeA.leaf() && nodeB.leaf()) {
+            return edyn::intersect(boxesA[nodeA.id], boxesB[nodeB.id]);
+        }
+
+        return edyn::intersect(nodeA.aabb, nodeB.aabb);
+    }, [&] (uint32_t idA, uint32_t idB) {
+        ASSERT_TRUE(pairs.emplace(treeA.get_node(idA).id, treeB.get_node(idB).id).second);
+    });
+
+    auto expected = std::set<std::pair<uint32_t, uint32_t>>{};
+
+    for (uint32_t i = 0; i < boxesA.size(); ++i) {
+        for (uint32_t j = 0; j < boxesB.size(); ++j) {
+            if (edyn::intersect(boxesA[i], boxesB[j])) {
+                expected.emplace(i, j);
+            }
+        }
+    }
+
+    ASSERT_FALSE(expected.empty());
+    ASSERT_EQ(pairs, expected);
+}
+
+TEST(test_query_tree, deep_tree_pair) {
+    // The pending pairs of two chains exceed the inline capacity of the
+    // traversal stack.
+    constexpr size_t num_leaves = 100;
+    auto treeA = chain_tree(num_leaves);
+    auto treeB = chain_tree(num_leaves);
+    auto visits = std::set<std::pair<size_t, size_t>>{};
+
+    edyn::traverse_tree_pair(treeA, size_t{0}, treeB, size_t{0}, chain_tree::null_id,
+                             [] (auto &, auto &) { return true; },
+                             [&] (size_t idA, size_t idB) {
+        ASSERT_TRUE(visits.emplace(idA, idB).second);
+    });
+
+    ASSERT_EQ(visits.size(), num_leaves * num_leaves);
+}
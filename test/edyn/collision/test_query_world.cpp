@@ -0,0 +1,324 @@
+#include "../common/common.hpp"
+
+#include <random>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+// Creates static bodies of a few shape types with random orientations,
+// alternating between two collision groups.
+static void make_static_bodies(entt::registry &registry, std::mt19937 &rng) {
+    std::uniform_real_distribution<edyn::scalar> angle_dist(0, edyn::pi2);
+    auto def = edyn::rigidbody_def{};
+    def.kind = edyn::rigidbody_kind::rb_static;
+    auto index = 0;
+
+    for (auto x = 0; x < 5; ++x) {
+        for (auto y = 0; y < 3; ++y) {
+            for (auto z = 0; z < 5; ++z) {
+                switch (index % 3) {
+                case 0:
+                    def.shape = edyn::box_shape{0.4, 0.3, 0.5};
+                    break;
+                case 1:
+                    def.shape = edyn::sphere_shape{0.45};
+                    break;
+                case 2:
+                    def.shape = edyn::cylinder_shape{0.3, 0.4};
+                    break;
+                }
+
+                def.position = edyn::vector3{edyn::scalar(x * 2), edyn::scalar(y * 2), edyn::scalar(z * 2)};
+                def.orientation = edyn::quaternion_axis_angle(edyn::vector3_y, angle_dist(rng));
+                def.collision_group = index % 2 == 0 ? 0x1 : 0x2;
+                edyn::make_rigidbody(registry, def);
+                ++index;
+            }
+        }
+    }
+}
+
+static edyn::collision_filter random_filter(std::mt19937 &rng) {
+    auto filter = edyn::collision_filter{};
+
+    switch (std::uniform_int_distribution<int>(0, 2)(rng)) {
+    case 1:
+        filter.mask = 0x1;
+        break;
+    case 2:
+        filter.mask = 0x2;
+        break;
+    }
+
+    return filter;
+}
+
+TEST(test_query_world, same_results_as_registry) {
+    entt::registry registry;
+    edyn::init();
+    edyn::attach(registry);
+
+    std::mt19937 rng(1337);
+    std::uniform_real_distribution<edyn::scalar> pos_dist(-1, 9);
+    make_static_bodies(registry, rng);
+
+    auto buffer = edyn::query_world_buffer(registry);
+    buffer.publish();
+    auto world = buffer.acquire();
+    ASSERT_NE(world, nullptr);
+
+    // Raycasts.
+    std::vector<edyn::raycast_query> ray_queries;
+
+    for (auto i = 0; i < 200; ++i) {
+        auto p0 = edyn::vector3{pos_dist(rng), pos_dist(rng), pos_dist(rng)};
+        auto p1 = edyn::vector3{pos_dist(rng), pos_dist(rng), pos_dist(rng)};
+        ray_queries.push_back({p0, p1, random_filter(rng)});
+    }
+
+    std::vector<edyn::raycast_result> ray_results, world_ray_results;
+    edyn::raycast_batch(registry, ray_queries, ray_results);
+    world->raycast_batch(ray_queries, world_ray_results);
+    ASSERT_EQ(world_ray_results.size(), ray_queries.size());
+    auto num_ray_hits = 0;
+
+    for (size_t i = 0; i < ray_queries.size(); ++i) {
+        auto &query = ray_queries[i];
+        auto result = world->raycast(query.p0, query.p1, query.filter);
+        ASSERT_EQ(result.entity, ray_results[i].entity);
+        ASSERT_EQ(world_ray_results[i].entity, ray_results[i].entity);
+
+        if (result.entity != entt::null) {
+            ASSERT_SCALAR_EQ(result.fraction, ray_results[i].fraction);
+            ASSERT_VECTOR3_EQ(result.normal, ray_results[i].normal);
+            ASSERT_SCALAR_EQ(world_ray_results[i].fraction, ray_results[i].fraction);
+            ++num_ray_hits;
+        }
+    }
+
+    ASSERT_GT(num_ray_hits, 0);
+
+    // Overlaps and shape casts.
+    auto num_overlaps = 0;
+    auto num_cast_hits = 0;
+
+    for (auto i = 0; i < 100; ++i) {
+        auto orn = edyn::quaternion_axis_angle(edyn::vector3_x, pos_dist(rng));
+        auto shape = i % 2 == 0 ?
+            edyn::query_shape_variant_t{edyn::box_shape{0.3, 0.2, 0.4}} :
+            edyn::query_shape_variant_t{edyn::sphere_shape{0.5}};
+        auto filter = random_filter(rng);
+        auto p0 = edyn::vector3{pos_dist(rng), pos_dist(rng), pos_dist(rng)};
+        auto p1 = edyn::vector3{pos_dist(rng), pos_dist(rng), pos_dist(rng)};
+
+        auto overlap_query = edyn::overlap_query{shape, p0, orn, filter};
+        std::vector<entt::entity> world_entities, registry_entities;
+        world->overlap(overlap_query, world_entities);
+        edyn::overlap(registry, overlap_query, registry_entities);
+        std::sort(world_entities.begin(), world_entities.end());
+        std::sort(registry_entities.begin(), registry_entities.end());
+        ASSERT_EQ(world_entities, registry_entities);
+        num_overlaps += world_entities.size();
+
+        auto cast_query = edyn::shape_cast_query{shape, p0, p1, orn, filter};
+        auto world_result = world->shape_cast(cast_query);
+        auto registry_result = edyn::shape_cast(registry, cast_query);
+        ASSERT_EQ(world_result.entity, registry_result.entity);
+
+        if (world_result.entity != entt::null) {
+            ASSERT_SCALAR_EQ(world_result.fraction, registry_result.fraction);
+            ASSERT_VECTOR3_EQ(world_result.normal, registry_result.normal);
+            ++num_cast_hits;
+        }
+    }
+
+    ASSERT_GT(num_overlaps, 0);
+    ASSERT_GT(num_cast_hits, 0);
+
+    edyn::detach(registry);
+    edyn::deinit();
+}
+
+TEST(test_query_world, publish_does_not_reuse_held_world) {
+    entt::registry registry;
+    edyn::init();
+    edyn::attach(registry);
+
+    auto def = edyn::rigidbody_def{};
+    def.kind = edyn::rigidbody_kind::rb_static;
+    def.shape = edyn::box_shape{0.5, 0.5, 0.5};
+    auto first_box = edyn::make_rigidbody(registry, def);
+
+    auto buffer = edyn::query_world_buffer(registry);
+    ASSERT_EQ(buffer.acquire(), nullptr);
+
+    buffer.publish();
+    auto held = buffer.acquire();
+
+    buffer.publish();
+    auto *second = buffer.acquire().get();
+    ASSERT_NE(second, held.get());
+
+    // A body created after the held world was published.
+    def.position = edyn::vector3{3, 0, 0};
+    auto second_box = edyn::make_rigidbody(registry, def);
+
+    // The held world is in the back, thus a new one must be allocated.
+    buffer.publish();
+    auto third = buffer.acquire();
+    ASSERT_NE(third.get(), held.get());
+    ASSERT_NE(third.get(), second);
+
+    // The held world was not modified.
+    auto p0 = edyn::vector3{5, 0, 0};
+    auto p1 = edyn::vector3{-5, 0, 0};
+    ASSERT_EQ(held->raycast(p0, p1).entity, first_box);
+    ASSERT_EQ(third->raycast(p0, p1).entity, second_box);
+
+    // Worlds which are not held are reused.
+    held.reset();
+    third.reset();
+    buffer.publish();
+    ASSERT_EQ(buffer.acquire().get(), second);
+    ASSERT_EQ(buffer.acquire()->raycast(p0, p1).entity, second_box);
+
+    edyn::detach(registry);
+    edyn::deinit();
+}
+
+TEST(test_query_world, held_world_valid_after_disable_and_detach) {
+    edyn::init();
+
+    auto p0 = edyn::vector3{0, 5, 0};
+    auto p1 = edyn::vector3{0, -5, 0};
+    auto box = entt::entity{entt::null};
+    auto world = std::shared_ptr<const edyn::query_world>{};
+    auto other_world = std::shared_ptr<const edyn::query_world>{};
+
+    {
+        entt::registry registry;
+        edyn::attach(registry);
+
+        auto def = edyn::rigidbody_def{};
+        def.kind = edyn::rigidbody_kind::rb_static;
+        def.shape = edyn::box_shape{0.5, 0.5, 0.5};
+        box = edyn::make_rigidbody(registry, def);
+
+        ASSERT_EQ(edyn::get_query_world(registry), nullptr);
+        edyn::enable_query_world(registry);
+        edyn::update(registry);
+
+        world = edyn::get_query_world(registry);
+        ASSERT_NE(world, nullptr);
+
+        edyn::disable_query_world(registry);
+        ASSERT_EQ(edyn::get_query_world(registry), nullptr);
+
+        auto result = world->raycast(p0, p1);
+        ASSERT_EQ(result.entity, box);
+        ASSERT_NEAR(result.fraction, 0.45, 0.001);
+
+        edyn::enable_query_world(registry);
+        edyn::update(registry);
+        other_world = edyn::get_query_world(registry);
+        ASSERT_NE(other_world, nullptr);
+        ASSERT_NE(other_world, world);
+
+        edyn::detach(registry);
+        ASSERT_EQ(edyn::get_query_world(registry), nullptr);
+    }
+
+    // Neither world references the registry nor the buffer, which are gone.
+    ASSERT_EQ(world->raycast(p0, p1).entity, box);
+    ASSERT_EQ(other_world->raycast(p0, p1).entity, box);
+
+    std::vector<entt::entity> entities;
+    auto query = edyn::overlap_query{edyn::sphere_shape{0.5}, edyn::vector3_zero, edyn::quaternion_identity};
+    other_world->overlap(query, entities);
+    ASSERT_EQ(entities.size(), 1);
+    ASSERT_EQ(entities[0], box);
+
+    edyn::deinit();
+}
+
+TEST(test_query_world, modified_shape_copied_again) {
+    entt::registry registry;
+    edyn::init();
+    edyn::attach(registry);
+
+    auto def = edyn::rigidbody_def{};
+    def.kind = edyn::rigidbody_kind::rb_static;
+    def.shape = edyn::box_shape{0.5, 0.5, 0.5};
+    auto box = edyn::make_rigidbody(registry, def);
+
+    auto buffer = edyn::query_world_buffer(registry);
+    buffer.publish();
+    auto held = buffer.acquire();
+
+    auto p0 = edyn::vector3{0, 5, 0};
+    auto p1 = edyn::vector3{0, -5, 0};
+    ASSERT_NEAR(held->raycast(p0, p1).fraction, 0.45, 0.001);
+
+    registry.replace<edyn::box_shape>(box, edyn::box_shape{1, 1, 1});
+    buffer.publish();
+    auto world = buffer.acquire();
+
+    // The held world keeps the shape it was published with.
+    ASSERT_NEAR(held->raycast(p0, p1).fraction, 0.45, 0.001);
+    ASSERT_NEAR(world->raycast(p0, p1).fraction, 0.4, 0.001);
+
+    // Unmodified shapes are not copied again.
+    held.reset();
+    world.reset();
+    buffer.publish();
+    ASSERT_NEAR(buffer.acquire()->raycast(p0, p1).fraction, 0.4, 0.001);
+
+    edyn::detach(registry);
+    edyn::deinit();
+}
+
+TEST(test_query_world, source_used_from_other_thread) {
+    entt::registry registry;
+    edyn::init();
+    edyn::attach(registry);
+
+    auto def = edyn::rigidbody_def{};
+    def.kind = edyn::rigidbody_kind::rb_static;
+    def.shape = edyn::box_shape{0.5, 0.5, 0.5};
+    auto box = edyn::make_rigidbody(registry, def);
+
+    auto source = edyn::enable_query_world(registry);
+    ASSERT_EQ(source, edyn::enable_query_world(registry));
+    ASSERT_EQ(source->acquire(), nullptr);
+    edyn::update(registry);
+
+    // The reader never touches the registry, thus it can keep querying while
+    // the query world is disabled.
+    std::atomic<bool> stop {false};
+    std::atomic<int> num_hits {0};
+    auto reader = std::thread([&] {
+        while (!stop) {
+            auto world = source->acquire();
+
+            if (world->raycast({0, 5, 0}, {0, -5, 0}).entity == box) {
+                ++num_hits;
+            }
+        }
+    });
+
+    for (auto i = 0; i < 20; ++i) {
+        edyn::update(registry);
+    }
+
+    edyn::disable_query_world(registry);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    stop = true;
+    reader.join();
+
+    ASSERT_GT(num_hits.load(), 0);
+    ASSERT_NE(source->acquire(), nullptr);
+
+    edyn::detach(registry);
+    edyn::deinit();
+}
@@ -0,0 +1,158 @@
+#include "../common/common.hpp"
+
+#include <random>
+
+// Creates a grid of static boxes with random orientations, alternating
+// between two collision groups.
+static std::vector<entt::entity> make_box_grid(entt::registry &registry, std::mt19937 &rng) {
+    std::uniform_real_distribution<edyn::scalar> angle_dist(0, edyn::pi2);
+    std::vector<entt::entity> entities;
+
+    auto def = edyn::rigidbody_def{};
+    def.kind = edyn::rigidbody_kind::rb_static;
+    def.shape = edyn::box_shape{0.4, 0.3, 0.5};
+
+    for (auto x = 0; x < 6; ++x) {
+        for (auto y = 0; y < 6; ++y) {
+            for (auto z = 0; z < 6; ++z) {
+                def.position = edyn::vector3{edyn::scalar(x * 2), edyn::scalar(y * 2), edyn::scalar(z * 2)};
+                def.orientation = edyn::quaternion_axis_angle(edyn::vector3_y, angle_dist(rng));
+                def.collision_group = entities.size() % 2 == 0 ? 0x1 : 0x2;
+                entities.push_back(edyn::make_rigidbody(registry, def));
+            }
+        }
+    }
+
+    return entities;
+}
+
+// Raycasts each entity individually and returns the closest hit.
+static edyn::raycast_result brute_force_raycast(entt::registry &registry,
+                                                const std::vector<entt::entity> &entities,
+                                                const edyn::raycast_query &query) {
+    auto result = edyn::raycast_result{};
+
+    for (auto entity : entities) {
+        if (!edyn::filters_collide(query.filter, registry.get<edyn::collision_filter>(entity))) {
+            continue;
+        }
+
+        auto &box = registry.get<edyn::box_shape>(entity);
+        auto pos = static_cast<edyn::vector3>(registry.get<edyn::position>(entity));
+        auto orn = static_cast<edyn::quaternion>(registry.get<edyn::orientation>(entity));
+        auto res = edyn::raycast(box, edyn::raycast_context{pos, orn, query.p0, query.p1});
+
+        if (res.fraction < result.fraction) {
+            static_cast<edyn::shape_raycast_result &>(result) = res;
+            result.entity = entity;
+        }
+    }
+
+    return result;
+}
+
+static std::vector<edyn::raycast_query> make_random_rays(std::mt19937 &rng) {
+    std::uniform_real_distribution<edyn::scalar> pos_dist(-2, 12);
+    std::uniform_int_distribution<int> filter_dist(0, 2);
+    std::vector<edyn::raycast_query> queries;
+
+    for (auto i = 0; i < 500; ++i) {
+        auto query = edyn::raycast_query{};
+        query.p0 = edyn::vector3{pos_dist(rng), pos_dist(rng), pos_dist(rng)};
+        query.p1 = edyn::vector3{pos_dist(rng), pos_dist(rng), pos_dist(rng)};
+
+        switch (filter_dist(rng)) {
+        case 1:
+            query.filter.mask = 0x1;
+            break;
+        case 2:
+            query.filter.mask = 0x2;
+            break;
+        }
+
+        queries.push_back(query);
+    }
+
+    // Rays which hit nothing.
+    queries.push_back({edyn::vector3{-5, -5, -5}, edyn::vector3{-5, 20, -5}});
+    queries.push_back({edyn::vector3{20, 1, 1}, edyn::vector3{30, 1, 1}});
+
+    return queries;
+}
+
+TEST(test_raycast, batch_closest_hit_matches_brute_force) {
+    entt::registry registry;
+    edyn::init();
+    edyn::attach(registry);
+
+    std::mt19937 rng(1337);
+    auto entities = make_box_grid(registry, rng);
+    auto queries = make_random_rays(rng);
+
+    std::vector<edyn::raycast_result> results;
+    edyn::raycast_batch(registry, queries, results);
+    ASSERT_EQ(results.size(), queries.size());
+
+    auto num_hits = 0;
+
+    for (size_t i = 0; i < queries.size(); ++i) {
+        auto expected = brute_force_raycast(registry, entities, queries[i]);
+        ASSERT_EQ(results[i].entity, expected.entity);
+
+        if (expected.entity != entt::null) {
+            ASSERT_SCALAR_EQ(results[i].fraction, expected.fraction);
+            ASSERT_VECTOR3_EQ(results[i].normal, expected.normal);
+            ++num_hits;
+        }
+    }
+
+    // Ensure the culling of nodes beyond the closest hit was exercised.
+    ASSERT_GT(num_hits, 100);
+
+    // The single raycast has no filter.
+    for (size_t i = 0; i < 50; ++i) {
+        auto query = edyn::raycast_query{queries[i].p0, queries[i].p1};
+        auto expected = brute_force_raycast(registry, entities, query);
+        auto result = edyn::raycast(registry, query.p0, query.p1);
+        ASSERT_EQ(result.entity, expected.entity);
+
+        if (expected.entity != entt::null) {
+            ASSERT_SCALAR_EQ(result.fraction, expected.fraction);
+        }
+    }
+
+    edyn::detach(registry);
+    edyn::deinit();
+}
+
+TEST(test_raycast, batch_any_hit_matches_brute_force) {
+    entt::registry registry;
+    edyn::init();
+    edyn::attach(registry);
+
+    std::mt19937 rng(1338);
+    auto entities = make_box_grid(registry, rng);
+    auto queries = make_random_rays(rng);
+
+    std::vector<edyn::raycast_result> results;
+    edyn::raycast_batch(registry, queries, results, edyn::raycast_mode::any_hit);
+    ASSERT_EQ(results.size(), queries.size());
+
+    for (size_t i = 0; i < queries.size(); ++i) {
+        auto expected = brute_force_raycast(registry, entities, queries[i]);
+
+        // Any entity can be reported, as long as the ray does hit it.
+        if (expected.entity == entt::null) {
+            ASSERT_EQ(results[i].entity, entt::null);
+        } else {
+            ASSERT_NE(results[i].entity, entt::null);
+            auto single_entity = std::vector<entt::entity>{results[i].entity};
+            auto hit = brute_force_raycast(registry, single_entity, queries[i]);
+            ASSERT_EQ(hit.entity, results[i].entity);
+            ASSERT_SCALAR_EQ(results[i].fraction, hit.fraction);
+        }
+    }
+
+    edyn::detach(registry);
+    edyn::deinit();
+}
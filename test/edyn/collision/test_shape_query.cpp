@@ -0,0 +1,208 @@
+#include "../common/common.hpp"
+
+#include <random>
+#include <algorithm>
+
+static entt::entity make_static_box(entt::registry &registry, edyn::vector3 pos,
+                                    uint64_t group = ~0ULL) {
+    auto def = edyn::rigidbody_def{};
+    def.kind = edyn::rigidbody_kind::rb_static;
+    def.shape = edyn::box_shape{0.5, 0.5, 0.5};
+    def.position = pos;
+    def.collision_group = group;
+    return edyn::make_rigidbody(registry, def);
+}
+
+TEST(test_shape_query, sphere_cast_box) {
+    entt::registry registry;
+    edyn::init();
+    edyn::attach(registry);
+
+    auto box = make_static_box(registry, edyn::vector3_zero);
+
+    auto query = edyn::shape_cast_query{};
+    query.shape = edyn::sphere_shape{0.5};
+    query.p0 = edyn::vector3{-5, 0, 0};
+    query.p1 = edyn::vector3{5, 0, 0};
+    query.orn = edyn::quaternion_identity;
+    auto result = edyn::shape_cast(registry, query);
+
+    // The sphere touches the box when its center is at x = -1.
+    ASSERT_EQ(result.entity, box);
+    ASSERT_NEAR(result.fraction, 0.4, 0.001);
+    ASSERT_NEAR(result.normal.x, -1, 0.001);
+    ASSERT_NEAR(result.normal.y, 0, 0.001);
+    ASSERT_NEAR(result.normal.z, 0, 0.001);
+    ASSERT_NEAR(result.point.x, -0.5, 0.001);
+
+    // Sweep passes above the box.
+    query.p0 = edyn::vector3{-5, 1.1, 0};
+    query.p1 = edyn::vector3{5, 1.1, 0};
+    result = edyn::shape_cast(registry, query);
+    ASSERT_EQ(result.entity, entt::null);
+
+    // Sweep stops short of the box.
+    query.p0 = edyn::vector3{-5, 0, 0};
+    query.p1 = edyn::vector3{-2, 0, 0};
+    result = edyn::shape_cast(registry, query);
+    ASSERT_EQ(result.entity, entt::null);
+
+    edyn::detach(registry);
+    edyn::deinit();
+}
+
+TEST(test_shape_query, cast_starts_intersecting) {
+    entt::registry registry;
+    edyn::init();
+    edyn::attach(registry);
+
+    auto box = make_static_box(registry, edyn::vector3_zero);
+
+    auto query = edyn::shape_cast_query{};
+    query.shape = edyn::sphere_shape{0.5};
+    query.p0 = edyn::vector3{-0.6, 0, 0};
+    query.p1 = edyn::vector3{5, 0, 0};
+    query.orn = edyn::quaternion_identity;
+    auto result = edyn::shape_cast(registry, query);
+
+    // The normal is the direction which resolves the penetration.
+    ASSERT_EQ(result.entity, box);
+    ASSERT_SCALAR_EQ(result.fraction, 0);
+    ASSERT_NEAR(result.normal.x, -1, 0.001);
+    ASSERT_NEAR(result.normal.y, 0, 0.001);
+    ASSERT_NEAR(result.normal.z, 0, 0.001);
+
+    edyn::detach(registry);
+    edyn::deinit();
+}
+
+TEST(test_shape_query, overlap_hit_miss_and_filter) {
+    entt::registry registry;
+    edyn::init();
+    edyn::attach(registry);
+
+    auto first = make_static_box(registry, edyn::vector3_zero, 0x1);
+    auto second = make_static_box(registry, edyn::vector3{3, 0, 0}, 0x2);
+
+    auto query = edyn::overlap_query{};
+    query.shape = edyn::sphere_shape{0.5};
+    query.pos = edyn::vector3{0.9, 0, 0};
+    query.orn = edyn::quaternion_identity;
+
+    std::vector<entt::entity> entities;
+    edyn::overlap(registry, query, entities);
+    ASSERT_EQ(entities.size(), 1);
+    ASSERT_EQ(entities[0], first);
+
+    // In between both boxes, inside the AABB of neither.
+    entities.clear();
+    query.pos = edyn::vector3{1.5, 0, 0};
+    edyn::overlap(registry, query, entities);
+    ASSERT_TRUE(entities.empty());
+
+    // Close to a corner of the box, inside its AABB, but not touching it.
+    query.pos = edyn::vector3{0.8, 0.8, 0.8};
+    query.shape = edyn::sphere_shape{0.4};
+    edyn::overlap(registry, query, entities);
+    ASSERT_TRUE(entities.empty());
+
+    // Touches both.
+    query.pos = edyn::vector3{1.5, 0, 0};
+    query.shape = edyn::sphere_shape{1.2};
+    edyn::overlap(registry, query, entities);
+    std::sort(entities.begin(), entities.end());
+    auto expected = std::vector<entt::entity>{first, second};
+    std::sort(expected.begin(), expected.end());
+    ASSERT_EQ(entities, expected);
+
+    // Only the first box is accepted by the filter.
+    entities.clear();
+    query.filter.mask = 0x1;
+    edyn::overlap(registry, query, entities);
+    ASSERT_EQ(entities.size(), 1);
+    ASSERT_EQ(entities[0], first);
+
+    // The first box does not accept the filter group.
+    entities.clear();
+    auto filter = registry.get<edyn::collision_filter>(first);
+    filter.mask = 0x1;
+    registry.replace<edyn::collision_filter>(first, filter);
+    query.filter.group = 0x2;
+    query.filter.mask = ~0ULL;
+    edyn::overlap(registry, query, entities);
+    ASSERT_EQ(entities.size(), 1);
+    ASSERT_EQ(entities[0], second);
+
+    edyn::detach(registry);
+    edyn::deinit();
+}
+
+TEST(test_shape_query, batch_matches_single_queries) {
+    entt::registry registry;
+    edyn::init();
+    edyn::attach(registry);
+
+    std::mt19937 rng(1337);
+    std::uniform_real_distribution<edyn::scalar> pos_dist(-1, 11);
+    std::uniform_real_distribution<edyn::scalar> angle_dist(0, edyn::pi2);
+
+    for (auto x = 0; x < 5; ++x) {
+        for (auto z = 0; z < 5; ++z) {
+            auto pos = edyn::vector3{edyn::scalar(x * 2), 0, edyn::scalar(z * 2)};
+            make_static_box(registry, pos, (x + z) % 2 == 0 ? 0x1 : 0x2);
+        }
+    }
+
+    std::vector<edyn::overlap_query> overlap_queries;
+    std::vector<edyn::shape_cast_query> cast_queries;
+
+    for (auto i = 0; i < 200; ++i) {
+        auto orn = edyn::quaternion_axis_angle(edyn::normalize(edyn::vector3{1, 1, 0}), angle_dist(rng));
+        auto shape = i % 2 == 0 ?
+            edyn::query_shape_variant_t{edyn::box_shape{0.3, 0.2, 0.4}} :
+            edyn::query_shape_variant_t{edyn::capsule_shape{0.2, 0.3}};
+        auto filter = edyn::collision_filter{};
+
+        if (i % 3 == 0) {
+            filter.mask = 0x1;
+        }
+
+        auto p0 = edyn::vector3{pos_dist(rng), pos_dist(rng) * edyn::scalar(0.2), pos_dist(rng)};
+        auto p1 = edyn::vector3{pos_dist(rng), pos_dist(rng) * edyn::scalar(0.2), pos_dist(rng)};
+        overlap_queries.push_back({shape, p0, orn, filter});
+        cast_queries.push_back({shape, p0, p1, orn, filter});
+    }
+
+    std::vector<std::vector<entt::entity>> overlap_results;
+    edyn::overlap_batch(registry, overlap_queries, overlap_results);
+    ASSERT_EQ(overlap_results.size(), overlap_queries.size());
+
+    for (size_t i = 0; i < overlap_queries.size(); ++i) {
+        std::vector<entt::entity> entities;
+        edyn::overlap(registry, overlap_queries[i], entities);
+        ASSERT_EQ(overlap_results[i], entities);
+    }
+
+    std::vector<edyn::shape_cast_result> cast_results;
+    edyn::shape_cast_batch(registry, cast_queries, cast_results);
+    ASSERT_EQ(cast_results.size(), cast_queries.size());
+
+    auto num_hits = 0;
+
+    for (size_t i = 0; i < cast_queries.size(); ++i) {
+        auto result = edyn::shape_cast(registry, cast_queries[i]);
+        ASSERT_EQ(cast_results[i].entity, result.entity);
+
+        if (result.entity != entt::null) {
+            ASSERT_SCALAR_EQ(cast_results[i].fraction, result.fraction);
+            ASSERT_VECTOR3_EQ(cast_results[i].normal, result.normal);
+            ASSERT_VECTOR3_EQ(cast_results[i].point, result.point);
+            ++num_hits;
+        }
+    }
+
+    ASSERT_GT(num_hits, 0);
+
+    edyn::detach(registry);
+    edyn::deinit();
+}
@@ -0,0 +1,250 @@
+#include "../common/common.hpp"
+#include <edyn/collision/static_tree.hpp>
+
+#include <set>
+#include <random>
+
+static std::vector<edyn::AABB> make_random_aabbs(size_t count, unsigned seed = 1337) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<edyn::scalar> pos_dist(-500, 500);
+    std::uniform_real_distribution<edyn::scalar> size_dist(0.001, 3);
+    std::vector<edyn::AABB> aabbs;
+
+    for (size_t i = 0; i < count; ++i) {
+        auto center = edyn::vector3{pos_dist(rng), pos_dist(rng) * 0.01, pos_dist(rng)};
+        auto half_size = edyn::vector3{size_dist(rng), size_dist(rng), size_dist(rng)};
+        aabbs.push_back({center - half_size, center + half_size});
+    }
+
+    return aabbs;
+}
+
+static auto report_leaf = [] (edyn::static_tree::tree_node &node, auto ids_begin, auto) {
+    node.id = *ids_begin;
+};
+
+// Checks that the tree contains exactly the leaves with the given ids, that
+// each node contains its children and that queries find every leaf.
+static void check_tree(const edyn::static_tree &tree, const std::vector<edyn::AABB> &aabbs,
+                       const std::set<uint32_t> &ids) {
+    std::set<uint32_t> leaf_ids;
+    std::vector<uint32_t> stack{0};
+
+    while (!stack.empty()) {
+        auto node = tree.get_node(stack.back());
+        stack.pop_back();
+
+        if (node.leaf()) {
+            ASSERT_TRUE(node.aabb.contains(aabbs[node.id]));
+            ASSERT_TRUE(leaf_ids.insert(node.id).second);
+        } else {
+            for (auto child : {node.child1, node.child2}) {
+                ASSERT_TRUE(node.aabb.contains(tree.get_node(child).aabb));
+                stack.push_back(child);
+            }
+        }
+    }
+
+    ASSERT_EQ(leaf_ids, ids);
+
+    for (auto id : ids) {
+        auto found = false;
+        tree.query(aabbs[id], [&] (uint32_t node_idx) {
+            auto node_id = tree.get_node(node_idx).id;
+            ASSERT_EQ(ids.count(node_id), 1);
+            found |= node_id == id;
+        });
+        ASSERT_TRUE(found);
+    }
+}
+
+TEST(test_static_tree, quantized_bounds_contain_leaves) {
+    auto aabbs = make_random_aabbs(2000);
+    auto tree = edyn::static_tree{};
+    tree.build(aabbs.begin(), aabbs.end(), report_leaf);
+
+    size_t num_leaves = 0;
+    std::vector<uint32_t> stack{0};
+
+    while (!stack.empty()) {
+        auto node = tree.get_node(stack.back());
+        stack.pop_back();
+
+        if (node.leaf()) {
+            ASSERT_TRUE(node.aabb.contains(aabbs[node.id]));
+            ++num_leaves;
+        } else {
+            for (auto child : {node.child1, node.child2}) {
+                ASSERT_TRUE(node.aabb.contains(tree.get_node(child).aabb));
+                stack.push_back(child);
+            }
+        }
+    }
+
+    ASSERT_EQ(num_leaves, aabbs.size());
+
+    // Every leaf is found by a query with its exact AABB.
+    for (uint32_t id = 0; id < aabbs.size(); ++id) {
+        auto found = false;
+        tree.query(aabbs[id], [&] (uint32_t node_idx) {
+            found |= tree.get_node(node_idx).id == id;
+        });
+        ASSERT_TRUE(found);
+    }
+}
+
+TEST(test_static_tree, remove_and_insert_leaves) {
+    auto aabbs = make_random_aabbs(2000);
+    auto tree = edyn::static_tree{};
+    tree.build(aabbs.begin(), aabbs.end(), report_leaf);
+
+    std::set<uint32_t> ids;
+    std::vector<uint32_t> removed;
+
+    for (uint32_t id = 0; id < aabbs.size(); ++id) {
+        if (id % 7 == 0) {
+            removed.push_back(id);
+        } else {
+            ids.insert(id);
+        }
+    }
+
+    tree.remove_leaves(removed);
+
+    // New leaves within the bounds of the tree.
+    for (auto &aabb : make_random_aabbs(200, 1338)) {
+        auto id = static_cast<uint32_t>(aabbs.size());
+        aabbs.push_back(aabb);
+        ids.insert(id);
+        tree.insert_leaf(id, aabb);
+    }
+
+    // Moving some leaves also grows the root bounds.
+    for (auto id : {1u, 2u, 3u}) {
+        aabbs[id].min += edyn::vector3{0, 100, 0};
+        aabbs[id].max += edyn::vector3{0, 100, 0};
+    }
+
+    tree.refit([&] (uint32_t &id) {
+        return aabbs[id];
+    });
+
+    check_tree(tree, aabbs, ids);
+
+    // Unreachable nodes are discarded in the refit.
+    ASSERT_EQ(tree.memory_size(), (2 * ids.size() - 1) * sizeof(edyn::static_tree::packed_node));
+    ASSERT_GE(tree.root_aabb().max.y, aabbs[1].max.y);
+}
+
+TEST(test_static_tree, refit_region) {
+    auto aabbs = make_random_aabbs(2000);
+    auto tree = edyn::static_tree{};
+    tree.build(aabbs.begin(), aabbs.end(), report_leaf);
+
+    std::set<uint32_t> ids;
+
+    for (uint32_t id = 0; id < aabbs.size(); ++id) {
+        ids.insert(id);
+    }
+
+    // Shrink and move the leaves in a region, within the root bounds.
+    auto region = edyn::AABB{{-100, -10, -100}, {100, 10, 100}};
+    auto previous_aabbs = aabbs;
+    auto num_changed = 0;
+
+    for (auto &aabb : aabbs) {
+        if (region.contains(aabb)) {
+            auto center = aabb.center() + edyn::vector3{1, 0, -1};
+            aabb = {center - edyn::vector3_one * 0.1, center + edyn::vector3_one * 0.1};
+            ++num_changed;
+        }
+    }
+
+    ASSERT_GT(num_changed, 0);
+
+    auto updated = tree.refit_region(region, [&] (uint32_t id, edyn::AABB &aabb) {
+        if (aabbs[id].min == previous_aabbs[id].min && aabbs[id].max == previous_aabbs[id].max) {
+            return false;
+        }
+
+        aabb = aabbs[id];
+        return true;
+    });
+
+    ASSERT_TRUE(updated);
+    check_tree(tree, aabbs, ids);
+
+    // Leaves which leave the root bounds require a full refit.
+    auto root_aabb = tree.root_aabb();
+    auto &outside = aabbs[ids.size() / 2];
+    auto previous = outside;
+    outside.min.y = root_aabb.max.y + 1;
+    outside.max.y = root_aabb.max.y + 2;
+
+    updated = tree.refit_region(enclosing_aabb(previous, outside), [&] (uint32_t id, edyn::AABB &aabb) {
+        if (&aabbs[id] != &outside) {
+            return false;
+        }
+
+        aabb = outside;
+        return true;
+    });
+
+    ASSERT_FALSE(updated);
+    ASSERT_TRUE(tree.get_node(0).aabb.contains(previous));
+
+    tree.refit([&] (uint32_t &id) {
+        return aabbs[id];
+    });
+
+    check_tree(tree, aabbs, ids);
+}
+
+TEST(test_static_tree, parallel_build) {
+    edyn::init();
+
+    auto aabbs = make_random_aabbs(50000);
+    auto ids = std::set<uint32_t>{};
+
+    for (uint32_t id = 0; id < aabbs.size(); ++id) {
+        ids.insert(id);
+    }
+
+    auto serial_tree = edyn::static_tree{};
+    serial_tree.build(aabbs.begin(), aabbs.end(), report_leaf);
+
+    auto parallel_tree = edyn::static_tree{};
+    parallel_tree.build(aabbs.begin(), aabbs.end(), report_leaf, 1, true);
+    check_tree(parallel_tree, aabbs, ids);
+
+    // Same splits, thus the same number of nodes and the same results.
+    ASSERT_EQ(parallel_tree.memory_size(), serial_tree.memory_size());
+    ASSERT_VECTOR3_EQ(parallel_tree.root_aabb().min, serial_tree.root_aabb().min);
+    ASSERT_VECTOR3_EQ(parallel_tree.root_aabb().max, serial_tree.root_aabb().max);
+
+    auto query_aabbs = make_random_aabbs(100, 1338);
+
+    for (auto &aabb : query_aabbs) {
+        auto query_aabb = aabb.inset(edyn::vector3_one * -10);
+        auto serial_ids = std::set<uint32_t>{};
+        auto parallel_ids = std::set<uint32_t>{};
+        serial_tree.query(query_aabb, [&] (uint32_t node_idx) {
+            serial_ids.insert(serial_tree.get_node(node_idx).id);
+        });
+        parallel_tree.query(query_aabb, [&] (uint32_t node_idx) {
+            parallel_ids.insert(parallel_tree.get_node(node_idx).id);
+        });
+        ASSERT_EQ(serial_ids, parallel_ids);
+    }
+
+    // In a worker thread, the subtrees are built serially instead.
+    auto worker_tree = edyn::static_tree{};
+    run_in_worker([&] {
+        ASSERT_FALSE(edyn::can_parallel_for());
+        worker_tree.build(aabbs.begin(), aabbs.end(), report_leaf, 1, true);
+    });
+    check_tree(worker_tree, aabbs, ids);
+    ASSERT_EQ(worker_tree.memory_size(), serial_tree.memory_size());
+
+    edyn::deinit();
+}
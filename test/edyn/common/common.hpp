@@ -1,6 +1,9 @@
 #ifndef TEST_EDYN_COMMON_COMMON_HPP
 #define TEST_EDYN_COMMON_COMMON_HPP
 
+#include <future>
+#include <cstring>
+#include <functional>
 #include <gtest/gtest.h>
 #include <edyn/edyn.hpp>
 
@@ -16,4 +19,29 @@ inline void ASSERT_VECTOR3_EQ(edyn::vector3 v0, edyn::vector3 v1) {
     ASSERT_SCALAR_EQ(v0.z, v1.z);
 }
 
+// Runs `func` in a worker thread of the global job dispatcher and waits for
+// it to finish.
+inline void run_in_worker(std::function<void()> func) {
+    struct context {
+        std::function<void()> func;
+        std::promise<void> done;
+    };
+
+    auto ctx = context{func, {}};
+    auto *ctx_ptr = &ctx;
+    auto future = ctx.done.get_future();
+
+    auto j = edyn::job{};
+    std::memcpy(j.data.data(), &ctx_ptr, sizeof(ctx_ptr));
+    j.func = [] (edyn::job::data_type &data) {
+        context *ctx;
+        std::memcpy(&ctx, data.data(), sizeof(ctx));
+        ctx->func();
+        ctx->done.set_value();
+    };
+    edyn::job_dispatcher::global().async(j);
+
+    future.wait();
+}
+
 #endif // TEST_EDYN_COMMON_COMMON_HPP
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "../common/common.hpp"
 #include "edyn/math/math.hpp"
+#include "edyn/math/octahedral.hpp"
 
 TEST(math_test, average) {
     auto vertices = std::array<edyn::vector3, 3>{
@@ -12,3 +13,53 @@ TEST(math_test, average) {
     ASSERT_SCALAR_EQ(center.y, 1.f / 3.f);
     ASSERT_SCALAR_EQ(center.z, 0);
 }
+
+TEST(math_test, octahedral_poles) {
+    for (auto v : {edyn::vector3_x, edyn::vector3_y, edyn::vector3_z}) {
+        ASSERT_VECTOR3_EQ(edyn::octahedral_decode(edyn::octahedral_encode(v)), v);
+        ASSERT_VECTOR3_EQ(edyn::octahedral_decode(edyn::octahedral_encode(-v)), -v);
+    }
+}
+
+TEST(math_test, octahedral_seams) {
+    // Vectors on the edges of the octahedron, where the octants meet, and on
+    // the equator, where the lower half is folded over the upper half.
+    constexpr auto max_error = edyn::scalar(2e-4);
+    auto seam_vectors = std::vector<edyn::vector3>{};
+
+    for (auto s0 : {-1, 1}) {
+        for (auto s1 : {-1, 1}) {
+            seam_vectors.push_back({edyn::scalar(s0), edyn::scalar(s1), 0});
+            seam_vectors.push_back({edyn::scalar(s0), 0, edyn::scalar(s1)});
+            seam_vectors.push_back({0, edyn::scalar(s0), edyn::scalar(s1)});
+            seam_vectors.push_back({edyn::scalar(s0) * 0.3, edyn::scalar(s1) * 0.7, -1e-6});
+            seam_vectors.push_back({edyn::scalar(s0) * 0.3, edyn::scalar(s1) * 0.7, 1e-6});
+        }
+    }
+
+    for (auto v : seam_vectors) {
+        v = edyn::normalize(v);
+        auto decoded = edyn::octahedral_decode(edyn::octahedral_encode(v));
+        ASSERT_LT(edyn::length(decoded - v), max_error);
+    }
+}
+
+TEST(math_test, octahedral_lower_hemisphere) {
+    constexpr auto max_error = edyn::scalar(2e-4);
+    constexpr size_t num_steps = 32;
+
+    for (size_t i = 0; i < num_steps; ++i) {
+        // Elevation in (-pi/2, 0).
+        auto elevation = -edyn::half_pi * (edyn::scalar(i) + edyn::scalar(0.5)) / num_steps;
+
+        for (size_t j = 0; j < num_steps; ++j) {
+            auto azimuth = edyn::pi2 * edyn::scalar(j) / num_steps;
+            auto v = edyn::vector3{std::cos(elevation) * std::cos(azimuth),
+                                   std::cos(elevation) * std::sin(azimuth),
+                                   std::sin(elevation)};
+            auto decoded = edyn::octahedral_decode(edyn::octahedral_encode(v));
+            ASSERT_LT(edyn::length(decoded - v), max_error);
+            ASSERT_LT(decoded.z, 0);
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#include "../common/common.hpp"
+
+#include <thread>
+#include <chrono>
+
+// Creates two dynamic bodies joined by a constraint, thus in the same island.
+static std::pair<entt::entity, entt::entity> make_joined_bodies(entt::registry &registry) {
+    auto def = edyn::rigidbody_def{};
+    def.shape = edyn::box_shape{0.5, 0.5, 0.5};
+    auto first = edyn::make_rigidbody(registry, def);
+    def.position = {2, 0, 0};
+    auto second = edyn::make_rigidbody(registry, def);
+    edyn::make_constraint<edyn::null_constraint>(registry, first, second);
+    return {first, second};
+}
+
+// Steps until the bodies are assigned to an island, which happens in the
+// coordinator in the next update.
+static entt::entity get_island(entt::registry &registry, entt::entity entity) {
+    for (auto i = 0; i < 10; ++i) {
+        edyn::update(registry);
+        auto island_entity = registry.get<edyn::island_resident>(entity).island_entity;
+
+        if (island_entity != entt::null) {
+            return island_entity;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    return entt::null;
+}
+
+TEST(test_island_coordinator, new_island_starts_asleep) {
+    entt::registry registry;
+    edyn::init();
+    edyn::attach(registry);
+
+    auto [first, second] = make_joined_bodies(registry);
+    registry.emplace<edyn::sleeping_tag>(first);
+    registry.emplace<edyn::sleeping_tag>(second);
+
+    auto island_entity = get_island(registry, first);
+    ASSERT_NE(island_entity, entt::null);
+    ASSERT_EQ(registry.get<edyn::island_resident>(second).island_entity, island_entity);
+    ASSERT_TRUE(registry.all_of<edyn::sleeping_tag>(island_entity));
+
+    // Bodies do not fall under gravity while asleep.
+    for (auto i = 0; i < 10; ++i) {
+        edyn::update(registry);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_TRUE(registry.all_of<edyn::sleeping_tag>(island_entity));
+    ASSERT_TRUE(registry.all_of<edyn::sleeping_tag>(first));
+    ASSERT_VECTOR3_EQ(registry.get<edyn::position>(first), edyn::vector3_zero);
+
+    edyn::detach(registry);
+    edyn::deinit();
+}
+
+TEST(test_island_coordinator, new_island_starts_awake_if_any_node_is_awake) {
+    entt::registry registry;
+    edyn::init();
+    edyn::attach(registry);
+
+    auto [first, second] = make_joined_bodies(registry);
+    registry.emplace<edyn::sleeping_tag>(first);
+
+    auto island_entity = get_island(registry, second);
+    ASSERT_NE(island_entity, entt::null);
+    ASSERT_FALSE(registry.all_of<edyn::sleeping_tag>(island_entity));
+
+    edyn::detach(registry);
+    edyn::deinit();
+}
@@ -0,0 +1,161 @@
+#include "../common/common.hpp"
+
+#include <thread>
+#include <chrono>
+
+TEST(snapshot_test, test_save_load) {
+    entt::registry registry;
+    auto &graph = registry.set<edyn::entity_graph>();
+
+    auto mesh = std::make_shared<edyn::convex_mesh>();
+    mesh->vertices = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}};
+    mesh->indices = {0, 1, 2};
+
+    auto body0 = registry.create();
+    auto body1 = registry.create();
+
+    for (auto entity : {body0, body1}) {
+        registry.emplace<edyn::position>(entity, edyn::vector3{1, 2, 3});
+        registry.emplace<edyn::linvel>(entity, edyn::vector3{4, 5, 6});
+        registry.emplace<edyn::dynamic_tag>(entity);
+        registry.emplace<edyn::procedural_tag>(entity);
+        registry.emplace<edyn::sleeping_tag>(entity);
+        registry.emplace<edyn::continuous>(entity).insert<edyn::position, edyn::linvel>();
+        registry.emplace<edyn::graph_node>(entity, graph.insert_node(entity));
+    }
+
+    registry.emplace<edyn::polyhedron_shape>(body0).mesh = mesh;
+
+    // Compound sharing the same convex mesh.
+    auto compound = edyn::compound_shape{};
+    compound.nodes.push_back({edyn::polyhedron_shape{}, edyn::vector3_zero, edyn::quaternion_identity, {}});
+    std::get<edyn::polyhedron_shape>(compound.nodes[0].shape_var).mesh = mesh;
+    compound.nodes.push_back({edyn::box_shape{{2, 3, 4}}, edyn::vector3_one, edyn::quaternion_identity, {}});
+    registry.emplace<edyn::compound_shape>(body1, compound);
+
+    auto manifold_entity = registry.create();
+    auto point_entity = registry.create();
+    auto &manifold = registry.emplace<edyn::contact_manifold>(manifold_entity);
+    manifold.body = {body0, body1};
+    manifold.point.fill(entt::null);
+    manifold.point[0] = point_entity;
+    registry.emplace<edyn::procedural_tag>(manifold_entity);
+    auto edge_index = graph.insert_edge(manifold_entity,
+                                        registry.get<edyn::graph_node>(body0).node_index,
+                                        registry.get<edyn::graph_node>(body1).node_index);
+    registry.emplace<edyn::graph_edge>(manifold_entity, edge_index);
+
+    auto &cp = registry.emplace<edyn::contact_point>(point_entity);
+    cp.body = {body0, body1};
+    cp.distance = 0.25;
+
+    // Not part of the snapshot.
+    registry.emplace<edyn::sleeping_tag>(registry.create());
+
+    auto buffer = edyn::memory_output_archive::buffer_type{};
+    auto output = edyn::memory_output_archive(buffer);
+    edyn::save_snapshot(registry, output);
+
+    entt::registry other;
+    auto &other_graph = other.set<edyn::entity_graph>();
+    auto input = edyn::memory_input_archive(buffer.data(), buffer.size());
+    ASSERT_TRUE(edyn::load_snapshot(other, input));
+
+    auto sleeping_view = other.view<edyn::sleeping_tag>();
+    ASSERT_EQ(std::distance(sleeping_view.begin(), sleeping_view.end()), 2);
+
+    auto manifold_view = other.view<edyn::contact_manifold>();
+    auto other_manifold_entity = *manifold_view.begin();
+    auto &other_manifold = other.get<edyn::contact_manifold>(other_manifold_entity);
+    auto other_body0 = other_manifold.body[0];
+    auto other_body1 = other_manifold.body[1];
+
+    auto node_entities = other_graph.edge_node_entities(other.get<edyn::graph_edge>(other_manifold_entity).edge_index);
+    ASSERT_EQ(node_entities.first, other_body0);
+    ASSERT_EQ(node_entities.second, other_body1);
+
+    auto &other_cp = other.get<edyn::contact_point>(other_manifold.point[0]);
+    ASSERT_EQ(other_cp.body[1], other_body1);
+    ASSERT_SCALAR_EQ(other_cp.distance, 0.25);
+
+    ASSERT_VECTOR3_EQ(other.get<edyn::linvel>(other_body1), edyn::vector3{4, 5, 6});
+
+    auto &other_cont = other.get<edyn::continuous>(other_body0);
+    ASSERT_EQ(other_cont.size, 2);
+    ASSERT_EQ(other_cont.types[0], entt::type_seq<edyn::position>::value());
+
+    // The convex mesh is shared after loading.
+    auto &other_polyhedron = other.get<edyn::polyhedron_shape>(other_body0);
+    auto &other_compound = other.get<edyn::compound_shape>(other_body1);
+    ASSERT_EQ(other_polyhedron.mesh->vertices.size(), 3);
+    ASSERT_EQ(other_polyhedron.mesh, std::get<edyn::polyhedron_shape>(other_compound.nodes[0].shape_var).mesh);
+    ASSERT_SCALAR_EQ(std::get<edyn::box_shape>(other_compound.nodes[1].shape_var).half_extents.z, 4);
+}
+
+TEST(snapshot_test, load_into_attached_registry) {
+    edyn::init();
+
+    auto buffer = edyn::memory_output_archive::buffer_type{};
+
+    {
+        entt::registry registry;
+        edyn::attach(registry);
+
+        // Two boxes in contact which were asleep when the snapshot was taken.
+        auto def = edyn::rigidbody_def{};
+        def.shape = edyn::box_shape{0.5, 0.5, 0.5};
+        auto body0 = edyn::make_rigidbody(registry, def);
+        def.position = {0, 0.99, 0};
+        auto body1 = edyn::make_rigidbody(registry, def);
+        edyn::make_contact_manifold(registry, body0, body1, edyn::contact_breaking_threshold);
+        registry.emplace<edyn::sleeping_tag>(body0);
+        registry.emplace<edyn::sleeping_tag>(body1);
+
+        auto output = edyn::memory_output_archive(buffer);
+        edyn::save_snapshot(registry, output);
+
+        edyn::detach(registry);
+    }
+
+    entt::registry registry;
+    edyn::attach(registry);
+
+    auto input = edyn::memory_input_archive(buffer.data(), buffer.size());
+    ASSERT_TRUE(edyn::load_snapshot(registry, input));
+
+    auto manifold_view = registry.view<edyn::contact_manifold>();
+    ASSERT_EQ(std::distance(manifold_view.begin(), manifold_view.end()), 1);
+    auto manifold_entity = *manifold_view.begin();
+    auto body0 = registry.get<edyn::contact_manifold>(manifold_entity).body[0];
+    auto body1 = registry.get<edyn::contact_manifold>(manifold_entity).body[1];
+    auto pos0 = registry.get<edyn::position>(body0);
+    auto pos1 = registry.get<edyn::position>(body1);
+
+    edyn::update(registry);
+
+    // The bodies are placed into a new island which stays asleep.
+    auto island_view = registry.view<edyn::island>();
+    ASSERT_EQ(std::distance(island_view.begin(), island_view.end()), 1);
+    auto island_entity = *island_view.begin();
+    ASSERT_TRUE(registry.all_of<edyn::sleeping_tag>(island_entity));
+    ASSERT_EQ(registry.get<edyn::island_resident>(body0).island_entity, island_entity);
+    ASSERT_EQ(registry.get<edyn::island_resident>(body1).island_entity, island_entity);
+    ASSERT_EQ(registry.get<edyn::island_resident>(manifold_entity).island_entity, island_entity);
+
+    for (auto i = 0; i < 10; ++i) {
+        edyn::update(registry);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    // The manifold is kept and nothing moved.
+    ASSERT_TRUE(registry.valid(manifold_entity));
+    ASSERT_TRUE(edyn::manifold_exists(registry, body0, body1));
+    ASSERT_TRUE(registry.all_of<edyn::sleeping_tag>(island_entity));
+    ASSERT_TRUE(registry.all_of<edyn::sleeping_tag>(body0));
+    ASSERT_TRUE(registry.all_of<edyn::sleeping_tag>(body1));
+    ASSERT_VECTOR3_EQ(registry.get<edyn::position>(body0), pos0);
+    ASSERT_VECTOR3_EQ(registry.get<edyn::position>(body1), pos1);
+
+    edyn::detach(registry);
+    edyn::deinit();
+}
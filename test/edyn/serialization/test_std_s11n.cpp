@@ -10,4 +10,40 @@ TEST(std_serialization_test, test_variant) {
     serialize(input, var_in);
     ASSERT_TRUE(std::holds_alternative<double>(var_in));
     ASSERT_DOUBLE_EQ(std::get<double>(var_in), 1.2);
-}
\ No newline at end of file
+}
+
+TEST(std_serialization_test, test_buffered_file) {
+    auto points = std::vector<edyn::vector3>{};
+    auto values = std::vector<int>{};
+
+    for (int i = 0; i < 10000; ++i) {
+        points.push_back(edyn::vector3{edyn::scalar(i), 1, 2});
+        values.push_back(i);
+    }
+
+    auto filename = "buffered.bin";
+
+    {
+        // Small buffer to exercise writes larger than the buffer.
+        auto output = edyn::buffered_file_output_archive(filename, 1024);
+        output(points);
+        output(values);
+    }
+
+    // Must be readable by the unbuffered archive as well.
+    auto input = edyn::file_input_archive(filename);
+    auto points_in = std::vector<edyn::vector3>{};
+    auto values_in = std::vector<int>{};
+    input(points_in);
+    ASSERT_VECTOR3_EQ(points_in.back(), points.back());
+    points_in.clear();
+
+    auto buffered_input = edyn::buffered_file_input_archive(filename, 1024);
+    buffered_input(points_in);
+    buffered_input(values_in);
+    ASSERT_FALSE(buffered_input.is_file_at_end());
+
+    ASSERT_EQ(points_in.size(), points.size());
+    ASSERT_EQ(values_in, values);
+    ASSERT_VECTOR3_EQ(points_in.back(), points.back());
+}
@@ -1,5 +1,10 @@
 #include "../common/common.hpp"
 
+#include <set>
+#include <thread>
+#include <fstream>
+#include <algorithm>
+
 TEST(triangle_mesh_serialization, test) {
     // Create triangle mesh.
     auto extent_x = 2;
@@ -69,3 +74,174 @@ TEST(triangle_mesh_serialization, test) {
         ASSERT_EQ(trimesh.is_convex_edge(i), input_trimesh.is_convex_edge(i));
     }
 }
+
+TEST(triangle_mesh_serialization, test_mapped) {
+    std::vector<edyn::vector3> vertices;
+    std::vector<edyn::triangle_mesh::index_type> indices;
+    edyn::make_plane_mesh(4, 4, 8, 8, vertices, indices);
+
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        vertices[i].y = std::sin(edyn::scalar(i) * edyn::scalar(0.7)) * edyn::scalar(0.2);
+    }
+
+    auto trimesh = edyn::triangle_mesh();
+    trimesh.insert_vertices(vertices.begin(), vertices.end());
+    trimesh.insert_indices(indices.begin(), indices.end());
+    trimesh.initialize();
+
+    auto filename = "trimesh_mapped.bin";
+
+    {
+        auto output = edyn::mapped_output_archive(filename);
+        edyn::serialize(output, trimesh);
+    }
+
+    auto file = edyn::mapped_file(filename);
+    ASSERT_TRUE(file.is_open());
+
+    auto input_trimesh = edyn::triangle_mesh();
+    auto input = edyn::mapped_input_archive(file.data(), file.size());
+    edyn::serialize(input, input_trimesh);
+
+    ASSERT_EQ(trimesh.num_vertices(), input_trimesh.num_vertices());
+    ASSERT_EQ(trimesh.num_triangles(), input_trimesh.num_triangles());
+    ASSERT_EQ(trimesh.num_edges(), input_trimesh.num_edges());
+
+    for (size_t i = 0; i < trimesh.num_vertices(); ++i) {
+        ASSERT_VECTOR3_EQ(trimesh.get_vertex_position(i), input_trimesh.get_vertex_position(i));
+    }
+
+    for (size_t i = 0; i < trimesh.num_triangles(); ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            ASSERT_EQ(trimesh.get_face_edge_index(i, j), input_trimesh.get_face_edge_index(i, j));
+            ASSERT_VECTOR3_EQ(trimesh.get_adjacent_face_normal(i, j), input_trimesh.get_adjacent_face_normal(i, j));
+        }
+    }
+
+    for (size_t i = 0; i < trimesh.num_edges(); ++i) {
+        ASSERT_EQ(trimesh.is_convex_edge(i), input_trimesh.is_convex_edge(i));
+        ASSERT_EQ(trimesh.is_boundary_edge(i), input_trimesh.is_boundary_edge(i));
+    }
+}
+
+static void write_mapped_paged_mesh(const std::string &filename, std::set<uint32_t> &tree_ids) {
+    std::vector<edyn::vector3> vertices;
+    std::vector<edyn::triangle_mesh::index_type> indices;
+    edyn::make_plane_mesh(8, 8, 16, 16, vertices, indices);
+
+    auto loader = std::make_shared<edyn::paged_triangle_mesh_file_input_archive>();
+    auto paged_trimesh = edyn::paged_triangle_mesh(loader);
+    edyn::create_paged_triangle_mesh(paged_trimesh, vertices.begin(), vertices.end(),
+                                     indices.begin(), indices.end(), 32);
+    auto tree = paged_trimesh.get_tree();
+    tree->query(tree->root_aabb(), [&] (uint32_t id) { tree_ids.insert(id); });
+
+    auto output = edyn::mapped_output_archive(filename);
+    edyn::serialize(output, paged_trimesh);
+}
+
+TEST(triangle_mesh_serialization, mapped_tree_outlives_loader) {
+    auto filename = "paged_trimesh_mapped.bin";
+    auto tree_ids = std::set<uint32_t>{};
+    write_mapped_paged_mesh(filename, tree_ids);
+    ASSERT_GT(tree_ids.size(), 1);
+
+    auto tree = std::shared_ptr<const edyn::static_tree>{};
+
+    {
+        auto loader = std::make_shared<edyn::paged_triangle_mesh_mapped_loader>(filename);
+        ASSERT_TRUE(loader->is_open());
+        auto paged_trimesh = edyn::paged_triangle_mesh(loader);
+        edyn::serialize(*loader, paged_trimesh);
+        tree = paged_trimesh.get_tree();
+    }
+
+    // The nodes of the tree are still mapped after the loader and the mesh
+    // are gone.
+    auto input_ids = std::set<uint32_t>{};
+    tree->query(tree->root_aabb(), [&] (uint32_t id) { input_ids.insert(id); });
+    ASSERT_EQ(input_ids, tree_ids);
+}
+
+TEST(triangle_mesh_serialization, mapped_byte_order_mismatch) {
+    auto filename = "paged_trimesh_mapped_swapped.bin";
+    auto tree_ids = std::set<uint32_t>{};
+    write_mapped_paged_mesh(filename, tree_ids);
+
+    {
+        auto loader = edyn::paged_triangle_mesh_mapped_loader(filename);
+        ASSERT_TRUE(loader.is_open());
+    }
+
+    // Reverse the byte order mark, which follows the magic and version, as
+    // if the file was written on a platform with the opposite endianness.
+    {
+        auto file = std::fstream(filename, std::ios::binary | std::ios::in | std::ios::out);
+        char mark[4];
+        file.seekg(8);
+        file.read(mark, sizeof mark);
+        std::reverse(std::begin(mark), std::end(mark));
+        file.seekp(8);
+        file.write(mark, sizeof mark);
+    }
+
+    auto loader = edyn::paged_triangle_mesh_mapped_loader(filename);
+    ASSERT_FALSE(loader.is_open());
+}
+
+TEST(triangle_mesh_serialization, concurrent_embedded_submesh_loads) {
+    std::vector<edyn::vector3> vertices;
+    std::vector<edyn::triangle_mesh::index_type> indices;
+    edyn::make_plane_mesh(8, 8, 16, 16, vertices, indices);
+
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        vertices[i].y = std::sin(edyn::scalar(i) * edyn::scalar(0.3)) * edyn::scalar(0.5);
+    }
+
+    auto paged_trimesh = edyn::paged_triangle_mesh(std::make_shared<edyn::paged_triangle_mesh_file_input_archive>());
+    edyn::create_paged_triangle_mesh(paged_trimesh, vertices.begin(), vertices.end(),
+                                     indices.begin(), indices.end(), 32);
+
+    auto filename = "paged_trimesh_embedded.bin";
+
+    {
+        auto output = edyn::paged_triangle_mesh_file_output_archive(filename, edyn::paged_triangle_mesh_serialization_mode::embedded);
+        edyn::serialize(output, paged_trimesh);
+    }
+
+    auto input = std::make_shared<edyn::paged_triangle_mesh_file_input_archive>(filename);
+    auto input_trimesh = edyn::paged_triangle_mesh(input);
+    edyn::serialize(*input, input_trimesh);
+    auto num_submeshes = input_trimesh.num_submeshes();
+    ASSERT_EQ(num_submeshes, paged_trimesh.num_submeshes());
+    ASSERT_GT(num_submeshes, 4);
+
+    // Each load reads from its own file handle, thus the submeshes can be
+    // read in parallel from the same archive.
+    auto threads = std::vector<std::thread>{};
+    constexpr size_t num_threads = 4;
+
+    for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t] {
+            for (size_t i = t; i < num_submeshes; i += num_threads) {
+                input->load_blocking(i);
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (size_t i = 0; i < num_submeshes; ++i) {
+        auto submesh = paged_trimesh.get_submesh(i);
+        auto input_submesh = input_trimesh.get_submesh(i);
+        ASSERT_NE(input_submesh, nullptr);
+        ASSERT_EQ(submesh->num_vertices(), input_submesh->num_vertices());
+        ASSERT_EQ(submesh->num_triangles(), input_submesh->num_triangles());
+
+        for (size_t j = 0; j < submesh->num_vertices(); ++j) {
+            ASSERT_VECTOR3_EQ(submesh->get_vertex_position(j), input_submesh->get_vertex_position(j));
+        }
+    }
+}
@@ -0,0 +1,167 @@
+#include "../common/common.hpp"
+
+#include <set>
+#include <algorithm>
+#include <random>
+#include <utility>
+
+// Builds a prism whose base is a regular polygon with the given number of
+// sides, which has many more vertices than a box.
+static void make_prism_mesh(size_t num_sides, edyn::convex_mesh &mesh) {
+    constexpr auto half_height = edyn::scalar(0.5);
+    auto n = static_cast<uint16_t>(num_sides);
+
+    // Bottom vertices followed by top vertices.
+    for (auto y : {-half_height, half_height}) {
+        for (uint16_t i = 0; i < n; ++i) {
+            auto angle = edyn::pi2 * i / n;
+            mesh.vertices.push_back({std::cos(angle), y, std::sin(angle)});
+        }
+    }
+
+    // Bottom face, counter-clockwise when seen from below.
+    mesh.faces.insert(mesh.faces.end(), {uint16_t(mesh.indices.size()), n});
+
+    for (uint16_t i = 0; i < n; ++i) {
+        mesh.indices.push_back(i);
+    }
+
+    // Top face.
+    mesh.faces.insert(mesh.faces.end(), {uint16_t(mesh.indices.size()), n});
+
+    for (uint16_t i = n; i > 0; --i) {
+        mesh.indices.push_back(n + i - 1);
+    }
+
+    // Side faces.
+    for (uint16_t i = 0; i < n; ++i) {
+        auto j = static_cast<uint16_t>((i + 1) % n);
+        mesh.faces.insert(mesh.faces.end(), {uint16_t(mesh.indices.size()), uint16_t(4)});
+        mesh.indices.insert(mesh.indices.end(), {i, uint16_t(n + i), uint16_t(n + j), j});
+    }
+
+    mesh.initialize();
+}
+
+static edyn::scalar max_projection(const std::vector<edyn::vector3> &points, const edyn::vector3 &dir) {
+    auto max_proj = -EDYN_SCALAR_MAX;
+
+    for (auto &point : points) {
+        max_proj = std::max(max_proj, edyn::dot(point, dir));
+    }
+
+    return max_proj;
+}
+
+TEST(test_convex_mesh, vertex_adjacency) {
+    auto mesh = edyn::convex_mesh{};
+    make_prism_mesh(32, mesh);
+    ASSERT_EQ(mesh.adjacency_offsets.size(), mesh.vertices.size() + 1);
+    ASSERT_EQ(mesh.adjacency.size(), mesh.edges.size());
+
+    auto edges = std::set<std::pair<uint16_t, uint16_t>>{};
+
+    for (size_t i = 0; i < mesh.edges.size(); i += 2) {
+        edges.emplace(mesh.edges[i], mesh.edges[i + 1]);
+        edges.emplace(mesh.edges[i + 1], mesh.edges[i]);
+    }
+
+    // Each vertex of a prism has two neighbors in its polygon and one in the
+    // opposite polygon. Every neighbor shares an edge with the vertex.
+    for (uint16_t i = 0; i < mesh.vertices.size(); ++i) {
+        auto begin = mesh.adjacency_offsets[i];
+        auto end = mesh.adjacency_offsets[i + 1];
+        ASSERT_EQ(end - begin, 3);
+
+        for (auto k = begin; k < end; ++k) {
+            ASSERT_EQ(edges.count({i, mesh.adjacency[k]}), 1);
+        }
+    }
+}
+
+TEST(test_convex_mesh, support_vertex_matches_linear_scan) {
+    auto mesh = edyn::convex_mesh{};
+    make_prism_mesh(64, mesh);
+
+    auto orn = edyn::quaternion_axis_angle(edyn::normalize(edyn::vector3{1, 2, 3}), 0.7);
+    auto rotated = edyn::make_rotated_mesh(mesh, orn);
+
+    // Without adjacency, a linear scan is performed.
+    auto unconnected = mesh;
+    unconnected.adjacency_offsets.clear();
+    unconnected.adjacency.clear();
+
+    auto rng = std::mt19937(11);
+    auto dist = std::uniform_real_distribution<edyn::scalar>(-1, 1);
+    auto start_dist = std::uniform_int_distribution<uint16_t>(0, mesh.vertices.size() - 1);
+
+    for (size_t i = 0; i < 500; ++i) {
+        auto dir = edyn::vector3{dist(rng), dist(rng), dist(rng)};
+        auto start = start_dist(rng);
+
+        for (auto *points : {&mesh.vertices, &rotated.vertices}) {
+            auto expected = max_projection(*points, dir);
+            auto idx = mesh.support_vertex_index(*points, dir, start);
+            ASSERT_SCALAR_EQ(edyn::dot((*points)[idx], dir), expected);
+
+            idx = unconnected.support_vertex_index(*points, dir, start);
+            ASSERT_SCALAR_EQ(edyn::dot((*points)[idx], dir), expected);
+        }
+    }
+}
+
+TEST(test_convex_mesh, support_projection_hint) {
+    auto mesh = edyn::convex_mesh{};
+    make_prism_mesh(64, mesh);
+
+    // The hint is updated with the support vertex, which is the start of the
+    // next query. Sweep the direction around the axis of the prism.
+    uint16_t hint = 0;
+
+    for (size_t i = 0; i < 256; ++i) {
+        auto angle = edyn::pi2 * i / 256;
+        auto dir = edyn::vector3{std::cos(angle), 0.3, std::sin(angle)};
+        auto proj = mesh.support_projection(mesh.vertices, dir, hint);
+        ASSERT_SCALAR_EQ(proj, max_projection(mesh.vertices, dir));
+        ASSERT_SCALAR_EQ(edyn::dot(mesh.vertices[hint], dir), proj);
+    }
+}
+
+TEST(test_convex_mesh, edge_faces) {
+    auto mesh = edyn::convex_mesh{};
+    make_prism_mesh(8, mesh);
+    ASSERT_EQ(mesh.edge_faces.size(), mesh.edges.size());
+
+    auto face_contains = [&] (uint16_t face_idx, uint16_t vertex_idx) {
+        auto first = mesh.faces[face_idx * 2];
+        auto count = mesh.faces[face_idx * 2 + 1];
+        auto begin = mesh.indices.begin() + first;
+        return std::find(begin, begin + count, vertex_idx) != begin + count;
+    };
+
+    // In a closed mesh, each edge is shared by two faces which contain both
+    // of its vertices.
+    for (size_t i = 0; i < mesh.num_edges(); ++i) {
+        auto [face0, face1] = mesh.get_edge_faces(i);
+        ASSERT_NE(face0, face1);
+
+        for (auto vertex_idx : {mesh.edges[i * 2], mesh.edges[i * 2 + 1]}) {
+            ASSERT_TRUE(face_contains(face0, vertex_idx));
+            ASSERT_TRUE(face_contains(face1, vertex_idx));
+        }
+    }
+
+    // Edges of an open mesh with a single face belong to that face only.
+    auto quad = edyn::convex_mesh{};
+    quad.vertices = {{0, 0, 0}, {1, 0, 0}, {1, 0, 1}, {0, 0, 1}};
+    quad.indices = {0, 3, 2, 1};
+    quad.faces = {0, 4};
+    quad.calculate_edges();
+    ASSERT_EQ(quad.num_edges(), 4);
+
+    for (size_t i = 0; i < quad.num_edges(); ++i) {
+        auto [face0, face1] = quad.get_edge_faces(i);
+        ASSERT_EQ(face0, 0);
+        ASSERT_EQ(face1, 0);
+    }
+}
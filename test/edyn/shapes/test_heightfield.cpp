@@ -0,0 +1,242 @@
+#include "../common/common.hpp"
+
+#include <algorithm>
+
+static edyn::heightfield make_heightfield(size_t num_rows = 6, size_t num_columns = 8) {
+    auto heights = std::vector<edyn::scalar>{};
+
+    for (size_t i = 0; i < num_rows; ++i) {
+        for (size_t j = 0; j < num_columns; ++j) {
+            heights.push_back(std::sin(edyn::scalar(i)) + std::cos(edyn::scalar(j) * 0.5));
+        }
+    }
+
+    return edyn::heightfield(num_rows, num_columns, 0.5, heights, {-1, 2, -1});
+}
+
+TEST(test_heightfield, visit_triangles) {
+    auto field = make_heightfield();
+    auto aabb = edyn::AABB{{0.1, 0, 0.2}, {0.9, 5, 1.1}};
+
+    auto visited = std::vector<size_t>{};
+    field.visit_triangles(aabb, [&] (size_t tri_idx) {
+        visited.push_back(tri_idx);
+    });
+
+    auto expected = std::vector<size_t>{};
+
+    for (size_t i = 0; i < field.num_triangles(); ++i) {
+        if (edyn::intersect(aabb, edyn::get_triangle_aabb(field.get_triangle_vertices(i)))) {
+            expected.push_back(i);
+        }
+    }
+
+    ASSERT_FALSE(visited.empty());
+    ASSERT_EQ(visited, expected);
+}
+
+// Triangle mesh initialized from all triangles of a heightfield, in the same
+// order.
+static edyn::triangle_mesh make_heightfield_mesh(const edyn::heightfield &field) {
+    auto vertices = std::vector<edyn::vector3>{};
+    auto indices = std::vector<uint32_t>{};
+
+    auto num_columns = field.num_columns();
+
+    for (size_t r = 0; r < field.num_rows(); ++r) {
+        for (size_t c = 0; c < num_columns; ++c) {
+            vertices.push_back(field.get_vertex_position(r, c));
+        }
+    }
+
+    for (size_t r = 0; r + 1 < field.num_rows(); ++r) {
+        for (size_t c = 0; c + 1 < num_columns; ++c) {
+            auto v00 = static_cast<uint32_t>(r * num_columns + c);
+            auto v01 = v00 + 1;
+            auto v10 = static_cast<uint32_t>(v00 + num_columns);
+            auto v11 = v10 + 1;
+            indices.insert(indices.end(), {v00, v10, v11, v00, v11, v01});
+        }
+    }
+
+    auto trimesh = edyn::triangle_mesh{};
+    trimesh.insert_vertices(vertices.begin(), vertices.end());
+    trimesh.insert_indices(indices.begin(), indices.end());
+    trimesh.initialize();
+    return trimesh;
+}
+
+TEST(test_heightfield, patch_adjacency) {
+    // Several tiles in each direction, with partial tiles at the end.
+    auto field = make_heightfield(20, 40);
+    ASSERT_EQ(field.num_tile_rows(), 2);
+    ASSERT_EQ(field.num_tile_columns(), 3);
+
+    // Compare against the generic initialization of the whole field.
+    auto trimesh = make_heightfield_mesh(field);
+    auto visited = std::vector<bool>(field.num_triangles(), false);
+
+    for (size_t tile_idx = 0; tile_idx < field.num_tiles(); ++tile_idx) {
+        auto patch = edyn::triangle_mesh{};
+        field.build_tile_patch(tile_idx, patch);
+        ASSERT_LE(patch.num_triangles(), edyn::heightfield::tile_size * edyn::heightfield::tile_size * 2);
+
+        for (size_t i = 0; i < patch.num_triangles(); ++i) {
+            auto tri_idx = field.get_tile_triangle_index(tile_idx, i);
+            ASSERT_FALSE(visited[tri_idx]);
+            visited[tri_idx] = true;
+
+            auto patch_vertices = patch.get_triangle_vertices(i);
+            auto field_vertices = field.get_triangle_vertices(tri_idx);
+
+            for (size_t j = 0; j < 3; ++j) {
+                ASSERT_EQ(patch_vertices[j], field_vertices[j]);
+
+                // Edges shared with other tiles are boundary edges of the
+                // patch but they must have the same adjacency as the ones
+                // inside of it.
+                auto edge_idx0 = patch.get_face_edge_index(i, j);
+                auto edge_idx1 = trimesh.get_face_edge_index(tri_idx, j);
+
+                if (trimesh.is_boundary_edge(edge_idx1)) {
+                    ASSERT_TRUE(patch.is_boundary_edge(edge_idx0));
+                }
+
+                // The vertices of the mesh are quantized and the patch's are
+                // not, thus the convexity of flat edges can differ.
+                auto cos_angle = edyn::dot(patch.get_triangle_normal(i), patch.get_adjacent_face_normal(i, j));
+                auto flat = cos_angle > edyn::scalar(1) - edyn::scalar(1e-4);
+
+                if (!flat) {
+                    ASSERT_EQ(patch.is_convex_edge(edge_idx0), trimesh.is_convex_edge(edge_idx1));
+                }
+
+                auto normal_diff = patch.get_adjacent_face_normal(i, j) - trimesh.get_adjacent_face_normal(tri_idx, j);
+                ASSERT_LT(edyn::length(normal_diff), edyn::scalar(1e-3));
+            }
+        }
+    }
+
+    // Each triangle belongs to exactly one tile.
+    ASSERT_TRUE(std::all_of(visited.begin(), visited.end(), [] (bool v) { return v; }));
+}
+
+TEST(test_heightfield, visit_tiles) {
+    auto field = make_heightfield(20, 40);
+    auto count_triangles = [] (auto &shape, const edyn::AABB &aabb) {
+        size_t count = 0;
+        shape.visit_triangles(aabb, [&] (size_t) { ++count; });
+        return count;
+    };
+
+    // AABB over the corner shared by four tiles.
+    auto corner = edyn::vector3{-1, 0, -1} + edyn::vector3{16, 0, 16} * edyn::scalar(0.5);
+    auto aabb = edyn::AABB{corner + edyn::vector3{-0.6, 0, -0.7}, corner + edyn::vector3{0.8, 5, 0.9}};
+    auto tiles = std::vector<size_t>{};
+
+    field.visit_tiles(aabb, [&] (size_t tile_idx) {
+        tiles.push_back(tile_idx);
+    });
+
+    ASSERT_EQ(tiles, (std::vector<size_t>{0, 1, 3, 4}));
+
+    // The patches of the tiles contain the same triangles as the field.
+    auto count = size_t{0};
+
+    for (auto tile_idx : tiles) {
+        auto patch = edyn::triangle_mesh{};
+        field.build_tile_patch(tile_idx, patch);
+        count += count_triangles(patch, aabb);
+    }
+
+    ASSERT_GT(count, 0);
+    ASSERT_EQ(count, count_triangles(field, aabb));
+
+    // AABB above the terrain.
+    auto num_visits = size_t{0};
+    field.visit_tiles({{-0.2, 10, -0.3}, {0.4, 11, 0.1}}, [&] (size_t) { ++num_visits; });
+    ASSERT_EQ(num_visits, 0);
+}
+
+TEST(test_heightfield, raycast) {
+    auto field = std::make_shared<edyn::heightfield>(make_heightfield());
+    auto shape = edyn::heightfield_shape{field};
+    auto p0 = edyn::vector3{-0.8, 6, 1.3};
+    auto p1 = edyn::vector3{2.1, -2, 0.1};
+
+    auto ctx = edyn::raycast_context{edyn::vector3_zero, edyn::quaternion_identity, p0, p1};
+    auto result = edyn::raycast(shape, ctx);
+
+    // Brute force.
+    auto min_fraction = EDYN_SCALAR_MAX;
+
+    for (size_t i = 0; i < field->num_triangles(); ++i) {
+        auto t = edyn::scalar(0);
+
+        if (edyn::intersect_segment_triangle(p0, p1, field->get_triangle_vertices(i),
+                                             field->get_triangle_normal(i), t) &&
+            t >= 0 && t <= 1) {
+            min_fraction = std::min(min_fraction, t);
+        }
+    }
+
+    ASSERT_LT(min_fraction, EDYN_SCALAR_MAX);
+    ASSERT_SCALAR_EQ(result.fraction, min_fraction);
+}
+
+TEST(test_heightfield, cached_patch) {
+    auto field = std::make_shared<edyn::heightfield>(make_heightfield(20, 40));
+    auto patch = edyn::get_heightfield_patch(field, 1);
+    ASSERT_NE(patch, nullptr);
+
+    // Reused while the tile is visited again.
+    ASSERT_EQ(edyn::get_heightfield_patch(field, 1), patch);
+    ASSERT_NE(edyn::get_heightfield_patch(field, 2), patch);
+
+    // Evicted after many other tiles are visited. The new patch is the same
+    // as the old one, thus the indices of its features remain valid.
+    for (size_t i = 0; i < 16; ++i) {
+        auto other_field = std::make_shared<edyn::heightfield>(*field);
+        edyn::get_heightfield_patch(other_field, 0);
+    }
+
+    auto new_patch = edyn::get_heightfield_patch(field, 1);
+    ASSERT_NE(new_patch, patch);
+    ASSERT_EQ(new_patch->num_triangles(), patch->num_triangles());
+    ASSERT_EQ(new_patch->num_edges(), patch->num_edges());
+
+    for (size_t i = 0; i < patch->num_triangles(); ++i) {
+        ASSERT_EQ(new_patch->get_triangle_vertices(i), patch->get_triangle_vertices(i));
+
+        for (size_t j = 0; j < 3; ++j) {
+            ASSERT_EQ(new_patch->get_face_edge_index(i, j), patch->get_face_edge_index(i, j));
+        }
+    }
+
+    // Patches are not shared among heightfields.
+    auto other_field = std::make_shared<edyn::heightfield>(*field);
+    ASSERT_NE(edyn::get_heightfield_patch(other_field, 1), new_patch);
+}
+
+TEST(test_heightfield, cell_materials) {
+    auto field = make_heightfield();
+    ASSERT_EQ(field.get_material({0, 0, 0}), nullptr);
+
+    auto indices = std::vector<edyn::heightfield::material_type>{};
+
+    for (size_t i = 0; i < field.num_triangles() / 2; ++i) {
+        indices.push_back(i % 2);
+    }
+
+    auto materials = std::vector<edyn::material>(2);
+    materials[0].friction = 0.1;
+    materials[1].friction = 0.9;
+    field.set_materials(indices, materials);
+
+    // Point over the cell in the second row and third column, whose index
+    // is 9. Its height is irrelevant.
+    auto *cell_material = field.get_material({0.25, 100, -0.25});
+    ASSERT_NE(cell_material, nullptr);
+    ASSERT_SCALAR_EQ(cell_material->friction, 0.9);
+    ASSERT_EQ(field.get_triangle_material(9 * 2 + 1), 1);
+}
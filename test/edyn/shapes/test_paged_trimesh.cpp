@@ -1,16 +1,63 @@
 #include "../common/common.hpp"
 
+#include <map>
+#include <set>
+#include <random>
+#include <algorithm>
+
 class triangle_mesh_page_loader: public edyn::triangle_mesh_page_loader_base {
 public:
     void load(size_t index) override {}
-    virtual entt::delegate<loaded_mesh_func_t> & on_load_sink() override {
-            return entt::sink {m_loaded_signal};
+    entt::sink<loaded_mesh_func_t> on_load_sink() override {
+        return entt::sink{m_loaded_signal};
     }
 
 private:
     entt::sigh<loaded_mesh_func_t> m_loaded_signal;
 };
 
+// Publishes copies of submeshes kept in memory as soon as they're requested.
+class memory_page_loader: public edyn::triangle_mesh_page_loader_base {
+public:
+    void load(size_t index) override {
+        ++num_loads;
+        m_loaded_signal.publish(index, std::make_shared<edyn::triangle_mesh>(*submeshes[index]));
+    }
+
+    entt::sink<loaded_mesh_func_t> on_load_sink() override {
+        return entt::sink{m_loaded_signal};
+    }
+
+    std::vector<std::shared_ptr<edyn::triangle_mesh>> submeshes;
+    size_t num_loads {0};
+
+private:
+    entt::sigh<loaded_mesh_func_t> m_loaded_signal;
+};
+
+// Creates a bumpy grid with `size * size` quads, split in two triangles each.
+static void make_grid(uint32_t size, std::vector<edyn::vector3> &vertices,
+                      std::vector<edyn::triangle_mesh::index_type> &indices) {
+    for (uint32_t i = 0; i <= size; ++i) {
+        for (uint32_t j = 0; j <= size; ++j) {
+            auto x = edyn::scalar(i), z = edyn::scalar(j);
+            vertices.push_back({x, edyn::scalar(0.3) * std::sin(x * edyn::scalar(0.7)) +
+                                   edyn::scalar(0.2) * std::cos(z * edyn::scalar(0.9)), z});
+        }
+    }
+
+    for (uint32_t i = 0; i < size; ++i) {
+        for (uint32_t j = 0; j < size; ++j) {
+            auto v00 = i * (size + 1) + j;
+            auto v01 = v00 + 1;
+            auto v10 = v00 + size + 1;
+            auto v11 = v10 + 1;
+            indices.insert(indices.end(), {v00, v01, v11});
+            indices.insert(indices.end(), {v00, v11, v10});
+        }
+    }
+}
+
 TEST(test_paged_trimesh, voronoi_regions) {
     edyn::init();
 
@@ -36,7 +83,7 @@ TEST(test_paged_trimesh, voronoi_regions) {
 
     auto offset = edyn::vector3_one * 0.01f;
     auto vertex_aabb = edyn::AABB{vertices[4] - offset, vertices[4] + offset};
-    trimesh.visit_triangles(vertex_aabb, [&] (size_t mesh_idx, size_t tri_idx) {
+    trimesh.visit_triangles(vertex_aabb, [&] (size_t mesh_idx, size_t tri_idx, auto &) {
         auto submesh = trimesh.get_submesh(mesh_idx);
         auto tri_vertices = submesh->get_triangle_vertices(tri_idx);
 
@@ -49,3 +96,431 @@ TEST(test_paged_trimesh, voronoi_regions) {
         }
     });
 }
+
+TEST(test_paged_trimesh, edit_submesh) {
+    edyn::init();
+
+    // Bumpy grid, thus the normals of adjacent faces differ.
+    std::vector<edyn::vector3> vertices;
+    std::vector<edyn::triangle_mesh::index_type> indices;
+    make_grid(16, vertices, indices);
+
+    auto loader = std::make_shared<triangle_mesh_page_loader>();
+    auto trimesh = edyn::paged_triangle_mesh(loader);
+    edyn::create_paged_triangle_mesh(trimesh, vertices.begin(), vertices.end(), indices.begin(), indices.end(), 32);
+    ASSERT_GT(trimesh.num_submeshes(), 1);
+
+    auto submesh = trimesh.get_submesh(0);
+    auto num_triangles = submesh->num_triangles();
+    auto tree = trimesh.get_tree();
+    auto aabb = trimesh.get_aabb();
+
+    auto face_indices = [] (const edyn::triangle_mesh &mesh, size_t face_idx) {
+        return std::array<uint32_t, 3>{
+            mesh.get_face_vertex_index(face_idx, 0),
+            mesh.get_face_vertex_index(face_idx, 1),
+            mesh.get_face_vertex_index(face_idx, 2)
+        };
+    };
+
+    // Boundary flags and adjacent normals, which include the normals of the
+    // faces in neighboring submeshes, keyed by face vertex indices and edge
+    // index, since the index of the last face changes.
+    auto boundary_edges = std::map<std::pair<std::array<uint32_t, 3>, size_t>, bool>{};
+    auto adjacent_normals = std::map<std::pair<std::array<uint32_t, 3>, size_t>, edyn::vector3>{};
+
+    for (size_t face_idx = 0; face_idx < num_triangles; ++face_idx) {
+        for (size_t i = 0; i < 3; ++i) {
+            auto key = std::make_pair(face_indices(*submesh, face_idx), i);
+            boundary_edges[key] = submesh->is_boundary_edge(submesh->get_face_edge_index(face_idx, i));
+            adjacent_normals[key] = submesh->get_adjacent_face_normal(face_idx, i);
+        }
+    }
+
+    // Remove a triangle from the middle of the submesh.
+    auto removed_idx = static_cast<uint32_t>(num_triangles / 2);
+    auto removed_face = face_indices(*submesh, removed_idx);
+    auto edit = edyn::triangle_mesh_edit{};
+    edit.removed_triangles.push_back(removed_idx);
+    trimesh.edit_submesh(0, edit);
+
+    // The submesh is replaced by an edited copy.
+    auto edited = trimesh.get_submesh(0);
+    ASSERT_NE(edited, submesh);
+    ASSERT_EQ(submesh->num_triangles(), num_triangles);
+    ASSERT_EQ(edited->num_triangles(), num_triangles - 1);
+
+    for (size_t face_idx = 0; face_idx < edited->num_triangles(); ++face_idx) {
+        auto indices = face_indices(*edited, face_idx);
+
+        for (size_t i = 0; i < 3; ++i) {
+            auto edge_idx = edited->get_face_edge_index(face_idx, i);
+            auto key = std::make_pair(indices, i);
+            auto shares_removed_edge = false;
+
+            for (size_t j = 0; j < 3; ++j) {
+                shares_removed_edge |= std::minmax(indices[i], indices[(i + 1) % 3]) ==
+                                       std::minmax(removed_face[j], removed_face[(j + 1) % 3]);
+            }
+
+            if (shares_removed_edge) {
+                ASSERT_TRUE(edited->is_boundary_edge(edge_idx));
+            } else {
+                ASSERT_EQ(edited->is_boundary_edge(edge_idx), boundary_edges.at(key));
+                ASSERT_VECTOR3_EQ(edited->get_adjacent_face_normal(face_idx, i), adjacent_normals.at(key));
+            }
+        }
+    }
+
+    // The bounds did not grow thus the tree is kept.
+    ASSERT_EQ(trimesh.get_tree(), tree);
+
+    // Add a triangle above the mesh, which grows the bounds of the submesh.
+    auto apex = edited->get_aabb().center();
+    apex.y = 10;
+    edit = {};
+    edit.added_vertices.push_back(apex);
+    edit.added_triangles.push_back({edited->get_face_vertex_index(0, 0),
+                                    edited->get_face_vertex_index(0, 1),
+                                    static_cast<uint32_t>(edited->num_vertices())});
+    trimesh.edit_submesh(0, edit);
+
+    // The tree is replaced and the previous one is not modified.
+    ASSERT_NE(trimesh.get_tree(), tree);
+    ASSERT_VECTOR3_EQ(tree->root_aabb().min, aabb.min);
+    ASSERT_VECTOR3_EQ(tree->root_aabb().max, aabb.max);
+    ASSERT_GE(trimesh.get_aabb().max.y, 10);
+
+    auto apex_aabb = edyn::AABB{apex - edyn::vector3_one * edyn::scalar(0.1),
+                                apex + edyn::vector3_one * edyn::scalar(0.1)};
+    auto num_hits = 0;
+    trimesh.visit_triangles(apex_aabb, [&] (size_t mesh_idx, size_t tri_idx, auto &) {
+        ASSERT_EQ(mesh_idx, 0);
+        ++num_hits;
+    });
+    ASSERT_EQ(num_hits, 1);
+
+    // Every triangle which intersects a query is visited.
+    std::mt19937 rng(1337);
+    std::uniform_real_distribution<edyn::scalar> dist(0, 1);
+    aabb = trimesh.get_aabb();
+
+    for (auto k = 0; k < 100; ++k) {
+        auto center = aabb.min + (aabb.max - aabb.min) * edyn::vector3{dist(rng), dist(rng), dist(rng)};
+        auto query_aabb = edyn::AABB{center - edyn::vector3_one, center + edyn::vector3_one};
+        auto visited = std::set<std::pair<size_t, size_t>>{};
+
+        trimesh.visit_triangles(query_aabb, [&] (size_t mesh_idx, size_t tri_idx, auto &) {
+            visited.emplace(mesh_idx, tri_idx);
+        });
+
+        for (size_t mesh_idx = 0; mesh_idx < trimesh.num_submeshes(); ++mesh_idx) {
+            auto mesh = trimesh.get_submesh(mesh_idx);
+
+            for (size_t tri_idx = 0; tri_idx < mesh->num_triangles(); ++tri_idx) {
+                auto tri_aabb = edyn::get_triangle_aabb(mesh->get_triangle_vertices(tri_idx));
+
+                if (edyn::intersect(tri_aabb, query_aabb)) {
+                    ASSERT_EQ(visited.count({mesh_idx, tri_idx}), 1);
+                }
+            }
+        }
+    }
+}
+
+TEST(test_paged_trimesh, create_in_worker) {
+    edyn::init();
+
+    std::vector<edyn::vector3> vertices;
+    std::vector<edyn::triangle_mesh::index_type> indices;
+    make_grid(64, vertices, indices);
+
+    auto loader = std::make_shared<triangle_mesh_page_loader>();
+    auto trimesh = edyn::paged_triangle_mesh(loader);
+    edyn::create_paged_triangle_mesh(trimesh, vertices.begin(), vertices.end(), indices.begin(), indices.end(), 256);
+
+    // Submeshes are built serially in a worker, since it must not block on
+    // other jobs, with the same result.
+    auto worker_trimesh = edyn::paged_triangle_mesh(loader);
+    run_in_worker([&] {
+        edyn::create_paged_triangle_mesh(worker_trimesh, vertices.begin(), vertices.end(), indices.begin(), indices.end(), 256);
+    });
+
+    ASSERT_EQ(worker_trimesh.num_submeshes(), trimesh.num_submeshes());
+    ASSERT_VECTOR3_EQ(worker_trimesh.get_aabb().min, trimesh.get_aabb().min);
+    ASSERT_VECTOR3_EQ(worker_trimesh.get_aabb().max, trimesh.get_aabb().max);
+
+    for (size_t mesh_idx = 0; mesh_idx < trimesh.num_submeshes(); ++mesh_idx) {
+        auto submesh = trimesh.get_submesh(mesh_idx);
+        auto worker_submesh = worker_trimesh.get_submesh(mesh_idx);
+        ASSERT_EQ(worker_submesh->num_triangles(), submesh->num_triangles());
+        ASSERT_EQ(worker_submesh->num_edges(), submesh->num_edges());
+
+        for (size_t face_idx = 0; face_idx < submesh->num_triangles(); ++face_idx) {
+            for (size_t i = 0; i < 3; ++i) {
+                ASSERT_VECTOR3_EQ(worker_submesh->get_adjacent_face_normal(face_idx, i),
+                                  submesh->get_adjacent_face_normal(face_idx, i));
+            }
+        }
+    }
+
+    edyn::deinit();
+}
+
+// Creates a paged grid and makes the loader return copies of its submeshes.
+static void make_paged_grid(edyn::paged_triangle_mesh &trimesh, memory_page_loader &loader) {
+    std::vector<edyn::vector3> vertices;
+    std::vector<edyn::triangle_mesh::index_type> indices;
+    make_grid(32, vertices, indices);
+    edyn::create_paged_triangle_mesh(trimesh, vertices.begin(), vertices.end(), indices.begin(), indices.end(), 64);
+
+    for (size_t mesh_idx = 0; mesh_idx < trimesh.num_submeshes(); ++mesh_idx) {
+        loader.submeshes.push_back(trimesh.get_submesh(mesh_idx));
+    }
+}
+
+// Visits a submesh with a query that does not touch any other, which loads
+// it if needed and marks it as recently visited.
+static void visit_submesh(edyn::paged_triangle_mesh &trimesh, const memory_page_loader &loader, size_t mesh_idx) {
+    auto center = loader.submeshes[mesh_idx]->get_aabb().center();
+    auto aabb = edyn::AABB{center - edyn::vector3_one * edyn::scalar(0.01),
+                           center + edyn::vector3_one * edyn::scalar(0.01)};
+    auto visited = std::set<size_t>{};
+
+    trimesh.visit_submeshes(aabb, [&] (size_t idx, auto &submesh) {
+        ASSERT_NE(submesh, nullptr);
+        visited.insert(idx);
+    });
+
+    ASSERT_EQ(visited, std::set<size_t>{mesh_idx});
+}
+
+// Sum of the sizes of the loaded submeshes.
+static size_t loaded_size(const edyn::paged_triangle_mesh &trimesh) {
+    auto size = size_t{0};
+
+    for (size_t mesh_idx = 0; mesh_idx < trimesh.num_submeshes(); ++mesh_idx) {
+        if (auto submesh = trimesh.get_submesh(mesh_idx)) {
+            size += submesh->memory_size();
+        }
+    }
+
+    return size;
+}
+
+TEST(test_paged_trimesh, cache_size_budget) {
+    auto loader = std::make_shared<memory_page_loader>();
+    auto trimesh = edyn::paged_triangle_mesh(loader);
+    make_paged_grid(trimesh, *loader);
+    ASSERT_GT(trimesh.num_submeshes(), 8);
+    ASSERT_EQ(trimesh.cache_size(), loaded_size(trimesh));
+
+    auto max_submesh_size = size_t{0};
+
+    for (auto &submesh : loader->submeshes) {
+        max_submesh_size = std::max(max_submesh_size, submesh->memory_size());
+    }
+
+    // Lowering the budget trims the cache right away.
+    auto budget = max_submesh_size * 3;
+    trimesh.set_max_cache_size(budget);
+    ASSERT_EQ(trimesh.max_cache_size(), budget);
+    ASSERT_LE(trimesh.cache_size(), budget);
+    ASSERT_EQ(trimesh.cache_size(), loaded_size(trimesh));
+
+    trimesh.clear_cache();
+    ASSERT_EQ(trimesh.cache_size(), 0);
+
+    // The cache never exceeds the budget while all submeshes are visited.
+    for (size_t mesh_idx = 0; mesh_idx < trimesh.num_submeshes(); ++mesh_idx) {
+        visit_submesh(trimesh, *loader, mesh_idx);
+        ASSERT_NE(trimesh.get_submesh(mesh_idx), nullptr);
+        ASSERT_LE(trimesh.cache_size(), budget);
+        ASSERT_EQ(trimesh.cache_size(), loaded_size(trimesh));
+    }
+
+    ASSERT_GT(trimesh.cache_size(), max_submesh_size);
+}
+
+TEST(test_paged_trimesh, clock_eviction) {
+    auto loader = std::make_shared<memory_page_loader>();
+    auto trimesh = edyn::paged_triangle_mesh(loader);
+    make_paged_grid(trimesh, *loader);
+
+    // Pick submeshes of the same size, so the budget fits exactly four.
+    auto by_size = std::map<size_t, std::vector<size_t>>{};
+
+    for (size_t mesh_idx = 0; mesh_idx < trimesh.num_submeshes(); ++mesh_idx) {
+        by_size[loader->submeshes[mesh_idx]->memory_size()].push_back(mesh_idx);
+    }
+
+    auto it = std::find_if(by_size.begin(), by_size.end(), [] (auto &pair) {
+        return pair.second.size() >= 6;
+    });
+    ASSERT_NE(it, by_size.end());
+    auto submesh_size = it->first;
+    auto &idx = it->second;
+
+    trimesh.clear_cache();
+    trimesh.set_max_cache_size(submesh_size * 4);
+
+    for (size_t i = 0; i < 4; ++i) {
+        visit_submesh(trimesh, *loader, idx[i]);
+    }
+
+    // The first sweep clears the flags of all submeshes, then the first
+    // submesh under the hand is evicted.
+    visit_submesh(trimesh, *loader, idx[4]);
+    ASSERT_EQ(trimesh.get_submesh(idx[0]), nullptr);
+
+    // A visited submesh gets a second chance. The hand moves past it and
+    // evicts the next one.
+    visit_submesh(trimesh, *loader, idx[1]);
+    visit_submesh(trimesh, *loader, idx[5]);
+    ASSERT_NE(trimesh.get_submesh(idx[1]), nullptr);
+    ASSERT_EQ(trimesh.get_submesh(idx[2]), nullptr);
+    ASSERT_NE(trimesh.get_submesh(idx[3]), nullptr);
+    ASSERT_NE(trimesh.get_submesh(idx[4]), nullptr);
+    ASSERT_NE(trimesh.get_submesh(idx[5]), nullptr);
+    ASSERT_EQ(trimesh.cache_size(), submesh_size * 4);
+
+    // Visiting loaded submeshes does not load them again.
+    auto num_loads = loader->num_loads;
+    visit_submesh(trimesh, *loader, idx[3]);
+    ASSERT_EQ(loader->num_loads, num_loads);
+}
+
+TEST(test_paged_trimesh, edited_submesh_pinned) {
+    auto loader = std::make_shared<memory_page_loader>();
+    auto trimesh = edyn::paged_triangle_mesh(loader);
+    make_paged_grid(trimesh, *loader);
+    trimesh.clear_cache();
+
+    // The submesh is loaded before being edited.
+    auto edit = edyn::triangle_mesh_edit{};
+    edit.removed_triangles.push_back(0);
+    trimesh.edit_submesh(2, edit);
+    auto edited = trimesh.get_submesh(2);
+    ASSERT_NE(edited, nullptr);
+    ASSERT_EQ(edited->num_triangles(), loader->submeshes[2]->num_triangles() - 1);
+
+    // Edited submeshes are never evicted, even if they exceed the budget.
+    trimesh.set_max_cache_size(0);
+    ASSERT_EQ(trimesh.get_submesh(2), edited);
+    ASSERT_EQ(trimesh.cache_size(), edited->memory_size());
+
+    for (size_t mesh_idx = 0; mesh_idx < trimesh.num_submeshes(); ++mesh_idx) {
+        visit_submesh(trimesh, *loader, mesh_idx);
+        ASSERT_EQ(trimesh.get_submesh(2), edited);
+    }
+
+    // Clearing the cache reverts the edit.
+    trimesh.clear_cache();
+    visit_submesh(trimesh, *loader, 2);
+    ASSERT_EQ(trimesh.get_submesh(2)->num_triangles(), loader->submeshes[2]->num_triangles());
+}
+
+// Records requests without loading anything, as if loads were still pending.
+class recording_page_loader: public edyn::triangle_mesh_page_loader_base {
+public:
+    void load(size_t index) override {
+        requests.push_back(index);
+    }
+
+    entt::sink<loaded_mesh_func_t> on_load_sink() override {
+        return entt::sink{m_loaded_signal};
+    }
+
+    std::vector<size_t> requests;
+
+private:
+    entt::sigh<loaded_mesh_func_t> m_loaded_signal;
+};
+
+static edyn::scalar aabb_distance_sqr(const edyn::AABB &b0, const edyn::AABB &b1) {
+    auto gap = edyn::max(edyn::max(b0.min - b1.max, b1.min - b0.max), edyn::vector3_zero);
+    return edyn::length_sqr(gap);
+}
+
+TEST(test_paged_trimesh, prefetch_regions) {
+    auto loader = std::make_shared<recording_page_loader>();
+    auto trimesh = edyn::paged_triangle_mesh(loader);
+    std::vector<edyn::vector3> vertices;
+    std::vector<edyn::triangle_mesh::index_type> indices;
+    make_grid(32, vertices, indices);
+    edyn::create_paged_triangle_mesh(trimesh, vertices.begin(), vertices.end(), indices.begin(), indices.end(), 64);
+    trimesh.clear_cache();
+
+    // A body near one corner moving along the x axis.
+    auto region = edyn::paged_triangle_mesh::prefetch_region{};
+    region.aabb = {{1, -1, 1}, {2, 1, 2}};
+    region.displacement = {12, 0, 0};
+    auto swept_aabb = edyn::AABB{region.aabb.min, region.aabb.max + region.displacement};
+
+    // Submeshes in the swept region and the distance of their node to the
+    // current AABB of the body.
+    auto tree = trimesh.get_tree();
+    auto expected = std::map<size_t, edyn::scalar>{};
+
+    tree->query(swept_aabb, [&] (auto tree_node_idx) {
+        auto node = tree->get_node(tree_node_idx);
+        expected[node.id] = aabb_distance_sqr(region.aabb, node.aabb);
+    });
+
+    ASSERT_GT(expected.size(), 2);
+
+    trimesh.prefetch({region});
+
+    // Each submesh in the swept region is requested once, closest first.
+    ASSERT_EQ(loader->requests.size(), expected.size());
+    auto previous_dist_sqr = edyn::scalar(0);
+
+    for (auto mesh_idx : loader->requests) {
+        ASSERT_EQ(expected.count(mesh_idx), 1);
+        ASSERT_GE(expected[mesh_idx], previous_dist_sqr);
+        previous_dist_sqr = expected[mesh_idx];
+        expected.erase(mesh_idx);
+    }
+
+    // Submeshes which are loading are not requested again.
+    auto num_requests = loader->requests.size();
+    trimesh.prefetch({region, region});
+    ASSERT_EQ(loader->requests.size(), num_requests);
+}
+
+TEST(test_paged_trimesh, blocking_load) {
+    auto loader = std::make_shared<memory_page_loader>();
+    auto trimesh = edyn::paged_triangle_mesh(loader);
+    make_paged_grid(trimesh, *loader);
+    trimesh.clear_cache();
+    auto num_evictions = trimesh.num_evictions();
+
+    auto aabb = edyn::AABB{{4, -1, 4}, {20, 1, 9}};
+    auto expected = std::set<size_t>{};
+    auto tree = trimesh.get_tree();
+
+    tree->query(aabb, [&] (auto tree_node_idx) {
+        expected.insert(tree->get_node(tree_node_idx).id);
+    });
+
+    ASSERT_GT(expected.size(), 1);
+    ASSERT_LT(expected.size(), trimesh.num_submeshes());
+
+    // All submeshes in the region are loaded before it returns.
+    trimesh.load_blocking(aabb);
+    ASSERT_EQ(loader->num_loads, expected.size());
+
+    for (size_t mesh_idx = 0; mesh_idx < trimesh.num_submeshes(); ++mesh_idx) {
+        ASSERT_EQ(trimesh.get_submesh(mesh_idx) != nullptr, expected.count(mesh_idx) > 0);
+    }
+
+    // Loaded submeshes are not loaded again.
+    trimesh.load_blocking(aabb);
+    ASSERT_EQ(loader->num_loads, expected.size());
+    ASSERT_EQ(trimesh.num_evictions(), num_evictions);
+
+    // Unloading any submesh changes the eviction count, which tells whether
+    // a region loaded before might not be resident anymore.
+    trimesh.set_max_cache_size(trimesh.cache_size() - 1);
+    ASSERT_GT(trimesh.num_evictions(), num_evictions);
+}
@@ -1,5 +1,97 @@
 #include "../common/common.hpp"
 
+#include <map>
+#include <random>
+
+// Creates a bumpy grid with `size * size` quads, split in two triangles each.
+static edyn::triangle_mesh make_grid_mesh(size_t size) {
+    auto vertices = std::vector<edyn::vector3>{};
+    auto indices = std::vector<uint32_t>{};
+
+    for (size_t i = 0; i <= size; ++i) {
+        for (size_t j = 0; j <= size; ++j) {
+            auto x = edyn::scalar(i), z = edyn::scalar(j);
+            vertices.push_back({x, edyn::scalar(0.3) * std::sin(x * edyn::scalar(0.7)) +
+                                   edyn::scalar(0.2) * std::cos(z * edyn::scalar(0.9)), z});
+        }
+    }
+
+    for (uint32_t i = 0; i < size; ++i) {
+        for (uint32_t j = 0; j < size; ++j) {
+            auto v00 = i * (size + 1) + j;
+            auto v01 = v00 + 1;
+            auto v10 = v00 + size + 1;
+            auto v11 = v10 + 1;
+            indices.insert(indices.end(), {v00, v01, v11});
+            indices.insert(indices.end(), {v00, v11, v10});
+        }
+    }
+
+    auto trimesh = edyn::triangle_mesh{};
+    trimesh.insert_vertices(vertices.begin(), vertices.end());
+    trimesh.insert_indices(indices.begin(), indices.end());
+    trimesh.initialize();
+    return trimesh;
+}
+
+// Checks that faces and edges reference each other consistently.
+static void check_adjacency(const edyn::triangle_mesh &trimesh) {
+    auto edge_referenced = std::vector<bool>(trimesh.num_edges());
+
+    for (size_t face_idx = 0; face_idx < trimesh.num_triangles(); ++face_idx) {
+        for (size_t i = 0; i < 3; ++i) {
+            auto edge_idx = trimesh.get_face_edge_index(face_idx, i);
+            ASSERT_LT(edge_idx, trimesh.num_edges());
+            edge_referenced[edge_idx] = true;
+
+            auto vertex_idx0 = trimesh.get_face_vertex_index(face_idx, i);
+            auto vertex_idx1 = trimesh.get_face_vertex_index(face_idx, (i + 1) % 3);
+            auto edge_vertices = trimesh.get_edge_vertex_indices(edge_idx);
+            ASSERT_EQ(std::minmax(vertex_idx0, vertex_idx1), std::minmax(edge_vertices[0], edge_vertices[1]));
+
+            auto edge_faces = trimesh.get_edge_face_indices(edge_idx);
+            ASSERT_TRUE(edge_faces[0] == face_idx || edge_faces[1] == face_idx);
+            ASSERT_EQ(trimesh.is_boundary_edge(edge_idx), edge_faces[0] == edge_faces[1]);
+
+            for (auto other_idx : edge_faces) {
+                ASSERT_LT(other_idx, trimesh.num_triangles());
+            }
+        }
+    }
+
+    for (auto referenced : edge_referenced) {
+        ASSERT_TRUE(referenced);
+    }
+}
+
+// Checks that the triangle tree finds every triangle which intersects an AABB.
+static void check_triangle_tree(const edyn::triangle_mesh &trimesh) {
+    std::mt19937 rng(1337);
+    auto aabb = trimesh.get_aabb();
+    std::uniform_real_distribution<edyn::scalar> dist(0, 1);
+
+    for (auto k = 0; k < 100; ++k) {
+        auto center = aabb.min + (aabb.max - aabb.min) * edyn::vector3{dist(rng), dist(rng), dist(rng)};
+        auto query_aabb = edyn::AABB{center - edyn::vector3_one * edyn::scalar(0.6),
+                                     center + edyn::vector3_one * edyn::scalar(0.6)};
+        auto visited = std::vector<bool>(trimesh.num_triangles());
+
+        trimesh.visit_triangles(query_aabb, [&] (auto tri_idx) {
+            ASSERT_LT(tri_idx, trimesh.num_triangles());
+            ASSERT_FALSE(visited[tri_idx]);
+            visited[tri_idx] = true;
+        });
+
+        for (size_t tri_idx = 0; tri_idx < trimesh.num_triangles(); ++tri_idx) {
+            auto tri_aabb = edyn::get_triangle_aabb(trimesh.get_triangle_vertices(tri_idx));
+
+            if (edyn::intersect(tri_aabb, query_aabb)) {
+                ASSERT_TRUE(visited[tri_idx]);
+            }
+        }
+    }
+}
+
 TEST(test_trimesh, voronoi_regions) {
     auto vertices = std::vector<edyn::vector3>{};
     vertices.push_back({1, 0, 1});
@@ -39,3 +131,240 @@ TEST(test_trimesh, voronoi_regions) {
     ASSERT_VECTOR3_EQ(trimesh.get_aabb().min, {-1, 0, -1});
     ASSERT_VECTOR3_EQ(trimesh.get_aabb().max, {2, 1, 1});
 }
+
+TEST(test_trimesh, apply_edit) {
+    auto vertices = std::vector<edyn::vector3>{};
+    vertices.push_back({1, 0, 1});
+    vertices.push_back({1, 0, -1});
+    vertices.push_back({-1, 0, -1});
+    vertices.push_back({-1, 0, 1});
+    vertices.push_back({0, 1, 0});
+    vertices.push_back({2, 0, 0});
+
+    auto indices = std::vector<uint32_t>{};
+    indices.insert(indices.end(), {0, 1, 4});
+    indices.insert(indices.end(), {1, 2, 4});
+    indices.insert(indices.end(), {2, 3, 4});
+    indices.insert(indices.end(), {3, 0, 4});
+    indices.insert(indices.end(), {0, 5, 1});
+
+    auto trimesh = edyn::triangle_mesh{};
+    trimesh.insert_vertices(vertices.begin(), vertices.end());
+    trimesh.insert_indices(indices.begin(), indices.end());
+    trimesh.initialize();
+
+    auto edit = edyn::triangle_mesh_edit{};
+    edit.removed_triangles.push_back(4);
+    trimesh.apply_edit(edit);
+
+    ASSERT_EQ(trimesh.num_triangles(), 4);
+    ASSERT_EQ(trimesh.num_edges(), 8);
+    ASSERT_TRUE(trimesh.is_boundary_edge(trimesh.get_face_edge_index(0, 0)));
+    ASSERT_VECTOR3_EQ(trimesh.get_aabb().max, {1, 1, 1});
+
+    // Add the triangle back and move the apex beyond the bounds of the mesh.
+    edit = {};
+    edit.moved_vertices.push_back({4, {0, 2, 0}});
+    edit.added_triangles.push_back({0, 5, 1});
+    trimesh.apply_edit(edit);
+
+    ASSERT_EQ(trimesh.num_triangles(), 5);
+    ASSERT_EQ(trimesh.num_edges(), 10);
+    ASSERT_FALSE(trimesh.is_boundary_edge(trimesh.get_face_edge_index(0, 0)));
+    ASSERT_FALSE(trimesh.is_convex_edge(trimesh.get_face_edge_index(4, 2)));
+    ASSERT_TRUE(trimesh.is_convex_edge(trimesh.get_face_edge_index(0, 1)));
+    ASSERT_VECTOR3_EQ(trimesh.get_aabb().max, {2, 2, 1});
+
+    auto num_hits = 0;
+    trimesh.visit_triangles({{-0.1, 1.9, -0.1}, {0.1, 2.1, 0.1}}, [&] (auto tri_idx) { ++num_hits; });
+    ASSERT_EQ(num_hits, 4);
+}
+
+TEST(test_trimesh, apply_edit_remove_middle) {
+    auto trimesh = make_grid_mesh(6);
+    auto num_triangles = trimesh.num_triangles();
+    auto num_edges = trimesh.num_edges();
+    auto removed_idx = uint32_t{30};
+    auto last_idx = static_cast<uint32_t>(num_triangles - 1);
+
+    auto face_indices = [&] (size_t face_idx) {
+        return std::array<uint32_t, 3>{
+            trimesh.get_face_vertex_index(face_idx, 0),
+            trimesh.get_face_vertex_index(face_idx, 1),
+            trimesh.get_face_vertex_index(face_idx, 2)
+        };
+    };
+
+    auto removed_face = face_indices(removed_idx);
+    auto last_face = face_indices(last_idx);
+
+    auto is_removed_edge = [&] (uint32_t vertex_idx0, uint32_t vertex_idx1) {
+        for (size_t i = 0; i < 3; ++i) {
+            if (std::minmax(vertex_idx0, vertex_idx1) ==
+                std::minmax(removed_face[i], removed_face[(i + 1) % 3])) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // Boundary flags and adjacent normals keyed by face vertex indices and
+    // edge index, since the index of the last face changes.
+    auto boundary_edges = std::map<std::pair<std::array<uint32_t, 3>, size_t>, bool>{};
+    auto adjacent_normals = std::map<std::pair<std::array<uint32_t, 3>, size_t>, edyn::vector3>{};
+
+    for (size_t face_idx = 0; face_idx < num_triangles; ++face_idx) {
+        for (size_t i = 0; i < 3; ++i) {
+            auto key = std::make_pair(face_indices(face_idx), i);
+            boundary_edges[key] = trimesh.is_boundary_edge(trimesh.get_face_edge_index(face_idx, i));
+            adjacent_normals[key] = trimesh.get_adjacent_face_normal(face_idx, i);
+        }
+    }
+
+    auto edit = edyn::triangle_mesh_edit{};
+    edit.removed_triangles.push_back(removed_idx);
+    trimesh.apply_edit(edit);
+
+    // The last triangle takes the place of the removed one. No edge is left
+    // without faces since the removed triangle was surrounded by others.
+    ASSERT_EQ(trimesh.num_triangles(), num_triangles - 1);
+    ASSERT_EQ(trimesh.num_edges(), num_edges);
+    ASSERT_EQ(face_indices(removed_idx), last_face);
+    check_adjacency(trimesh);
+
+    for (size_t face_idx = 0; face_idx < trimesh.num_triangles(); ++face_idx) {
+        auto indices = face_indices(face_idx);
+
+        for (size_t i = 0; i < 3; ++i) {
+            auto edge_idx = trimesh.get_face_edge_index(face_idx, i);
+            auto key = std::make_pair(indices, i);
+
+            if (is_removed_edge(indices[i], indices[(i + 1) % 3])) {
+                ASSERT_FALSE(boundary_edges.at(key));
+                ASSERT_TRUE(trimesh.is_boundary_edge(edge_idx));
+            } else {
+                ASSERT_EQ(trimesh.is_boundary_edge(edge_idx), boundary_edges.at(key));
+                ASSERT_VECTOR3_EQ(trimesh.get_adjacent_face_normal(face_idx, i), adjacent_normals.at(key));
+            }
+        }
+    }
+
+    check_triangle_tree(trimesh);
+
+    // Nothing is found where the removed triangle was, except its neighbors.
+    auto removed_vertices = edyn::triangle_vertices{
+        trimesh.get_vertex_position(removed_face[0]),
+        trimesh.get_vertex_position(removed_face[1]),
+        trimesh.get_vertex_position(removed_face[2])
+    };
+    auto centroid = (removed_vertices[0] + removed_vertices[1] + removed_vertices[2]) / edyn::scalar(3);
+    auto centroid_aabb = edyn::AABB{centroid - edyn::vector3_one * edyn::scalar(0.01),
+                                    centroid + edyn::vector3_one * edyn::scalar(0.01)};
+
+    trimesh.visit_triangles(centroid_aabb, [&] (auto tri_idx) {
+        ASSERT_NE(face_indices(tri_idx), removed_face);
+    });
+}
+
+TEST(test_trimesh, apply_edit_move_and_add) {
+    auto trimesh = make_grid_mesh(6);
+    auto num_triangles = trimesh.num_triangles();
+
+    // Remove two triangles and add three, one of which references a new
+    // vertex above the mesh.
+    auto edit = edyn::triangle_mesh_edit{};
+    edit.removed_triangles = {10, 40};
+    auto new_vertex_idx = static_cast<uint32_t>(trimesh.num_vertices());
+    edit.added_vertices.push_back({3, 5, 3});
+    edit.added_triangles.push_back({trimesh.get_face_vertex_index(10, 0),
+                                    trimesh.get_face_vertex_index(10, 1),
+                                    trimesh.get_face_vertex_index(10, 2)});
+    edit.added_triangles.push_back({trimesh.get_face_vertex_index(40, 0),
+                                    trimesh.get_face_vertex_index(40, 1),
+                                    new_vertex_idx});
+    edit.added_triangles.push_back({trimesh.get_face_vertex_index(40, 1),
+                                    trimesh.get_face_vertex_index(40, 2),
+                                    new_vertex_idx});
+    edit.moved_vertices.push_back({0, {0, -2, 0}});
+    trimesh.apply_edit(edit);
+
+    ASSERT_EQ(trimesh.num_triangles(), num_triangles + 1);
+    ASSERT_SCALAR_EQ(trimesh.get_aabb().max.y, 5);
+    ASSERT_SCALAR_EQ(trimesh.get_aabb().min.y, -2);
+    check_adjacency(trimesh);
+    check_triangle_tree(trimesh);
+
+    auto num_hits = 0;
+    trimesh.visit_triangles({{2.9, 4.9, 2.9}, {3.1, 5.1, 3.1}}, [&] (auto tri_idx) { ++num_hits; });
+    ASSERT_EQ(num_hits, 2);
+}
+
+TEST(test_trimesh, parallel_initialize) {
+    edyn::init();
+
+    // Large enough to be initialized in parallel in the main thread.
+    auto trimesh = make_grid_mesh(64);
+    ASSERT_GE(trimesh.num_triangles(), 4096);
+    check_adjacency(trimesh);
+    check_triangle_tree(trimesh);
+
+    // In a worker thread it is initialized serially, with the same result.
+    auto worker_trimesh = edyn::triangle_mesh{};
+    run_in_worker([&] {
+        worker_trimesh = make_grid_mesh(64);
+    });
+
+    ASSERT_EQ(worker_trimesh.num_triangles(), trimesh.num_triangles());
+    ASSERT_EQ(worker_trimesh.num_edges(), trimesh.num_edges());
+    ASSERT_EQ(worker_trimesh.memory_size(), trimesh.memory_size());
+
+    for (size_t face_idx = 0; face_idx < trimesh.num_triangles(); ++face_idx) {
+        ASSERT_VECTOR3_EQ(worker_trimesh.get_triangle_normal(face_idx), trimesh.get_triangle_normal(face_idx));
+
+        for (size_t i = 0; i < 3; ++i) {
+            ASSERT_EQ(worker_trimesh.get_face_edge_index(face_idx, i), trimesh.get_face_edge_index(face_idx, i));
+        }
+    }
+
+    for (size_t edge_idx = 0; edge_idx < trimesh.num_edges(); ++edge_idx) {
+        ASSERT_EQ(worker_trimesh.is_convex_edge(edge_idx), trimesh.is_convex_edge(edge_idx));
+    }
+
+    edyn::deinit();
+}
+
+TEST(test_trimesh, edit_mesh_shape) {
+    entt::registry registry;
+    edyn::init();
+    edyn::attach(registry);
+
+    auto trimesh = std::make_shared<edyn::triangle_mesh>(make_grid_mesh(8));
+    auto def = edyn::rigidbody_def{};
+    def.kind = edyn::rigidbody_kind::rb_static;
+    def.shape = edyn::mesh_shape{trimesh};
+    auto entity = edyn::make_rigidbody(registry, def);
+
+    // Raise the vertex in the middle of the grid.
+    auto vertex_idx = edyn::triangle_mesh::index_type{4 * 9 + 4};
+    auto old_vertex = trimesh->get_vertex_position(vertex_idx);
+    auto edit = edyn::triangle_mesh_edit{};
+    edit.moved_vertices.push_back({vertex_idx, {4, 3, 4}});
+    edyn::edit_mesh_shape(registry, entity, edit);
+
+    // The shared mesh is not modified, a new one is assigned instead.
+    auto &shape = registry.get<edyn::mesh_shape>(entity);
+    ASSERT_NE(shape.trimesh, trimesh);
+    ASSERT_VECTOR3_EQ(trimesh->get_vertex_position(vertex_idx), old_vertex);
+    ASSERT_VECTOR3_EQ(shape.trimesh->get_vertex_position(vertex_idx), (edyn::vector3{4, 3, 4}));
+    ASSERT_SCALAR_EQ(registry.get<edyn::AABB>(entity).max.y, 3);
+
+    // The broadphase tree and the mesh tree were updated.
+    auto p0 = edyn::vector3{4.05, 10, 4.02};
+    auto p1 = edyn::vector3{4.05, -10, 4.02};
+    auto result = edyn::raycast(registry, p0, p1);
+    ASSERT_EQ(result.entity, entity);
+    ASSERT_GT(edyn::lerp(p0, p1, result.fraction).y, 2.5);
+
+    edyn::detach(registry);
+    edyn::deinit();
+}